@@ -0,0 +1,110 @@
+#!/bin/sh
+#
+# Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License.  You may obtain a copy
+# of the License at http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, without
+# warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+# License for the specific language governing permissions and limitations
+# under the License.
+#
+
+#checks the apispec url cache of the cli against a local http server:
+#the first fetch, a hit within the ttl, a 304 after it, a server that
+#is down and one that never answers. run by make check in the cli
+#build directory. skipped without python3, which serves the spec.
+
+cli=./copenapi_cli
+spec=${srcdir:-.}/../tests/test.json
+
+if ! command -v python3 >/dev/null 2>&1; then
+    echo "python3 not found"
+    exit 77
+fi
+
+work=$(mktemp -d)
+server=
+cleanup() {
+    [ -n "$server" ] && kill $server 2>/dev/null
+    rm -rf "$work"
+}
+trap cleanup EXIT
+
+fail() {
+    echo "FAIL: $1"
+    cat "$work/out"
+    exit 1
+}
+
+#runs the cli on the spec url with the given options, output in out
+run_cli() {
+    XDG_CACHE_HOME="$work/cache" $cli --apispec "$url" -v "$@" \
+        > "$work/out" 2>&1
+}
+
+requests() {
+    grep -c '"GET /spec.json' "$work/server.log"
+}
+
+mkdir "$work/www"
+cp "$spec" "$work/www/spec.json"
+
+port=$(python3 -c 'import socket
+s = socket.socket()
+s.bind(("127.0.0.1", 0))
+print(s.getsockname()[1])')
+url=http://127.0.0.1:$port/spec.json
+
+(cd "$work/www" &&
+ exec python3 -u -m http.server $port --bind 127.0.0.1) \
+    > "$work/server.log" 2>&1 &
+server=$!
+for i in 1 2 3 4 5 6 7 8 9 10; do
+    grep -q Serving "$work/server.log" && break
+    sleep 1
+done
+
+run_cli || fail "first fetch"
+grep -q "apispec: fetched" "$work/out" || fail "first fetch not fetched"
+[ "$(requests)" = 1 ] || fail "first fetch made $(requests) requests"
+
+run_cli || fail "fetch within the ttl"
+grep -q "apispec: cached" "$work/out" || fail "ttl hit not cached"
+[ "$(requests)" = 1 ] || fail "ttl hit went to the server"
+
+run_cli --apispec-ttl 0 || fail "fetch after the ttl"
+grep -q "apispec: not modified" "$work/out" || fail "no 304 after the ttl"
+grep -q '"GET /spec.json HTTP/1.1" 304' "$work/server.log" ||
+    fail "server did not answer 304"
+
+kill $server
+wait $server 2>/dev/null
+server=
+
+run_cli --apispec-ttl 0 || fail "server down with a cached copy"
+grep -q "using cached copy" "$work/out" || fail "cached copy not used"
+grep -qi "^error" "$work/out" && fail "error shown with a cached copy"
+
+#a server that takes the connection and never answers times out
+python3 -c 'import socket, sys, time
+s = socket.socket()
+s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+s.bind(("127.0.0.1", int(sys.argv[1])))
+s.listen(1)
+time.sleep(600)' $port &
+server=$!
+sleep 1
+run_cli --apispec-ttl 0 || fail "silent server with a cached copy"
+grep -q "using cached copy" "$work/out" || fail "cached copy not used"
+kill $server
+wait $server 2>/dev/null
+server=
+
+rm -rf "$work/cache"
+run_cli --apispec-ttl 0 && fail "server down without a cached copy"
+
+exit 0
@@ -0,0 +1,119 @@
+#!/bin/sh
+#
+# Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License.  You may obtain a copy
+# of the License at http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, without
+# warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+# License for the specific language governing permissions and limitations
+# under the License.
+#
+
+#checks that runs of the cli that name a module map the compiled image
+#made by --compile and the shared image made by --shared-image, and
+#print the same help as a load of the json. run by make check in the
+#cli build directory.
+
+cli=./copenapi_cli
+shared=/dev/shm/copenapi-$(id -u)
+
+work=$(mktemp -d)
+cleanup() {
+    #shared images and indexes keep the path of their spec
+    grep -l "$work" "$shared"/* 2>/dev/null | xargs rm -f
+    rm -rf "$work"
+}
+trap cleanup EXIT
+
+fail() {
+    echo "FAIL: $1"
+    cat "$work/out"
+    exit 1
+}
+
+#runs the cli on the spec with the given options, output in out
+run_cli() {
+    $cli --apispec "$work/spec.json" -v "$@" > "$work/out" 2>&1
+}
+
+mapped() {
+    grep -q "apispec: mapped image" "$work/out"
+}
+
+#help without the verbose note, to compare with a load of the json
+help_of() {
+    grep -v "^apispec: " "$work/out" > "$work/$1"
+}
+
+cat > "$work/spec.json" <<EOF
+{
+  "swagger": "2.0",
+  "host": "localhost",
+  "basePath": "/v1",
+  "tags": [{"name": "pet"}, {"name": "store"}],
+  "paths": {
+    "/pet/{petId}": {
+      "get": {
+        "tags": ["pet"],
+        "summary": "Find pet by id",
+        "parameters": [
+          {"name": "petId", "in": "path", "required": true, "type": "integer"}
+        ]
+      }
+    },
+    "/store/order": {
+      "post": {
+        "tags": ["store"],
+        "summary": "Place an order",
+        "parameters": [
+          {"name": "quantity", "in": "query", "type": "integer"}
+        ]
+      }
+    }
+  }
+}
+EOF
+
+run_cli pet --help || fail "module help from json"
+mapped && fail "module help mapped an image before --compile"
+help_of json_module
+run_cli pet petId --help || fail "command help from json"
+help_of json_command
+
+run_cli --compile || fail "compile"
+[ -f "$work/spec.json.coapi" ] || fail "no image after --compile"
+
+run_cli pet --help || fail "module help from image"
+mapped || fail "module help did not map the image"
+help_of image_module
+cmp -s "$work/json_module" "$work/image_module" ||
+    fail "module help differs from the json"
+
+run_cli pet petId --help || fail "command help from image"
+mapped || fail "command help did not map the image"
+help_of image_command
+cmp -s "$work/json_command" "$work/image_command" ||
+    fail "command help differs from the json"
+
+rm "$work/spec.json.coapi"
+
+run_cli --shared-image pet --help || fail "first shared run"
+mapped || fail "first shared run did not map the image"
+image=$(grep -l "$work/spec.json" "$shared"/*.coapi 2>/dev/null)
+[ -n "$image" ] || fail "no shared image after the first run"
+stamp=$(ls -li --time-style=full-iso "$image")
+
+#a later run maps the published image and does not compile again
+run_cli --shared-image pet petId --help || fail "second shared run"
+mapped || fail "second shared run did not map the image"
+[ "$(ls -li --time-style=full-iso "$image")" = "$stamp" ] ||
+    fail "second shared run compiled the spec again"
+help_of shared_command
+cmp -s "$work/json_command" "$work/shared_command" ||
+    fail "shared command help differs from the json"
+
+exit 0
@@ -18,23 +18,43 @@
 #define RESET   "\033[0m"
 #define COPENAPI_CONFIG_FILE ".copenapi"
 
+//apispec urls are cached here, under the user's cache dir
+#define COPENAPI_SPEC_CACHE_DIR     "copenapi"
+#define COPENAPI_SPEC_CACHE_SECTION "cache"
+//seconds a cached apispec is used before asking the server again
+#define COPENAPI_SPEC_CACHE_TTL     300
+//limits of an apispec fetch, in seconds. a fetch slower than
+//LOW_SPEED bytes a second for LOW_SPEED_TIME seconds is dropped.
+#define COPENAPI_SPEC_CONNECT_TIMEOUT  10
+#define COPENAPI_SPEC_FETCH_TIMEOUT    120
+#define COPENAPI_SPEC_LOW_SPEED        1
+#define COPENAPI_SPEC_LOW_SPEED_TIME   15
+
 #define COPENAPI_CLI_SHOW_HELP 128
 
 #define ERROR_COPENAPI_CLI_BASE        1000
+#define ERROR_COPENAPI_CLI_SPEC_FETCH  1001
 #define ERROR_COPENAPI_CLI_CURL_BASE   1300
 #define ERROR_COPENAPI_CLI_CURL_END    1400
 
 #define HTTP_OK  200
+#define HTTP_NOT_MODIFIED 304
 
 //cmd line client options
 #define OPT_BASEURL  "baseurl"
 #define OPT_USER     "user"
 #define OPT_APISPEC  "apispec"
+#define OPT_APISPEC_TTL "apispec-ttl"
 #define OPT_VERBOSE  "verbose"
 #define OPT_INSECURE "insecure"
 #define OPT_NETRC    "netrc"
 #define OPT_HELP     "help"
 #define OPT_REQUEST  "request"
+#define OPT_COMPILE  "compile"
+#define OPT_LOAD_STATS "load-stats"
+#define OPT_SHARED_IMAGE "shared-image"
+#define OPT_FOOTPRINT "footprint"
+#define OPT_FOOTPRINT_SORT "footprint-sort"
 
 #define BAIL_ON_CURL_ERROR(dwError) \
     do {                                                           \
@@ -21,8 +21,14 @@ show_util_help(
     printf("usage: copenapi-cli [options] COMMAND [command options]\n");
     printf("\n");
 
-    printf("options    [--apispec - specify path to apispec to load.]\n");
+    printf("options    [--apispec - specify path or http(s) url of apispec to load.]\n");
+    printf("           [--apispec-ttl - seconds a cached apispec url is used before checking it. default 300]\n");
     printf("           [--baseurl - server url including port]\n");
+    printf("           [--compile - compile apispec to a binary image used by later runs]\n");
+    printf("           [--footprint - load apispec in full and print bytes by module, endpoint, method or param]\n");
+    printf("           [--footprint-sort - order of --footprint: total, strings, options, nodes, shared or def]\n");
+    printf("           [--load-stats - load apispec in full and print where the time went]\n");
+    printf("           [--shared-image - map apispec from an image in shared memory made by the first run]\n");
     printf("           [-k --insecure - bypass certificate verification.]\n");
     printf("           [-n --netrc - read user/pass from .netrc file in user's home]\n");
     printf("           [-u --user - user name. prompts for password.]\n");
@@ -82,12 +88,13 @@ show_help(
         }
         else if(nCmdCount == 1)
         {
-            dwError = show_module_commands(pModule);
+            dwError = show_module_commands(pApiDef, pModule);
             BAIL_ON_ERROR(dwError);
         }
         else if(nCmdCount > 1)
         {
             dwError = show_method(
+                          pApiDef,
                           pModule,
                           pArgs->ppszCmds[1]);
             BAIL_ON_ERROR(dwError);
@@ -151,13 +158,14 @@ error:
 
 uint32_t
 show_module_commands(
+    PREST_API_DEF pApiDef,
     PREST_API_MODULE pModule
     )
 {
     uint32_t dwError = 0;
     PREST_API_ENDPOINT pEndPoint = NULL;
 
-    if(!pModule)
+    if(!pApiDef || !pModule)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
@@ -176,6 +184,9 @@ show_module_commands(
             PREST_API_METHOD pMethod = pEndPoint->pMethods[i];
             if(pMethod)
             {
+                dwError = coapi_load_method_details(pApiDef, pMethod);
+                BAIL_ON_ERROR(dwError);
+
                 fprintf(stdout,
                         "%-15s %-75s\n",
                         pEndPoint->pszCommandName,
@@ -260,6 +271,7 @@ error:
 
 uint32_t
 show_method(
+    PREST_API_DEF pApiDef,
     PREST_API_MODULE pModule,
     const char *pszMethod
     )
@@ -269,7 +281,7 @@ show_method(
     PREST_API_ENDPOINT *ppMatchingEndPoints = NULL;
     PREST_API_ENDPOINT *ppEndPoint = NULL;
 
-    if(!pModule || IsNullOrEmptyString(pszMethod))
+    if(!pApiDef || !pModule || IsNullOrEmptyString(pszMethod))
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
@@ -296,6 +308,10 @@ show_method(
             {
                 continue;
             }
+
+            dwError = coapi_load_method_details(pApiDef, pMethod);
+            BAIL_ON_ERROR(dwError);
+
             fprintf(stdout, "Method: %s\n", ppszMethods[nMethodIndex]);
             fprintf(stdout, "Summary : %s\n", pMethod->pszSummary);
             fprintf(stdout, "Description : %s\n", pMethod->pszDescription);
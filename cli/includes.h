@@ -15,14 +15,16 @@
 #pragma once
 
 #include <ctype.h>
+#include <limits.h>
+#include <time.h>
 #include <sys/param.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <pwd.h>
 
 #include "../common/includes.h"
 #include <getopt.h>
 
-#include <jansson.h>
 #include <curl/curl.h>
 
 #include <copenapi.h>
@@ -76,8 +76,14 @@ main(
     PCMD_ARGS pArgs = NULL;
     char **argvDup = NULL;
     char *pszDefaultApiSpec = NULL;
+    char *pszCachedApiSpec = NULL;
     const char *pszApiSpec = NULL;
+    int nApiSpecTtl = -1;
+    int nCurlInit = 0;
     char *pszPass = NULL;
+    COAPI_LOAD_OPTIONS stOptions = {COAPI_LOAD_LAZY_METHODS};
+    COAPI_LOAD_STATS stStats = {0};
+    PCOAPI_FOOTPRINT pFootprint = NULL;
 
     dwError = dup_argv(argc, argv, &argvDup);
     BAIL_ON_ERROR(dwError);
@@ -95,15 +101,100 @@ main(
 
     if(IsNullOrEmptyString(pszApiSpec))
     {
-        dwError = get_default_api_spec(&pszDefaultApiSpec);
+        dwError = get_default_api_spec(&pszDefaultApiSpec, &nApiSpecTtl);
         BAIL_ON_ERROR(dwError);
 
         pszApiSpec = pszDefaultApiSpec;
     }
 
-    dwError = coapi_load_from_file(pszApiSpec, &pApiDef);
+    //a url is loaded from its copy in the disk cache
+    if(is_url_api_spec(pszApiSpec))
+    {
+        if(pArgs->nApiSpecTtl >= 0)
+        {
+            nApiSpecTtl = pArgs->nApiSpecTtl;
+        }
+        else if(nApiSpecTtl < 0)
+        {
+            nApiSpecTtl = COPENAPI_SPEC_CACHE_TTL;
+        }
+
+        dwError = curl_global_init(CURL_GLOBAL_ALL);
+        BAIL_ON_ERROR(dwError);
+        nCurlInit = 1;
+
+        dwError = get_api_spec_from_url(pszApiSpec,
+                                        pArgs,
+                                        nApiSpecTtl,
+                                        &pszCachedApiSpec);
+        BAIL_ON_ERROR(dwError);
+
+        pszApiSpec = pszCachedApiSpec;
+    }
+
+    if(pArgs->nCompile)
+    {
+        dwError = coapi_compile_file(pszApiSpec, NULL);
+        BAIL_ON_ERROR(dwError);
+
+        fprintf(stdout, "compiled %s\n", pszApiSpec);
+        goto cleanup;
+    }
+
+    //every method and param, as a server would load the spec
+    if(pArgs->nLoadStats)
+    {
+        stOptions.dwFlags = COAPI_LOAD_PROFILE;
+        dwError = coapi_load_from_file_ex(pszApiSpec, &stOptions, &pApiDef);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_get_load_stats(pApiDef, &stStats);
+        BAIL_ON_ERROR(dwError);
+
+        fprintf(stdout, "loaded %s\n\n", pszApiSpec);
+        coapi_print_load_stats(&stStats);
+        goto cleanup;
+    }
+
+    if(pArgs->nFootprintLevel != COAPI_FOOTPRINT_LEVEL_COUNT)
+    {
+        stOptions.dwFlags = 0;
+        dwError = coapi_load_from_file_ex(pszApiSpec, &stOptions, &pApiDef);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_get_footprint(pApiDef, &pFootprint);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_sort_footprint(pFootprint, pArgs->nFootprintSort);
+        BAIL_ON_ERROR(dwError);
+
+        fprintf(stdout, "loaded %s\n\n", pszApiSpec);
+        coapi_print_footprint(pFootprint, pArgs->nFootprintLevel);
+        goto cleanup;
+    }
+
+    //a run uses one method at most, read the rest of it when needed.
+    //once a module is named, only its endpoints are needed. a compiled
+    //or shared image is still mapped, less the other endpoints.
+    if(pArgs->nCmdCount > 0)
+    {
+        stOptions.pszModule = pArgs->ppszCmds[0];
+    }
+
+    //runs after the first share one parsed copy of the spec
+    if(pArgs->nSharedImage)
+    {
+        stOptions.dwFlags |= COAPI_LOAD_SHARED_IMAGE;
+    }
+
+    dwError = coapi_load_from_file_ex(pszApiSpec, &stOptions, &pApiDef);
     BAIL_ON_ERROR(dwError);
 
+    if(pArgs->nVerbose && pApiDef->pImage)
+    {
+        fprintf(stdout, "apispec: mapped image of %s\n", pszApiSpec);
+    }
+
     if(argc < 2 || pArgs->nHelp)
     {
         show_help(pArgs, pApiDef);
@@ -142,8 +233,12 @@ main(
         BAIL_ON_ERROR(dwError);
     }
 
-    dwError = curl_global_init(CURL_GLOBAL_ALL);
-    BAIL_ON_ERROR(dwError);
+    if(!nCurlInit)
+    {
+        dwError = curl_global_init(CURL_GLOBAL_ALL);
+        BAIL_ON_ERROR(dwError);
+        nCurlInit = 1;
+    }
 
     dwError = rest_exec(pApiDef, pArgs, pRestCmdArgs);
     BAIL_ON_ERROR(dwError);
@@ -151,7 +246,11 @@ main(
 cleanup:
     SAFE_FREE_MEMORY(pszPass);
     SAFE_FREE_MEMORY(pszDefaultApiSpec);
-    curl_global_cleanup();
+    SAFE_FREE_MEMORY(pszCachedApiSpec);
+    if(nCurlInit)
+    {
+        curl_global_cleanup();
+    }
     if(argvDup)
     {
         coapi_free_string_array_with_count(argvDup, argc);
@@ -164,6 +263,7 @@ cleanup:
     {
         coapi_free_api_def(pApiDef);
     }
+    coapi_free_footprint(pFootprint);
     free_rest_cmd_args(pRestCmdArgs);
     return dwError;
 
@@ -177,6 +277,8 @@ error:
 ".copenapi file should have the following conf file format\n"
 "[default]\n"
 "apispec=/etc/pmd/restapispec.json\n\n"
+"apispec can also be an http(s) url. it is cached and checked again\n"
+"after apispec_ttl seconds, 300 by default.\n\n"
 "Search is done in the following order and stops on first find.\n"
 "--apispec\n"
 ".copenapi in current working directory\n"
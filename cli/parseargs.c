@@ -23,10 +23,16 @@ static struct option _pstMainOptions[] =
     {OPT_VERBOSE,  no_argument, &_main_opt.nVerbose, 'v'},
     {OPT_INSECURE, no_argument, &_main_opt.nInsecure, 'k'},
     {OPT_APISPEC,  required_argument, 0, 'a'},
+    {OPT_APISPEC_TTL, required_argument, 0, 0},
     {OPT_USER,     required_argument, 0, 'u'},
     {OPT_BASEURL,  required_argument, 0, 'b'},
     {OPT_NETRC,    no_argument, &_main_opt.nNetrc, 'n'},
     {OPT_REQUEST,  required_argument, 0, 'X'},
+    {OPT_COMPILE,  no_argument, &_main_opt.nCompile, 1},
+    {OPT_LOAD_STATS, no_argument, &_main_opt.nLoadStats, 1},
+    {OPT_SHARED_IMAGE, no_argument, &_main_opt.nSharedImage, 1},
+    {OPT_FOOTPRINT, required_argument, 0, 0},
+    {OPT_FOOTPRINT_SORT, required_argument, 0, 0},
     {0, 0, 0, 0}
 };
 
@@ -53,6 +59,9 @@ parse_main_args(
                             (void**)&pCmdArgs);
     BAIL_ON_ERROR(dwError);
     pCmdArgs->nRestMethod = METHOD_INVALID;
+    pCmdArgs->nApiSpecTtl = -1;
+    pCmdArgs->nFootprintLevel = COAPI_FOOTPRINT_LEVEL_COUNT;
+    pCmdArgs->nFootprintSort = COAPI_FOOTPRINT_SORT_TOTAL;
 
     opterr = 0;//tell getopt to not print errors
     while (1)
@@ -126,6 +135,9 @@ parse_main_args(
     pCmdArgs->nInsecure = _main_opt.nInsecure;
     pCmdArgs->nVerbose = _main_opt.nVerbose;
     pCmdArgs->nNetrc = _main_opt.nNetrc;
+    pCmdArgs->nCompile = _main_opt.nCompile;
+    pCmdArgs->nLoadStats = _main_opt.nLoadStats;
+    pCmdArgs->nSharedImage = _main_opt.nSharedImage;
     pCmdArgs->nCmdIndex = optind;
 
     dwError = collect_extra_args(optind,
@@ -234,6 +246,11 @@ parse_option(
                       &pCmdArgs->pszApiSpec);
         BAIL_ON_ERROR(dwError);
     }
+    else if(!strcasecmp(pszName, OPT_APISPEC_TTL))
+    {
+        dwError = parse_api_spec_ttl(pszArg, &pCmdArgs->nApiSpecTtl);
+        BAIL_ON_ERROR(dwError);
+    }
     else if(!strcasecmp(pszName, OPT_USER))
     {
         dwError = coapi_allocate_string(
@@ -257,6 +274,26 @@ parse_option(
         }
         BAIL_ON_ERROR(dwError);
     }
+    else if(!strcasecmp(pszName, OPT_FOOTPRINT))
+    {
+        dwError = coapi_get_footprint_level(pszArg,
+                                            &pCmdArgs->nFootprintLevel);
+        if(dwError)
+        {
+            fprintf(stderr, "%s is not a valid footprint level\n", pszArg);
+        }
+        BAIL_ON_ERROR(dwError);
+    }
+    else if(!strcasecmp(pszName, OPT_FOOTPRINT_SORT))
+    {
+        dwError = coapi_get_footprint_sort(pszArg,
+                                           &pCmdArgs->nFootprintSort);
+        if(dwError)
+        {
+            fprintf(stderr, "%s is not a valid footprint sort\n", pszArg);
+        }
+        BAIL_ON_ERROR(dwError);
+    }
 cleanup:
     return dwError;
 
@@ -45,11 +45,13 @@ show_modules(
 
 uint32_t
 show_module_commands(
+    PREST_API_DEF pApiDef,
     PREST_API_MODULE pModule
     );
 
 uint32_t
 show_method(
+    PREST_API_DEF pApiDef,
     PREST_API_MODULE pModule,
     const char *pszMethod
     );
@@ -185,12 +187,93 @@ has_module(
     int *pnHasModule
     );
 
+uint32_t
+get_home_dir(
+    char **ppszDir
+    );
+
+uint32_t
+parse_api_spec_ttl(
+    const char *pszValue,
+    int *pnTtl
+    );
+
+uint32_t
+read_default_config(
+    const char *pszFile,
+    char **ppszApiSpec,
+    int *pnApiSpecTtl
+    );
+
 uint32_t
 get_default_api_spec(
-    char **ppszApiSpec
+    char **ppszApiSpec,
+    int *pnApiSpecTtl
     );
 
 void
 show_error(
     uint32_t dwError
     );
+
+//specfetch.c
+int
+is_url_api_spec(
+    const char *pszApiSpec
+    );
+
+uint32_t
+get_spec_cache_dir(
+    char **ppszDir
+    );
+
+uint32_t
+get_spec_cache_files(
+    const char *pszUrl,
+    char **ppszSpecFile,
+    char **ppszMetaFile
+    );
+
+uint32_t
+read_spec_cache_meta(
+    const char *pszMetaFile,
+    const char *pszUrl,
+    PSPEC_CACHE_META pMeta
+    );
+
+uint32_t
+write_spec_cache_meta(
+    const char *pszMetaFile,
+    const char *pszUrl,
+    PSPEC_CACHE_META pMeta
+    );
+
+void
+free_spec_cache_meta(
+    PSPEC_CACHE_META pMeta
+    );
+
+size_t
+spec_cache_header_cb(
+    char *pszHeader,
+    size_t nSize,
+    size_t nCount,
+    void *pUserData
+    );
+
+uint32_t
+fetch_api_spec(
+    const char *pszUrl,
+    PCMD_ARGS pArgs,
+    const char *pszSpecFile,
+    PSPEC_CACHE_META pMeta,
+    long *pnStatus
+    );
+
+uint32_t
+get_api_spec_from_url(
+    const char *pszUrl,
+    PCMD_ARGS pArgs,
+    int nTtl,
+    char **ppszSpecFile
+    );
@@ -474,6 +474,9 @@ rest_get_method(
         BAIL_ON_ERROR(dwError);
     }
 
+    dwError = coapi_load_method_details(pApiDef, pMethod);
+    BAIL_ON_ERROR(dwError);
+
     *ppMethod = pMethod;
     if(ppEndpoint)
     {
@@ -0,0 +1,653 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//apispec given as a url. The spec is kept in a disk cache under
+//~/.cache/copenapi, named after a hash of the url, with a .meta conf
+//file holding the url, ETag and Last-Modified of the response. The
+//mtime of the .meta file is when the copy was last checked. Within the
+//ttl the copy is used without going to the server. After it the spec
+//is fetched with If-None-Match and If-Modified-Since. A 304 only
+//touches the .meta file, so the cached spec and its images stay as
+//they are. If the server can not be reached, a cached copy is used.
+
+#include "includes.h"
+
+int
+is_url_api_spec(
+    const char *pszApiSpec
+    )
+{
+    return pszApiSpec &&
+           (!strncasecmp(pszApiSpec, "http://", 7) ||
+            !strncasecmp(pszApiSpec, "https://", 8));
+}
+
+//$XDG_CACHE_HOME/copenapi or ~/.cache/copenapi, made if missing
+uint32_t
+get_spec_cache_dir(
+    char **ppszDir
+    )
+{
+    uint32_t dwError = 0;
+    char *pszDir = NULL;
+    char *pszHomeDir = NULL;
+    char *pszCacheHome = NULL;
+    const char *pszXdgCache = getenv("XDG_CACHE_HOME");
+
+    if(!ppszDir)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!IsNullOrEmptyString(pszXdgCache))
+    {
+        dwError = coapi_allocate_string(pszXdgCache, &pszCacheHome);
+        BAIL_ON_ERROR(dwError);
+    }
+    else
+    {
+        dwError = get_home_dir(&pszHomeDir);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_allocate_string_printf(&pszCacheHome,
+                                               "%s/.cache",
+                                               pszHomeDir);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_allocate_string_printf(&pszDir,
+                                           "%s/%s",
+                                           pszCacheHome,
+                                           COPENAPI_SPEC_CACHE_DIR);
+    BAIL_ON_ERROR(dwError);
+
+    if((mkdir(pszCacheHome, 0700) && errno != EEXIST) ||
+       (mkdir(pszDir, 0700) && errno != EEXIST))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppszDir = pszDir;
+
+cleanup:
+    SAFE_FREE_MEMORY(pszHomeDir);
+    SAFE_FREE_MEMORY(pszCacheHome);
+    return dwError;
+
+error:
+    if(ppszDir)
+    {
+        *ppszDir = NULL;
+    }
+    SAFE_FREE_MEMORY(pszDir);
+    goto cleanup;
+}
+
+uint32_t
+get_spec_cache_files(
+    const char *pszUrl,
+    char **ppszSpecFile,
+    char **ppszMetaFile
+    )
+{
+    uint32_t dwError = 0;
+    char *pszDir = NULL;
+    char *pszSpecFile = NULL;
+    char *pszMetaFile = NULL;
+    uint64_t nHash = 14695981039346656037ULL;
+    const char *pszPos = NULL;
+
+    if(IsNullOrEmptyString(pszUrl) || !ppszSpecFile || !ppszMetaFile)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //fnv-1a. the url in the .meta file catches collisions
+    for(pszPos = pszUrl; *pszPos; ++pszPos)
+    {
+        nHash ^= (unsigned char)*pszPos;
+        nHash *= 1099511628211ULL;
+    }
+
+    dwError = get_spec_cache_dir(&pszDir);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_allocate_string_printf(&pszSpecFile,
+                                           "%s/%016llx.json",
+                                           pszDir,
+                                           (unsigned long long)nHash);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_allocate_string_printf(&pszMetaFile,
+                                           "%s.meta",
+                                           pszSpecFile);
+    BAIL_ON_ERROR(dwError);
+
+    *ppszSpecFile = pszSpecFile;
+    *ppszMetaFile = pszMetaFile;
+
+cleanup:
+    SAFE_FREE_MEMORY(pszDir);
+    return dwError;
+
+error:
+    SAFE_FREE_MEMORY(pszSpecFile);
+    SAFE_FREE_MEMORY(pszMetaFile);
+    goto cleanup;
+}
+
+//validators of the cached copy of pszUrl. ENOENT if there is none.
+uint32_t
+read_spec_cache_meta(
+    const char *pszMetaFile,
+    const char *pszUrl,
+    PSPEC_CACHE_META pMeta
+    )
+{
+    uint32_t dwError = 0;
+    PCONF_DATA pData = NULL;
+    PCONF_SECTION pSection = NULL;
+    PKEYVALUE pKeyValue = NULL;
+    int nSameUrl = 0;
+
+    if(IsNullOrEmptyString(pszMetaFile) || !pszUrl || !pMeta)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = read_config_file(pszMetaFile, 0, &pData);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = config_get_section(pData,
+                                 COPENAPI_SPEC_CACHE_SECTION,
+                                 &pSection);
+    BAIL_ON_ERROR(dwError);
+
+    for(pKeyValue = pSection->pKeyValues; pKeyValue;
+        pKeyValue = pKeyValue->pNext)
+    {
+        if(!strcmp(pKeyValue->pszKey, "url"))
+        {
+            nSameUrl = !strcmp(pKeyValue->pszValue, pszUrl);
+        }
+        else if(!strcmp(pKeyValue->pszKey, "etag"))
+        {
+            SAFE_FREE_MEMORY(pMeta->pszETag);
+            dwError = coapi_allocate_string(pKeyValue->pszValue,
+                                            &pMeta->pszETag);
+            BAIL_ON_ERROR(dwError);
+        }
+        else if(!strcmp(pKeyValue->pszKey, "last_modified"))
+        {
+            SAFE_FREE_MEMORY(pMeta->pszLastModified);
+            dwError = coapi_allocate_string(pKeyValue->pszValue,
+                                            &pMeta->pszLastModified);
+            BAIL_ON_ERROR(dwError);
+        }
+    }
+
+    if(!nSameUrl)
+    {
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    free_config_data(pData);
+    return dwError;
+
+error:
+    free_spec_cache_meta(pMeta);
+    goto cleanup;
+}
+
+//written aside and renamed. the new mtime marks the copy as checked.
+uint32_t
+write_spec_cache_meta(
+    const char *pszMetaFile,
+    const char *pszUrl,
+    PSPEC_CACHE_META pMeta
+    )
+{
+    uint32_t dwError = 0;
+    char *pszTempFile = NULL;
+    int fd = -1;
+    FILE *fp = NULL;
+
+    dwError = coapi_allocate_string_printf(&pszTempFile,
+                                           "%s.XXXXXX",
+                                           pszMetaFile);
+    BAIL_ON_ERROR(dwError);
+
+    fd = mkstemp(pszTempFile);
+    if(fd < 0)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    fp = fdopen(fd, "w");
+    if(!fp)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+    fd = -1;
+
+    fprintf(fp, "[%s]\nurl=%s\n", COPENAPI_SPEC_CACHE_SECTION, pszUrl);
+    //empty values do not read back
+    if(!IsNullOrEmptyString(pMeta->pszETag))
+    {
+        fprintf(fp, "etag=%s\n", pMeta->pszETag);
+    }
+    if(!IsNullOrEmptyString(pMeta->pszLastModified))
+    {
+        fprintf(fp, "last_modified=%s\n", pMeta->pszLastModified);
+    }
+
+    if(fclose(fp))
+    {
+        fp = NULL;
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+    fp = NULL;
+
+    if(rename(pszTempFile, pszMetaFile))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    SAFE_FREE_MEMORY(pszTempFile);
+    return dwError;
+
+error:
+    if(fp)
+    {
+        fclose(fp);
+    }
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+    if(pszTempFile)
+    {
+        unlink(pszTempFile);
+    }
+    goto cleanup;
+}
+
+void
+free_spec_cache_meta(
+    PSPEC_CACHE_META pMeta
+    )
+{
+    if(pMeta)
+    {
+        SAFE_FREE_MEMORY(pMeta->pszETag);
+        SAFE_FREE_MEMORY(pMeta->pszLastModified);
+        pMeta->pszETag = NULL;
+        pMeta->pszLastModified = NULL;
+    }
+}
+
+//keeps the validators of the last response. redirects start over.
+size_t
+spec_cache_header_cb(
+    char *pszHeader,
+    size_t nSize,
+    size_t nCount,
+    void *pUserData
+    )
+{
+    PSPEC_CACHE_META pMeta = pUserData;
+    size_t nLength = nSize * nCount;
+    const char *pszValue = NULL;
+    const char *pszEnd = pszHeader + nLength;
+    char **ppszField = NULL;
+
+    if(nLength > 5 && !strncmp(pszHeader, "HTTP/", 5))
+    {
+        free_spec_cache_meta(pMeta);
+    }
+    else if(nLength > 5 && !strncasecmp(pszHeader, "ETag:", 5))
+    {
+        ppszField = &pMeta->pszETag;
+        pszValue = pszHeader + 5;
+    }
+    else if(nLength > 14 && !strncasecmp(pszHeader, "Last-Modified:", 14))
+    {
+        ppszField = &pMeta->pszLastModified;
+        pszValue = pszHeader + 14;
+    }
+
+    if(ppszField)
+    {
+        for(; pszValue < pszEnd && isspace((unsigned char)*pszValue);
+            ++pszValue);
+        for(; pszEnd > pszValue && isspace((unsigned char)pszEnd[-1]);
+            --pszEnd);
+
+        SAFE_FREE_MEMORY(*ppszField);
+        *ppszField = strndup(pszValue, pszEnd - pszValue);
+        if(!*ppszField)
+        {
+            return 0;
+        }
+    }
+    return nLength;
+}
+
+//conditional get of pszUrl. a 200 replaces pszSpecFile and pMeta,
+//a 304 leaves both. *pnStatus has the http status, also when it fails
+//the fetch. errors are left to the caller to show, it may have a
+//cached copy to use instead.
+uint32_t
+fetch_api_spec(
+    const char *pszUrl,
+    PCMD_ARGS pArgs,
+    const char *pszSpecFile,
+    PSPEC_CACHE_META pMeta,
+    long *pnStatus
+    )
+{
+    uint32_t dwError = 0;
+    CURL *pCurl = NULL;
+    struct curl_slist *pHeaders = NULL;
+    struct curl_slist *pTemp = NULL;
+    SPEC_CACHE_META stResponse = {0};
+    char *pszTempFile = NULL;
+    char *pszHeader = NULL;
+    int fd = -1;
+    FILE *fp = NULL;
+    long nStatus = 0;
+
+    dwError = coapi_allocate_string_printf(&pszTempFile,
+                                           "%s.XXXXXX",
+                                           pszSpecFile);
+    BAIL_ON_ERROR(dwError);
+
+    fd = mkstemp(pszTempFile);
+    if(fd < 0)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    fp = fdopen(fd, "w");
+    if(!fp)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+    fd = -1;
+
+    if(!IsNullOrEmptyString(pMeta->pszETag))
+    {
+        dwError = coapi_allocate_string_printf(&pszHeader,
+                                               "If-None-Match: %s",
+                                               pMeta->pszETag);
+        BAIL_ON_ERROR(dwError);
+
+        pTemp = curl_slist_append(pHeaders, pszHeader);
+        SAFE_FREE_MEMORY(pszHeader);
+        pszHeader = NULL;
+        if(!pTemp)
+        {
+            dwError = ENOMEM;
+            BAIL_ON_ERROR(dwError);
+        }
+        pHeaders = pTemp;
+    }
+    if(!IsNullOrEmptyString(pMeta->pszLastModified))
+    {
+        dwError = coapi_allocate_string_printf(&pszHeader,
+                                               "If-Modified-Since: %s",
+                                               pMeta->pszLastModified);
+        BAIL_ON_ERROR(dwError);
+
+        pTemp = curl_slist_append(pHeaders, pszHeader);
+        if(!pTemp)
+        {
+            dwError = ENOMEM;
+            BAIL_ON_ERROR(dwError);
+        }
+        pHeaders = pTemp;
+    }
+
+    pCurl = curl_easy_init();
+    if(!pCurl)
+    {
+        dwError = ENOMEM;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pArgs->nInsecure)
+    {
+        dwError = curl_easy_setopt(pCurl, CURLOPT_SSL_VERIFYHOST, 0L);
+        BAIL_ON_CURL_ERROR(dwError);
+        dwError = curl_easy_setopt(pCurl, CURLOPT_SSL_VERIFYPEER, 0L);
+        BAIL_ON_CURL_ERROR(dwError);
+    }
+
+    dwError = curl_easy_setopt(pCurl, CURLOPT_FOLLOWLOCATION, 1L);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    //a server that stops answering fails the fetch like any other
+    //error, so a cached copy is used
+    dwError = curl_easy_setopt(pCurl,
+                               CURLOPT_CONNECTTIMEOUT,
+                               (long)COPENAPI_SPEC_CONNECT_TIMEOUT);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    dwError = curl_easy_setopt(pCurl,
+                               CURLOPT_TIMEOUT,
+                               (long)COPENAPI_SPEC_FETCH_TIMEOUT);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    dwError = curl_easy_setopt(pCurl,
+                               CURLOPT_LOW_SPEED_LIMIT,
+                               (long)COPENAPI_SPEC_LOW_SPEED);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    dwError = curl_easy_setopt(pCurl,
+                               CURLOPT_LOW_SPEED_TIME,
+                               (long)COPENAPI_SPEC_LOW_SPEED_TIME);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    dwError = curl_easy_setopt(pCurl, CURLOPT_URL, pszUrl);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    dwError = curl_easy_setopt(pCurl, CURLOPT_HTTPHEADER, pHeaders);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    dwError = curl_easy_setopt(pCurl,
+                               CURLOPT_HEADERFUNCTION,
+                               spec_cache_header_cb);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    dwError = curl_easy_setopt(pCurl, CURLOPT_HEADERDATA, &stResponse);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    dwError = curl_easy_setopt(pCurl, CURLOPT_WRITEDATA, fp);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    dwError = curl_easy_perform(pCurl);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    dwError = curl_easy_getinfo(pCurl, CURLINFO_RESPONSE_CODE, &nStatus);
+    BAIL_ON_CURL_ERROR(dwError);
+
+    *pnStatus = nStatus;
+
+    if(fclose(fp))
+    {
+        fp = NULL;
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+    fp = NULL;
+
+    if(nStatus == HTTP_OK)
+    {
+        if(chmod(pszTempFile, 0644) ||
+           rename(pszTempFile, pszSpecFile))
+        {
+            dwError = errno;
+            BAIL_ON_ERROR(dwError);
+        }
+        free_spec_cache_meta(pMeta);
+        *pMeta = stResponse;
+        memset(&stResponse, 0, sizeof(stResponse));
+    }
+    else if(nStatus != HTTP_NOT_MODIFIED)
+    {
+        dwError = ERROR_COPENAPI_CLI_SPEC_FETCH;
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    if(pCurl)
+    {
+        curl_easy_cleanup(pCurl);
+    }
+    curl_slist_free_all(pHeaders);
+    free_spec_cache_meta(&stResponse);
+    if(fp)
+    {
+        fclose(fp);
+    }
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+    if(pszTempFile)
+    {
+        //gone already if it became the spec
+        unlink(pszTempFile);
+    }
+    SAFE_FREE_MEMORY(pszTempFile);
+    SAFE_FREE_MEMORY(pszHeader);
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//the local file to load for the spec at pszUrl. the server is asked
+//at most once every nTtl seconds.
+uint32_t
+get_api_spec_from_url(
+    const char *pszUrl,
+    PCMD_ARGS pArgs,
+    int nTtl,
+    char **ppszSpecFile
+    )
+{
+    uint32_t dwError = 0;
+    char *pszSpecFile = NULL;
+    char *pszMetaFile = NULL;
+    SPEC_CACHE_META stMeta = {0};
+    struct stat stMetaFile = {0};
+    int nHaveCopy = 0;
+    long nStatus = 0;
+    uint32_t dwFetchError = 0;
+
+    if(!is_url_api_spec(pszUrl) || !pArgs || !ppszSpecFile)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = get_spec_cache_files(pszUrl, &pszSpecFile, &pszMetaFile);
+    BAIL_ON_ERROR(dwError);
+
+    nHaveCopy = !stat(pszMetaFile, &stMetaFile) &&
+                !access(pszSpecFile, R_OK) &&
+                !read_spec_cache_meta(pszMetaFile, pszUrl, &stMeta);
+
+    if(nHaveCopy && time(NULL) - stMetaFile.st_mtime < nTtl)
+    {
+        if(pArgs->nVerbose)
+        {
+            fprintf(stdout, "apispec: cached %s\n", pszSpecFile);
+        }
+    }
+    else if((dwFetchError = fetch_api_spec(pszUrl,
+                                           pArgs,
+                                           pszSpecFile,
+                                           &stMeta,
+                                           &nStatus)))
+    {
+        //the copy is used as it is, the failed check is only a note
+        if(nHaveCopy)
+        {
+            fprintf(stderr,
+                    "warning: could not check apispec %s, "
+                    "using cached copy\n",
+                    pszUrl);
+        }
+        else
+        {
+            if(dwFetchError == ERROR_COPENAPI_CLI_SPEC_FETCH && nStatus)
+            {
+                fprintf(stderr,
+                        "Error: server returned %ld for apispec %s\n",
+                        nStatus,
+                        pszUrl);
+            }
+            else
+            {
+                show_error(dwFetchError);
+            }
+            dwError = ERROR_COPENAPI_CLI_SPEC_FETCH;
+            BAIL_ON_ERROR(dwError);
+        }
+    }
+    else
+    {
+        dwError = write_spec_cache_meta(pszMetaFile, pszUrl, &stMeta);
+        BAIL_ON_ERROR(dwError);
+
+        if(pArgs->nVerbose)
+        {
+            fprintf(stdout,
+                    "apispec: %s %s\n",
+                    nStatus == HTTP_OK ? "fetched" : "not modified",
+                    pszSpecFile);
+        }
+    }
+
+    *ppszSpecFile = pszSpecFile;
+    pszSpecFile = NULL;
+
+cleanup:
+    free_spec_cache_meta(&stMeta);
+    SAFE_FREE_MEMORY(pszSpecFile);
+    SAFE_FREE_MEMORY(pszMetaFile);
+    return dwError;
+
+error:
+    if(ppszSpecFile)
+    {
+        *ppszSpecFile = NULL;
+    }
+    goto cleanup;
+}
@@ -65,9 +65,18 @@ typedef struct _REST_CMD_ARGS_
     PREST_CMD_PARAM pParams;
 }REST_CMD_ARGS, *PREST_CMD_ARGS;
 
+//validators of a cached apispec, see specfetch.c
+typedef struct _SPEC_CACHE_META_
+{
+    char *pszETag;
+    char *pszLastModified;
+}SPEC_CACHE_META, *PSPEC_CACHE_META;
+
 typedef struct _CMD_ARGS_
 {
     char *pszApiSpec;
+    //seconds, -1 if not given
+    int nApiSpecTtl;
     char *pszBaseUrl;
     char *pszUser;
     char *pszDomain;
@@ -78,6 +87,12 @@ typedef struct _CMD_ARGS_
     int nVerbose;
     int nInsecure;
     int nNetrc;
+    int nCompile;
+    int nLoadStats;
+    int nSharedImage;
+    //level of --footprint, COAPI_FOOTPRINT_LEVEL_COUNT if not given
+    COAPI_FOOTPRINT_LEVEL nFootprintLevel;
+    COAPI_FOOTPRINT_SORT nFootprintSort;
     int nCmdIndex;
     RESTMETHOD nRestMethod;
     char **ppszCmds;
@@ -53,19 +53,57 @@ error:
     goto cleanup;
 }
 
+//seconds a cached apispec url is used without asking the server
+uint32_t
+parse_api_spec_ttl(
+    const char *pszValue,
+    int *pnTtl
+    )
+{
+    uint32_t dwError = 0;
+    char *pszEnd = NULL;
+    long nTtl = 0;
+
+    if(IsNullOrEmptyString(pszValue) || !pnTtl)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    errno = 0;
+    nTtl = strtol(pszValue, &pszEnd, 10);
+    if(errno || *pszEnd || nTtl < 0 || nTtl > INT_MAX)
+    {
+        fprintf(stderr, "%s is not a valid apispec ttl\n", pszValue);
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *pnTtl = nTtl;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//*pnApiSpecTtl is -1 if the config has no apispec_ttl
 uint32_t
 read_default_config(
     const char *pszFile,
-    char **ppszApiSpec
+    char **ppszApiSpec,
+    int *pnApiSpecTtl
     )
 {
     uint32_t dwError = 0;
     char *pszApiSpec = NULL;
+    int nApiSpecTtl = -1;
     PCONF_DATA pData = NULL;
     PCONF_SECTION pSection = NULL;
     PKEYVALUE pKeyValues = NULL;
 
-    if(IsNullOrEmptyString(pszFile) || !ppszApiSpec)
+    if(IsNullOrEmptyString(pszFile) || !ppszApiSpec || !pnApiSpecTtl)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
@@ -87,9 +125,15 @@ read_default_config(
                           &pszApiSpec);
             BAIL_ON_ERROR(dwError);
         }
+        else if(!strcmp(pKeyValues->pszKey, "apispec_ttl"))
+        {
+            dwError = parse_api_spec_ttl(pKeyValues->pszValue, &nApiSpecTtl);
+            BAIL_ON_ERROR(dwError);
+        }
     }
 
     *ppszApiSpec = pszApiSpec;
+    *pnApiSpecTtl = nApiSpecTtl;
 
 cleanup:
     free_config_data(pData);
@@ -151,7 +195,8 @@ error:
 
 uint32_t
 get_default_api_spec(
-    char **ppszApiSpec
+    char **ppszApiSpec,
+    int *pnApiSpecTtl
     )
 {
     uint32_t dwError = 0;
@@ -160,7 +205,7 @@ get_default_api_spec(
     char *pszConfig = NULL;
     char *pszHomeDir = NULL;
 
-    if(!ppszApiSpec)
+    if(!ppszApiSpec || !pnApiSpecTtl)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
@@ -209,7 +254,7 @@ get_default_api_spec(
         }
     }
 
-    dwError = read_default_config(pszConfig, &pszApiSpec);
+    dwError = read_default_config(pszConfig, &pszApiSpec, pnApiSpecTtl);
     BAIL_ON_ERROR(dwError);
 
     *ppszApiSpec = pszApiSpec;
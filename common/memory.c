@@ -36,6 +36,38 @@ error:
     goto cleanup;
 }
 
+uint32_t
+coapi_reallocate_memory(
+    void* pMemory,
+    size_t size,
+    void** ppNewMemory
+    )
+{
+    uint32_t dwError = 0;
+    void* pNewMemory = NULL;
+
+    if (!ppNewMemory || !size)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pNewMemory = realloc(pMemory, size);
+    if (!pNewMemory)
+    {
+        dwError = ENOMEM;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppNewMemory = pNewMemory;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
 void
 coapi_free_memory(
     void* pMemory
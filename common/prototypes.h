@@ -7,6 +7,13 @@ coapi_allocate_memory(
     void** ppMemory
     );
 
+uint32_t
+coapi_reallocate_memory(
+    void* pMemory,
+    size_t size,
+    void** ppNewMemory
+    );
+
 void
 coapi_free_memory(
     void* pMemory
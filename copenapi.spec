@@ -8,9 +8,7 @@ Distribution:  Photon
 License:       Apache 2.0
 URL:           https://www.github.com/vmware/copenapi
 BuildArch:     x86_64
-Requires:      jansson
 Requires:      curl
-BuildRequires: jansson-devel
 BuildRequires: curl-devel
 Source0:       %{name}-%{version}.tar.gz
 %define sha1 copenapi=0cfd79271ec3639129a36c4a5c3375cca8c54f32
@@ -0,0 +1,141 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Loads an apispec with the simd json scans and with
+//COAPI_LOAD_SCALAR_JSON and prints how fast each reads the spec text.
+//Parse time is the root and paths phases of the load stats, reading
+//the file is left out. Each load is run the given number of times and
+//the fastest counts. Both loads must give the same def.
+//usage: bench_json_scan [-n rounds] apispec.json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <copenapi.h>
+
+static uint32_t
+time_load(
+    const char *pszFile,
+    uint32_t dwFlags,
+    int nRounds,
+    uint64_t *pnBest,
+    size_t *pnParams
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_LOAD_OPTIONS stOptions = {dwFlags};
+    COAPI_LOAD_STATS stStats = {0};
+    PREST_API_DEF pApiDef = NULL;
+    uint64_t nParse = 0;
+    int i = 0;
+
+    *pnBest = UINT64_MAX;
+    for(i = 0; i < nRounds; ++i)
+    {
+        dwError = coapi_load_from_file_ex(pszFile, &stOptions, &pApiDef);
+        if(dwError)
+        {
+            return dwError;
+        }
+        coapi_get_load_stats(pApiDef, &stStats);
+        coapi_free_api_def(pApiDef);
+
+        nParse = stStats.stRoot.nNanoseconds +
+                 stStats.stEndPoints.nNanoseconds;
+        if(nParse < *pnBest)
+        {
+            *pnBest = nParse;
+        }
+        *pnParams = stStats.nParams;
+    }
+    return 0;
+}
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+    int dwError = 0;
+    struct stat stFile = {0};
+    uint64_t nSimd = 0;
+    uint64_t nScalar = 0;
+    size_t nSimdParams = 0;
+    size_t nScalarParams = 0;
+    int nRounds = 5;
+    int nFirst = 1;
+
+    if(argc > 2 && !strcmp(argv[1], "-n"))
+    {
+        nRounds = atoi(argv[2]);
+        nFirst = 3;
+    }
+    if(argc - nFirst != 1 || nRounds < 1)
+    {
+        fprintf(stderr, "usage: bench_json_scan [-n rounds] apispec.json\n");
+        return 1;
+    }
+
+    if(stat(argv[nFirst], &stFile))
+    {
+        fprintf(stderr, "could not stat %s\n", argv[nFirst]);
+        return 1;
+    }
+
+    //loads of the same kind in a row, so that caches are warm for both
+    dwError = time_load(argv[nFirst], 0, nRounds, &nSimd, &nSimdParams);
+    if(dwError)
+    {
+        goto error;
+    }
+
+    dwError = time_load(argv[nFirst],
+                        COAPI_LOAD_SCALAR_JSON,
+                        nRounds,
+                        &nScalar,
+                        &nScalarParams);
+    if(dwError)
+    {
+        goto error;
+    }
+
+    fprintf(stdout,
+            "%s: %lld bytes\n",
+            argv[nFirst],
+            (long long)stFile.st_size);
+    fprintf(stdout,
+            "simd   : %8.3f ms %6.2f GB/s\n",
+            nSimd / 1000000.0,
+            (double)stFile.st_size / nSimd);
+    fprintf(stdout,
+            "scalar : %8.3f ms %6.2f GB/s\n",
+            nScalar / 1000000.0,
+            (double)stFile.st_size / nScalar);
+
+    if(nSimdParams != nScalarParams)
+    {
+        fprintf(stdout, "loads differ\n");
+        dwError = 1;
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    fprintf(stdout, "Error: %d\n", dwError);
+    goto cleanup;
+}
@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License.  You may obtain a copy
+# of the License at http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, without
+# warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+# License for the specific language governing permissions and limitations
+# under the License.
+#
+
+#runs the examples that exit non zero on a failed check against a
+#generated spec. run by make check in the examples build directory.
+#scale_api_def fails on timing and is left to be run by hand.
+
+set -e
+
+spec=check_examples.json
+trap 'rm -f $spec' EXIT
+
+#paths spread over a few tags, each with a path param, a param of its
+#own per method and a shared $ref param
+awk -v paths=2000 -v tags=5 'BEGIN {
+    printf "{\"swagger\":\"2.0\",\"host\":\"localhost\",\"basePath\":\"/v1\","
+    printf "\"tags\":["
+    for(t = 0; t < tags; ++t)
+        printf "%s{\"name\":\"tag%d\",\"description\":\"tag %d\"}",
+               t ? "," : "", t, t
+    printf "],\"paths\":{"
+    for(p = 0; p < paths; ++p)
+    {
+        printf "%s\"/items%d/{id}\":{", p ? "," : "", p
+        printf "\"parameters\":[{\"name\":\"id\",\"in\":\"path\","
+        printf "\"required\":true,\"type\":\"string\"}],"
+        printf "\"get\":{\"tags\":[\"tag%d\"],", p % tags
+        printf "\"summary\":\"get %d\",", p
+        printf "\"parameters\":[{\"$ref\":\"#/parameters/limit\"},"
+        printf "{\"name\":\"q%d\",\"in\":\"query\",", p
+        printf "\"type\":\"string\",\"enum\":[\"a\",\"b\\\\u00e9\"]}]},"
+        printf "\"put\":{\"tags\":[\"tag%d\"],", p % tags
+        printf "\"description\":\"put\\\\n%d\",", p
+        printf "\"parameters\":[{\"name\":\"body\",\"in\":\"body\","
+        printf "\"required\":true,\"schema\":{\"type\":\"object\"}}]}}"
+    }
+    printf "},\"parameters\":{\"limit\":{\"name\":\"limit\",\"in\":\"query\","
+    printf "\"type\":\"integer\"}}}\n"
+}' > $spec
+
+./write_api_def $spec
+./write_api_def ${srcdir:-.}/../tests/test.json
+./bench_json_scan -n 3 $spec
@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Starts a background load for every apispec given and waits for them
+//the way a service would after the rest of its startup. Loads still
+//running after the time limit are cancelled.
+//usage: load_async [-t ms] apispec.json...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <copenapi.h>
+
+static double
+now_ms(
+    void
+    )
+{
+    struct timespec stNow = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return stNow.tv_sec * 1000.0 + stNow.tv_nsec / 1000000.0;
+}
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+    int dwError = 0;
+    PCOAPI_LOAD_TASK *ppTasks = NULL;
+    PREST_API_DEF pApiDef = NULL;
+    int nTimeoutMs = -1;
+    int nWaitMs = -1;
+    int nFirst = 1;
+    int nCount = 0;
+    int i = 0;
+    size_t nEndPoints = 0;
+    double dStart = 0;
+
+    if(argc > 2 && !strcmp(argv[1], "-t"))
+    {
+        nTimeoutMs = atoi(argv[2]);
+        nFirst = 3;
+    }
+    nCount = argc - nFirst;
+    if(nCount < 1)
+    {
+        fprintf(stderr, "usage: load_async [-t ms] apispec.json...\n");
+        return 1;
+    }
+
+    ppTasks = calloc(nCount, sizeof(PCOAPI_LOAD_TASK));
+    if(!ppTasks)
+    {
+        return 1;
+    }
+
+    dStart = now_ms();
+    for(i = 0; i < nCount; ++i)
+    {
+        dwError = coapi_load_from_file_async(argv[nFirst + i],
+                                             NULL,
+                                             NULL,
+                                             NULL,
+                                             &ppTasks[i]);
+        if(dwError)
+        {
+            goto error;
+        }
+    }
+    fprintf(stdout, "started %d loads in %.3f ms\n", nCount, now_ms() - dStart);
+
+    //the rest of the startup would run here
+    for(i = 0; i < nCount; ++i)
+    {
+        //the limit is for all loads together
+        if(nTimeoutMs >= 0)
+        {
+            nWaitMs = nTimeoutMs - (int)(now_ms() - dStart);
+            nWaitMs = nWaitMs < 0 ? 0 : nWaitMs;
+        }
+        dwError = coapi_load_task_wait(ppTasks[i], nWaitMs, &pApiDef);
+        if(dwError == ETIMEDOUT)
+        {
+            coapi_load_task_cancel(ppTasks[i]);
+            dwError = coapi_load_task_wait(ppTasks[i], -1, &pApiDef);
+        }
+        if(dwError)
+        {
+            fprintf(stdout, "%s: error %d\n", argv[nFirst + i], dwError);
+            dwError = 0;
+            continue;
+        }
+
+        coapi_get_endpoint_count(pApiDef, &nEndPoints);
+        fprintf(stdout,
+                "%s: %zu endpoints at %.3f ms\n",
+                argv[nFirst + i],
+                nEndPoints,
+                now_ms() - dStart);
+        coapi_free_api_def(pApiDef);
+        pApiDef = NULL;
+    }
+
+cleanup:
+    for(i = 0; ppTasks && i < nCount; ++i)
+    {
+        coapi_load_task_free(ppTasks[i]);
+    }
+    free(ppTasks);
+    return dwError;
+
+error:
+    fprintf(stdout, "Error: %d\n", dwError);
+    goto cleanup;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Loads several apispecs into one def and lists its modules with their
+//endpoints. Each spec is given as name=file and its modules are listed
+//under that name.
+//usage: load_federation name=apispec.json...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <copenapi.h>
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+    int dwError = 0;
+    PCOAPI_FEDERATED_SPEC pSpecs = NULL;
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_MODULE pModule = NULL;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    COAPI_LOAD_STATS stStats = {0};
+    char *pszFile = NULL;
+    int nCount = argc - 1;
+    int nEndPoints = 0;
+    int i = 0;
+
+    if(nCount < 1)
+    {
+        fprintf(stderr, "usage: load_federation name=apispec.json...\n");
+        return 1;
+    }
+
+    pSpecs = calloc(nCount, sizeof(COAPI_FEDERATED_SPEC));
+    if(!pSpecs)
+    {
+        return 1;
+    }
+
+    for(i = 0; i < nCount; ++i)
+    {
+        pszFile = strchr(argv[i + 1], '=');
+        if(!pszFile)
+        {
+            fprintf(stderr, "%s is not name=apispec.json\n", argv[i + 1]);
+            dwError = 1;
+            goto cleanup;
+        }
+        *pszFile++ = '\0';
+        pSpecs[i].pszName = argv[i + 1];
+        pSpecs[i].pszFile = pszFile;
+    }
+
+    dwError = coapi_load_federation(pSpecs, nCount, NULL, &pApiDef);
+    if(dwError)
+    {
+        goto error;
+    }
+
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        nEndPoints = 0;
+        for(pEndPoint = pModule->pEndPoints;
+            pEndPoint;
+            pEndPoint = pEndPoint->pNext)
+        {
+            ++nEndPoints;
+        }
+        fprintf(stdout, "%-30s %d endpoints\n", pModule->pszName, nEndPoints);
+    }
+
+    coapi_get_load_stats(pApiDef, &stStats);
+    fprintf(stdout,
+            "\n%zu endpoints, %zu params, %zu shared\n",
+            stStats.nEndPoints,
+            stStats.nParams,
+            stStats.nSharedParams);
+
+cleanup:
+    coapi_free_api_def(pApiDef);
+    free(pSpecs);
+    return dwError;
+
+error:
+    fprintf(stdout, "Error: %d\n", dwError);
+    goto cleanup;
+}
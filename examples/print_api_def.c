@@ -13,10 +13,13 @@
  */
 
 //Illustrates loading of an apispec from file and performing a
-//print out of the apis
+//print out of the apis. Given a level, one of module, endpoint, method
+//or param, the bytes of each of them are printed instead, ordered by
+//total, strings, options, nodes, shared or def.
+//print_api_def [apispec.json [level [order]]]
 
 #include <stdio.h>
-#include <copenapi/copenapi.h>
+#include <copenapi.h>
 
 int
 main(
@@ -26,16 +29,59 @@ main(
 {
     int dwError = 0;
     PREST_API_DEF pApiDef = NULL;
+    PCOAPI_FOOTPRINT pFootprint = NULL;
+    const char *pszFile = "../tests/test.json";
+    COAPI_FOOTPRINT_LEVEL nLevel = COAPI_FOOTPRINT_MODULE;
+    COAPI_FOOTPRINT_SORT nSort = COAPI_FOOTPRINT_SORT_TOTAL;
 
-    dwError = coapi_load_from_file("../tests/test.json", &pApiDef);
+    if(argc > 1)
+    {
+        pszFile = argv[1];
+    }
+
+    dwError = coapi_load_from_file(pszFile, &pApiDef);
+    if(dwError)
+    {
+        goto error;
+    }
+
+    if(argc < 3)
+    {
+        coapi_print_api_def(pApiDef);
+        goto cleanup;
+    }
+
+    dwError = coapi_get_footprint_level(argv[2], &nLevel);
+    if(dwError)
+    {
+        goto error;
+    }
+
+    if(argc > 3)
+    {
+        dwError = coapi_get_footprint_sort(argv[3], &nSort);
+        if(dwError)
+        {
+            goto error;
+        }
+    }
+
+    dwError = coapi_get_footprint(pApiDef, &pFootprint);
+    if(dwError)
+    {
+        goto error;
+    }
+
+    dwError = coapi_sort_footprint(pFootprint, nSort);
     if(dwError)
     {
         goto error;
     }
 
-    coapi_print_api_def(pApiDef);
+    coapi_print_footprint(pFootprint, nLevel);
 
 cleanup:
+    coapi_free_footprint(pFootprint);
     coapi_free_api_def(pApiDef);
     return dwError;
 
@@ -0,0 +1,178 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Loads generated specs of 1k, 10k and 100k paths and checks that load
+//time grows linearly with the number of paths. The specs have no tags,
+//so every path goes to the default module, and each method has its own
+//params plus the params of its path.
+//Exits with 1 if ten times the paths take more than ten times as long,
+//with a margin for timer noise. This is a benchmark for an otherwise
+//idle machine and is not run by make check.
+//usage: scale_api_def [max paths]
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <copenapi.h>
+
+//allowed growth of the per path time from one size to the next
+#define SCALE_MARGIN 2.5
+#define SCALE_ROUNDS 3
+
+static double
+now_ms(
+    void
+    )
+{
+    struct timespec stNow = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return stNow.tv_sec * 1000.0 + stNow.tv_nsec / 1000000.0;
+}
+
+static int
+make_spec(
+    size_t nPaths,
+    char **ppszSpec,
+    size_t *pnLength
+    )
+{
+    FILE *fp = NULL;
+    size_t i = 0;
+
+    fp = open_memstream(ppszSpec, pnLength);
+    if(!fp)
+    {
+        return 1;
+    }
+
+    fprintf(fp, "{\"swagger\":\"2.0\",\"host\":\"localhost\","
+                "\"basePath\":\"/v1\",\"paths\":{");
+    for(i = 0; i < nPaths; ++i)
+    {
+        fprintf(fp,
+                "%s\"/items%zu/{id}\":{"
+                "\"parameters\":[{\"name\":\"id\",\"in\":\"path\","
+                "\"required\":true,\"type\":\"string\"}],"
+                "\"get\":{\"summary\":\"get item %zu\",\"parameters\":["
+                "{\"name\":\"limit\",\"in\":\"query\",\"type\":\"integer\"},"
+                "{\"name\":\"state\",\"in\":\"query\",\"type\":\"string\","
+                "\"enum\":[\"on\",\"off\"]}]},"
+                "\"put\":{\"summary\":\"set item %zu\",\"parameters\":["
+                "{\"name\":\"body\",\"in\":\"body\",\"required\":true}]}}",
+                i ? "," : "",
+                i,
+                i,
+                i);
+    }
+    fprintf(fp, "}}");
+
+    return fclose(fp) != 0;
+}
+
+static int
+time_load(
+    size_t nPaths,
+    double *pdMs
+    )
+{
+    int dwError = 0;
+    PREST_API_DEF pApiDef = NULL;
+    char *pszSpec = NULL;
+    size_t nLength = 0;
+    double dBest = 0;
+    double dStart = 0;
+    int i = 0;
+
+    dwError = make_spec(nPaths, &pszSpec, &nLength);
+    if(dwError)
+    {
+        goto cleanup;
+    }
+
+    for(i = 0; i < SCALE_ROUNDS; ++i)
+    {
+        dStart = now_ms();
+        dwError = coapi_load_from_string_ex(pszSpec, nLength, NULL, &pApiDef);
+        if(dwError)
+        {
+            goto cleanup;
+        }
+        dStart = now_ms() - dStart;
+        if(!i || dStart < dBest)
+        {
+            dBest = dStart;
+        }
+        coapi_free_api_def(pApiDef);
+        pApiDef = NULL;
+    }
+
+    *pdMs = dBest;
+
+cleanup:
+    free(pszSpec);
+    return dwError;
+}
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+    int dwError = 0;
+    size_t nMaxPaths = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t nPaths = 0;
+    double dMs = 0;
+    double dLastMs = 0;
+    int nSuperLinear = 0;
+
+    for(nPaths = 1000; nPaths <= nMaxPaths; nPaths *= 10)
+    {
+        dwError = time_load(nPaths, &dMs);
+        if(dwError)
+        {
+            goto error;
+        }
+
+        fprintf(stdout,
+                "%7zu paths: %10.2f ms, %6.3f us per path",
+                nPaths,
+                dMs,
+                dMs * 1000 / nPaths);
+        if(dLastMs > 0)
+        {
+            fprintf(stdout, ", x%.1f", dMs / dLastMs);
+            if(dMs > dLastMs * 10 * SCALE_MARGIN)
+            {
+                fprintf(stdout, " super-linear");
+                nSuperLinear = 1;
+            }
+        }
+        fprintf(stdout, "\n");
+        dLastMs = dMs;
+    }
+
+cleanup:
+    return dwError ? dwError : nSuperLinear;
+
+error:
+    fprintf(stdout, "Error: %d\n", dwError);
+    goto cleanup;
+}
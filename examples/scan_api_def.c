@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Times full scans of an apispec two ways: walking the module, endpoint
+//and param lists, and going through the count/get by index api.
+//It also looks up every endpoint by name, once by walking the lists the
+//way coapi_find_method used to and once with coapi_find_method.
+//usage: scan_api_def [apispec.json] [rounds]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <strings.h>
+#include <time.h>
+#include <copenapi.h>
+
+static double
+now_ms(
+    void
+    )
+{
+    struct timespec stNow = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return stNow.tv_sec * 1000.0 + stNow.tv_nsec / 1000000.0;
+}
+
+static size_t
+scan_lists(
+    PREST_API_DEF pApiDef
+    )
+{
+    PREST_API_MODULE pModule = NULL;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    PREST_API_PARAM pParam = NULL;
+    size_t nRequired = 0;
+    int i = 0;
+
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        for(pEndPoint = pModule->pEndPoints;
+            pEndPoint;
+            pEndPoint = pEndPoint->pNext)
+        {
+            for(i = 0; i < METHOD_COUNT; ++i)
+            {
+                if(!pEndPoint->pMethods[i])
+                {
+                    continue;
+                }
+                for(pParam = pEndPoint->pMethods[i]->pParams;
+                    pParam;
+                    pParam = pParam->pNext)
+                {
+                    nRequired += pParam->nRequired != 0;
+                }
+            }
+        }
+    }
+    return nRequired;
+}
+
+static size_t
+scan_index(
+    PREST_API_DEF pApiDef
+    )
+{
+    PREST_API_PARAM pParam = NULL;
+    size_t nMethods = 0;
+    size_t nParams = 0;
+    size_t nRequired = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    coapi_get_method_count(pApiDef, &nMethods);
+    for(i = 0; i < nMethods; ++i)
+    {
+        coapi_get_param_count(pApiDef, i, &nParams);
+        for(j = 0; j < nParams; ++j)
+        {
+            coapi_get_param(pApiDef, i, j, &pParam);
+            nRequired += pParam->nRequired != 0;
+        }
+    }
+    return nRequired;
+}
+
+static PREST_API_METHOD
+find_in_lists(
+    PREST_API_DEF pApiDef,
+    const char *pszEndPoint,
+    RESTMETHOD nMethod
+    )
+{
+    PREST_API_MODULE pModule = NULL;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        if(!coapi_find_endpoint_by_name(pszEndPoint,
+                                        pModule->pEndPoints,
+                                        &pEndPoint))
+        {
+            return pEndPoint->pMethods[nMethod];
+        }
+    }
+    return NULL;
+}
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+    int dwError = 0;
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    PREST_API_METHOD pMethod = NULL;
+    const char *pszFile = argc > 1 ? argv[1] : "../tests/test.json";
+    int nRounds = argc > 2 ? atoi(argv[2]) : 10;
+    size_t nEndPoints = 0;
+    size_t nFound = 0;
+    size_t nRequired = 0;
+    size_t i = 0;
+    int nRound = 0;
+    int nMethod = 0;
+    double dStart = 0;
+
+    dwError = coapi_load_from_file(pszFile, &pApiDef);
+    if(dwError)
+    {
+        goto error;
+    }
+
+    coapi_get_endpoint_count(pApiDef, &nEndPoints);
+
+    dStart = now_ms();
+    for(nRound = 0; nRound < nRounds; ++nRound)
+    {
+        nRequired = scan_lists(pApiDef);
+    }
+    fprintf(stdout,
+            "param scan, lists : %8.3f ms (%zu required)\n",
+            (now_ms() - dStart) / nRounds,
+            nRequired);
+
+    dStart = now_ms();
+    for(nRound = 0; nRound < nRounds; ++nRound)
+    {
+        nRequired = scan_index(pApiDef);
+    }
+    fprintf(stdout,
+            "param scan, index : %8.3f ms (%zu required)\n",
+            (now_ms() - dStart) / nRounds,
+            nRequired);
+
+    //every endpoint by the name it is registered with
+    dStart = now_ms();
+    for(i = 0, nFound = 0; i < nEndPoints; ++i)
+    {
+        coapi_get_endpoint(pApiDef, i, &pEndPoint);
+        for(nMethod = 0; nMethod < METHOD_COUNT; ++nMethod)
+        {
+            if(pEndPoint->pMethods[nMethod])
+            {
+                break;
+            }
+        }
+        if(nMethod == METHOD_COUNT)
+        {
+            continue;
+        }
+        nFound += find_in_lists(pApiDef, pEndPoint->pszName, nMethod) != NULL;
+    }
+    fprintf(stdout,
+            "lookups, lists    : %8.3f ms (%zu of %zu found)\n",
+            now_ms() - dStart,
+            nFound,
+            nEndPoints);
+
+    dStart = now_ms();
+    for(i = 0, nFound = 0; i < nEndPoints; ++i)
+    {
+        coapi_get_endpoint(pApiDef, i, &pEndPoint);
+        for(nMethod = 0; nMethod < METHOD_COUNT; ++nMethod)
+        {
+            if(pEndPoint->pMethods[nMethod])
+            {
+                break;
+            }
+        }
+        if(nMethod == METHOD_COUNT)
+        {
+            continue;
+        }
+        nFound += !coapi_find_method(pApiDef,
+                                     pEndPoint->pszName,
+                                     pEndPoint->pMethods[nMethod]->pszMethod,
+                                     &pMethod);
+    }
+    fprintf(stdout,
+            "lookups, index    : %8.3f ms (%zu of %zu found)\n",
+            now_ms() - dStart,
+            nFound,
+            nEndPoints);
+
+cleanup:
+    coapi_free_api_def(pApiDef);
+    return dwError;
+
+error:
+    fprintf(stdout, "Error: %d\n", dwError);
+    goto cleanup;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Writes a loaded apispec back out as json, times the writer and checks
+//that the output loads to a def that writes out the same again. The
+//output goes to out.json if given.
+//usage: write_api_def [-n rounds] apispec.json [out.json]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <copenapi.h>
+
+static double
+now_ms(
+    void
+    )
+{
+    struct timespec stNow = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return stNow.tv_sec * 1000.0 + stNow.tv_nsec / 1000000.0;
+}
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+    int dwError = 0;
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_DEF pReloaded = NULL;
+    char *pszJson = NULL;
+    char *pszReloaded = NULL;
+    size_t nLength = 0;
+    size_t nReloaded = 0;
+    char szTemp[] = "/tmp/write_api_def.XXXXXX";
+    const char *pszOut = NULL;
+    int nRounds = 10;
+    int nFirst = 1;
+    int fd = -1;
+    int i = 0;
+    double dStart = 0;
+    double dElapsed = 0;
+
+    if(argc > 2 && !strcmp(argv[1], "-n"))
+    {
+        nRounds = atoi(argv[2]);
+        nFirst = 3;
+    }
+    if(argc - nFirst < 1 || argc - nFirst > 2 || nRounds < 1)
+    {
+        fprintf(stderr,
+                "usage: write_api_def [-n rounds] apispec.json [out.json]\n");
+        return 1;
+    }
+
+    dwError = coapi_load_from_file(argv[nFirst], &pApiDef);
+    if(dwError)
+    {
+        goto error;
+    }
+
+    dStart = now_ms();
+    for(i = 0; i < nRounds; ++i)
+    {
+        free(pszJson);
+        pszJson = NULL;
+        dwError = coapi_write_api_def_to_string(pApiDef, &pszJson, &nLength);
+        if(dwError)
+        {
+            goto error;
+        }
+    }
+    dElapsed = (now_ms() - dStart) / nRounds;
+    fprintf(stdout,
+            "wrote %zu bytes in %.3f ms, %.1f MB/s\n",
+            nLength,
+            dElapsed,
+            dElapsed > 0 ? nLength / dElapsed / 1000.0 : 0);
+
+    if(argc - nFirst == 2)
+    {
+        pszOut = argv[nFirst + 1];
+        fd = open(pszOut, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    else
+    {
+        pszOut = szTemp;
+        fd = mkstemp(szTemp);
+    }
+    if(fd < 0)
+    {
+        dwError = 1;
+        goto error;
+    }
+
+    dwError = coapi_write_api_def(pApiDef, fd);
+    if(dwError)
+    {
+        goto error;
+    }
+    close(fd);
+    fd = -1;
+
+    dwError = coapi_load_from_file(pszOut, &pReloaded);
+    if(dwError)
+    {
+        goto error;
+    }
+
+    dwError = coapi_write_api_def_to_string(pReloaded,
+                                            &pszReloaded,
+                                            &nReloaded);
+    if(dwError)
+    {
+        goto error;
+    }
+
+    if(nReloaded != nLength || memcmp(pszReloaded, pszJson, nLength))
+    {
+        fprintf(stdout, "round trip differs\n");
+        dwError = 1;
+        goto cleanup;
+    }
+    fprintf(stdout, "round trip ok\n");
+
+cleanup:
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+    if(pszOut == szTemp)
+    {
+        unlink(szTemp);
+    }
+    free(pszJson);
+    free(pszReloaded);
+    coapi_free_api_def(pApiDef);
+    coapi_free_api_def(pReloaded);
+    return dwError;
+
+error:
+    fprintf(stdout, "Error: %d\n", dwError);
+    goto cleanup;
+}
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <stdint.h> //for uint32_t
+#include <stddef.h> //for size_t
 #include "copenapitypes.h"
 
 uint32_t
@@ -29,6 +30,124 @@ coapi_load_from_file(
     PREST_API_DEF *ppApiDef
     );
 
+//nLength is the length of pszString, which need not be terminated.
+//COAPI_LOAD_BORROW_STRINGS and COAPI_LOAD_LAZY_METHODS are for files only.
+uint32_t
+coapi_load_from_string_ex(
+    const char *pszString,
+    size_t nLength,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PREST_API_DEF *ppApiDef
+    );
+
+//the spec file is mapped and read in place. pOptions can be NULL.
+//a current .coapi image of the file is mapped instead, see
+//COAPI_LOAD_OPTIONS.
+uint32_t
+coapi_load_from_file_ex(
+    const char *pszFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PREST_API_DEF *ppApiDef
+    );
+
+//compile the json spec in pszFile to a binary image that
+//coapi_load_from_file maps instead of parsing the json.
+//pszImageFile defaults to pszFile with a .coapi suffix
+uint32_t
+coapi_compile_file(
+    const char *pszFile,
+    const char *pszImageFile
+    );
+
+//reads summary, description and params of a method loaded with
+//COAPI_LOAD_LAZY_METHODS. no op for methods that have them already.
+//coapi_find_method does this for the method it returns.
+//threads sharing a def can call this at the same time. with
+//COAPI_LOAD_BORROW_STRINGS a method that fails keeps failing with the
+//same error, as its text was partly decoded in place.
+uint32_t
+coapi_load_method_details(
+    PREST_API_DEF pApiDef,
+    PREST_API_METHOD pMethod
+    );
+
+//methods with equal params share the nodes of their param lists.
+//call this before changing the params of a method to give it a copy.
+//it can run while other threads read details of other methods, but
+//no thread may use the params of pMethod meanwhile. EINVAL for a def
+//put together by the caller, whose params the library does not share.
+uint32_t
+coapi_unshare_method_params(
+    PREST_API_DEF pApiDef,
+    PREST_API_METHOD pMethod
+    );
+
+//counts, time and allocations of the load that made pApiDef
+uint32_t
+coapi_get_load_stats(
+    PREST_API_DEF pApiDef,
+    PCOAPI_LOAD_STATS pStats
+    );
+
+void
+coapi_print_load_stats(
+    PCOAPI_LOAD_STATS pStats
+    );
+
+//endpoints, methods and params by index. endpoints are in module order
+//and methods in endpoint order, in the order of RESTMETHOD within an
+//endpoint. nMethod is the index of a method in the whole def.
+uint32_t
+coapi_get_endpoint_count(
+    PREST_API_DEF pApiDef,
+    size_t *pnCount
+    );
+
+uint32_t
+coapi_get_endpoint(
+    PREST_API_DEF pApiDef,
+    size_t nIndex,
+    PREST_API_ENDPOINT *ppEndPoint
+    );
+
+//methods of endpoint nEndPoint are *pnFirst up to *pnFirst + *pnCount
+uint32_t
+coapi_get_endpoint_methods(
+    PREST_API_DEF pApiDef,
+    size_t nEndPoint,
+    size_t *pnFirst,
+    size_t *pnCount
+    );
+
+uint32_t
+coapi_get_method_count(
+    PREST_API_DEF pApiDef,
+    size_t *pnCount
+    );
+
+uint32_t
+coapi_get_method(
+    PREST_API_DEF pApiDef,
+    size_t nIndex,
+    PREST_API_METHOD *ppMethod
+    );
+
+//with COAPI_LOAD_LAZY_METHODS these read the details of the method
+uint32_t
+coapi_get_param_count(
+    PREST_API_DEF pApiDef,
+    size_t nMethod,
+    size_t *pnCount
+    );
+
+uint32_t
+coapi_get_param(
+    PREST_API_DEF pApiDef,
+    size_t nMethod,
+    size_t nIndex,
+    PREST_API_PARAM *ppParam
+    );
+
 uint32_t
 coapi_find_module_by_name(
     const char *pszName,
@@ -92,6 +211,12 @@ coapi_get_rest_type(
     RESTPARAMTYPE *pnType
     );
 
+uint32_t
+coapi_get_rest_param_in(
+    const char *pszIn,
+    RESTPARAMIN *pnIn
+    );
+
 uint32_t
 coapi_get_rest_method_string(
     RESTMETHOD nMethod,
@@ -116,11 +241,171 @@ coapi_map_module_impl(
     PREST_MODULE pModuleImpl
     );
 
+//loads pszFile, maps it with pRegMap and reloads it in the background
+//whenever the file changes. COAPI_LOAD_LAZY_METHODS is not allowed.
+uint32_t
+coapi_api_handle_open(
+    const char *pszFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PMODULE_REG_MAP pRegMap,
+    PCOAPI_API_HANDLE *ppHandle
+    );
+
+//the current def, valid until the matching release. never blocks.
+uint32_t
+coapi_api_handle_acquire(
+    PCOAPI_API_HANDLE pHandle,
+    PREST_API_DEF *ppApiDef,
+    int *pnSlot
+    );
+
+void
+coapi_api_handle_release(
+    PCOAPI_API_HANDLE pHandle,
+    int nSlot
+    );
+
+//reloads now. on error the current def is kept. this waits for every
+//reader of the old def to release it, so a thread that holds an
+//acquire of pHandle must release it first or it waits forever.
+uint32_t
+coapi_api_handle_reload(
+    PCOAPI_API_HANDLE pHandle
+    );
+
+void
+coapi_api_handle_close(
+    PCOAPI_API_HANDLE pHandle
+    );
+
+//loads nSpecCount spec files into one def. strings and params equal
+//across specs are stored once. modules are named <spec>.<tag>, or
+//<spec> for a spec without tags. host, basePath and schemes of the def
+//are those of the first spec, endpoint names keep each spec's basePath.
+//lookups search all specs and find the first spec's endpoint when two
+//specs have the same path. pOptions can be NULL. pszModule,
+//COAPI_LOAD_BORROW_STRINGS and COAPI_LOAD_LAZY_METHODS are not
+//supported and give EINVAL.
+uint32_t
+coapi_load_federation(
+    PCOAPI_FEDERATED_SPEC pSpecs,
+    size_t nSpecCount,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PREST_API_DEF *ppApiDef
+    );
+
+//loads pszFile like coapi_load_from_file_ex on a new thread and returns
+//at once. pfnDone can be NULL, the def is then taken with
+//coapi_load_task_wait. every task is freed with coapi_load_task_free.
+uint32_t
+coapi_load_from_file_async(
+    const char *pszFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PFN_COAPI_LOAD_DONE pfnDone,
+    void *pUserData,
+    PCOAPI_LOAD_TASK *ppTask
+    );
+
+//readable once the load and its callback are done, for poll loops
+int
+coapi_load_task_get_fd(
+    PCOAPI_LOAD_TASK pTask
+    );
+
+//waits up to nTimeoutMs, -1 for no limit, and returns the error of the
+//load or ETIMEDOUT. the first wait after a load without a callback
+//takes the def. ppApiDef can be NULL.
+uint32_t
+coapi_load_task_wait(
+    PCOAPI_LOAD_TASK pTask,
+    int nTimeoutMs,
+    PREST_API_DEF *ppApiDef
+    );
+
+//stops the load at the next path. it ends with ECANCELED unless it was
+//done already.
+void
+coapi_load_task_cancel(
+    PCOAPI_LOAD_TASK pTask
+    );
+
+//waits for the load and frees the task with a def no one took. called
+//from the task's callback, the task is freed once the callback returns.
+//*ppTask of coapi_load_from_file_async is set before the callback runs.
+void
+coapi_load_task_free(
+    PCOAPI_LOAD_TASK pTask
+    );
+
 void
 coapi_print_api_def(
     PREST_API_DEF pApiDef
     );
 
+//bytes of every module, endpoint, method and param of a loaded def,
+//by strings, enum options and nodes. entries are in def order, every
+//module followed by its endpoints, an endpoint by its params and
+//methods and a method by its params. methods not read yet with
+//COAPI_LOAD_LAZY_METHODS have no params. free with coapi_free_footprint.
+uint32_t
+coapi_get_footprint(
+    PREST_API_DEF pApiDef,
+    PCOAPI_FOOTPRINT *ppFootprint
+    );
+
+uint32_t
+coapi_sort_footprint(
+    PCOAPI_FOOTPRINT pFootprint,
+    COAPI_FOOTPRINT_SORT nSort
+    );
+
+//module, endpoint, method or param
+uint32_t
+coapi_get_footprint_level(
+    const char *pszLevel,
+    COAPI_FOOTPRINT_LEVEL *pnLevel
+    );
+
+//def, total, strings, options, nodes or shared
+uint32_t
+coapi_get_footprint_sort(
+    const char *pszSort,
+    COAPI_FOOTPRINT_SORT *pnSort
+    );
+
+//totals and one line for every entry of nLevel, in the current order
+void
+coapi_print_footprint(
+    PCOAPI_FOOTPRINT pFootprint,
+    COAPI_FOOTPRINT_LEVEL nLevel
+    );
+
+void
+coapi_free_footprint(
+    PCOAPI_FOOTPRINT pFootprint
+    );
+
+//writes the def to fd as a swagger json spec that loads to the same
+//def. only what the loader keeps is written. paths are relative to
+//the basePath of the def. methods not read yet with
+//COAPI_LOAD_LAZY_METHODS are read first.
+uint32_t
+coapi_write_api_def(
+    PREST_API_DEF pApiDef,
+    int fd
+    );
+
+//like coapi_write_api_def into a string. free *ppszJson with free.
+uint32_t
+coapi_write_api_def_to_string(
+    PREST_API_DEF pApiDef,
+    char **ppszJson,
+    size_t *pnLength
+    );
+
+//a def put together by the caller has pArena and pImage NULL. its
+//nodes and strings are freed one by one, and path level params of an
+//endpoint once, even where methods' params end with them.
 void
 coapi_free_api_def(
     PREST_API_DEF pApiDef
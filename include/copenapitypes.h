@@ -36,6 +36,16 @@ typedef enum _RESTPARAMTYPE_
     RESTPARAM_INVALID
 }RESTPARAMTYPE;
 
+typedef enum _RESTPARAMIN_
+{
+    RESTPARAMIN_PATH = 0,
+    RESTPARAMIN_QUERY,
+    RESTPARAMIN_HEADER,
+    RESTPARAMIN_BODY,
+    RESTPARAMIN_FORMDATA,
+    RESTPARAMIN_INVALID
+}RESTPARAMIN;
+
 typedef uint32_t
 (*PFN_MODULE_ENDPOINT_CB)(
      void *pIn,
@@ -71,6 +81,8 @@ typedef struct _REST_API_PARAM_
     char **ppszOptions;
 
     struct _REST_API_PARAM_ *pNext;
+    //pszIn as an enum, RESTPARAMIN_INVALID for unknown locations
+    RESTPARAMIN nIn;
 }REST_API_PARAM, *PREST_API_PARAM;
 
 typedef struct _REST_API_METHOD_
@@ -81,6 +93,9 @@ typedef struct _REST_API_METHOD_
     char *pszDescription;
     PREST_API_PARAM pParams;
     PFN_MODULE_ENDPOINT_CB pFnImpl;
+    //with COAPI_LOAD_LAZY_METHODS, the method object in the spec.
+    //NULL once summary, description and params are loaded.
+    const char *pszDetails;
 }REST_API_METHOD, *PREST_API_METHOD;
 
 typedef struct _REST_API_ENDPOINT_
@@ -91,6 +106,8 @@ typedef struct _REST_API_ENDPOINT_
     char *pszCommandName;
     PREST_API_METHOD pMethods[METHOD_COUNT];
     struct _REST_API_ENDPOINT_ *pNext;
+    //path level params. every method's params end with this list.
+    PREST_API_PARAM pParams;
 }REST_API_ENDPOINT, *PREST_API_ENDPOINT;
 
 typedef struct _REST_API_MODULE_
@@ -102,6 +119,120 @@ typedef struct _REST_API_MODULE_
     struct _REST_API_MODULE_ *pNext;
 }REST_API_MODULE, *PREST_API_MODULE;
 
+//owns the nodes and strings of a loaded definition
+typedef struct _COAPI_ARENA_ *PCOAPI_ARENA;
+
+//endpoints, methods and params of a def in arrays, see apitable.c
+typedef struct _COAPI_API_TABLE_ *PCOAPI_API_TABLE;
+
+//one phase of a load. allocations are from the arena of the def,
+//including params that are dropped once they are shared.
+typedef struct _COAPI_LOAD_PHASE_
+{
+    uint64_t nNanoseconds;
+    size_t nAllocations;
+    size_t nAllocatedBytes;
+}COAPI_LOAD_PHASE, *PCOAPI_LOAD_PHASE;
+
+//filled in by the loader, see coapi_get_load_stats
+typedef struct _COAPI_LOAD_STATS_
+{
+    //param nodes and enum option arrays that were equal to ones
+    //already loaded and are shared instead of allocated
+    size_t nSharedParams;
+    size_t nSharedParamBytes;
+    //modules, endpoints and methods of the def. params and enum
+    //options as read from the spec, $ref targets once. defs mapped
+    //from an image read no params.
+    size_t nModules;
+    size_t nEndPoints;
+    size_t nMethods;
+    size_t nParams;
+    size_t nOptions;
+    //mapping and decompressing the file, or mapping the image
+    COAPI_LOAD_PHASE stRead;
+    //the root object except paths
+    COAPI_LOAD_PHASE stRoot;
+    //tags, part of stRoot
+    COAPI_LOAD_PHASE stModules;
+    //paths with their methods
+    COAPI_LOAD_PHASE stEndPoints;
+    //parameter lists and the path names made from them, both part of
+    //stEndPoints. only with COAPI_LOAD_PROFILE. with
+    //COAPI_LOAD_PARALLEL these add up the threads.
+    COAPI_LOAD_PHASE stParams;
+    COAPI_LOAD_PHASE stPathNames;
+    //the arrays of coapi_build_api_table
+    COAPI_LOAD_PHASE stIndex;
+}COAPI_LOAD_STATS, *PCOAPI_LOAD_STATS;
+
+//what a part of a def is, see coapi_get_footprint
+typedef enum _COAPI_FOOTPRINT_LEVEL_
+{
+    COAPI_FOOTPRINT_MODULE = 0,
+    COAPI_FOOTPRINT_ENDPOINT,
+    COAPI_FOOTPRINT_METHOD,
+    COAPI_FOOTPRINT_PARAM,
+    COAPI_FOOTPRINT_LEVEL_COUNT
+}COAPI_FOOTPRINT_LEVEL;
+
+//order of the entries of a footprint. bytes sort largest first.
+typedef enum _COAPI_FOOTPRINT_SORT_
+{
+    //modules, endpoints, methods and params as they are in the def
+    COAPI_FOOTPRINT_SORT_DEF = 0,
+    COAPI_FOOTPRINT_SORT_TOTAL,
+    COAPI_FOOTPRINT_SORT_STRINGS,
+    COAPI_FOOTPRINT_SORT_OPTIONS,
+    COAPI_FOOTPRINT_SORT_NODES,
+    COAPI_FOOTPRINT_SORT_SHARED,
+    COAPI_FOOTPRINT_SORT_INVALID
+}COAPI_FOOTPRINT_SORT;
+
+//bytes of one module, endpoint, method or param, including the parts
+//below it. a node or string is counted for the first entry that has it
+//and is shared bytes for the entries after. params of an endpoint are
+//its own and not those of its methods.
+typedef struct _COAPI_FOOTPRINT_ENTRY_
+{
+    COAPI_FOOTPRINT_LEVEL nLevel;
+    //position in def order
+    size_t nIndex;
+    //names of the entry and of the ones it is part of, NULL below its
+    //level. pszMethod is NULL for params of an endpoint.
+    const char *pszModule;
+    const char *pszEndPoint;
+    const char *pszMethod;
+    const char *pszParam;
+    //names, paths, summaries and descriptions
+    size_t nStringBytes;
+    //enum option arrays and their values
+    size_t nOptionBytes;
+    //module, endpoint, method and param structs
+    size_t nNodeBytes;
+    size_t nSharedBytes;
+}COAPI_FOOTPRINT_ENTRY, *PCOAPI_FOOTPRINT_ENTRY;
+
+//names point into the def, which must outlive the footprint
+typedef struct _COAPI_FOOTPRINT_
+{
+    PCOAPI_FOOTPRINT_ENTRY pEntries;
+    size_t nEntryCount;
+    //the def struct with its host and base path
+    size_t nDefBytes;
+    //the arrays of the lookup table
+    size_t nIndexBytes;
+    //strings read in place from a spec loaded with
+    //COAPI_LOAD_BORROW_STRINGS. these are not allocated.
+    size_t nBorrowedBytes;
+    //def, index and modules
+    size_t nTotalBytes;
+    //what the arena of the def allocated, params that were dropped for
+    //shared ones included. the size of the image for mapped defs.
+    size_t nArenaBytes;
+    size_t nImageBytes;
+}COAPI_FOOTPRINT, *PCOAPI_FOOTPRINT;
+
 typedef struct _REST_API_DEF_
 {
     int nNoModules;
@@ -109,4 +240,84 @@ typedef struct _REST_API_DEF_
     char *pszHost;
     char *pszBasePath;
     PREST_API_MODULE pModules;
+    //set when this definition lives in a mapped compiled image
+    void *pImage;
+    size_t nImageSize;
+    //mapped spec that borrowed strings point into
+    void *pSource;
+    size_t nSourceSize;
+    //$ref targets in pSource, for method details read later
+    const char *pszRefParameters;
+    const char *pszRefDefinitions;
+    PCOAPI_ARENA pArena;
+    //index over the lists above for lookups and the count/get api
+    PCOAPI_API_TABLE pTable;
+    uint32_t dwLoadFlags;
+    COAPI_LOAD_STATS stStats;
 }REST_API_DEF, *PREST_API_DEF;
+
+typedef enum _COAPI_LOAD_FLAGS_
+{
+    //names and values point into the mapped spec file instead of being
+    //copied. the mapping stays until the definition is freed.
+    COAPI_LOAD_BORROW_STRINGS = 0x1,
+    //only paths, methods and tags are read at load. summary, description
+    //and params of a method are read by coapi_load_method_details.
+    COAPI_LOAD_LAZY_METHODS = 0x2,
+    //paths are split across dwThreads threads. endpoints end up in the
+    //same order as a serial load.
+    COAPI_LOAD_PARALLEL = 0x4,
+    //summaries and descriptions of methods and modules are not read.
+    //enough for coapi_map_api_impl and dispatch, not for help output.
+    COAPI_LOAD_NO_DOCS = 0x8,
+    //stParams and stPathNames of the load stats are measured. this
+    //reads the clock twice for every param list and path.
+    COAPI_LOAD_PROFILE = 0x10,
+    //the def is mapped from a compiled image in shared memory. the
+    //first load of a spec publishes the image, later loads in any
+    //process map the same pages instead of parsing. see
+    //COAPI_LOAD_OPTIONS for what other flags do with an image.
+    COAPI_LOAD_SHARED_IMAGE = 0x20,
+    //the json reader looks at a byte at a time instead of using simd
+    //scans. the def is the same, this is for comparing the two.
+    COAPI_LOAD_SCALAR_JSON = 0x40
+}COAPI_LOAD_FLAGS;
+
+//a def mapped from a compiled image has every method with its details,
+//and its strings are in the mapping, which stays until the def is
+//freed. COAPI_LOAD_NO_DOCS, COAPI_LOAD_LAZY_METHODS and
+//COAPI_LOAD_BORROW_STRINGS ask for less or the same, and an image
+//gives the def as it is. for pszModule the whole image is mapped and
+//the endpoints of the other modules are left out of the def.
+typedef struct _COAPI_LOAD_OPTIONS_
+{
+    uint32_t dwFlags;
+    //if set, only endpoints of this module (tag) are loaded. all modules
+    //are still listed.
+    const char *pszModule;
+    //threads for COAPI_LOAD_PARALLEL, 0 for one per online cpu
+    uint32_t dwThreads;
+}COAPI_LOAD_OPTIONS, *PCOAPI_LOAD_OPTIONS;
+
+//one spec of a federation, see coapi_load_federation
+typedef struct _COAPI_FEDERATED_SPEC_
+{
+    //prefix of the spec's module names, unique in the federation
+    const char *pszName;
+    const char *pszFile;
+}COAPI_FEDERATED_SPEC, *PCOAPI_FEDERATED_SPEC;
+
+//reloadable api def, see coapi_api_handle_open
+typedef struct _COAPI_API_HANDLE_ *PCOAPI_API_HANDLE;
+
+//load running on a thread of its own, see coapi_load_from_file_async
+typedef struct _COAPI_LOAD_TASK_ *PCOAPI_LOAD_TASK;
+
+//called on the load thread when an async load ends. pApiDef belongs to
+//the callback and is NULL on error.
+typedef void
+(*PFN_COAPI_LOAD_DONE)(
+    void *pUserData,
+    uint32_t dwError,
+    PREST_API_DEF pApiDef
+    );
@@ -21,62 +21,59 @@ coapi_load_from_string(
     )
 {
     uint32_t dwError = 0;
-    json_t *pRoot = NULL;
-    PREST_API_DEF pApiDef = NULL;
 
-    if(!pszString)
+    if(IsNullOrEmptyString(pszString) || !ppApiDef)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
-    
-    dwError = get_json_object_from_string(pszString, &pRoot);
-    BAIL_ON_ERROR(dwError);
 
-    dwError = coapi_allocate_memory(sizeof(REST_API_DEF), (void **)&pApiDef);
+    dwError = coapi_load_from_string_ex(
+                  pszString,
+                  strlen(pszString),
+                  NULL,
+                  ppApiDef);
     BAIL_ON_ERROR(dwError);
 
-    dwError = coapi_load_secure_scheme(pRoot, &pApiDef->nHasSecureScheme);
-    //default to https if not specified
-    if(dwError == ENODATA)
-    {
-        dwError = 0;
-        pApiDef->nHasSecureScheme = 1;
-    }
-    BAIL_ON_ERROR(dwError);
+cleanup:
+    return dwError;
 
-    dwError = json_get_string_value(pRoot, "host", &pApiDef->pszHost);
-    BAIL_ON_ERROR(dwError);
+error:
+    goto cleanup;
+}
 
-    dwError = json_get_string_value(pRoot, "basePath", &pApiDef->pszBasePath);
-    BAIL_ON_ERROR(dwError);
+uint32_t
+coapi_load_from_string_ex(
+    const char *pszString,
+    size_t nLength,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PREST_API_DEF *ppApiDef
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_DEF pApiDef = NULL;
 
-    dwError = coapi_load_modules(pRoot, &pApiDef->pModules);
-    if(dwError == ENODATA)
+    if(!pszString || !nLength || !ppApiDef)
     {
-        dwError = coapi_add_default_module(
-                      pApiDef->pszBasePath,
-                      &pApiDef->pModules);
+        dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
-
-        pApiDef->nNoModules = 1;
     }
 
-    BAIL_ON_ERROR(dwError);
+    //borrowed strings and lazy methods need a mapping the def can own
+    if(pOptions && (pOptions->dwFlags & COAPI_LOAD_KEEP_SOURCE))
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
 
-    dwError = coapi_load_endpoints(pRoot, pApiDef->pszBasePath, pApiDef->pModules);
+    dwError = coapi_load_api_def(pszString, nLength, pOptions, NULL, &pApiDef);
     BAIL_ON_ERROR(dwError);
 
     *ppApiDef = pApiDef;
 cleanup:
-    if(pRoot)
-    {
-        json_decref(pRoot);
-    }
     return dwError;
 
 error:
-    SAFE_FREE_MEMORY(pApiDef);
     goto cleanup;
 }
 
@@ -85,10 +82,36 @@ coapi_load_from_file(
     const char *pszFile,
     PREST_API_DEF *ppApiDef
     )
+{
+    return coapi_load_from_file_ex(pszFile, NULL, ppApiDef);
+}
+
+uint32_t
+coapi_load_from_file_ex(
+    const char *pszFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PREST_API_DEF *ppApiDef
+    )
+{
+    return coapi_load_file(pszFile, pOptions, NULL, ppApiDef);
+}
+
+//the load stops with ECANCELED once *pnCancel is set, which can be NULL
+uint32_t
+coapi_load_file(
+    const char *pszFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    const int *pnCancel,
+    PREST_API_DEF *ppApiDef
+    )
 {
     uint32_t dwError = 0;
     char *pszJson = NULL;
+    size_t nLength = 0;
+    uint32_t dwFlags = pOptions ? pOptions->dwFlags : 0;
     PREST_API_DEF pApiDef = NULL;
+    COAPI_LOAD_PHASE stMark = {0};
+    COAPI_LOAD_PHASE stRead = {0};
 
     if(!pszFile || !ppApiDef)
     {
@@ -96,19 +119,87 @@ coapi_load_from_file(
         BAIL_ON_ERROR(dwError);
     }
 
-    dwError = coapi_file_read_all_text(pszFile, &pszJson);
+    //a current compiled image, or the shared one if asked for, is
+    //mapped instead of parsing the json. any problem with the images
+    //falls back to the json spec. images are whole specs, a load of
+    //one module maps the image and drops the other endpoints.
+    coapi_load_phase_begin(NULL, &stMark);
+    dwError = coapi_image_load_for_file(pszFile, &pApiDef);
+    if(dwError && (dwFlags & COAPI_LOAD_SHARED_IMAGE))
+    {
+        dwError = coapi_image_load_shared(pszFile,
+                                          pOptions,
+                                          pnCancel,
+                                          &pApiDef);
+        if(dwError == ECANCELED)
+        {
+            BAIL_ON_ERROR(dwError);
+        }
+    }
+    if(!dwError)
+    {
+        PCOAPI_LOAD_STATS pStats = &pApiDef->stStats;
+
+        //the image has the stats of the load that compiled it, the
+        //stats of this load start from zero
+        memset(pStats, 0, sizeof(*pStats));
+
+        if(pOptions && pOptions->pszModule)
+        {
+            dwError = coapi_image_filter_module(pApiDef, pOptions->pszModule);
+            BAIL_ON_ERROR(dwError);
+        }
+        coapi_load_phase_end(NULL, &stMark, &pStats->stRead);
+
+        coapi_load_phase_begin(NULL, &stMark);
+        dwError = coapi_build_api_table(pApiDef);
+        BAIL_ON_ERROR(dwError);
+        coapi_load_phase_end(NULL, &stMark, &pStats->stIndex);
+
+        //the table is all the image def allocates
+        pStats->stIndex.nAllocations = pApiDef->pArena->nAllocations;
+        pStats->stIndex.nAllocatedBytes = pApiDef->pArena->nAllocatedBytes;
+
+        dwError = coapi_count_api_def(pApiDef, pStats);
+        BAIL_ON_ERROR(dwError);
+
+        *ppApiDef = pApiDef;
+        goto cleanup;
+    }
+
+    //a failed image lookup is part of reading
+    dwError = coapi_file_map(pszFile, &pszJson, &nLength);
     BAIL_ON_ERROR(dwError);
+    coapi_load_phase_end(NULL, &stMark, &stRead);
 
-    dwError = coapi_load_from_string(pszJson, &pApiDef);
+    dwError = coapi_check_cancel(pnCancel);
     BAIL_ON_ERROR(dwError);
 
+    dwError = coapi_load_api_def(pszJson,
+                                 nLength,
+                                 pOptions,
+                                 pnCancel,
+                                 &pApiDef);
+    if(dwFlags & COAPI_LOAD_KEEP_SOURCE)
+    {
+        //the mapping belongs to the def now, or is gone on error
+        pszJson = NULL;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    pApiDef->stStats.stRead = stRead;
+
     *ppApiDef = pApiDef;
 
 cleanup:
-    SAFE_FREE_MEMORY(pszJson);
+    coapi_file_unmap(pszJson, nLength);
     return dwError;
 
 error:
-    SAFE_FREE_MEMORY(pApiDef);
+    if(ppApiDef)
+    {
+        *ppApiDef = NULL;
+    }
+    coapi_free_api_def(pApiDef);
     goto cleanup;
 }
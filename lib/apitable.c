@@ -0,0 +1,596 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Array index over a loaded def. The module, endpoint and param lists
+//stay as they are for callers that walk them. Once a def is loaded its
+//endpoints, methods and params are also put in arrays in the def arena
+//so that lookups scan contiguous names instead of following pNext, and
+//callers can count and index them. The table is read only after it is
+//built and can be used from any number of threads.
+
+#include "includes.h"
+
+uint32_t
+coapi_build_api_table(
+    PREST_API_DEF pApiDef
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_API_TABLE pTable = NULL;
+    PREST_API_MODULE pModule = NULL;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    PREST_API_PARAM pParam = NULL;
+    size_t nEndPoint = 0;
+    size_t nMethod = 0;
+    size_t nParam = 0;
+    int i = 0;
+
+    if(!pApiDef)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //defs mapped from an image have no arena of their own yet
+    if(!pApiDef->pArena)
+    {
+        dwError = coapi_arena_create(&pApiDef->pArena);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_arena_allocate(pApiDef->pArena,
+                                   sizeof(COAPI_API_TABLE),
+                                   (void **)&pTable);
+    BAIL_ON_ERROR(dwError);
+
+    pTable->nHasParams = !(pApiDef->dwLoadFlags & COAPI_LOAD_LAZY_METHODS);
+
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        for(pEndPoint = pModule->pEndPoints;
+            pEndPoint;
+            pEndPoint = pEndPoint->pNext)
+        {
+            ++pTable->nEndPointCount;
+            for(i = 0; i < METHOD_COUNT; ++i)
+            {
+                if(!pEndPoint->pMethods[i])
+                {
+                    continue;
+                }
+                ++pTable->nMethodCount;
+                if(!pTable->nHasParams)
+                {
+                    continue;
+                }
+                for(pParam = pEndPoint->pMethods[i]->pParams;
+                    pParam;
+                    pParam = pParam->pNext)
+                {
+                    ++pTable->nParamCount;
+                }
+            }
+        }
+    }
+
+    if(pTable->nMethodCount > UINT32_MAX || pTable->nParamCount > UINT32_MAX)
+    {
+        dwError = E2BIG;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_arena_allocate(
+                  pApiDef->pArena,
+                  sizeof(uint32_t) * (pTable->nEndPointCount + 1),
+                  (void **)&pTable->pdwEndPointMethods);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_arena_allocate(
+                  pApiDef->pArena,
+                  sizeof(uint32_t) * (pTable->nMethodCount + 1),
+                  (void **)&pTable->pdwMethodParams);
+    BAIL_ON_ERROR(dwError);
+
+    if(pTable->nEndPointCount)
+    {
+        dwError = coapi_arena_allocate(
+                      pApiDef->pArena,
+                      sizeof(char *) * pTable->nEndPointCount,
+                      (void **)&pTable->ppszEndPointNames);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_arena_allocate(
+                      pApiDef->pArena,
+                      sizeof(uint32_t) * pTable->nEndPointCount,
+                      (void **)&pTable->pdwEndPointNameLengths);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_arena_allocate(
+                      pApiDef->pArena,
+                      sizeof(uint32_t) * pTable->nEndPointCount,
+                      (void **)&pTable->pdwEndPointPrefixes);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_arena_allocate(
+                      pApiDef->pArena,
+                      sizeof(PREST_API_ENDPOINT) * pTable->nEndPointCount,
+                      (void **)&pTable->ppEndPoints);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pTable->nMethodCount)
+    {
+        dwError = coapi_arena_allocate(
+                      pApiDef->pArena,
+                      sizeof(PREST_API_METHOD) * pTable->nMethodCount,
+                      (void **)&pTable->ppMethods);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pTable->nParamCount)
+    {
+        dwError = coapi_arena_allocate(
+                      pApiDef->pArena,
+                      sizeof(PREST_API_PARAM) * pTable->nParamCount,
+                      (void **)&pTable->ppParams);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        for(pEndPoint = pModule->pEndPoints;
+            pEndPoint;
+            pEndPoint = pEndPoint->pNext)
+        {
+            const char *pszName = pEndPoint->pszName;
+
+            pTable->ppszEndPointNames[nEndPoint] = pszName;
+            pTable->pdwEndPointNameLengths[nEndPoint] = strlen(pszName);
+            if(pEndPoint->nHasPathSubs)
+            {
+                //stored plus one, 0 is for names without subs
+                pTable->pdwEndPointPrefixes[nEndPoint] =
+                    strcspn(pszName, "*?[\\") + 1;
+            }
+            pTable->ppEndPoints[nEndPoint] = pEndPoint;
+            pTable->pdwEndPointMethods[nEndPoint] = nMethod;
+            ++nEndPoint;
+
+            for(i = 0; i < METHOD_COUNT; ++i)
+            {
+                if(!pEndPoint->pMethods[i])
+                {
+                    continue;
+                }
+                pTable->ppMethods[nMethod] = pEndPoint->pMethods[i];
+                pTable->pdwMethodParams[nMethod] = nParam;
+                ++nMethod;
+                if(!pTable->nHasParams)
+                {
+                    continue;
+                }
+                for(pParam = pEndPoint->pMethods[i]->pParams;
+                    pParam;
+                    pParam = pParam->pNext)
+                {
+                    pTable->ppParams[nParam++] = pParam;
+                }
+            }
+        }
+    }
+    pTable->pdwEndPointMethods[nEndPoint] = nMethod;
+    pTable->pdwMethodParams[nMethod] = nParam;
+
+    dwError = pthread_mutex_init(&pTable->mutexDetails, NULL);
+    BAIL_ON_ERROR(dwError);
+
+    pApiDef->pTable = pTable;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//the table itself is in the def arena
+void
+coapi_free_api_table(
+    PCOAPI_API_TABLE pTable
+    )
+{
+    if(pTable)
+    {
+        pthread_mutex_destroy(&pTable->mutexDetails);
+        coapi_pointer_map_free(&pTable->stFailedDetails);
+    }
+}
+
+//same match as coapi_find_endpoint_by_name over every module in turn
+uint32_t
+coapi_table_find_endpoint(
+    PCOAPI_API_TABLE pTable,
+    const char *pszName,
+    PREST_API_ENDPOINT *ppEndPoint
+    )
+{
+    uint32_t dwError = 0;
+    size_t i = 0;
+    size_t nLength = 0;
+
+    if(!pTable || !pszName || !ppEndPoint)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nLength = strlen(pszName);
+
+    //lengths and literal prefixes rule out most names before a compare
+    for(i = 0; i < pTable->nEndPointCount; ++i)
+    {
+        const char *pszEndPoint = pTable->ppszEndPointNames[i];
+        uint32_t dwPrefix = pTable->pdwEndPointPrefixes[i];
+
+        if(pTable->pdwEndPointNameLengths[i] == nLength &&
+           !strcasecmp(pszEndPoint, pszName))
+        {
+            break;
+        }
+        if(dwPrefix &&
+           !strncmp(pszEndPoint, pszName, dwPrefix - 1) &&
+           !fnmatch(pszEndPoint, pszName, 0))
+        {
+            break;
+        }
+    }
+
+    if(i == pTable->nEndPointCount)
+    {
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppEndPoint = pTable->ppEndPoints[i];
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppEndPoint)
+    {
+        *ppEndPoint = NULL;
+    }
+    goto cleanup;
+}
+
+//points the params of pMethod in the table at its current list, which
+//has as many params as before. used when a method gets its own copy.
+uint32_t
+coapi_table_update_params(
+    PCOAPI_API_TABLE pTable,
+    PREST_API_METHOD pMethod
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_PARAM pParam = NULL;
+    size_t i = 0;
+    size_t nParam = 0;
+
+    if(!pTable || !pMethod)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!pTable->nHasParams)
+    {
+        goto cleanup;
+    }
+
+    for(i = 0; i < pTable->nMethodCount; ++i)
+    {
+        if(pTable->ppMethods[i] == pMethod)
+        {
+            break;
+        }
+    }
+    if(i == pTable->nMethodCount)
+    {
+        goto cleanup;
+    }
+
+    nParam = pTable->pdwMethodParams[i];
+    for(pParam = pMethod->pParams; pParam; pParam = pParam->pNext)
+    {
+        if(nParam == pTable->pdwMethodParams[i + 1])
+        {
+            dwError = EINVAL;
+            BAIL_ON_ERROR(dwError);
+        }
+        pTable->ppParams[nParam++] = pParam;
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_get_endpoint_count(
+    PREST_API_DEF pApiDef,
+    size_t *pnCount
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!pApiDef || !pApiDef->pTable || !pnCount)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *pnCount = pApiDef->pTable->nEndPointCount;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_get_endpoint(
+    PREST_API_DEF pApiDef,
+    size_t nIndex,
+    PREST_API_ENDPOINT *ppEndPoint
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!pApiDef || !pApiDef->pTable || !ppEndPoint)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(nIndex >= pApiDef->pTable->nEndPointCount)
+    {
+        dwError = ERANGE;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppEndPoint = pApiDef->pTable->ppEndPoints[nIndex];
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppEndPoint)
+    {
+        *ppEndPoint = NULL;
+    }
+    goto cleanup;
+}
+
+//methods of endpoint nEndPoint are *pnFirst up to *pnFirst + *pnCount
+uint32_t
+coapi_get_endpoint_methods(
+    PREST_API_DEF pApiDef,
+    size_t nEndPoint,
+    size_t *pnFirst,
+    size_t *pnCount
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_API_TABLE pTable = NULL;
+
+    if(!pApiDef || !pApiDef->pTable || !pnFirst || !pnCount)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+    pTable = pApiDef->pTable;
+
+    if(nEndPoint >= pTable->nEndPointCount)
+    {
+        dwError = ERANGE;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *pnFirst = pTable->pdwEndPointMethods[nEndPoint];
+    *pnCount = pTable->pdwEndPointMethods[nEndPoint + 1] -
+               pTable->pdwEndPointMethods[nEndPoint];
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_get_method_count(
+    PREST_API_DEF pApiDef,
+    size_t *pnCount
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!pApiDef || !pApiDef->pTable || !pnCount)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *pnCount = pApiDef->pTable->nMethodCount;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_get_method(
+    PREST_API_DEF pApiDef,
+    size_t nIndex,
+    PREST_API_METHOD *ppMethod
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!pApiDef || !pApiDef->pTable || !ppMethod)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(nIndex >= pApiDef->pTable->nMethodCount)
+    {
+        dwError = ERANGE;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppMethod = pApiDef->pTable->ppMethods[nIndex];
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppMethod)
+    {
+        *ppMethod = NULL;
+    }
+    goto cleanup;
+}
+
+//lazily loaded methods have their details read here and their params
+//counted from the list
+uint32_t
+coapi_get_param_count(
+    PREST_API_DEF pApiDef,
+    size_t nMethod,
+    size_t *pnCount
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_API_TABLE pTable = NULL;
+    PREST_API_METHOD pMethod = NULL;
+    PREST_API_PARAM pParam = NULL;
+    size_t nCount = 0;
+
+    if(!pApiDef || !pApiDef->pTable || !pnCount)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+    pTable = pApiDef->pTable;
+
+    if(nMethod >= pTable->nMethodCount)
+    {
+        dwError = ERANGE;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pTable->nHasParams)
+    {
+        *pnCount = pTable->pdwMethodParams[nMethod + 1] -
+                   pTable->pdwMethodParams[nMethod];
+        goto cleanup;
+    }
+
+    pMethod = pTable->ppMethods[nMethod];
+    dwError = coapi_load_method_details(pApiDef, pMethod);
+    BAIL_ON_ERROR(dwError);
+
+    for(pParam = pMethod->pParams; pParam; pParam = pParam->pNext)
+    {
+        ++nCount;
+    }
+    *pnCount = nCount;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_get_param(
+    PREST_API_DEF pApiDef,
+    size_t nMethod,
+    size_t nIndex,
+    PREST_API_PARAM *ppParam
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_API_TABLE pTable = NULL;
+    PREST_API_METHOD pMethod = NULL;
+    PREST_API_PARAM pParam = NULL;
+
+    if(!pApiDef || !pApiDef->pTable || !ppParam)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+    pTable = pApiDef->pTable;
+
+    if(nMethod >= pTable->nMethodCount)
+    {
+        dwError = ERANGE;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pTable->nHasParams)
+    {
+        if(nIndex >= pTable->pdwMethodParams[nMethod + 1] -
+                     pTable->pdwMethodParams[nMethod])
+        {
+            dwError = ERANGE;
+            BAIL_ON_ERROR(dwError);
+        }
+        *ppParam = pTable->ppParams[pTable->pdwMethodParams[nMethod] + nIndex];
+        goto cleanup;
+    }
+
+    pMethod = pTable->ppMethods[nMethod];
+    dwError = coapi_load_method_details(pApiDef, pMethod);
+    BAIL_ON_ERROR(dwError);
+
+    for(pParam = pMethod->pParams; pParam && nIndex; pParam = pParam->pNext)
+    {
+        --nIndex;
+    }
+    if(!pParam)
+    {
+        dwError = ERANGE;
+        BAIL_ON_ERROR(dwError);
+    }
+    *ppParam = pParam;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppParam)
+    {
+        *ppParam = NULL;
+    }
+    goto cleanup;
+}
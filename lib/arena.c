@@ -0,0 +1,331 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Arena that owns every node and string of a loaded api def.
+//Allocations are bumped out of the current block and never freed on
+//their own. Freeing the arena releases all blocks at once.
+
+#include "includes.h"
+
+uint32_t
+coapi_arena_create(
+    PCOAPI_ARENA *ppArena
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_ARENA pArena = NULL;
+
+    if(!ppArena)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_allocate_memory(sizeof(COAPI_ARENA), (void **)&pArena);
+    BAIL_ON_ERROR(dwError);
+
+    *ppArena = pArena;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppArena)
+    {
+        *ppArena = NULL;
+    }
+    goto cleanup;
+}
+
+//large allocations get a block of their own behind the current block
+//so that the rest of the current block is still used.
+uint32_t
+coapi_arena_add_block(
+    PCOAPI_ARENA pArena,
+    size_t nSize,
+    PCOAPI_ARENA_BLOCK *ppBlock
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_ARENA_BLOCK pBlock = NULL;
+    int nDedicated = 0;
+
+    if(!pArena || !ppBlock)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nDedicated = nSize > COAPI_ARENA_BLOCK_SIZE / 4;
+    if(!nDedicated)
+    {
+        nSize = COAPI_ARENA_BLOCK_SIZE;
+    }
+
+    dwError = coapi_allocate_memory(COAPI_ARENA_HEADER_SIZE + nSize,
+                                    (void **)&pBlock);
+    BAIL_ON_ERROR(dwError);
+
+    pBlock->nSize = nSize;
+
+    if(nDedicated && pArena->pBlocks)
+    {
+        pBlock->pNext = pArena->pBlocks->pNext;
+        pArena->pBlocks->pNext = pBlock;
+    }
+    else
+    {
+        pBlock->pNext = pArena->pBlocks;
+        pArena->pBlocks = pBlock;
+    }
+
+    *ppBlock = pBlock;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppBlock)
+    {
+        *ppBlock = NULL;
+    }
+    goto cleanup;
+}
+
+//memory is zeroed, blocks come from coapi_allocate_memory and are
+//never reused
+uint32_t
+coapi_arena_allocate_aligned(
+    PCOAPI_ARENA pArena,
+    size_t nSize,
+    size_t nAlign,
+    void **ppMemory
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_ARENA_BLOCK pBlock = NULL;
+    size_t nOffset = 0;
+
+    if(!pArena || !nSize || !nAlign || !ppMemory)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pBlock = pArena->pBlocks;
+    if(pBlock)
+    {
+        nOffset = (pBlock->nUsed + nAlign - 1) & ~(nAlign - 1);
+    }
+
+    if(!pBlock || nOffset > pBlock->nSize || pBlock->nSize - nOffset < nSize)
+    {
+        dwError = coapi_arena_add_block(pArena, nSize, &pBlock);
+        BAIL_ON_ERROR(dwError);
+
+        nOffset = 0;
+    }
+
+    pBlock->nUsed = nOffset + nSize;
+    ++pArena->nAllocations;
+    pArena->nAllocatedBytes += nSize;
+    *ppMemory = (char *)pBlock + COAPI_ARENA_HEADER_SIZE + nOffset;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppMemory)
+    {
+        *ppMemory = NULL;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_arena_allocate(
+    PCOAPI_ARENA pArena,
+    size_t nSize,
+    void **ppMemory
+    )
+{
+    return coapi_arena_allocate_aligned(
+               pArena,
+               nSize,
+               COAPI_ARENA_ALIGN,
+               ppMemory);
+}
+
+uint32_t
+coapi_arena_allocate_string_length(
+    PCOAPI_ARENA pArena,
+    const char *pszString,
+    size_t nLength,
+    char **ppszString
+    )
+{
+    uint32_t dwError = 0;
+    char *pszCopy = NULL;
+
+    if(!pArena || !pszString || !ppszString)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_arena_allocate_aligned(pArena,
+                                           nLength + 1,
+                                           1,
+                                           (void **)&pszCopy);
+    BAIL_ON_ERROR(dwError);
+
+    memcpy(pszCopy, pszString, nLength);
+
+    *ppszString = pszCopy;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszString)
+    {
+        *ppszString = NULL;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_arena_allocate_string(
+    PCOAPI_ARENA pArena,
+    const char *pszString,
+    char **ppszString
+    )
+{
+    if(!pszString)
+    {
+        return EINVAL;
+    }
+    return coapi_arena_allocate_string_length(
+               pArena,
+               pszString,
+               strlen(pszString),
+               ppszString);
+}
+
+uint32_t
+coapi_arena_allocate_string_printf(
+    PCOAPI_ARENA pArena,
+    char **ppszString,
+    const char *pszFmt,
+    ...
+    )
+{
+    uint32_t dwError = 0;
+    int nLength = 0;
+    char *pszString = NULL;
+    va_list argList;
+
+    if(!pArena || !ppszString || !pszFmt)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    va_start(argList, pszFmt);
+    nLength = vsnprintf(NULL, 0, pszFmt, argList);
+    va_end(argList);
+
+    if(nLength < 0)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_arena_allocate_aligned(pArena,
+                                           nLength + 1,
+                                           1,
+                                           (void **)&pszString);
+    BAIL_ON_ERROR(dwError);
+
+    va_start(argList, pszFmt);
+    vsnprintf(pszString, nLength + 1, pszFmt, argList);
+    va_end(argList);
+
+    *ppszString = pszString;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszString)
+    {
+        *ppszString = NULL;
+    }
+    goto cleanup;
+}
+
+//moves every block of pSource into pArena and frees pSource. blocks go
+//behind the current block of pArena, which keeps filling.
+void
+coapi_arena_merge(
+    PCOAPI_ARENA pArena,
+    PCOAPI_ARENA pSource
+    )
+{
+    PCOAPI_ARENA_BLOCK pLast = NULL;
+
+    if(!pArena || !pSource)
+    {
+        return;
+    }
+
+    if(pSource->pBlocks)
+    {
+        for(pLast = pSource->pBlocks; pLast->pNext; pLast = pLast->pNext);
+
+        if(pArena->pBlocks)
+        {
+            pLast->pNext = pArena->pBlocks->pNext;
+            pArena->pBlocks->pNext = pSource->pBlocks;
+        }
+        else
+        {
+            pArena->pBlocks = pSource->pBlocks;
+        }
+    }
+    pArena->nAllocations += pSource->nAllocations;
+    pArena->nAllocatedBytes += pSource->nAllocatedBytes;
+    coapi_free_memory(pSource);
+}
+
+void
+coapi_arena_free(
+    PCOAPI_ARENA pArena
+    )
+{
+    PCOAPI_ARENA_BLOCK pBlock = NULL;
+
+    if(!pArena)
+    {
+        return;
+    }
+    pBlock = pArena->pBlocks;
+    while(pBlock)
+    {
+        PCOAPI_ARENA_BLOCK pNext = pBlock->pNext;
+        coapi_free_memory(pBlock);
+        pBlock = pNext;
+    }
+    coapi_free_memory(pArena);
+}
@@ -0,0 +1,309 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Spec loads on a thread of their own, so that hosts can do other setup
+//while large specs load. A task runs one coapi_load_from_file_ex, calls
+//the callback and then writes to a pipe. The read end stays readable,
+//which lets waiters poll it along with their own fds. Cancelling sets
+//a flag the loader checks between paths.
+
+#include "includes.h"
+
+//the task whose callback runs on this thread, see coapi_load_task_free
+static __thread PCOAPI_LOAD_TASK _pCallbackTask = NULL;
+
+uint32_t
+coapi_load_from_file_async(
+    const char *pszFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PFN_COAPI_LOAD_DONE pfnDone,
+    void *pUserData,
+    PCOAPI_LOAD_TASK *ppTask
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_LOAD_TASK pTask = NULL;
+    int nStartLocked = 0;
+
+    if(IsNullOrEmptyString(pszFile) || !ppTask)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_allocate_memory(sizeof(COAPI_LOAD_TASK),
+                                    (void **)&pTask);
+    BAIL_ON_ERROR(dwError);
+
+    pTask->pnDonePipe[0] = -1;
+    pTask->pnDonePipe[1] = -1;
+    pTask->pfnDone = pfnDone;
+    pTask->pUserData = pUserData;
+
+    dwError = coapi_allocate_string(pszFile, &pTask->pszFile);
+    BAIL_ON_ERROR(dwError);
+
+    //the caller's options need not outlive this call
+    if(pOptions)
+    {
+        pTask->stOptions = *pOptions;
+        pTask->stOptions.pszModule = NULL;
+        if(pOptions->pszModule)
+        {
+            dwError = coapi_allocate_string(pOptions->pszModule,
+                                            &pTask->pszModule);
+            BAIL_ON_ERROR(dwError);
+            pTask->stOptions.pszModule = pTask->pszModule;
+        }
+    }
+
+    if(pipe2(pTask->pnDonePipe, O_CLOEXEC))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = pthread_mutex_init(&pTask->mutexStart, NULL);
+    BAIL_ON_ERROR(dwError);
+    pTask->nMutexInit = 1;
+
+    //a callback that frees the task waits for this thread to let go
+    pthread_mutex_lock(&pTask->mutexStart);
+    nStartLocked = 1;
+
+    pTask->nThreadStarted = 1;
+    dwError = pthread_create(&pTask->nThread,
+                             NULL,
+                             coapi_load_task_run,
+                             pTask);
+    if(dwError)
+    {
+        pTask->nThreadStarted = 0;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppTask = pTask;
+
+cleanup:
+    if(nStartLocked)
+    {
+        //the task can be gone after this
+        pthread_mutex_unlock(&pTask->mutexStart);
+    }
+    return dwError;
+
+error:
+    if(ppTask)
+    {
+        *ppTask = NULL;
+    }
+    if(nStartLocked)
+    {
+        pthread_mutex_unlock(&pTask->mutexStart);
+        nStartLocked = 0;
+    }
+    coapi_load_task_free(pTask);
+    goto cleanup;
+}
+
+void *
+coapi_load_task_run(
+    void *pArg
+    )
+{
+    PCOAPI_LOAD_TASK pTask = pArg;
+    PREST_API_DEF pApiDef = NULL;
+    uint32_t dwError = 0;
+
+    if(!pTask)
+    {
+        return NULL;
+    }
+
+    dwError = coapi_load_file(pTask->pszFile,
+                              &pTask->stOptions,
+                              &pTask->nCancel,
+                              &pApiDef);
+
+    pTask->dwError = dwError;
+
+    //until coapi_load_from_file_async is done with the task
+    pthread_mutex_lock(&pTask->mutexStart);
+    pthread_mutex_unlock(&pTask->mutexStart);
+
+    if(pTask->pfnDone)
+    {
+        _pCallbackTask = pTask;
+        pTask->pfnDone(pTask->pUserData, dwError, pApiDef);
+        _pCallbackTask = NULL;
+
+        //the callback freed the task, which is left to this thread
+        if(pTask->nFreeOnExit)
+        {
+            coapi_load_task_destroy(pTask);
+            return NULL;
+        }
+    }
+    else
+    {
+        pTask->pApiDef = pApiDef;
+    }
+
+    __atomic_store_n(&pTask->nDone, 1, __ATOMIC_RELEASE);
+    if(write(pTask->pnDonePipe[1], "x", 1) != 1)
+    {
+        fprintf(stderr, "could not signal the end of a spec load\n");
+    }
+    return NULL;
+}
+
+//ECANCELED once *pnCancel is set. pnCancel can be NULL.
+uint32_t
+coapi_check_cancel(
+    const int *pnCancel
+    )
+{
+    if(pnCancel && __atomic_load_n(pnCancel, __ATOMIC_RELAXED))
+    {
+        return ECANCELED;
+    }
+    return 0;
+}
+
+int
+coapi_load_task_get_fd(
+    PCOAPI_LOAD_TASK pTask
+    )
+{
+    return pTask ? pTask->pnDonePipe[0] : -1;
+}
+
+uint32_t
+coapi_load_task_wait(
+    PCOAPI_LOAD_TASK pTask,
+    int nTimeoutMs,
+    PREST_API_DEF *ppApiDef
+    )
+{
+    uint32_t dwError = 0;
+    struct pollfd stPoll = {0};
+    int nReady = 0;
+
+    if(!pTask)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    stPoll.fd = pTask->pnDonePipe[0];
+    stPoll.events = POLLIN;
+
+    do
+    {
+        nReady = poll(&stPoll, 1, nTimeoutMs);
+    } while(nReady < 0 && errno == EINTR);
+
+    if(nReady < 0)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+    if(nReady == 0 || !__atomic_load_n(&pTask->nDone, __ATOMIC_ACQUIRE))
+    {
+        dwError = ETIMEDOUT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(ppApiDef)
+    {
+        *ppApiDef = pTask->pApiDef;
+        pTask->pApiDef = NULL;
+    }
+    dwError = pTask->dwError;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppApiDef)
+    {
+        *ppApiDef = NULL;
+    }
+    goto cleanup;
+}
+
+void
+coapi_load_task_cancel(
+    PCOAPI_LOAD_TASK pTask
+    )
+{
+    if(pTask)
+    {
+        __atomic_store_n(&pTask->nCancel, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void
+coapi_load_task_free(
+    PCOAPI_LOAD_TASK pTask
+    )
+{
+    if(!pTask)
+    {
+        return;
+    }
+
+    if(pTask->nThreadStarted)
+    {
+        //called from the callback, on the load thread. joining it would
+        //fail, so the thread frees the task once the callback returns.
+        if(_pCallbackTask == pTask)
+        {
+            pTask->nFreeOnExit = 1;
+            pthread_detach(pthread_self());
+            return;
+        }
+        pthread_join(pTask->nThread, NULL);
+    }
+    coapi_load_task_destroy(pTask);
+}
+
+//frees a task whose thread is done or was never started
+void
+coapi_load_task_destroy(
+    PCOAPI_LOAD_TASK pTask
+    )
+{
+    if(!pTask)
+    {
+        return;
+    }
+
+    if(pTask->pnDonePipe[0] >= 0)
+    {
+        close(pTask->pnDonePipe[0]);
+    }
+    if(pTask->pnDonePipe[1] >= 0)
+    {
+        close(pTask->pnDonePipe[1]);
+    }
+    if(pTask->nMutexInit)
+    {
+        pthread_mutex_destroy(&pTask->mutexStart);
+    }
+    coapi_free_api_def(pTask->pApiDef);
+    SAFE_FREE_MEMORY(pTask->pszFile);
+    SAFE_FREE_MEMORY(pTask->pszModule);
+    SAFE_FREE_MEMORY(pTask);
+}
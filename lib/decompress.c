@@ -0,0 +1,388 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Compressed spec files. gzip and zstd input is told by its magic bytes
+//and decompressed a chunk at a time into an anonymous mapping, which
+//the loader then reads like a mapped spec file. Nothing is written to
+//disk. Each format needs its library at build time.
+
+#include "includes.h"
+
+COAPI_COMPRESSION
+coapi_get_compression(
+    const char *pData,
+    size_t nLength
+    )
+{
+    const unsigned char *pBytes = (const unsigned char *)pData;
+
+    if(!pData)
+    {
+        return COAPI_COMPRESSION_NONE;
+    }
+    if(nLength >= 2 && pBytes[0] == 0x1f && pBytes[1] == 0x8b)
+    {
+        return COAPI_COMPRESSION_GZIP;
+    }
+    if(nLength >= 4 && pBytes[0] == 0x28 && pBytes[1] == 0xb5 &&
+       pBytes[2] == 0x2f && pBytes[3] == 0xfd)
+    {
+        return COAPI_COMPRESSION_ZSTD;
+    }
+    return COAPI_COMPRESSION_NONE;
+}
+
+//makes room for at least nSize more bytes. the mapping grows in place
+//where the kernel can, and moves otherwise.
+uint32_t
+coapi_text_buffer_reserve(
+    PCOAPI_TEXT_BUFFER pBuffer,
+    size_t nSize
+    )
+{
+    uint32_t dwError = 0;
+    size_t nCapacity = 0;
+    char *pszText = MAP_FAILED;
+
+    if(!pBuffer || !nSize)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pBuffer->nCapacity - pBuffer->nLength >= nSize)
+    {
+        goto cleanup;
+    }
+
+    nCapacity = pBuffer->nCapacity ? pBuffer->nCapacity * 2 : nSize;
+    while(nCapacity - pBuffer->nLength < nSize)
+    {
+        nCapacity *= 2;
+    }
+
+    if(pBuffer->pszText)
+    {
+        pszText = mremap(pBuffer->pszText,
+                         pBuffer->nCapacity,
+                         nCapacity,
+                         MREMAP_MAYMOVE);
+    }
+    else
+    {
+        pszText = mmap(NULL,
+                       nCapacity,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS,
+                       -1,
+                       0);
+    }
+    if(pszText == MAP_FAILED)
+    {
+        dwError = ENOMEM;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pBuffer->pszText = pszText;
+    pBuffer->nCapacity = nCapacity;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+void
+coapi_text_buffer_free(
+    PCOAPI_TEXT_BUFFER pBuffer
+    )
+{
+    if(!pBuffer)
+    {
+        return;
+    }
+    if(pBuffer->pszText)
+    {
+        munmap(pBuffer->pszText, pBuffer->nCapacity);
+    }
+    memset(pBuffer, 0, sizeof(*pBuffer));
+}
+
+uint32_t
+coapi_gzip_decompress(
+    const char *pData,
+    size_t nLength,
+    PCOAPI_TEXT_BUFFER pBuffer
+    )
+{
+    uint32_t dwError = 0;
+#ifdef HAVE_LIBZ
+    z_stream stStream = {0};
+    int nInit = 0;
+    int nResult = Z_OK;
+    size_t nSizeHint = 0;
+    const unsigned char *pTrailer = NULL;
+
+    if(!pData || nLength < 18 || !pBuffer)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //the trailer has the size of the last member mod 2^32
+    pTrailer = (const unsigned char *)pData + nLength - 4;
+    nSizeHint = (size_t)pTrailer[0] |
+                (size_t)pTrailer[1] << 8 |
+                (size_t)pTrailer[2] << 16 |
+                (size_t)pTrailer[3] << 24;
+
+    dwError = coapi_text_buffer_reserve(pBuffer,
+                                        nSizeHint ? nSizeHint + 1 :
+                                                    COAPI_DECOMPRESS_CHUNK);
+    BAIL_ON_ERROR(dwError);
+
+    //15 + 16 accepts gzip only
+    if(inflateInit2(&stStream, 15 + 16) != Z_OK)
+    {
+        dwError = ENOMEM;
+        BAIL_ON_ERROR(dwError);
+    }
+    nInit = 1;
+
+    stStream.next_in = (unsigned char *)pData;
+
+    while(nLength || nResult != Z_STREAM_END)
+    {
+        size_t nIn = nLength > UINT32_MAX ? UINT32_MAX : nLength;
+        size_t nOut = 0;
+
+        dwError = coapi_text_buffer_reserve(pBuffer, COAPI_DECOMPRESS_CHUNK);
+        BAIL_ON_ERROR(dwError);
+
+        nOut = pBuffer->nCapacity - pBuffer->nLength;
+        if(nOut > UINT32_MAX)
+        {
+            nOut = UINT32_MAX;
+        }
+
+        stStream.avail_in = nIn;
+        stStream.next_out = (unsigned char *)pBuffer->pszText +
+                            pBuffer->nLength;
+        stStream.avail_out = nOut;
+
+        nResult = inflate(&stStream, Z_NO_FLUSH);
+
+        nLength -= nIn - stStream.avail_in;
+        pBuffer->nLength += nOut - stStream.avail_out;
+
+        if(nResult == Z_STREAM_END)
+        {
+            //concatenated members, as written by gzip -c a b
+            if(nLength && inflateReset(&stStream) != Z_OK)
+            {
+                dwError = EINVAL;
+                BAIL_ON_ERROR(dwError);
+            }
+            continue;
+        }
+        if(nResult == Z_BUF_ERROR && !nLength)
+        {
+            fprintf(stderr, "gzip spec is truncated\n");
+            dwError = EINVAL;
+            BAIL_ON_ERROR(dwError);
+        }
+        if(nResult != Z_OK && nResult != Z_BUF_ERROR)
+        {
+            fprintf(stderr,
+                    "gzip spec is corrupt: %s\n",
+                    stStream.msg ? stStream.msg : "unknown error");
+            dwError = EINVAL;
+            BAIL_ON_ERROR(dwError);
+        }
+    }
+
+cleanup:
+    if(nInit)
+    {
+        inflateEnd(&stStream);
+    }
+    return dwError;
+
+error:
+    goto cleanup;
+#else
+    fprintf(stderr, "gzip specs need copenapi built with zlib\n");
+    dwError = ENOTSUP;
+    return dwError;
+#endif
+}
+
+uint32_t
+coapi_zstd_decompress(
+    const char *pData,
+    size_t nLength,
+    PCOAPI_TEXT_BUFFER pBuffer
+    )
+{
+    uint32_t dwError = 0;
+#ifdef HAVE_LIBZSTD
+    ZSTD_DStream *pStream = NULL;
+    ZSTD_inBuffer stIn = {0};
+    unsigned long long nSizeHint = 0;
+    size_t nResult = 0;
+
+    if(!pData || !nLength || !pBuffer)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //the frame header may have the size of the first frame
+    nSizeHint = ZSTD_getFrameContentSize(pData, nLength);
+    if(nSizeHint == ZSTD_CONTENTSIZE_UNKNOWN ||
+       nSizeHint == ZSTD_CONTENTSIZE_ERROR ||
+       nSizeHint >= SIZE_MAX)
+    {
+        nSizeHint = 0;
+    }
+
+    dwError = coapi_text_buffer_reserve(pBuffer,
+                                        nSizeHint ? nSizeHint + 1 :
+                                                    COAPI_DECOMPRESS_CHUNK);
+    BAIL_ON_ERROR(dwError);
+
+    pStream = ZSTD_createDStream();
+    if(!pStream)
+    {
+        dwError = ENOMEM;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    stIn.src = pData;
+    stIn.size = nLength;
+
+    //a result of 0 means the frame is done. more input is a next frame.
+    do
+    {
+        ZSTD_outBuffer stOut = {0};
+
+        dwError = coapi_text_buffer_reserve(pBuffer, COAPI_DECOMPRESS_CHUNK);
+        BAIL_ON_ERROR(dwError);
+
+        stOut.dst = pBuffer->pszText + pBuffer->nLength;
+        stOut.size = pBuffer->nCapacity - pBuffer->nLength;
+
+        nResult = ZSTD_decompressStream(pStream, &stOut, &stIn);
+        if(ZSTD_isError(nResult))
+        {
+            fprintf(stderr,
+                    "zstd spec is corrupt: %s\n",
+                    ZSTD_getErrorName(nResult));
+            dwError = EINVAL;
+            BAIL_ON_ERROR(dwError);
+        }
+        pBuffer->nLength += stOut.pos;
+
+        if(nResult && stIn.pos == stIn.size && stOut.pos < stOut.size)
+        {
+            fprintf(stderr, "zstd spec is truncated\n");
+            dwError = EINVAL;
+            BAIL_ON_ERROR(dwError);
+        }
+    }while(nResult || stIn.pos < stIn.size);
+
+cleanup:
+    if(pStream)
+    {
+        ZSTD_freeDStream(pStream);
+    }
+    return dwError;
+
+error:
+    goto cleanup;
+#else
+    fprintf(stderr, "zstd specs need copenapi built with libzstd\n");
+    dwError = ENOTSUP;
+    return dwError;
+#endif
+}
+
+//decompresses pData into a new anonymous mapping of exactly *pnLength
+//bytes, to be released with coapi_file_unmap.
+uint32_t
+coapi_decompress_text(
+    const char *pData,
+    size_t nLength,
+    COAPI_COMPRESSION nCompression,
+    char **ppszText,
+    size_t *pnLength
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_TEXT_BUFFER stBuffer = {0};
+    char *pszText = MAP_FAILED;
+
+    if(!pData || !nLength || !ppszText || !pnLength)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(nCompression == COAPI_COMPRESSION_GZIP)
+    {
+        dwError = coapi_gzip_decompress(pData, nLength, &stBuffer);
+    }
+    else if(nCompression == COAPI_COMPRESSION_ZSTD)
+    {
+        dwError = coapi_zstd_decompress(pData, nLength, &stBuffer);
+    }
+    else
+    {
+        dwError = EINVAL;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    if(!stBuffer.nLength)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //unmapping takes the length of the text, so drop the spare pages
+    pszText = mremap(stBuffer.pszText, stBuffer.nCapacity, stBuffer.nLength, 0);
+    if(pszText == MAP_FAILED)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppszText = pszText;
+    *pnLength = stBuffer.nLength;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszText)
+    {
+        *ppszText = NULL;
+    }
+    if(pnLength)
+    {
+        *pnLength = 0;
+    }
+    coapi_text_buffer_free(&stBuffer);
+    goto cleanup;
+}
@@ -18,3 +18,79 @@
 
 #define URL_SEPARATOR '/'
 #define DEFAULT_BASE_PATH "api"
+
+//api def arena
+#define COAPI_ARENA_BLOCK_SIZE (64 * 1024)
+#define COAPI_ARENA_ALIGN      8
+#define COAPI_ARENA_HEADER_SIZE \
+    ((sizeof(COAPI_ARENA_BLOCK) + COAPI_ARENA_ALIGN - 1) & \
+     ~(size_t)(COAPI_ARENA_ALIGN - 1))
+
+//load flags that need the def to own the mapped spec
+#define COAPI_LOAD_KEEP_SOURCE \
+    (COAPI_LOAD_BORROW_STRINGS | COAPI_LOAD_LAZY_METHODS)
+
+//parallel loads give each thread at least this many paths
+#define COAPI_PARALLEL_MIN_PATHS 512
+#define COAPI_PARALLEL_MAX_THREADS 64
+
+//same nesting limit as jansson
+#define COAPI_JSON_MAX_DEPTH 2048
+
+//initial slots in a pointer map, power of 2
+#define COAPI_POINTER_MAP_SIZE 256
+
+//initial entries of a footprint, see footprint.c
+#define COAPI_FOOTPRINT_ENTRY_COUNT 256
+
+//a $ref may point at another $ref this many times
+#define COAPI_REF_MAX_DEPTH 32
+
+//initial slots in the string interning table, power of 2
+#define COAPI_STRING_TABLE_SIZE 256
+
+//spec reloads wait this long after the last change to the file
+#define COAPI_RELOAD_SETTLE_MS 100
+//writer poll interval while waiting for readers of an old def
+#define COAPI_RELOAD_GRACE_POLL_US 1000
+#define COAPI_RELOAD_EVENT_BUFFER 4096
+
+//sse2 scans in the json reader, see jsonscan.c
+#if defined(__SSE2__) && !defined(COAPI_DISABLE_SIMD)
+#define COAPI_HAVE_SSE2 1
+#endif
+
+//json output is buffered this much before it is written to an fd
+#define COAPI_JSON_WRITER_BUFFER (64 * 1024)
+//writes a string literal as is, for keys and punctuation
+#define COAPI_JSON_WRITE_LITERAL(pWriter, pszLiteral) \
+    coapi_json_write_raw((pWriter), (pszLiteral), sizeof(pszLiteral) - 1)
+
+//compressed specs are decompressed this much at a time
+#define COAPI_DECOMPRESS_CHUNK (256 * 1024)
+
+//compiled spec image
+#define COAPI_IMAGE_MAGIC      "COAPIIMG"
+#define COAPI_IMAGE_VERSION    10
+#define COAPI_IMAGE_EXTENSION  ".coapi"
+#define COAPI_IMAGE_ALIGN      8
+#define COAPI_IMAGE_INITIAL_SIZE (64 * 1024)
+//kinds of nodes, see coapi_image_check_def
+#define COAPI_IMAGE_NODE_MODULE   1
+#define COAPI_IMAGE_NODE_ENDPOINT 2
+#define COAPI_IMAGE_NODE_METHOD   3
+#define COAPI_IMAGE_NODE_PARAM    4
+//images shared by processes, see COAPI_LOAD_SHARED_IMAGE. they are in
+//a directory of each user, named with the prefix and the user id.
+#define COAPI_SHARED_IMAGE_DIR    "/dev/shm"
+#define COAPI_SHARED_IMAGE_PREFIX "copenapi-"
+//sidecar index of spec text hashes, kept with the shared images
+#define COAPI_INDEX_MAGIC      "COAPIIDX"
+#define COAPI_INDEX_VERSION    1
+#define COAPI_INDEX_EXTENSION  ".index"
+//images are laid out for this address. mapping there needs no relocation
+#if UINTPTR_MAX > 0xffffffffUL
+#define COAPI_IMAGE_PREFERRED_BASE 0x3c0000000000ULL
+#else
+#define COAPI_IMAGE_PREFERRED_BASE 0ULL
+#endif
@@ -0,0 +1,195 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Several specs loaded into one def. The specs go through one loader in
+//turn, so strings and params equal across specs are stored once. Each
+//spec's modules are prefixed with its name and the index is built over
+//all of them at the end, so lookups see every spec.
+
+#include "includes.h"
+
+uint32_t
+coapi_load_federation(
+    PCOAPI_FEDERATED_SPEC pSpecs,
+    size_t nSpecCount,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PREST_API_DEF *ppApiDef
+    )
+{
+    uint32_t dwError = 0;
+    uint32_t dwFlags = pOptions ? pOptions->dwFlags : 0;
+    COAPI_LOADER stLoader = {{0}};
+    COAPI_SPEC stSpec = {0};
+    COAPI_LOAD_PHASE stMark = {0};
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_MODULE *ppTail = NULL;
+    char *pszJson = NULL;
+    size_t nLength = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    if(!pSpecs || !nSpecCount || !ppApiDef)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //sources are unmapped after each spec and modules come from all
+    //of them
+    if((dwFlags & COAPI_LOAD_KEEP_SOURCE) || (pOptions && pOptions->pszModule))
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    for(i = 0; i < nSpecCount; ++i)
+    {
+        if(IsNullOrEmptyString(pSpecs[i].pszName) ||
+           IsNullOrEmptyString(pSpecs[i].pszFile))
+        {
+            dwError = EINVAL;
+            BAIL_ON_ERROR(dwError);
+        }
+        for(j = 0; j < i; ++j)
+        {
+            if(!strcmp(pSpecs[i].pszName, pSpecs[j].pszName))
+            {
+                dwError = EINVAL;
+                BAIL_ON_ERROR(dwError);
+            }
+        }
+    }
+
+    dwError = coapi_loader_begin_def(&stLoader, dwFlags, NULL, &pApiDef);
+    BAIL_ON_ERROR(dwError);
+
+    ppTail = &pApiDef->pModules;
+    for(i = 0; i < nSpecCount; ++i)
+    {
+        coapi_load_phase_begin(NULL, &stMark);
+        dwError = coapi_file_map(pSpecs[i].pszFile, &pszJson, &nLength);
+        BAIL_ON_ERROR(dwError);
+        coapi_load_phase_end(NULL, &stMark, &stLoader.stStats.stRead);
+
+        memset(&stSpec, 0, sizeof(stSpec));
+        dwError = coapi_load_spec(&stLoader,
+                                  pszJson,
+                                  nLength,
+                                  pOptions,
+                                  &stSpec);
+        BAIL_ON_ERROR(dwError);
+
+        coapi_file_unmap(pszJson, nLength);
+        pszJson = NULL;
+
+        //the def is served from where the first spec is
+        if(i == 0)
+        {
+            pApiDef->pszHost = stSpec.pszHost;
+            pApiDef->pszBasePath = stSpec.pszBasePath;
+            pApiDef->nHasSecureScheme = stSpec.nHasSecureScheme;
+        }
+
+        //endpoints were matched to tags by name, so names change last
+        dwError = coapi_name_federated_modules(stLoader.pArena,
+                                               pSpecs[i].pszName,
+                                               &stSpec);
+        BAIL_ON_ERROR(dwError);
+
+        *ppTail = stSpec.pModules;
+        while(*ppTail)
+        {
+            ppTail = &(*ppTail)->pNext;
+        }
+    }
+
+    dwError = coapi_loader_end_def(&stLoader);
+    BAIL_ON_ERROR(dwError);
+
+    *ppApiDef = pApiDef;
+
+cleanup:
+    coapi_free_loader(&stLoader);
+    return dwError;
+
+error:
+    if(pSpecs && i < nSpecCount && pApiDef)
+    {
+        fprintf(stderr,
+                "could not load spec %s (%s) of the federation\n",
+                pSpecs[i].pszName,
+                pSpecs[i].pszFile);
+    }
+    if(ppApiDef)
+    {
+        *ppApiDef = NULL;
+    }
+    if(pszJson)
+    {
+        coapi_file_unmap(pszJson, nLength);
+    }
+    coapi_free_api_def(pApiDef);
+    goto cleanup;
+}
+
+//modules of a spec become <spec>.<tag>. the default module of a spec
+//without tags is named after the spec.
+uint32_t
+coapi_name_federated_modules(
+    PCOAPI_ARENA pArena,
+    const char *pszSpecName,
+    PCOAPI_SPEC pSpec
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_MODULE pModule = NULL;
+    size_t nSpecLength = 0;
+    size_t nTagLength = 0;
+    char *pszName = NULL;
+
+    if(!pArena || IsNullOrEmptyString(pszSpecName) || !pSpec)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nSpecLength = strlen(pszSpecName);
+    for(pModule = pSpec->pModules; pModule; pModule = pModule->pNext)
+    {
+        nTagLength = pSpec->nNoModules ? 0 : strlen(pModule->pszName) + 1;
+
+        dwError = coapi_arena_allocate(pArena,
+                                       nSpecLength + nTagLength + 1,
+                                       (void **)&pszName);
+        BAIL_ON_ERROR(dwError);
+
+        memcpy(pszName, pszSpecName, nSpecLength);
+        if(nTagLength)
+        {
+            pszName[nSpecLength] = '.';
+            memcpy(pszName + nSpecLength + 1,
+                   pModule->pszName,
+                   nTagLength - 1);
+        }
+        pszName[nSpecLength + nTagLength] = '\0';
+
+        pModule->pszName = pszName;
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
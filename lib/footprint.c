@@ -0,0 +1,963 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Bytes of a loaded def by module, endpoint, method and param. The def
+//is walked in order and every node and string is counted once, for the
+//first entry that points to it, so interned strings and shared params
+//add up to what the def holds. Nodes are counted at their size in the
+//arena, strings with their terminator.
+
+#include "includes.h"
+
+size_t
+coapi_footprint_round(
+    size_t nSize
+    )
+{
+    return (nSize + COAPI_ARENA_ALIGN - 1) & ~(size_t)(COAPI_ARENA_ALIGN - 1);
+}
+
+int
+coapi_footprint_is_borrowed(
+    PREST_API_DEF pApiDef,
+    const void *pBlock
+    )
+{
+    const char *pszSource = pApiDef->pSource;
+
+    return pszSource &&
+           (const char *)pBlock >= pszSource &&
+           (const char *)pBlock < pszSource + pApiDef->nSourceSize;
+}
+
+//nSize bytes at pBlock go to *pnBytes the first time pBlock is seen and
+//to the shared bytes of pEntry after that. pEntry can be NULL for the
+//parts of the def that are not in an entry.
+uint32_t
+coapi_footprint_add(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    const void *pBlock,
+    size_t nSize,
+    PCOAPI_FOOTPRINT_ENTRY pEntry,
+    size_t *pnBytes
+    )
+{
+    uint32_t dwError = 0;
+    size_t nValue = 0;
+
+    if(!pWalk || !pnBytes)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!pBlock)
+    {
+        goto cleanup;
+    }
+
+    dwError = coapi_pointer_map_get(&pWalk->stSeen, pBlock, &nValue);
+    if(!dwError)
+    {
+        if(pEntry)
+        {
+            pEntry->nSharedBytes += nSize;
+        }
+        goto cleanup;
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_pointer_map_set(&pWalk->stSeen, pBlock, 1);
+    BAIL_ON_ERROR(dwError);
+
+    if(coapi_footprint_is_borrowed(pWalk->pApiDef, pBlock))
+    {
+        pWalk->pFootprint->nBorrowedBytes += nSize;
+    }
+    else
+    {
+        *pnBytes += nSize;
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_footprint_add_string(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    const char *pszString,
+    PCOAPI_FOOTPRINT_ENTRY pEntry,
+    size_t *pnBytes
+    )
+{
+    if(!pszString)
+    {
+        return 0;
+    }
+    return coapi_footprint_add(pWalk,
+                               pszString,
+                               strlen(pszString) + 1,
+                               pEntry,
+                               pnBytes);
+}
+
+//appends an entry with the names of entry nParent, which is ignored
+//for modules. *ppEntry is valid until the next entry is added.
+uint32_t
+coapi_footprint_add_entry(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    size_t nParent,
+    COAPI_FOOTPRINT_LEVEL nLevel,
+    PCOAPI_FOOTPRINT_ENTRY *ppEntry
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_FOOTPRINT pFootprint = NULL;
+    PCOAPI_FOOTPRINT_ENTRY pEntries = NULL;
+    PCOAPI_FOOTPRINT_ENTRY pEntry = NULL;
+    size_t nCapacity = 0;
+
+    if(!pWalk || !ppEntry)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pFootprint = pWalk->pFootprint;
+    if(pFootprint->nEntryCount == pWalk->nEntryCapacity)
+    {
+        nCapacity = pWalk->nEntryCapacity ? pWalk->nEntryCapacity * 2 :
+                                            COAPI_FOOTPRINT_ENTRY_COUNT;
+
+        dwError = coapi_reallocate_memory(
+                      pFootprint->pEntries,
+                      sizeof(COAPI_FOOTPRINT_ENTRY) * nCapacity,
+                      (void **)&pEntries);
+        BAIL_ON_ERROR(dwError);
+
+        pFootprint->pEntries = pEntries;
+        pWalk->nEntryCapacity = nCapacity;
+    }
+
+    pEntry = &pFootprint->pEntries[pFootprint->nEntryCount];
+    memset(pEntry, 0, sizeof(*pEntry));
+    if(nLevel != COAPI_FOOTPRINT_MODULE)
+    {
+        pEntry->pszModule = pFootprint->pEntries[nParent].pszModule;
+        pEntry->pszEndPoint = pFootprint->pEntries[nParent].pszEndPoint;
+        pEntry->pszMethod = pFootprint->pEntries[nParent].pszMethod;
+    }
+    pEntry->nLevel = nLevel;
+    pEntry->nIndex = pFootprint->nEntryCount++;
+
+    *ppEntry = pEntry;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppEntry)
+    {
+        *ppEntry = NULL;
+    }
+    goto cleanup;
+}
+
+//the bytes of entry nChild are part of entry nParent
+void
+coapi_footprint_add_child(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    size_t nParent,
+    size_t nChild
+    )
+{
+    PCOAPI_FOOTPRINT_ENTRY pParent = &pWalk->pFootprint->pEntries[nParent];
+    PCOAPI_FOOTPRINT_ENTRY pChild = &pWalk->pFootprint->pEntries[nChild];
+
+    pParent->nStringBytes += pChild->nStringBytes;
+    pParent->nOptionBytes += pChild->nOptionBytes;
+    pParent->nNodeBytes += pChild->nNodeBytes;
+    pParent->nSharedBytes += pChild->nSharedBytes;
+}
+
+uint32_t
+coapi_footprint_walk_param(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    size_t nParent,
+    PREST_API_PARAM pParam
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_FOOTPRINT_ENTRY pEntry = NULL;
+    size_t nIndex = 0;
+    int i = 0;
+
+    dwError = coapi_footprint_add_entry(pWalk,
+                                        nParent,
+                                        COAPI_FOOTPRINT_PARAM,
+                                        &pEntry);
+    BAIL_ON_ERROR(dwError);
+
+    nIndex = pEntry->nIndex;
+    pEntry->pszParam = pParam->pszName;
+
+    dwError = coapi_footprint_add(pWalk,
+                                  pParam,
+                                  coapi_footprint_round(sizeof(*pParam)),
+                                  pEntry,
+                                  &pEntry->nNodeBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pParam->pszName,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pParam->pszIn,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    if(pParam->ppszOptions && pParam->nOptionCount > 0)
+    {
+        dwError = coapi_footprint_add(
+                      pWalk,
+                      pParam->ppszOptions,
+                      coapi_footprint_round(
+                          sizeof(char *) * pParam->nOptionCount),
+                      pEntry,
+                      &pEntry->nOptionBytes);
+        BAIL_ON_ERROR(dwError);
+
+        for(i = 0; i < pParam->nOptionCount; ++i)
+        {
+            dwError = coapi_footprint_add_string(pWalk,
+                                                 pParam->ppszOptions[i],
+                                                 pEntry,
+                                                 &pEntry->nOptionBytes);
+            BAIL_ON_ERROR(dwError);
+        }
+    }
+
+    coapi_footprint_add_child(pWalk, nParent, nIndex);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//params of the method up to the params of its endpoint
+uint32_t
+coapi_footprint_walk_method(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    size_t nParent,
+    PREST_API_ENDPOINT pEndPoint,
+    PREST_API_METHOD pMethod
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_FOOTPRINT_ENTRY pEntry = NULL;
+    PREST_API_PARAM pParam = NULL;
+    size_t nIndex = 0;
+
+    dwError = coapi_footprint_add_entry(pWalk,
+                                        nParent,
+                                        COAPI_FOOTPRINT_METHOD,
+                                        &pEntry);
+    BAIL_ON_ERROR(dwError);
+
+    nIndex = pEntry->nIndex;
+    pEntry->pszMethod = pMethod->pszMethod;
+
+    dwError = coapi_footprint_add(pWalk,
+                                  pMethod,
+                                  coapi_footprint_round(sizeof(*pMethod)),
+                                  pEntry,
+                                  &pEntry->nNodeBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pMethod->pszMethod,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pMethod->pszSummary,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pMethod->pszDescription,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    for(pParam = pMethod->pParams;
+        pParam && pParam != pEndPoint->pParams;
+        pParam = pParam->pNext)
+    {
+        dwError = coapi_footprint_walk_param(pWalk, nIndex, pParam);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    coapi_footprint_add_child(pWalk, nParent, nIndex);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_footprint_walk_endpoint(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    size_t nParent,
+    PREST_API_ENDPOINT pEndPoint
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_FOOTPRINT_ENTRY pEntry = NULL;
+    PREST_API_PARAM pParam = NULL;
+    size_t nIndex = 0;
+    int i = 0;
+
+    dwError = coapi_footprint_add_entry(pWalk,
+                                        nParent,
+                                        COAPI_FOOTPRINT_ENDPOINT,
+                                        &pEntry);
+    BAIL_ON_ERROR(dwError);
+
+    nIndex = pEntry->nIndex;
+    pEntry->pszEndPoint = pEndPoint->pszName;
+
+    dwError = coapi_footprint_add(pWalk,
+                                  pEndPoint,
+                                  coapi_footprint_round(sizeof(*pEndPoint)),
+                                  pEntry,
+                                  &pEntry->nNodeBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pEndPoint->pszName,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pEndPoint->pszActualName,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pEndPoint->pszCommandName,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    for(pParam = pEndPoint->pParams; pParam; pParam = pParam->pNext)
+    {
+        dwError = coapi_footprint_walk_param(pWalk, nIndex, pParam);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    for(i = 0; i < METHOD_COUNT; ++i)
+    {
+        if(!pEndPoint->pMethods[i])
+        {
+            continue;
+        }
+        dwError = coapi_footprint_walk_method(pWalk,
+                                              nIndex,
+                                              pEndPoint,
+                                              pEndPoint->pMethods[i]);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    coapi_footprint_add_child(pWalk, nParent, nIndex);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_footprint_walk_module(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    PREST_API_MODULE pModule
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_FOOTPRINT_ENTRY pEntry = NULL;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    size_t nIndex = 0;
+
+    dwError = coapi_footprint_add_entry(pWalk,
+                                        0,
+                                        COAPI_FOOTPRINT_MODULE,
+                                        &pEntry);
+    BAIL_ON_ERROR(dwError);
+
+    nIndex = pEntry->nIndex;
+    pEntry->pszModule = pModule->pszName;
+
+    dwError = coapi_footprint_add(pWalk,
+                                  pModule,
+                                  coapi_footprint_round(sizeof(*pModule)),
+                                  pEntry,
+                                  &pEntry->nNodeBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pModule->pszDefaultName,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pModule->pszName,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(pWalk,
+                                         pModule->pszDescription,
+                                         pEntry,
+                                         &pEntry->nStringBytes);
+    BAIL_ON_ERROR(dwError);
+
+    for(pEndPoint = pModule->pEndPoints;
+        pEndPoint;
+        pEndPoint = pEndPoint->pNext)
+    {
+        dwError = coapi_footprint_walk_endpoint(pWalk, nIndex, pEndPoint);
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//the arrays of coapi_build_api_table
+size_t
+coapi_footprint_get_index_bytes(
+    PCOAPI_API_TABLE pTable
+    )
+{
+    size_t nBytes = 0;
+
+    if(!pTable)
+    {
+        return 0;
+    }
+
+    nBytes = coapi_footprint_round(sizeof(*pTable));
+    nBytes += coapi_footprint_round(
+                  sizeof(uint32_t) * (pTable->nEndPointCount + 1));
+    nBytes += coapi_footprint_round(
+                  sizeof(uint32_t) * (pTable->nMethodCount + 1));
+    if(pTable->nEndPointCount)
+    {
+        nBytes += coapi_footprint_round(
+                      sizeof(char *) * pTable->nEndPointCount);
+        nBytes += 2 * coapi_footprint_round(
+                          sizeof(uint32_t) * pTable->nEndPointCount);
+        nBytes += coapi_footprint_round(
+                      sizeof(PREST_API_ENDPOINT) * pTable->nEndPointCount);
+    }
+    if(pTable->nMethodCount)
+    {
+        nBytes += coapi_footprint_round(
+                      sizeof(PREST_API_METHOD) * pTable->nMethodCount);
+    }
+    if(pTable->nParamCount)
+    {
+        nBytes += coapi_footprint_round(
+                      sizeof(PREST_API_PARAM) * pTable->nParamCount);
+    }
+    return nBytes;
+}
+
+uint32_t
+coapi_get_footprint(
+    PREST_API_DEF pApiDef,
+    PCOAPI_FOOTPRINT *ppFootprint
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_FOOTPRINT_WALK stWalk = {0};
+    PCOAPI_FOOTPRINT pFootprint = NULL;
+    PREST_API_MODULE pModule = NULL;
+    size_t i = 0;
+
+    if(!pApiDef || !ppFootprint)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_allocate_memory(sizeof(COAPI_FOOTPRINT),
+                                    (void **)&pFootprint);
+    BAIL_ON_ERROR(dwError);
+
+    stWalk.pApiDef = pApiDef;
+    stWalk.pFootprint = pFootprint;
+
+    dwError = coapi_footprint_add(&stWalk,
+                                  pApiDef,
+                                  coapi_footprint_round(sizeof(*pApiDef)),
+                                  NULL,
+                                  &pFootprint->nDefBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(&stWalk,
+                                         pApiDef->pszHost,
+                                         NULL,
+                                         &pFootprint->nDefBytes);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_footprint_add_string(&stWalk,
+                                         pApiDef->pszBasePath,
+                                         NULL,
+                                         &pFootprint->nDefBytes);
+    BAIL_ON_ERROR(dwError);
+
+    pFootprint->nIndexBytes = coapi_footprint_get_index_bytes(
+                                  pApiDef->pTable);
+
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        dwError = coapi_footprint_walk_module(&stWalk, pModule);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pFootprint->nTotalBytes = pFootprint->nDefBytes +
+                              pFootprint->nIndexBytes;
+    for(i = 0; i < pFootprint->nEntryCount; ++i)
+    {
+        PCOAPI_FOOTPRINT_ENTRY pEntry = &pFootprint->pEntries[i];
+
+        if(pEntry->nLevel == COAPI_FOOTPRINT_MODULE)
+        {
+            pFootprint->nTotalBytes += pEntry->nStringBytes +
+                                       pEntry->nOptionBytes +
+                                       pEntry->nNodeBytes;
+        }
+    }
+
+    if(pApiDef->pArena)
+    {
+        pFootprint->nArenaBytes = pApiDef->pArena->nAllocatedBytes;
+    }
+    pFootprint->nImageBytes = pApiDef->nImageSize;
+
+    *ppFootprint = pFootprint;
+
+cleanup:
+    coapi_pointer_map_free(&stWalk.stSeen);
+    return dwError;
+
+error:
+    if(ppFootprint)
+    {
+        *ppFootprint = NULL;
+    }
+    coapi_free_footprint(pFootprint);
+    goto cleanup;
+}
+
+size_t
+coapi_footprint_entry_bytes(
+    PCOAPI_FOOTPRINT_ENTRY pEntry
+    )
+{
+    return pEntry->nStringBytes + pEntry->nOptionBytes + pEntry->nNodeBytes;
+}
+
+//larger first, then def order
+int
+coapi_footprint_compare_bytes(
+    size_t nLeft,
+    size_t nRight,
+    PCOAPI_FOOTPRINT_ENTRY pLeft,
+    PCOAPI_FOOTPRINT_ENTRY pRight
+    )
+{
+    if(nLeft != nRight)
+    {
+        return nLeft > nRight ? -1 : 1;
+    }
+    return pLeft->nIndex < pRight->nIndex ? -1 :
+           pLeft->nIndex > pRight->nIndex;
+}
+
+int
+coapi_footprint_compare_def(
+    const void *pLeft,
+    const void *pRight
+    )
+{
+    return coapi_footprint_compare_bytes(0,
+                                         0,
+                                         (PCOAPI_FOOTPRINT_ENTRY)pLeft,
+                                         (PCOAPI_FOOTPRINT_ENTRY)pRight);
+}
+
+int
+coapi_footprint_compare_total(
+    const void *pLeft,
+    const void *pRight
+    )
+{
+    PCOAPI_FOOTPRINT_ENTRY pLeftEntry = (PCOAPI_FOOTPRINT_ENTRY)pLeft;
+    PCOAPI_FOOTPRINT_ENTRY pRightEntry = (PCOAPI_FOOTPRINT_ENTRY)pRight;
+
+    return coapi_footprint_compare_bytes(
+               coapi_footprint_entry_bytes(pLeftEntry),
+               coapi_footprint_entry_bytes(pRightEntry),
+               pLeftEntry,
+               pRightEntry);
+}
+
+int
+coapi_footprint_compare_strings(
+    const void *pLeft,
+    const void *pRight
+    )
+{
+    PCOAPI_FOOTPRINT_ENTRY pLeftEntry = (PCOAPI_FOOTPRINT_ENTRY)pLeft;
+    PCOAPI_FOOTPRINT_ENTRY pRightEntry = (PCOAPI_FOOTPRINT_ENTRY)pRight;
+
+    return coapi_footprint_compare_bytes(pLeftEntry->nStringBytes,
+                                         pRightEntry->nStringBytes,
+                                         pLeftEntry,
+                                         pRightEntry);
+}
+
+int
+coapi_footprint_compare_options(
+    const void *pLeft,
+    const void *pRight
+    )
+{
+    PCOAPI_FOOTPRINT_ENTRY pLeftEntry = (PCOAPI_FOOTPRINT_ENTRY)pLeft;
+    PCOAPI_FOOTPRINT_ENTRY pRightEntry = (PCOAPI_FOOTPRINT_ENTRY)pRight;
+
+    return coapi_footprint_compare_bytes(pLeftEntry->nOptionBytes,
+                                         pRightEntry->nOptionBytes,
+                                         pLeftEntry,
+                                         pRightEntry);
+}
+
+int
+coapi_footprint_compare_nodes(
+    const void *pLeft,
+    const void *pRight
+    )
+{
+    PCOAPI_FOOTPRINT_ENTRY pLeftEntry = (PCOAPI_FOOTPRINT_ENTRY)pLeft;
+    PCOAPI_FOOTPRINT_ENTRY pRightEntry = (PCOAPI_FOOTPRINT_ENTRY)pRight;
+
+    return coapi_footprint_compare_bytes(pLeftEntry->nNodeBytes,
+                                         pRightEntry->nNodeBytes,
+                                         pLeftEntry,
+                                         pRightEntry);
+}
+
+int
+coapi_footprint_compare_shared(
+    const void *pLeft,
+    const void *pRight
+    )
+{
+    PCOAPI_FOOTPRINT_ENTRY pLeftEntry = (PCOAPI_FOOTPRINT_ENTRY)pLeft;
+    PCOAPI_FOOTPRINT_ENTRY pRightEntry = (PCOAPI_FOOTPRINT_ENTRY)pRight;
+
+    return coapi_footprint_compare_bytes(pLeftEntry->nSharedBytes,
+                                         pRightEntry->nSharedBytes,
+                                         pLeftEntry,
+                                         pRightEntry);
+}
+
+uint32_t
+coapi_sort_footprint(
+    PCOAPI_FOOTPRINT pFootprint,
+    COAPI_FOOTPRINT_SORT nSort
+    )
+{
+    uint32_t dwError = 0;
+    int (*pfnCompare)(const void *, const void *) = NULL;
+
+    if(!pFootprint)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    switch(nSort)
+    {
+        case COAPI_FOOTPRINT_SORT_DEF:
+            pfnCompare = coapi_footprint_compare_def;
+            break;
+        case COAPI_FOOTPRINT_SORT_TOTAL:
+            pfnCompare = coapi_footprint_compare_total;
+            break;
+        case COAPI_FOOTPRINT_SORT_STRINGS:
+            pfnCompare = coapi_footprint_compare_strings;
+            break;
+        case COAPI_FOOTPRINT_SORT_OPTIONS:
+            pfnCompare = coapi_footprint_compare_options;
+            break;
+        case COAPI_FOOTPRINT_SORT_NODES:
+            pfnCompare = coapi_footprint_compare_nodes;
+            break;
+        case COAPI_FOOTPRINT_SORT_SHARED:
+            pfnCompare = coapi_footprint_compare_shared;
+            break;
+        default:
+            dwError = EINVAL;
+            BAIL_ON_ERROR(dwError);
+    }
+
+    if(pFootprint->nEntryCount > 1)
+    {
+        qsort(pFootprint->pEntries,
+              pFootprint->nEntryCount,
+              sizeof(COAPI_FOOTPRINT_ENTRY),
+              pfnCompare);
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_get_footprint_level(
+    const char *pszLevel,
+    COAPI_FOOTPRINT_LEVEL *pnLevel
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_FOOTPRINT_LEVEL nLevel = COAPI_FOOTPRINT_LEVEL_COUNT;
+
+    if(!pszLevel || !pnLevel)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!strcasecmp(pszLevel, "module"))
+    {
+        nLevel = COAPI_FOOTPRINT_MODULE;
+    }
+    else if(!strcasecmp(pszLevel, "endpoint"))
+    {
+        nLevel = COAPI_FOOTPRINT_ENDPOINT;
+    }
+    else if(!strcasecmp(pszLevel, "method"))
+    {
+        nLevel = COAPI_FOOTPRINT_METHOD;
+    }
+    else if(!strcasecmp(pszLevel, "param"))
+    {
+        nLevel = COAPI_FOOTPRINT_PARAM;
+    }
+    else
+    {
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *pnLevel = nLevel;
+
+cleanup:
+    return dwError;
+
+error:
+    if(pnLevel)
+    {
+        *pnLevel = COAPI_FOOTPRINT_LEVEL_COUNT;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_get_footprint_sort(
+    const char *pszSort,
+    COAPI_FOOTPRINT_SORT *pnSort
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_FOOTPRINT_SORT nSort = COAPI_FOOTPRINT_SORT_INVALID;
+
+    if(!pszSort || !pnSort)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!strcasecmp(pszSort, "def"))
+    {
+        nSort = COAPI_FOOTPRINT_SORT_DEF;
+    }
+    else if(!strcasecmp(pszSort, "total"))
+    {
+        nSort = COAPI_FOOTPRINT_SORT_TOTAL;
+    }
+    else if(!strcasecmp(pszSort, "strings"))
+    {
+        nSort = COAPI_FOOTPRINT_SORT_STRINGS;
+    }
+    else if(!strcasecmp(pszSort, "options"))
+    {
+        nSort = COAPI_FOOTPRINT_SORT_OPTIONS;
+    }
+    else if(!strcasecmp(pszSort, "nodes"))
+    {
+        nSort = COAPI_FOOTPRINT_SORT_NODES;
+    }
+    else if(!strcasecmp(pszSort, "shared"))
+    {
+        nSort = COAPI_FOOTPRINT_SORT_SHARED;
+    }
+    else
+    {
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *pnSort = nSort;
+
+cleanup:
+    return dwError;
+
+error:
+    if(pnSort)
+    {
+        *pnSort = COAPI_FOOTPRINT_SORT_INVALID;
+    }
+    goto cleanup;
+}
+
+const char *
+coapi_footprint_name(
+    const char *pszName
+    )
+{
+    return pszName ? pszName : "-";
+}
+
+//names are last so that lines can also be sorted by column
+void
+coapi_print_footprint(
+    PCOAPI_FOOTPRINT pFootprint,
+    COAPI_FOOTPRINT_LEVEL nLevel
+    )
+{
+    size_t nModuleBytes = 0;
+    size_t i = 0;
+
+    if(!pFootprint)
+    {
+        return;
+    }
+
+    nModuleBytes = pFootprint->nTotalBytes -
+                   pFootprint->nDefBytes -
+                   pFootprint->nIndexBytes;
+
+    printf("def           : %zu\n", pFootprint->nDefBytes);
+    printf("index         : %zu\n", pFootprint->nIndexBytes);
+    printf("modules       : %zu\n", nModuleBytes);
+    printf("total         : %zu\n", pFootprint->nTotalBytes);
+    printf("arena         : %zu\n", pFootprint->nArenaBytes);
+    if(pFootprint->nImageBytes)
+    {
+        printf("image         : %zu\n", pFootprint->nImageBytes);
+    }
+    if(pFootprint->nBorrowedBytes)
+    {
+        printf("borrowed      : %zu\n", pFootprint->nBorrowedBytes);
+    }
+    printf("\n");
+    printf("%10s %10s %10s %10s %10s  %s\n",
+           "total", "strings", "options", "nodes", "shared", "name");
+
+    for(i = 0; i < pFootprint->nEntryCount; ++i)
+    {
+        PCOAPI_FOOTPRINT_ENTRY pEntry = &pFootprint->pEntries[i];
+
+        if(pEntry->nLevel != nLevel)
+        {
+            continue;
+        }
+
+        printf("%10zu %10zu %10zu %10zu %10zu  %s",
+               coapi_footprint_entry_bytes(pEntry),
+               pEntry->nStringBytes,
+               pEntry->nOptionBytes,
+               pEntry->nNodeBytes,
+               pEntry->nSharedBytes,
+               coapi_footprint_name(pEntry->pszModule));
+        if(nLevel >= COAPI_FOOTPRINT_ENDPOINT)
+        {
+            printf(" %s", coapi_footprint_name(pEntry->pszEndPoint));
+        }
+        if(nLevel >= COAPI_FOOTPRINT_METHOD)
+        {
+            printf(" %s", coapi_footprint_name(pEntry->pszMethod));
+        }
+        if(nLevel >= COAPI_FOOTPRINT_PARAM)
+        {
+            printf(" %s", coapi_footprint_name(pEntry->pszParam));
+        }
+        printf("\n");
+    }
+}
+
+void
+coapi_free_footprint(
+    PCOAPI_FOOTPRINT pFootprint
+    )
+{
+    if(!pFootprint)
+    {
+        return;
+    }
+    SAFE_FREE_MEMORY(pFootprint->pEntries);
+    coapi_free_memory(pFootprint);
+}
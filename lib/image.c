@@ -0,0 +1,1704 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Compiled spec images.
+//An image is a flat copy of a loaded REST_API_DEF where every pointer is
+//written as if the file was mapped at COAPI_IMAGE_PREFERRED_BASE. The
+//offsets of all pointers are kept in a relocation table at the end.
+//Loading maps the file privately at the preferred address; if the kernel
+//places it elsewhere, the pointers are moved by the difference.
+
+#include "includes.h"
+
+uint32_t
+coapi_image_reserve(
+    PCOAPI_IMAGE_WRITER pWriter,
+    size_t nSize,
+    size_t *pnOffset
+    )
+{
+    uint32_t dwError = 0;
+    size_t nOffset = 0;
+    size_t nCapacity = 0;
+    char *pData = NULL;
+
+    if(!pWriter || !nSize || !pnOffset)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nOffset = (pWriter->nSize + COAPI_IMAGE_ALIGN - 1) &
+              ~((size_t)COAPI_IMAGE_ALIGN - 1);
+
+    if(nOffset + nSize > pWriter->nCapacity)
+    {
+        nCapacity = pWriter->nCapacity ?
+                    pWriter->nCapacity : COAPI_IMAGE_INITIAL_SIZE;
+        while(nCapacity < nOffset + nSize)
+        {
+            nCapacity *= 2;
+        }
+
+        dwError = coapi_reallocate_memory(
+                      pWriter->pData,
+                      nCapacity,
+                      (void **)&pData);
+        BAIL_ON_ERROR(dwError);
+
+        memset(pData + pWriter->nCapacity,
+               0,
+               nCapacity - pWriter->nCapacity);
+
+        pWriter->pData = pData;
+        pWriter->nCapacity = nCapacity;
+    }
+
+    pWriter->nSize = nOffset + nSize;
+    *pnOffset = nOffset;
+
+cleanup:
+    return dwError;
+
+error:
+    if(pnOffset)
+    {
+        *pnOffset = 0;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_image_add_reloc(
+    PCOAPI_IMAGE_WRITER pWriter,
+    size_t nSlot,
+    size_t nTarget
+    )
+{
+    uint32_t dwError = 0;
+    uintptr_t nValue = 0;
+    size_t nCapacity = 0;
+    uint64_t *pRelocs = NULL;
+
+    if(!pWriter || nSlot + sizeof(nValue) > pWriter->nSize)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pWriter->nRelocCount == pWriter->nRelocCapacity)
+    {
+        nCapacity = pWriter->nRelocCapacity ?
+                    pWriter->nRelocCapacity * 2 : 1024;
+
+        dwError = coapi_reallocate_memory(
+                      pWriter->pRelocs,
+                      nCapacity * sizeof(uint64_t),
+                      (void **)&pRelocs);
+        BAIL_ON_ERROR(dwError);
+
+        pWriter->pRelocs = pRelocs;
+        pWriter->nRelocCapacity = nCapacity;
+    }
+
+    nValue = (uintptr_t)(COAPI_IMAGE_PREFERRED_BASE + nTarget);
+    memcpy(pWriter->pData + nSlot, &nValue, sizeof(nValue));
+
+    pWriter->pRelocs[pWriter->nRelocCount++] = nSlot;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//offset 0 is the header, so a 0 target means a NULL pointer
+uint32_t
+coapi_image_set_pointer(
+    PCOAPI_IMAGE_WRITER pWriter,
+    size_t nSlot,
+    size_t nTarget
+    )
+{
+    if(!nTarget)
+    {
+        return 0;
+    }
+    return coapi_image_add_reloc(pWriter, nSlot, nTarget);
+}
+
+uint32_t
+coapi_image_put_string(
+    PCOAPI_IMAGE_WRITER pWriter,
+    const char *pszString,
+    size_t nSlot
+    )
+{
+    uint32_t dwError = 0;
+    size_t nOffset = 0;
+    size_t nLength = 0;
+
+    if(!pWriter)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!pszString)
+    {
+        goto cleanup;
+    }
+
+    nLength = strlen(pszString);
+
+    dwError = coapi_image_reserve(pWriter, nLength + 1, &nOffset);
+    BAIL_ON_ERROR(dwError);
+
+    memcpy(pWriter->pData + nOffset, pszString, nLength);
+
+    dwError = coapi_image_set_pointer(pWriter, nSlot, nOffset);
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//params shared by several lists are written once. a list that reaches
+//a param already in the image links to it, along with its tail.
+uint32_t
+coapi_image_write_params(
+    PCOAPI_IMAGE_WRITER pWriter,
+    PREST_API_PARAM pParams,
+    size_t nHeadSlot
+    )
+{
+    uint32_t dwError = 0;
+    size_t nSlot = nHeadSlot;
+    PREST_API_PARAM pParam = NULL;
+
+    if(!pWriter)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    for(pParam = pParams; pParam; pParam = pParam->pNext)
+    {
+        int i = 0;
+        size_t nOffset = 0;
+        size_t nOptions = 0;
+        PREST_API_PARAM pOut = NULL;
+
+        dwError = coapi_pointer_map_get(&pWriter->stWritten, pParam, &nOffset);
+        if(!dwError)
+        {
+            dwError = coapi_image_set_pointer(pWriter, nSlot, nOffset);
+            BAIL_ON_ERROR(dwError);
+            break;
+        }
+        if(dwError == ENOENT)
+        {
+            dwError = 0;
+        }
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_reserve(
+                      pWriter,
+                      sizeof(REST_API_PARAM),
+                      &nOffset);
+        BAIL_ON_ERROR(dwError);
+
+        pOut = (PREST_API_PARAM)(pWriter->pData + nOffset);
+        pOut->nIn = pParam->nIn;
+        pOut->nRequired = pParam->nRequired;
+        pOut->nType = pParam->nType;
+        pOut->nOptionCount = pParam->nOptionCount;
+
+        dwError = coapi_image_put_string(
+                      pWriter,
+                      pParam->pszName,
+                      nOffset + offsetof(REST_API_PARAM, pszName));
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_put_string(
+                      pWriter,
+                      pParam->pszIn,
+                      nOffset + offsetof(REST_API_PARAM, pszIn));
+        BAIL_ON_ERROR(dwError);
+
+        if(pParam->nOptionCount > 0 && pParam->ppszOptions)
+        {
+            dwError = coapi_pointer_map_get(&pWriter->stWritten,
+                                            pParam->ppszOptions,
+                                            &nOptions);
+            if(dwError == ENOENT)
+            {
+                dwError = coapi_image_reserve(
+                              pWriter,
+                              sizeof(char *) * pParam->nOptionCount,
+                              &nOptions);
+                BAIL_ON_ERROR(dwError);
+
+                for(i = 0; i < pParam->nOptionCount; ++i)
+                {
+                    dwError = coapi_image_put_string(
+                                  pWriter,
+                                  pParam->ppszOptions[i],
+                                  nOptions + sizeof(char *) * i);
+                    BAIL_ON_ERROR(dwError);
+                }
+
+                dwError = coapi_pointer_map_set(&pWriter->stWritten,
+                                                pParam->ppszOptions,
+                                                nOptions);
+            }
+            BAIL_ON_ERROR(dwError);
+
+            dwError = coapi_image_set_pointer(
+                          pWriter,
+                          nOffset + offsetof(REST_API_PARAM, ppszOptions),
+                          nOptions);
+            BAIL_ON_ERROR(dwError);
+        }
+
+        dwError = coapi_pointer_map_set(&pWriter->stWritten, pParam, nOffset);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_set_pointer(pWriter, nSlot, nOffset);
+        BAIL_ON_ERROR(dwError);
+
+        nSlot = nOffset + offsetof(REST_API_PARAM, pNext);
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_image_write_method(
+    PCOAPI_IMAGE_WRITER pWriter,
+    PREST_API_METHOD pMethod,
+    size_t nSlot
+    )
+{
+    uint32_t dwError = 0;
+    size_t nOffset = 0;
+
+    if(!pWriter || !pMethod)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_image_reserve(pWriter, sizeof(REST_API_METHOD), &nOffset);
+    BAIL_ON_ERROR(dwError);
+
+    //implementations are mapped at runtime, pFnImpl stays NULL
+    ((PREST_API_METHOD)(pWriter->pData + nOffset))->nMethod = pMethod->nMethod;
+
+    dwError = coapi_image_put_string(
+                  pWriter,
+                  pMethod->pszMethod,
+                  nOffset + offsetof(REST_API_METHOD, pszMethod));
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_put_string(
+                  pWriter,
+                  pMethod->pszSummary,
+                  nOffset + offsetof(REST_API_METHOD, pszSummary));
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_put_string(
+                  pWriter,
+                  pMethod->pszDescription,
+                  nOffset + offsetof(REST_API_METHOD, pszDescription));
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_write_params(
+                  pWriter,
+                  pMethod->pParams,
+                  nOffset + offsetof(REST_API_METHOD, pParams));
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_set_pointer(pWriter, nSlot, nOffset);
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_image_write_endpoints(
+    PCOAPI_IMAGE_WRITER pWriter,
+    PREST_API_ENDPOINT pEndPoints,
+    size_t nHeadSlot
+    )
+{
+    uint32_t dwError = 0;
+    size_t nSlot = nHeadSlot;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+
+    if(!pWriter)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    for(pEndPoint = pEndPoints; pEndPoint; pEndPoint = pEndPoint->pNext)
+    {
+        int i = 0;
+        size_t nOffset = 0;
+
+        dwError = coapi_image_reserve(
+                      pWriter,
+                      sizeof(REST_API_ENDPOINT),
+                      &nOffset);
+        BAIL_ON_ERROR(dwError);
+
+        ((PREST_API_ENDPOINT)(pWriter->pData + nOffset))->nHasPathSubs =
+            pEndPoint->nHasPathSubs;
+
+        dwError = coapi_image_put_string(
+                      pWriter,
+                      pEndPoint->pszName,
+                      nOffset + offsetof(REST_API_ENDPOINT, pszName));
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_put_string(
+                      pWriter,
+                      pEndPoint->pszActualName,
+                      nOffset + offsetof(REST_API_ENDPOINT, pszActualName));
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_put_string(
+                      pWriter,
+                      pEndPoint->pszCommandName,
+                      nOffset + offsetof(REST_API_ENDPOINT, pszCommandName));
+        BAIL_ON_ERROR(dwError);
+
+        //path level params are written first, methods link to them
+        dwError = coapi_image_write_params(
+                      pWriter,
+                      pEndPoint->pParams,
+                      nOffset + offsetof(REST_API_ENDPOINT, pParams));
+        BAIL_ON_ERROR(dwError);
+
+        for(i = 0; i < METHOD_COUNT; ++i)
+        {
+            if(!pEndPoint->pMethods[i])
+            {
+                continue;
+            }
+            dwError = coapi_image_write_method(
+                          pWriter,
+                          pEndPoint->pMethods[i],
+                          nOffset + offsetof(REST_API_ENDPOINT, pMethods) +
+                          sizeof(PREST_API_METHOD) * i);
+            BAIL_ON_ERROR(dwError);
+        }
+
+        dwError = coapi_image_set_pointer(pWriter, nSlot, nOffset);
+        BAIL_ON_ERROR(dwError);
+
+        nSlot = nOffset + offsetof(REST_API_ENDPOINT, pNext);
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_image_write_modules(
+    PCOAPI_IMAGE_WRITER pWriter,
+    PREST_API_MODULE pModules,
+    size_t nHeadSlot
+    )
+{
+    uint32_t dwError = 0;
+    size_t nSlot = nHeadSlot;
+    PREST_API_MODULE pModule = NULL;
+
+    if(!pWriter)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    for(pModule = pModules; pModule; pModule = pModule->pNext)
+    {
+        size_t nOffset = 0;
+
+        dwError = coapi_image_reserve(
+                      pWriter,
+                      sizeof(REST_API_MODULE),
+                      &nOffset);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_put_string(
+                      pWriter,
+                      pModule->pszDefaultName,
+                      nOffset + offsetof(REST_API_MODULE, pszDefaultName));
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_put_string(
+                      pWriter,
+                      pModule->pszName,
+                      nOffset + offsetof(REST_API_MODULE, pszName));
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_put_string(
+                      pWriter,
+                      pModule->pszDescription,
+                      nOffset + offsetof(REST_API_MODULE, pszDescription));
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_write_endpoints(
+                      pWriter,
+                      pModule->pEndPoints,
+                      nOffset + offsetof(REST_API_MODULE, pEndPoints));
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_set_pointer(pWriter, nSlot, nOffset);
+        BAIL_ON_ERROR(dwError);
+
+        nSlot = nOffset + offsetof(REST_API_MODULE, pNext);
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_image_write(
+    PREST_API_DEF pApiDef,
+    const char *pszPath,
+    size_t nSourceLength,
+    uint64_t nSourceHash,
+    PCOAPI_IMAGE_WRITER pWriter
+    )
+{
+    uint32_t dwError = 0;
+    size_t nHeader = 0;
+    size_t nDef = 0;
+    size_t nRelocs = 0;
+    size_t nRelocCount = 0;
+    size_t nPath = 0;
+    size_t nPathLength = 0;
+    PCOAPI_IMAGE_HEADER pHeader = NULL;
+    PREST_API_DEF pDefOut = NULL;
+
+    if(!pApiDef || !pszPath || !pWriter)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_image_reserve(pWriter, sizeof(COAPI_IMAGE_HEADER), &nHeader);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_reserve(pWriter, sizeof(REST_API_DEF), &nDef);
+    BAIL_ON_ERROR(dwError);
+
+    pDefOut = (PREST_API_DEF)(pWriter->pData + nDef);
+    pDefOut->nNoModules = pApiDef->nNoModules;
+    pDefOut->nHasSecureScheme = pApiDef->nHasSecureScheme;
+
+    //pImage points at the start of the mapping
+    dwError = coapi_image_add_reloc(
+                  pWriter,
+                  nDef + offsetof(REST_API_DEF, pImage),
+                  nHeader);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_put_string(
+                  pWriter,
+                  pApiDef->pszHost,
+                  nDef + offsetof(REST_API_DEF, pszHost));
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_put_string(
+                  pWriter,
+                  pApiDef->pszBasePath,
+                  nDef + offsetof(REST_API_DEF, pszBasePath));
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_write_modules(
+                  pWriter,
+                  pApiDef->pModules,
+                  nDef + offsetof(REST_API_DEF, pModules));
+    BAIL_ON_ERROR(dwError);
+
+    nPathLength = strlen(pszPath);
+    dwError = coapi_image_reserve(pWriter, nPathLength + 1, &nPath);
+    BAIL_ON_ERROR(dwError);
+
+    memcpy(pWriter->pData + nPath, pszPath, nPathLength);
+
+    //relocation table goes last and does not relocate itself
+    nRelocCount = pWriter->nRelocCount;
+    if(nRelocCount)
+    {
+        dwError = coapi_image_reserve(
+                      pWriter,
+                      sizeof(uint64_t) * nRelocCount,
+                      &nRelocs);
+        BAIL_ON_ERROR(dwError);
+
+        memcpy(pWriter->pData + nRelocs,
+               pWriter->pRelocs,
+               sizeof(uint64_t) * nRelocCount);
+    }
+
+    ((PREST_API_DEF)(pWriter->pData + nDef))->nImageSize = pWriter->nSize;
+
+    pHeader = (PCOAPI_IMAGE_HEADER)(pWriter->pData + nHeader);
+    memcpy(pHeader->szMagic, COAPI_IMAGE_MAGIC, sizeof(pHeader->szMagic));
+    pHeader->dwVersion = COAPI_IMAGE_VERSION;
+    pHeader->dwPointerSize = sizeof(void *);
+    pHeader->dwDefSize = sizeof(REST_API_DEF);
+    pHeader->dwModuleSize = sizeof(REST_API_MODULE);
+    pHeader->dwEndPointSize = sizeof(REST_API_ENDPOINT);
+    pHeader->dwMethodSize = sizeof(REST_API_METHOD);
+    pHeader->dwParamSize = sizeof(REST_API_PARAM);
+    pHeader->nImageSize = pWriter->nSize;
+    pHeader->nPreferredBase = COAPI_IMAGE_PREFERRED_BASE;
+    pHeader->nDefOffset = nDef;
+    pHeader->nRelocOffset = nRelocs;
+    pHeader->nRelocCount = nRelocCount;
+    pHeader->nSourceLength = nSourceLength;
+    pHeader->nSourceHash = nSourceHash;
+    pHeader->nPathOffset = nPath;
+    pHeader->nPathLength = nPathLength;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_image_save(
+    PCOAPI_IMAGE_WRITER pWriter,
+    const char *pszImageFile
+    )
+{
+    uint32_t dwError = 0;
+    char *pszTempFile = NULL;
+    int fd = -1;
+    size_t nWritten = 0;
+
+    if(!pWriter || !pWriter->nSize || IsNullOrEmptyString(pszImageFile))
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //write aside and rename so readers never map a partial image
+    dwError = coapi_allocate_string_printf(
+                  &pszTempFile,
+                  "%s.XXXXXX",
+                  pszImageFile);
+    BAIL_ON_ERROR(dwError);
+
+    fd = mkstemp(pszTempFile);
+    if(fd < 0)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    while(nWritten < pWriter->nSize)
+    {
+        ssize_t nBytes = write(fd,
+                               pWriter->pData + nWritten,
+                               pWriter->nSize - nWritten);
+        if(nBytes < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            dwError = errno;
+            BAIL_ON_ERROR(dwError);
+        }
+        nWritten += nBytes;
+    }
+
+    if(fchmod(fd, 0644) || close(fd))
+    {
+        fd = -1;
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+    fd = -1;
+
+    if(rename(pszTempFile, pszImageFile))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    SAFE_FREE_MEMORY(pszTempFile);
+    return dwError;
+
+error:
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+    if(pszTempFile)
+    {
+        unlink(pszTempFile);
+    }
+    goto cleanup;
+}
+
+void
+coapi_image_free_writer(
+    PCOAPI_IMAGE_WRITER pWriter
+    )
+{
+    if(pWriter)
+    {
+        SAFE_FREE_MEMORY(pWriter->pData);
+        SAFE_FREE_MEMORY(pWriter->pRelocs);
+        coapi_pointer_map_free(&pWriter->stWritten);
+        memset(pWriter, 0, sizeof(*pWriter));
+    }
+}
+
+uint32_t
+coapi_image_check_header(
+    PCOAPI_IMAGE_HEADER pHeader,
+    size_t nFileSize,
+    PCOAPI_SPEC_INDEX pSource
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!pHeader || !pSource)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(memcmp(pHeader->szMagic, COAPI_IMAGE_MAGIC, sizeof(pHeader->szMagic)) ||
+       pHeader->dwVersion != COAPI_IMAGE_VERSION ||
+       pHeader->dwPointerSize != sizeof(void *) ||
+       pHeader->dwDefSize != sizeof(REST_API_DEF) ||
+       pHeader->dwModuleSize != sizeof(REST_API_MODULE) ||
+       pHeader->dwEndPointSize != sizeof(REST_API_ENDPOINT) ||
+       pHeader->dwMethodSize != sizeof(REST_API_METHOD) ||
+       pHeader->dwParamSize != sizeof(REST_API_PARAM))
+    {
+        dwError = ESTALE;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pHeader->nImageSize != nFileSize ||
+       pHeader->nDefOffset < sizeof(COAPI_IMAGE_HEADER) ||
+       pHeader->nDefOffset > nFileSize - sizeof(REST_API_DEF) ||
+       pHeader->nRelocOffset > nFileSize ||
+       pHeader->nRelocOffset % sizeof(uint64_t) ||
+       pHeader->nRelocCount >
+           (nFileSize - pHeader->nRelocOffset) / sizeof(uint64_t) ||
+       pHeader->nPathOffset < sizeof(COAPI_IMAGE_HEADER) ||
+       pHeader->nPathOffset >= nFileSize ||
+       pHeader->nPathLength >= nFileSize - pHeader->nPathOffset)
+    {
+        dwError = EBADMSG;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //the spec text changed since this image was compiled
+    if(pHeader->nSourceLength != pSource->nTextLength ||
+       pHeader->nSourceHash != pSource->nTextHash)
+    {
+        dwError = ESTALE;
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_image_relocate(
+    char *pBase,
+    PCOAPI_IMAGE_HEADER pHeader
+    )
+{
+    uint32_t dwError = 0;
+    uint64_t i = 0;
+    uintptr_t nDelta = 0;
+    uint64_t *pRelocs = NULL;
+
+    if(!pBase || !pHeader)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nDelta = (uintptr_t)pBase - (uintptr_t)pHeader->nPreferredBase;
+    pRelocs = (uint64_t *)(pBase + pHeader->nRelocOffset);
+
+    //every slot is checked, also when nothing moves. pages at the
+    //preferred base are only read, so they stay shared.
+    for(i = 0; i < pHeader->nRelocCount; ++i)
+    {
+        uintptr_t nValue = 0;
+        uint64_t nSlot = pRelocs[i];
+
+        if(nSlot > pHeader->nImageSize - sizeof(nValue) ||
+           nSlot % sizeof(nValue))
+        {
+            dwError = EBADMSG;
+            BAIL_ON_ERROR(dwError);
+        }
+
+        memcpy(&nValue, pBase + nSlot, sizeof(nValue));
+        if(nValue - (uintptr_t)pHeader->nPreferredBase >= pHeader->nImageSize)
+        {
+            dwError = EBADMSG;
+            BAIL_ON_ERROR(dwError);
+        }
+
+        if(nDelta)
+        {
+            nValue += nDelta;
+            memcpy(pBase + nSlot, &nValue, sizeof(nValue));
+        }
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//nSize bytes at p, which is not NULL, are in the image
+int
+coapi_image_is_inside(
+    PCOAPI_IMAGE_CHECK pCheck,
+    const void *p,
+    size_t nSize
+    )
+{
+    uintptr_t nOffset = (uintptr_t)p - (uintptr_t)pCheck->pBase;
+
+    return nOffset < pCheck->nImageSize &&
+           nSize <= pCheck->nImageSize - nOffset;
+}
+
+//NULL or a string that ends inside the image
+uint32_t
+coapi_image_check_string(
+    PCOAPI_IMAGE_CHECK pCheck,
+    const char *pszString
+    )
+{
+    if(!pszString)
+    {
+        return 0;
+    }
+    if(!coapi_image_is_inside(pCheck, pszString, 1) ||
+       !memchr(pszString,
+               0,
+               pCheck->pBase + pCheck->nImageSize - pszString))
+    {
+        return EBADMSG;
+    }
+    return 0;
+}
+
+//a node of kind nKind. *pnChecked is set if it was checked as one
+//before. a valid image never has nodes of two kinds at one offset.
+uint32_t
+coapi_image_check_node(
+    PCOAPI_IMAGE_CHECK pCheck,
+    const void *pNode,
+    size_t nSize,
+    uint8_t nKind,
+    int *pnChecked
+    )
+{
+    uint32_t dwError = 0;
+    uintptr_t nOffset = (uintptr_t)pNode - (uintptr_t)pCheck->pBase;
+    uint8_t nChecked = 0;
+
+    *pnChecked = 0;
+
+    if(!coapi_image_is_inside(pCheck, pNode, nSize) ||
+       nOffset % COAPI_IMAGE_ALIGN)
+    {
+        dwError = EBADMSG;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nChecked = pCheck->pNodes[nOffset / COAPI_IMAGE_ALIGN];
+    if(nChecked && nChecked != nKind)
+    {
+        dwError = EBADMSG;
+        BAIL_ON_ERROR(dwError);
+    }
+    *pnChecked = nChecked != 0;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//pNode was checked by coapi_image_check_node
+void
+coapi_image_mark_node(
+    PCOAPI_IMAGE_CHECK pCheck,
+    const void *pNode,
+    uint8_t nKind
+    )
+{
+    uintptr_t nOffset = (uintptr_t)pNode - (uintptr_t)pCheck->pBase;
+
+    pCheck->pNodes[nOffset / COAPI_IMAGE_ALIGN] = nKind;
+}
+
+//params lists share tails. a list is checked up to a param checked
+//before, then marked. a list longer than the image can hold loops.
+uint32_t
+coapi_image_check_params(
+    PCOAPI_IMAGE_CHECK pCheck,
+    PREST_API_PARAM pParams
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_PARAM pParam = NULL;
+    size_t nCount = 0;
+    int nChecked = 0;
+    int i = 0;
+
+    for(pParam = pParams; pParam; pParam = pParam->pNext)
+    {
+        dwError = coapi_image_check_node(pCheck,
+                                         pParam,
+                                         sizeof(*pParam),
+                                         COAPI_IMAGE_NODE_PARAM,
+                                         &nChecked);
+        BAIL_ON_ERROR(dwError);
+
+        if(nChecked)
+        {
+            break;
+        }
+
+        if(++nCount > pCheck->nImageSize / sizeof(*pParam) ||
+           (unsigned)pParam->nIn > RESTPARAMIN_INVALID ||
+           (unsigned)pParam->nType > RESTPARAM_INVALID ||
+           pParam->nOptionCount < 0 ||
+           (pParam->nOptionCount && !pParam->ppszOptions))
+        {
+            dwError = EBADMSG;
+            BAIL_ON_ERROR(dwError);
+        }
+
+        dwError = coapi_image_check_string(pCheck, pParam->pszName);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_check_string(pCheck, pParam->pszIn);
+        BAIL_ON_ERROR(dwError);
+
+        if(pParam->nOptionCount)
+        {
+            if(!coapi_image_is_inside(
+                    pCheck,
+                    pParam->ppszOptions,
+                    sizeof(char *) * (size_t)pParam->nOptionCount))
+            {
+                dwError = EBADMSG;
+                BAIL_ON_ERROR(dwError);
+            }
+            for(i = 0; i < pParam->nOptionCount; ++i)
+            {
+                dwError = coapi_image_check_string(pCheck,
+                                                   pParam->ppszOptions[i]);
+                BAIL_ON_ERROR(dwError);
+            }
+        }
+    }
+
+    for(pParam = pParams;
+        pParam && !pCheck->pNodes[((uintptr_t)pParam -
+                                   (uintptr_t)pCheck->pBase) /
+                                  COAPI_IMAGE_ALIGN];
+        pParam = pParam->pNext)
+    {
+        coapi_image_mark_node(pCheck, pParam, COAPI_IMAGE_NODE_PARAM);
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_image_check_method(
+    PCOAPI_IMAGE_CHECK pCheck,
+    PREST_API_METHOD pMethod
+    )
+{
+    uint32_t dwError = 0;
+    int nChecked = 0;
+
+    dwError = coapi_image_check_node(pCheck,
+                                     pMethod,
+                                     sizeof(*pMethod),
+                                     COAPI_IMAGE_NODE_METHOD,
+                                     &nChecked);
+    BAIL_ON_ERROR(dwError);
+
+    //methods are in one endpoint. implementations and details are
+    //never in an image.
+    if(nChecked ||
+       (unsigned)pMethod->nMethod >= METHOD_COUNT ||
+       pMethod->pFnImpl ||
+       pMethod->pszDetails)
+    {
+        dwError = EBADMSG;
+        BAIL_ON_ERROR(dwError);
+    }
+    coapi_image_mark_node(pCheck, pMethod, COAPI_IMAGE_NODE_METHOD);
+
+    dwError = coapi_image_check_string(pCheck, pMethod->pszMethod);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_check_string(pCheck, pMethod->pszSummary);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_check_string(pCheck, pMethod->pszDescription);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_check_params(pCheck, pMethod->pParams);
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_image_check_endpoints(
+    PCOAPI_IMAGE_CHECK pCheck,
+    PREST_API_ENDPOINT pEndPoints
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    int nChecked = 0;
+    int i = 0;
+
+    for(pEndPoint = pEndPoints; pEndPoint; pEndPoint = pEndPoint->pNext)
+    {
+        dwError = coapi_image_check_node(pCheck,
+                                         pEndPoint,
+                                         sizeof(*pEndPoint),
+                                         COAPI_IMAGE_NODE_ENDPOINT,
+                                         &nChecked);
+        BAIL_ON_ERROR(dwError);
+
+        //endpoints are in one list each, seeing one again is a loop
+        if(nChecked ||
+           !pEndPoint->pszName ||
+           !pEndPoint->pszActualName)
+        {
+            dwError = EBADMSG;
+            BAIL_ON_ERROR(dwError);
+        }
+        coapi_image_mark_node(pCheck, pEndPoint, COAPI_IMAGE_NODE_ENDPOINT);
+
+        dwError = coapi_image_check_string(pCheck, pEndPoint->pszName);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_check_string(pCheck, pEndPoint->pszActualName);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_check_string(pCheck, pEndPoint->pszCommandName);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_check_params(pCheck, pEndPoint->pParams);
+        BAIL_ON_ERROR(dwError);
+
+        for(i = 0; i < METHOD_COUNT; ++i)
+        {
+            if(!pEndPoint->pMethods[i])
+            {
+                continue;
+            }
+            dwError = coapi_image_check_method(pCheck,
+                                               pEndPoint->pMethods[i]);
+            BAIL_ON_ERROR(dwError);
+        }
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//every pointer of the def is NULL or in the image, every string ends
+//in it, lists do not loop and counts and enums are in range. this runs
+//on every load, a damaged or planted image is never handed out.
+uint32_t
+coapi_image_check_def(
+    const char *pBase,
+    PCOAPI_IMAGE_HEADER pHeader,
+    PREST_API_DEF pApiDef
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_IMAGE_CHECK stCheck = {0};
+    PREST_API_MODULE pModule = NULL;
+    int nChecked = 0;
+
+    stCheck.pBase = pBase;
+    stCheck.nImageSize = pHeader->nImageSize;
+
+    dwError = coapi_allocate_memory(
+                  pHeader->nImageSize / COAPI_IMAGE_ALIGN + 1,
+                  (void **)&stCheck.pNodes);
+    BAIL_ON_ERROR(dwError);
+
+    if(pHeader->nDefOffset % COAPI_IMAGE_ALIGN ||
+       pApiDef->pImage != (void *)pBase ||
+       pApiDef->nImageSize != pHeader->nImageSize ||
+       pApiDef->pSource ||
+       pApiDef->pszRefParameters ||
+       pApiDef->pszRefDefinitions ||
+       pApiDef->pArena ||
+       pApiDef->pTable ||
+       pApiDef->dwLoadFlags)
+    {
+        dwError = EBADMSG;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_image_check_string(&stCheck, pApiDef->pszHost);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_check_string(&stCheck, pApiDef->pszBasePath);
+    BAIL_ON_ERROR(dwError);
+
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        dwError = coapi_image_check_node(&stCheck,
+                                         pModule,
+                                         sizeof(*pModule),
+                                         COAPI_IMAGE_NODE_MODULE,
+                                         &nChecked);
+        BAIL_ON_ERROR(dwError);
+
+        if(nChecked)
+        {
+            dwError = EBADMSG;
+            BAIL_ON_ERROR(dwError);
+        }
+        coapi_image_mark_node(&stCheck, pModule, COAPI_IMAGE_NODE_MODULE);
+
+        dwError = coapi_image_check_string(&stCheck,
+                                           pModule->pszDefaultName);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_check_string(&stCheck, pModule->pszName);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_check_string(&stCheck,
+                                           pModule->pszDescription);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_check_endpoints(&stCheck, pModule->pEndPoints);
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    SAFE_FREE_MEMORY(stCheck.pNodes);
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//maps the image of pszFile if it was compiled from the text pszFile
+//has now. the text is looked up in the spec index once the image is
+//open, so specs without images never need an index. pszPath is the
+//real path of pszFile for shared images, which must belong to this
+//user and be compiled from that path, and NULL for the image next to
+//the spec.
+uint32_t
+coapi_image_load(
+    const char *pszImageFile,
+    const char *pszFile,
+    const char *pszPath,
+    PREST_API_DEF *ppApiDef
+    )
+{
+    uint32_t dwError = 0;
+    int fd = -1;
+    struct stat stImage = {0};
+    COAPI_IMAGE_HEADER stHeader = {{0}};
+    COAPI_SPEC_INDEX stSource = {{0}};
+    char *pBase = MAP_FAILED;
+    void *pPreferred = NULL;
+
+    if(IsNullOrEmptyString(pszImageFile) ||
+       IsNullOrEmptyString(pszFile) ||
+       !ppApiDef)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    fd = open(pszImageFile,
+              O_RDONLY | O_CLOEXEC | (pszPath ? O_NOFOLLOW : 0));
+    if(fd < 0)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(fstat(fd, &stImage))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pszPath)
+    {
+        dwError = coapi_check_shared_file(&stImage);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(stImage.st_size < (off_t)(sizeof(stHeader) + sizeof(REST_API_DEF)))
+    {
+        dwError = EBADMSG;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pread(fd, &stHeader, sizeof(stHeader), 0) != sizeof(stHeader))
+    {
+        dwError = EIO;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_spec_index_get(pszFile, &stSource);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_check_header(&stHeader, stImage.st_size, &stSource);
+    BAIL_ON_ERROR(dwError);
+
+    //private and writable so relocation and coapi_map_api_impl can
+    //update pointers. untouched pages stay shared with the page cache.
+    pPreferred = (void *)(uintptr_t)stHeader.nPreferredBase;
+    pBase = mmap(pPreferred,
+                 stHeader.nImageSize,
+                 PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE,
+                 fd,
+                 0);
+    if(pBase == MAP_FAILED)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pszPath &&
+       (stHeader.nPathLength != strlen(pszPath) ||
+        memcmp(pBase + stHeader.nPathOffset, pszPath, stHeader.nPathLength)))
+    {
+        dwError = ESTALE;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_image_relocate(pBase, &stHeader);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_check_def(pBase,
+                                    &stHeader,
+                                    (PREST_API_DEF)(pBase +
+                                                    stHeader.nDefOffset));
+    BAIL_ON_ERROR(dwError);
+
+    *ppApiDef = (PREST_API_DEF)(pBase + stHeader.nDefOffset);
+
+cleanup:
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+    return dwError;
+
+error:
+    if(ppApiDef)
+    {
+        *ppApiDef = NULL;
+    }
+    if(pBase != MAP_FAILED)
+    {
+        munmap(pBase, stHeader.nImageSize);
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_image_get_file_name(
+    const char *pszFile,
+    char **ppszImageFile
+    )
+{
+    return coapi_allocate_string_printf(
+               ppszImageFile,
+               "%s%s",
+               pszFile,
+               COAPI_IMAGE_EXTENSION);
+}
+
+uint32_t
+coapi_image_load_for_file(
+    const char *pszFile,
+    PREST_API_DEF *ppApiDef
+    )
+{
+    uint32_t dwError = 0;
+    char *pszImageFile = NULL;
+    PREST_API_DEF pApiDef = NULL;
+
+    if(IsNullOrEmptyString(pszFile) || !ppApiDef)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_image_get_file_name(pszFile, &pszImageFile);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_load(pszImageFile, pszFile, NULL, &pApiDef);
+    BAIL_ON_ERROR(dwError);
+
+    *ppApiDef = pApiDef;
+
+cleanup:
+    SAFE_FREE_MEMORY(pszImageFile);
+    return dwError;
+
+error:
+    if(ppApiDef)
+    {
+        *ppApiDef = NULL;
+    }
+    goto cleanup;
+}
+
+//a load of one module maps the whole image and leaves the endpoints
+//of the other modules out of the def, as a load of the json does. the
+//mapping is private, only the pages of the modules are copied.
+uint32_t
+coapi_image_filter_module(
+    PREST_API_DEF pApiDef,
+    const char *pszModule
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_MODULE pModule = NULL;
+
+    if(!pApiDef || !pApiDef->pImage || IsNullOrEmptyString(pszModule))
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        if(strcasecmp(pModule->pszName, pszModule))
+        {
+            pModule->pEndPoints = NULL;
+        }
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+void
+coapi_image_free(
+    PREST_API_DEF pApiDef
+    )
+{
+    if(pApiDef && pApiDef->pImage)
+    {
+        //copies made by coapi_unshare_method_params
+        PCOAPI_ARENA pArena = pApiDef->pArena;
+
+        munmap(pApiDef->pImage, pApiDef->nImageSize);
+        coapi_arena_free(pArena);
+    }
+}
+
+uint32_t
+coapi_compile_file(
+    const char *pszFile,
+    const char *pszImageFile
+    )
+{
+    return coapi_image_compile(pszFile, pszImageFile, NULL, NULL);
+}
+
+//pszImageFile defaults to the .coapi file next to pszFile. only the
+//parallel flag and threads of pOptions are used, images have the
+//whole spec.
+uint32_t
+coapi_image_compile(
+    const char *pszFile,
+    const char *pszImageFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    const int *pnCancel
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_LOAD_OPTIONS stOptions = {0};
+    struct stat stSource = {0};
+    char *pszJson = NULL;
+    size_t nLength = 0;
+    uint64_t nHash = 0;
+    char *pszDefaultImageFile = NULL;
+    char *pszPath = NULL;
+    PREST_API_DEF pApiDef = NULL;
+    COAPI_IMAGE_WRITER stWriter = {0};
+
+    if(IsNullOrEmptyString(pszFile))
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //stat before reading, for the index. the image has the hash of
+    //the text that was read.
+    if(stat(pszFile, &stSource))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pszPath = realpath(pszFile, NULL);
+    if(!pszPath)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(IsNullOrEmptyString(pszImageFile))
+    {
+        dwError = coapi_image_get_file_name(pszFile, &pszDefaultImageFile);
+        BAIL_ON_ERROR(dwError);
+
+        pszImageFile = pszDefaultImageFile;
+    }
+
+    dwError = coapi_file_map(pszFile, &pszJson, &nLength);
+    BAIL_ON_ERROR(dwError);
+
+    nHash = coapi_hash_text(pszJson, nLength);
+
+    if(pOptions)
+    {
+        stOptions.dwFlags = pOptions->dwFlags & COAPI_LOAD_PARALLEL;
+        stOptions.dwThreads = pOptions->dwThreads;
+    }
+
+    dwError = coapi_load_api_def(pszJson,
+                                 nLength,
+                                 &stOptions,
+                                 pnCancel,
+                                 &pApiDef);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_write(pApiDef, pszPath, nLength, nHash, &stWriter);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_save(&stWriter, pszImageFile);
+    BAIL_ON_ERROR(dwError);
+
+    coapi_spec_index_update(pszFile, &stSource, nLength, nHash);
+
+cleanup:
+    coapi_image_free_writer(&stWriter);
+    coapi_free_api_def(pApiDef);
+    SAFE_FREE_MEMORY(pszDefaultImageFile);
+    free(pszPath);
+    coapi_file_unmap(pszJson, nLength);
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//the directory of this user's shared images and spec indexes, made
+//by the first load. it is not used if someone else owns it or can
+//write to it, so no other user can place images or indexes in it.
+uint32_t
+coapi_get_shared_dir(
+    char **ppszDir
+    )
+{
+    uint32_t dwError = 0;
+    char *pszDir = NULL;
+    struct stat stDir = {0};
+
+    if(!ppszDir)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_allocate_string_printf(
+                  &pszDir,
+                  "%s/%s%lu",
+                  COAPI_SHARED_IMAGE_DIR,
+                  COAPI_SHARED_IMAGE_PREFIX,
+                  (unsigned long)geteuid());
+    BAIL_ON_ERROR(dwError);
+
+    if(mkdir(pszDir, 0700) && errno != EEXIST)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(lstat(pszDir, &stDir))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!S_ISDIR(stDir.st_mode) ||
+       stDir.st_uid != geteuid() ||
+       (stDir.st_mode & (S_IRWXG | S_IRWXO)))
+    {
+        dwError = EPERM;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppszDir = pszDir;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszDir)
+    {
+        *ppszDir = NULL;
+    }
+    SAFE_FREE_MEMORY(pszDir);
+    goto cleanup;
+}
+
+//a file opened from the shared dir must be this user's and not
+//writable by others
+uint32_t
+coapi_check_shared_file(
+    const struct stat *pFile
+    )
+{
+    if(!pFile)
+    {
+        return EINVAL;
+    }
+    if(!S_ISREG(pFile->st_mode) ||
+       pFile->st_uid != geteuid() ||
+       (pFile->st_mode & (S_IWGRP | S_IWOTH)))
+    {
+        return EPERM;
+    }
+    return 0;
+}
+
+//files in the shared dir are named after the real path of the spec,
+//so that every process of the user that loads it finds the same one.
+//the name is only a hash, files keep the path to tell specs apart.
+uint32_t
+coapi_get_shared_file_name(
+    const char *pszPath,
+    const char *pszExtension,
+    char **ppszFile
+    )
+{
+    uint32_t dwError = 0;
+    char *pszDir = NULL;
+
+    if(!pszPath || !pszExtension || !ppszFile)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_get_shared_dir(&pszDir);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_allocate_string_printf(
+                  ppszFile,
+                  "%s/%016llx%s",
+                  pszDir,
+                  (unsigned long long)coapi_hash_text(pszPath,
+                                                      strlen(pszPath)),
+                  pszExtension);
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    SAFE_FREE_MEMORY(pszDir);
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//the shared image name of pszFile and its real path
+uint32_t
+coapi_image_get_shared_name(
+    const char *pszFile,
+    char **ppszImageFile,
+    char **ppszPath
+    )
+{
+    uint32_t dwError = 0;
+    char *pszRealPath = NULL;
+    char *pszPath = NULL;
+    char *pszImageFile = NULL;
+
+    if(IsNullOrEmptyString(pszFile) || !ppszImageFile || !ppszPath)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pszRealPath = realpath(pszFile, NULL);
+    if(!pszRealPath)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_allocate_string(pszRealPath, &pszPath);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_get_shared_file_name(pszPath,
+                                         COAPI_IMAGE_EXTENSION,
+                                         &pszImageFile);
+    BAIL_ON_ERROR(dwError);
+
+    *ppszImageFile = pszImageFile;
+    *ppszPath = pszPath;
+
+cleanup:
+    free(pszRealPath);
+    return dwError;
+
+error:
+    SAFE_FREE_MEMORY(pszPath);
+    SAFE_FREE_MEMORY(pszImageFile);
+    goto cleanup;
+}
+
+//maps the shared image of pszFile. the first load of a spec, or of a
+//changed spec, compiles it and publishes the image under its shared
+//name. later loads map the same pages and only write to the ones they
+//relocate or map implementations into.
+uint32_t
+coapi_image_load_shared(
+    const char *pszFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    const int *pnCancel,
+    PREST_API_DEF *ppApiDef
+    )
+{
+    uint32_t dwError = 0;
+    char *pszImageFile = NULL;
+    char *pszPath = NULL;
+    PREST_API_DEF pApiDef = NULL;
+
+    if(IsNullOrEmptyString(pszFile) || !ppApiDef)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_image_get_shared_name(pszFile, &pszImageFile, &pszPath);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_image_load(pszImageFile, pszFile, pszPath, &pApiDef);
+    if(dwError)
+    {
+        //loads racing here each publish a whole image. the last
+        //rename wins and all of them are valid.
+        dwError = coapi_image_compile(pszFile,
+                                      pszImageFile,
+                                      pOptions,
+                                      pnCancel);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_image_load(pszImageFile, pszFile, pszPath, &pApiDef);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppApiDef = pApiDef;
+
+cleanup:
+    SAFE_FREE_MEMORY(pszImageFile);
+    SAFE_FREE_MEMORY(pszPath);
+    return dwError;
+
+error:
+    if(ppApiDef)
+    {
+        *ppApiDef = NULL;
+    }
+    goto cleanup;
+}
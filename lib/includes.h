@@ -15,17 +15,33 @@
 #pragma once
 
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdint.h>
 #include <ctype.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 #include <fnmatch.h>
-#include <jansson.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 
 #include <copenapi.h>
 
 #include "../common/includes.h"
 
 #include "defines.h"
+#include "structs.h"
 #include "prototypes.h"
@@ -0,0 +1,1088 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Streaming json reader.
+//The loaders pull values one at a time from the spec text and never build
+//a document tree. Strings are decoded into a scratch buffer owned by the
+//reader that is valid until the next string is read, or in place in the
+//text when nInSitu is set. Values the loaders do not need are skipped
+//without decoding.
+
+#include "includes.h"
+
+void
+coapi_json_reader_init(
+    PCOAPI_JSON_READER pReader,
+    const char *pszText,
+    size_t nLength
+    )
+{
+    if(pReader)
+    {
+        memset(pReader, 0, sizeof(*pReader));
+        pReader->pScanner = coapi_json_get_scanner(0);
+        pReader->pszStart = pszText;
+        pReader->pszCur = pszText;
+        pReader->pszEnd = pszText + nLength;
+    }
+}
+
+void
+coapi_json_reader_free(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    if(pReader)
+    {
+        SAFE_FREE_MEMORY(pReader->pszBuffer);
+        pReader->pszBuffer = NULL;
+        pReader->nBufferSize = 0;
+    }
+}
+
+uint32_t
+coapi_json_error(
+    PCOAPI_JSON_READER pReader,
+    const char *pszError
+    )
+{
+    int nLine = 1;
+    const char *pszPos = NULL;
+
+    if(pReader)
+    {
+        for(pszPos = pReader->pszStart; pszPos < pReader->pszCur; ++pszPos)
+        {
+            if(*pszPos == '\n')
+            {
+                ++nLine;
+            }
+        }
+    }
+    fprintf(stderr, "error reading apispec: \n line: %d\n error: %s\n",
+            nLine,
+            pszError);
+    return EINVAL;
+}
+
+void
+coapi_json_skip_space(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    const char *pszCur = pReader->pszCur;
+
+    //minified text has no space to skip
+    if(pszCur < pReader->pszEnd && (unsigned char)*pszCur > ' ')
+    {
+        return;
+    }
+    pReader->pszCur = pReader->pScanner->pfnSkipSpace(pszCur,
+                                                      pReader->pszEnd);
+}
+
+uint32_t
+coapi_json_peek(
+    PCOAPI_JSON_READER pReader,
+    COAPI_JSON_TYPE *pnType
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_JSON_TYPE nType = JSON_TYPE_NONE;
+
+    if(!pReader || !pnType)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    coapi_json_skip_space(pReader);
+    if(pReader->pszCur >= pReader->pszEnd)
+    {
+        dwError = coapi_json_error(pReader, "unexpected end of input");
+        BAIL_ON_ERROR(dwError);
+    }
+
+    switch(*pReader->pszCur)
+    {
+        case '{':
+            nType = JSON_TYPE_OBJECT;
+        break;
+        case '[':
+            nType = JSON_TYPE_ARRAY;
+        break;
+        case '"':
+            nType = JSON_TYPE_STRING;
+        break;
+        case 't':
+            nType = JSON_TYPE_TRUE;
+        break;
+        case 'f':
+            nType = JSON_TYPE_FALSE;
+        break;
+        case 'n':
+            nType = JSON_TYPE_NULL;
+        break;
+        default:
+            if(*pReader->pszCur == '-' ||
+               isdigit((unsigned char)*pReader->pszCur))
+            {
+                nType = JSON_TYPE_NUMBER;
+            }
+            else
+            {
+                dwError = coapi_json_error(pReader, "invalid token");
+                BAIL_ON_ERROR(dwError);
+            }
+    }
+
+    *pnType = nType;
+
+cleanup:
+    return dwError;
+
+error:
+    if(pnType)
+    {
+        *pnType = JSON_TYPE_NONE;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_json_expect(
+    PCOAPI_JSON_READER pReader,
+    char chExpected,
+    const char *pszError
+    )
+{
+    coapi_json_skip_space(pReader);
+    if(pReader->pszCur >= pReader->pszEnd || *pReader->pszCur != chExpected)
+    {
+        return coapi_json_error(pReader, pszError);
+    }
+    ++pReader->pszCur;
+    return 0;
+}
+
+uint32_t
+coapi_json_begin_object(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!pReader)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_expect(pReader, '{', "expected object");
+    BAIL_ON_ERROR(dwError);
+
+    pReader->nNeedComma = 0;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_json_begin_array(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!pReader)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_expect(pReader, '[', "expected array");
+    BAIL_ON_ERROR(dwError);
+
+    pReader->nNeedComma = 0;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//returns ENOENT after consuming the closing brace
+uint32_t
+coapi_json_next_key(
+    PCOAPI_JSON_READER pReader,
+    const char **ppszKey
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszKey = NULL;
+
+    if(!pReader || !ppszKey)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    coapi_json_skip_space(pReader);
+    if(pReader->pszCur >= pReader->pszEnd)
+    {
+        dwError = coapi_json_error(pReader, "unexpected end of input");
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(*pReader->pszCur == '}')
+    {
+        ++pReader->pszCur;
+        //the object just closed is a value in its parent
+        pReader->nNeedComma = 1;
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pReader->nNeedComma)
+    {
+        dwError = coapi_json_expect(pReader, ',', "expected , or }");
+        BAIL_ON_ERROR(dwError);
+    }
+
+    coapi_json_skip_space(pReader);
+    if(pReader->pszCur >= pReader->pszEnd || *pReader->pszCur != '"')
+    {
+        dwError = coapi_json_error(pReader, "string or '}' expected");
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_get_string(pReader, &pszKey);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_expect(pReader, ':', "':' expected");
+    BAIL_ON_ERROR(dwError);
+
+    pReader->nNeedComma = 1;
+    *ppszKey = pszKey;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszKey)
+    {
+        *ppszKey = NULL;
+    }
+    goto cleanup;
+}
+
+//returns ENOENT after consuming the closing bracket
+uint32_t
+coapi_json_next_element(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!pReader)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    coapi_json_skip_space(pReader);
+    if(pReader->pszCur >= pReader->pszEnd)
+    {
+        dwError = coapi_json_error(pReader, "unexpected end of input");
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(*pReader->pszCur == ']')
+    {
+        ++pReader->pszCur;
+        pReader->nNeedComma = 1;
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pReader->nNeedComma)
+    {
+        dwError = coapi_json_expect(pReader, ',', "expected , or ]");
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pReader->nNeedComma = 1;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_json_reserve_buffer(
+    PCOAPI_JSON_READER pReader,
+    size_t nSize
+    )
+{
+    uint32_t dwError = 0;
+    size_t nBufferSize = 0;
+    char *pszBuffer = NULL;
+
+    if(nSize <= pReader->nBufferSize)
+    {
+        goto cleanup;
+    }
+
+    nBufferSize = pReader->nBufferSize ? pReader->nBufferSize : 256;
+    while(nBufferSize < nSize)
+    {
+        nBufferSize *= 2;
+    }
+
+    dwError = coapi_reallocate_memory(
+                  pReader->pszBuffer,
+                  nBufferSize,
+                  (void **)&pszBuffer);
+    BAIL_ON_ERROR(dwError);
+
+    pReader->pszBuffer = pszBuffer;
+    pReader->nBufferSize = nBufferSize;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_json_read_hex4(
+    PCOAPI_JSON_READER pReader,
+    const char *pszHex,
+    uint32_t *pnValue
+    )
+{
+    int i = 0;
+    uint32_t nValue = 0;
+
+    if(pReader->pszEnd - pszHex < 4)
+    {
+        return coapi_json_error(pReader, "invalid \\u escape");
+    }
+    for(i = 0; i < 4; ++i)
+    {
+        char ch = pszHex[i];
+        nValue <<= 4;
+        if(ch >= '0' && ch <= '9')
+        {
+            nValue |= ch - '0';
+        }
+        else if(ch >= 'a' && ch <= 'f')
+        {
+            nValue |= ch - 'a' + 10;
+        }
+        else if(ch >= 'A' && ch <= 'F')
+        {
+            nValue |= ch - 'A' + 10;
+        }
+        else
+        {
+            return coapi_json_error(pReader, "invalid \\u escape");
+        }
+    }
+    *pnValue = nValue;
+    return 0;
+}
+
+//decodes a string with escapes into pszOut. the decoded form is never
+//longer than the source so the caller sizes pszOut by the source length.
+uint32_t
+coapi_json_unescape(
+    PCOAPI_JSON_READER pReader,
+    char *pszOut,
+    size_t *pnLength
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszCur = pReader->pszCur;
+    const char *pszEnd = pReader->pszEnd;
+    char *pszDst = pszOut;
+
+    while(pszCur < pszEnd && *pszCur != '"')
+    {
+        unsigned char ch = *pszCur;
+        uint32_t nCode = 0;
+        uint32_t nLow = 0;
+
+        if(ch < 0x20)
+        {
+            pReader->pszCur = pszCur;
+            dwError = coapi_json_error(pReader, "control character in string");
+            BAIL_ON_ERROR(dwError);
+        }
+        if(ch != '\\')
+        {
+            *pszDst++ = ch;
+            ++pszCur;
+            continue;
+        }
+
+        if(++pszCur >= pszEnd)
+        {
+            break;
+        }
+        switch(*pszCur)
+        {
+            case '"':  *pszDst++ = '"';  break;
+            case '\\': *pszDst++ = '\\'; break;
+            case '/':  *pszDst++ = '/';  break;
+            case 'b':  *pszDst++ = '\b'; break;
+            case 'f':  *pszDst++ = '\f'; break;
+            case 'n':  *pszDst++ = '\n'; break;
+            case 'r':  *pszDst++ = '\r'; break;
+            case 't':  *pszDst++ = '\t'; break;
+            case 'u':
+                pReader->pszCur = pszCur;
+                dwError = coapi_json_read_hex4(pReader, pszCur + 1, &nCode);
+                BAIL_ON_ERROR(dwError);
+                pszCur += 4;
+
+                if(nCode >= 0xD800 && nCode <= 0xDBFF)
+                {
+                    if(pszEnd - pszCur < 7 || pszCur[1] != '\\' || pszCur[2] != 'u')
+                    {
+                        dwError = coapi_json_error(pReader,
+                                                   "invalid unicode surrogate");
+                        BAIL_ON_ERROR(dwError);
+                    }
+                    dwError = coapi_json_read_hex4(pReader, pszCur + 3, &nLow);
+                    BAIL_ON_ERROR(dwError);
+                    if(nLow < 0xDC00 || nLow > 0xDFFF)
+                    {
+                        dwError = coapi_json_error(pReader,
+                                                   "invalid unicode surrogate");
+                        BAIL_ON_ERROR(dwError);
+                    }
+                    pszCur += 6;
+                    nCode = 0x10000 + ((nCode - 0xD800) << 10) + (nLow - 0xDC00);
+                }
+                else if((nCode >= 0xDC00 && nCode <= 0xDFFF) || nCode == 0)
+                {
+                    dwError = coapi_json_error(pReader, "invalid \\u escape");
+                    BAIL_ON_ERROR(dwError);
+                }
+
+                if(nCode < 0x80)
+                {
+                    *pszDst++ = nCode;
+                }
+                else if(nCode < 0x800)
+                {
+                    *pszDst++ = 0xC0 | (nCode >> 6);
+                    *pszDst++ = 0x80 | (nCode & 0x3F);
+                }
+                else if(nCode < 0x10000)
+                {
+                    *pszDst++ = 0xE0 | (nCode >> 12);
+                    *pszDst++ = 0x80 | ((nCode >> 6) & 0x3F);
+                    *pszDst++ = 0x80 | (nCode & 0x3F);
+                }
+                else
+                {
+                    *pszDst++ = 0xF0 | (nCode >> 18);
+                    *pszDst++ = 0x80 | ((nCode >> 12) & 0x3F);
+                    *pszDst++ = 0x80 | ((nCode >> 6) & 0x3F);
+                    *pszDst++ = 0x80 | (nCode & 0x3F);
+                }
+            break;
+            default:
+                pReader->pszCur = pszCur;
+                dwError = coapi_json_error(pReader, "invalid escape");
+                BAIL_ON_ERROR(dwError);
+        }
+        ++pszCur;
+    }
+
+    if(pszCur >= pszEnd)
+    {
+        pReader->pszCur = pszCur;
+        dwError = coapi_json_error(pReader, "premature end of input");
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *pszDst = '\0';
+    *pnLength = pszDst - pszOut;
+    pReader->pszCur = pszCur + 1;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_json_get_string(
+    PCOAPI_JSON_READER pReader,
+    const char **ppszValue
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszStart = NULL;
+    const char *pszCur = NULL;
+    size_t nLength = 0;
+
+    if(!pReader || !ppszValue)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_expect(pReader, '"', "expected string");
+    BAIL_ON_ERROR(dwError);
+
+    pszStart = pReader->pszCur;
+    pszCur = pReader->pScanner->pfnFindStringEnd(pszStart, pReader->pszEnd);
+
+    if(pReader->nInSitu)
+    {
+        //the closing quote becomes the terminator
+        if(pszCur < pReader->pszEnd && *pszCur == '"')
+        {
+            nLength = pszCur - pszStart;
+            ((char *)pszStart)[nLength] = '\0';
+            pReader->pszCur = pszCur + 1;
+        }
+        else
+        {
+            dwError = coapi_json_unescape(pReader, (char *)pszStart, &nLength);
+            BAIL_ON_ERROR(dwError);
+        }
+        pReader->nLength = nLength;
+        *ppszValue = pszStart;
+        goto cleanup;
+    }
+
+    if(pszCur < pReader->pszEnd && *pszCur == '"')
+    {
+        //common case, no escapes
+        nLength = pszCur - pszStart;
+        dwError = coapi_json_reserve_buffer(pReader, nLength + 1);
+        BAIL_ON_ERROR(dwError);
+
+        memcpy(pReader->pszBuffer, pszStart, nLength);
+        pReader->pszBuffer[nLength] = '\0';
+        pReader->pszCur = pszCur + 1;
+    }
+    else
+    {
+        //escapes only shrink, the source up to the closing quote bounds
+        //the result. the escapes are checked while decoding.
+        while(pszCur < pReader->pszEnd && *pszCur == '\\')
+        {
+            pszCur = pszCur + 2 < pReader->pszEnd ? pszCur + 2 :
+                                                   pReader->pszEnd;
+            pszCur = pReader->pScanner->pfnFindStringEnd(pszCur,
+                                                         pReader->pszEnd);
+        }
+
+        dwError = coapi_json_reserve_buffer(pReader, pszCur - pszStart + 1);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_json_unescape(pReader, pReader->pszBuffer, &nLength);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pReader->nLength = nLength;
+    *ppszValue = pReader->pszBuffer;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszValue)
+    {
+        *ppszValue = NULL;
+    }
+    goto cleanup;
+}
+
+//a string that points into the text when decoding in place,
+//otherwise a copy in pArena
+uint32_t
+coapi_json_get_string_value(
+    PCOAPI_JSON_READER pReader,
+    PCOAPI_ARENA pArena,
+    char **ppszValue
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszValue = NULL;
+
+    if(!pReader || !pArena || !ppszValue)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_get_string(pReader, &pszValue);
+    BAIL_ON_ERROR(dwError);
+
+    if(pReader->nInSitu)
+    {
+        *ppszValue = (char *)pszValue;
+    }
+    else
+    {
+        dwError = coapi_arena_allocate_string_length(
+                      pArena,
+                      pszValue,
+                      pReader->nLength,
+                      ppszValue);
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszValue)
+    {
+        *ppszValue = NULL;
+    }
+    goto cleanup;
+}
+
+//reads any value. *pnTrue is set only for the literal true
+uint32_t
+coapi_json_get_true(
+    PCOAPI_JSON_READER pReader,
+    int *pnTrue
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_JSON_TYPE nType = JSON_TYPE_NONE;
+
+    if(!pReader || !pnTrue)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_peek(pReader, &nType);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_skip_value(pReader);
+    BAIL_ON_ERROR(dwError);
+
+    *pnTrue = nType == JSON_TYPE_TRUE;
+
+cleanup:
+    return dwError;
+
+error:
+    if(pnTrue)
+    {
+        *pnTrue = 0;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_json_skip_string(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    const char *pszCur = pReader->pszCur + 1;
+    const char *pszEnd = pReader->pszEnd;
+    PFN_COAPI_JSON_SCAN pfnFindStringEnd =
+        pReader->pScanner->pfnFindStringEnd;
+    size_t nEscape = 0;
+
+    while((pszCur = pfnFindStringEnd(pszCur, pszEnd)) < pszEnd)
+    {
+        if(*pszCur == '"')
+        {
+            pReader->pszCur = pszCur + 1;
+            return 0;
+        }
+        pReader->pszCur = pszCur;
+        if(*pszCur != '\\')
+        {
+            return coapi_json_error(pReader, "control character in string");
+        }
+        nEscape = coapi_json_escape_length(pszCur, pszEnd);
+        if(!nEscape)
+        {
+            return coapi_json_error(pReader, "invalid escape");
+        }
+        pszCur += nEscape;
+    }
+    pReader->pszCur = pszEnd;
+    return coapi_json_error(pReader, "premature end of input");
+}
+
+//length of the escape at the backslash at pszCur, 0 if it is invalid
+size_t
+coapi_json_escape_length(
+    const char *pszCur,
+    const char *pszEnd
+    )
+{
+    int i = 0;
+
+    if(pszEnd - pszCur < 2)
+    {
+        return 0;
+    }
+    if(pszCur[1] != 'u')
+    {
+        return pszCur[1] && strchr("\"\\/bfnrt", pszCur[1]) ? 2 : 0;
+    }
+    if(pszEnd - pszCur < 6)
+    {
+        return 0;
+    }
+    for(i = 2; i < 6; ++i)
+    {
+        if(!isxdigit((unsigned char)pszCur[i]))
+        {
+            return 0;
+        }
+    }
+    return 6;
+}
+
+uint32_t
+coapi_json_skip_literal(
+    PCOAPI_JSON_READER pReader,
+    const char *pszLiteral
+    )
+{
+    size_t nLength = strlen(pszLiteral);
+
+    if((size_t)(pReader->pszEnd - pReader->pszCur) < nLength ||
+       memcmp(pReader->pszCur, pszLiteral, nLength))
+    {
+        return coapi_json_error(pReader, "invalid token");
+    }
+    pReader->pszCur += nLength;
+    return 0;
+}
+
+uint32_t
+coapi_json_skip_number(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    const char *pszCur = pReader->pszCur;
+    const char *pszEnd = pReader->pszEnd;
+    const char *pszDigits = NULL;
+
+    if(pszCur < pszEnd && *pszCur == '-')
+    {
+        ++pszCur;
+    }
+    for(pszDigits = pszCur;
+        pszCur < pszEnd && isdigit((unsigned char)*pszCur);
+        ++pszCur);
+    //no leading zeros
+    if(pszCur == pszDigits || (*pszDigits == '0' && pszCur - pszDigits > 1))
+    {
+        return coapi_json_error(pReader, "invalid number");
+    }
+    if(pszCur < pszEnd && *pszCur == '.')
+    {
+        for(pszDigits = ++pszCur;
+            pszCur < pszEnd && isdigit((unsigned char)*pszCur);
+            ++pszCur);
+        if(pszCur == pszDigits)
+        {
+            return coapi_json_error(pReader, "invalid number");
+        }
+    }
+    if(pszCur < pszEnd && (*pszCur == 'e' || *pszCur == 'E'))
+    {
+        ++pszCur;
+        if(pszCur < pszEnd && (*pszCur == '+' || *pszCur == '-'))
+        {
+            ++pszCur;
+        }
+        for(pszDigits = pszCur;
+            pszCur < pszEnd && isdigit((unsigned char)*pszCur);
+            ++pszCur);
+        if(pszCur == pszDigits)
+        {
+            return coapi_json_error(pReader, "invalid number");
+        }
+    }
+    pReader->pszCur = pszCur;
+    return 0;
+}
+
+//skips containers without decoding them. the text is still checked
+//to be json, so a spec that loads is valid even where it is skipped.
+uint32_t
+coapi_json_skip_container(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    return pReader->pScanner->pfnSkipContainer(pReader);
+}
+
+//skips the token at the reader, which is not white space, and steps
+//the grammar over it
+uint32_t
+coapi_json_skip_token(
+    PCOAPI_JSON_READER pReader,
+    PCOAPI_JSON_SKIP pSkip,
+    int *pnDone
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszPos = pReader->pszCur;
+
+    dwError = coapi_json_match_tokens(pReader, pSkip, pszPos, 1, pnDone);
+    BAIL_ON_ERROR(dwError);
+
+    switch(*pszPos)
+    {
+        case '{':
+        case '[':
+        case '}':
+        case ']':
+        case ',':
+        case ':':
+            pReader->pszCur = pszPos + 1;
+        break;
+        case '"':
+            dwError = coapi_json_skip_string(pReader);
+        break;
+        default:
+            dwError = coapi_json_skip_scalar(pReader);
+    }
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//skips the number or literal at the reader
+uint32_t
+coapi_json_skip_scalar(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    switch(*pReader->pszCur)
+    {
+        case 't':
+            return coapi_json_skip_literal(pReader, "true");
+        case 'f':
+            return coapi_json_skip_literal(pReader, "false");
+        case 'n':
+            return coapi_json_skip_literal(pReader, "null");
+        default:
+            if(*pReader->pszCur == '-' ||
+               isdigit((unsigned char)*pReader->pszCur))
+            {
+                return coapi_json_skip_number(pReader);
+            }
+    }
+    return coapi_json_error(pReader, "invalid token");
+}
+
+uint32_t
+coapi_json_skip_value(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_JSON_TYPE nType = JSON_TYPE_NONE;
+
+    dwError = coapi_json_peek(pReader, &nType);
+    BAIL_ON_ERROR(dwError);
+
+    switch(nType)
+    {
+        case JSON_TYPE_OBJECT:
+        case JSON_TYPE_ARRAY:
+            dwError = coapi_json_skip_container(pReader);
+        break;
+        case JSON_TYPE_STRING:
+            dwError = coapi_json_skip_string(pReader);
+        break;
+        case JSON_TYPE_TRUE:
+            dwError = coapi_json_skip_literal(pReader, "true");
+        break;
+        case JSON_TYPE_FALSE:
+            dwError = coapi_json_skip_literal(pReader, "false");
+        break;
+        case JSON_TYPE_NULL:
+            dwError = coapi_json_skip_literal(pReader, "null");
+        break;
+        default:
+            dwError = coapi_json_skip_number(pReader);
+    }
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//true if the json pointer token of nLength at pszToken names pszKey.
+//~1 and ~0 stand for / and ~.
+int
+coapi_json_pointer_token_equals(
+    const char *pszToken,
+    size_t nLength,
+    const char *pszKey
+    )
+{
+    size_t i = 0;
+
+    for(i = 0; i < nLength; ++i, ++pszKey)
+    {
+        char ch = pszToken[i];
+
+        if(ch == '~' && i + 1 < nLength &&
+           (pszToken[i + 1] == '0' || pszToken[i + 1] == '1'))
+        {
+            ch = pszToken[++i] == '1' ? '/' : '~';
+        }
+        if(*pszKey != ch)
+        {
+            return 0;
+        }
+    }
+    return *pszKey == '\0';
+}
+
+//moves the reader from the value at the cursor to the value named by
+//pszPointer, a json pointer such as /pageSize or /items/0.
+//returns ENOENT if there is no such value.
+uint32_t
+coapi_json_find_pointer(
+    PCOAPI_JSON_READER pReader,
+    const char *pszPointer
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_JSON_TYPE nType = JSON_TYPE_NONE;
+    const char *pszKey = NULL;
+
+    if(!pReader || !pszPointer)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    while(*pszPointer)
+    {
+        const char *pszToken = pszPointer + 1;
+        size_t nLength = 0;
+        size_t nIndex = 0;
+        size_t i = 0;
+
+        if(*pszPointer != '/')
+        {
+            dwError = EINVAL;
+            BAIL_ON_ERROR(dwError);
+        }
+
+        nLength = strcspn(pszToken, "/");
+        pszPointer = pszToken + nLength;
+
+        dwError = coapi_json_peek(pReader, &nType);
+        BAIL_ON_ERROR(dwError);
+
+        if(nType == JSON_TYPE_OBJECT)
+        {
+            dwError = coapi_json_begin_object(pReader);
+            BAIL_ON_ERROR(dwError);
+
+            //ENOENT at the end of the object
+            while(!(dwError = coapi_json_next_key(pReader, &pszKey)))
+            {
+                if(coapi_json_pointer_token_equals(pszToken, nLength, pszKey))
+                {
+                    break;
+                }
+                dwError = coapi_json_skip_value(pReader);
+                BAIL_ON_ERROR(dwError);
+            }
+            BAIL_ON_ERROR(dwError);
+        }
+        else if(nType == JSON_TYPE_ARRAY)
+        {
+            if(!nLength || nLength > 9 ||
+               (nLength > 1 && *pszToken == '0') ||
+               strspn(pszToken, "0123456789") < nLength)
+            {
+                dwError = ENOENT;
+                BAIL_ON_ERROR(dwError);
+            }
+            nIndex = strtoul(pszToken, NULL, 10);
+
+            dwError = coapi_json_begin_array(pReader);
+            BAIL_ON_ERROR(dwError);
+
+            for(i = 0; !(dwError = coapi_json_next_element(pReader)); ++i)
+            {
+                if(i == nIndex)
+                {
+                    break;
+                }
+                dwError = coapi_json_skip_value(pReader);
+                BAIL_ON_ERROR(dwError);
+            }
+            BAIL_ON_ERROR(dwError);
+        }
+        else
+        {
+            dwError = ENOENT;
+            BAIL_ON_ERROR(dwError);
+        }
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_json_end(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    coapi_json_skip_space(pReader);
+    if(pReader->pszCur < pReader->pszEnd && *pReader->pszCur)
+    {
+        return coapi_json_error(pReader, "end of file expected");
+    }
+    return 0;
+}
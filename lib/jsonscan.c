@@ -0,0 +1,562 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Scans the json reader spends its time in: finding the end of a string,
+//the end of white space and skipping a whole object or array. Each
+//scanner does all three. The scalar one looks at a byte at a time. The
+//sse2 one compares 16 bytes at once and takes the first match from a bit
+//mask. To skip a container it indexes 64 bytes at a time: bit masks of
+//quotes, brackets, commas, colons and space, and a prefix xor of the
+//quotes for the bytes inside strings. Only the tokens outside strings
+//are stepped through the json grammar, so skipped text is checked to be
+//json without reading string contents. Strings with a backslash or that
+//cross the block, and scalars at its end, are read a token at a time
+//and the next block starts after them. sse2 is used where it is built in,
+//unless a load asks for COAPI_LOAD_SCALAR_JSON or configure had
+//--disable-simd. Both stop at the same byte with the same errors, so
+//loads give the same def either way.
+
+#include "includes.h"
+
+#ifdef COAPI_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+//the token each byte starts
+static const unsigned char _nJsonTokens[256] =
+{
+    ['"'] = JSON_TOKEN_STRING,
+    [','] = JSON_TOKEN_COMMA,
+    [':'] = JSON_TOKEN_COLON,
+    ['{'] = JSON_TOKEN_OBJECT_OPEN,
+    ['['] = JSON_TOKEN_ARRAY_OPEN,
+    ['}'] = JSON_TOKEN_OBJECT_CLOSE,
+    [']'] = JSON_TOKEN_ARRAY_CLOSE
+};
+
+//how each token changes the depth of the container being skipped
+static const signed char _nJsonDepth[JSON_TOKEN_COUNT] =
+{
+    [JSON_TOKEN_OBJECT_OPEN] = 1,
+    [JSON_TOKEN_ARRAY_OPEN] = 1,
+    [JSON_TOKEN_OBJECT_CLOSE] = -1,
+    [JSON_TOKEN_ARRAY_CLOSE] = -1
+};
+
+//what is expected after a value where one is expected
+static const unsigned char _nJsonAfterValue[JSON_EXPECT_COUNT] =
+{
+    [JSON_EXPECT_ROOT] = JSON_EXPECT_ROOT,
+    [JSON_EXPECT_ARRAY_VALUE_OR_CLOSE] = JSON_EXPECT_ARRAY_COMMA_OR_CLOSE,
+    [JSON_EXPECT_ARRAY_VALUE] = JSON_EXPECT_ARRAY_COMMA_OR_CLOSE,
+    [JSON_EXPECT_OBJECT_VALUE] = JSON_EXPECT_OBJECT_COMMA_OR_CLOSE
+};
+
+#define COAPI_JSON_VALUE_TOKENS(nAfter) \
+    [JSON_TOKEN_SCALAR] = nAfter, \
+    [JSON_TOKEN_STRING] = nAfter, \
+    [JSON_TOKEN_OBJECT_OPEN] = JSON_EXPECT_OBJECT_KEY_OR_CLOSE, \
+    [JSON_TOKEN_ARRAY_OPEN] = JSON_EXPECT_ARRAY_VALUE_OR_CLOSE
+
+//what is expected after each token, JSON_EXPECT_NONE where it is wrong
+static const unsigned char _nJsonNext[JSON_EXPECT_COUNT][JSON_TOKEN_COUNT] =
+{
+    [JSON_EXPECT_ROOT] =
+    {
+        [JSON_TOKEN_OBJECT_OPEN] = JSON_EXPECT_OBJECT_KEY_OR_CLOSE,
+        [JSON_TOKEN_ARRAY_OPEN] = JSON_EXPECT_ARRAY_VALUE_OR_CLOSE
+    },
+    [JSON_EXPECT_ARRAY_VALUE_OR_CLOSE] =
+    {
+        COAPI_JSON_VALUE_TOKENS(JSON_EXPECT_ARRAY_COMMA_OR_CLOSE),
+        [JSON_TOKEN_ARRAY_CLOSE] = JSON_EXPECT_POP
+    },
+    [JSON_EXPECT_ARRAY_VALUE] =
+    {
+        COAPI_JSON_VALUE_TOKENS(JSON_EXPECT_ARRAY_COMMA_OR_CLOSE)
+    },
+    [JSON_EXPECT_ARRAY_COMMA_OR_CLOSE] =
+    {
+        [JSON_TOKEN_COMMA] = JSON_EXPECT_ARRAY_VALUE,
+        [JSON_TOKEN_ARRAY_CLOSE] = JSON_EXPECT_POP
+    },
+    [JSON_EXPECT_OBJECT_KEY_OR_CLOSE] =
+    {
+        [JSON_TOKEN_STRING] = JSON_EXPECT_OBJECT_COLON,
+        [JSON_TOKEN_OBJECT_CLOSE] = JSON_EXPECT_POP
+    },
+    [JSON_EXPECT_OBJECT_KEY] =
+    {
+        [JSON_TOKEN_STRING] = JSON_EXPECT_OBJECT_COLON
+    },
+    [JSON_EXPECT_OBJECT_COLON] =
+    {
+        [JSON_TOKEN_COLON] = JSON_EXPECT_OBJECT_VALUE
+    },
+    [JSON_EXPECT_OBJECT_VALUE] =
+    {
+        COAPI_JSON_VALUE_TOKENS(JSON_EXPECT_OBJECT_COMMA_OR_CLOSE)
+    },
+    [JSON_EXPECT_OBJECT_COMMA_OR_CLOSE] =
+    {
+        [JSON_TOKEN_COMMA] = JSON_EXPECT_OBJECT_KEY,
+        [JSON_TOKEN_OBJECT_CLOSE] = JSON_EXPECT_POP
+    }
+};
+
+static COAPI_JSON_SCANNER _stScalarScanner =
+{
+    "scalar",
+    coapi_json_find_string_end_scalar,
+    coapi_json_skip_space_scalar,
+    coapi_json_skip_container_scalar
+};
+
+#ifdef COAPI_HAVE_SSE2
+static COAPI_JSON_SCANNER _stSse2Scanner =
+{
+    "sse2",
+    coapi_json_find_string_end_sse2,
+    coapi_json_skip_space_sse2,
+    coapi_json_skip_container_sse2
+};
+#endif
+
+//the scanner for a load with dwFlags
+PCOAPI_JSON_SCANNER
+coapi_json_get_scanner(
+    uint32_t dwFlags
+    )
+{
+#ifdef COAPI_HAVE_SSE2
+    if(!(dwFlags & COAPI_LOAD_SCALAR_JSON))
+    {
+        return &_stSse2Scanner;
+    }
+#endif
+    return &_stScalarScanner;
+}
+
+//first quote, backslash or control character, or pszEnd
+const char *
+coapi_json_find_string_end_scalar(
+    const char *pszCur,
+    const char *pszEnd
+    )
+{
+    for(; pszCur < pszEnd && *pszCur != '"' && *pszCur != '\\' &&
+          (unsigned char)*pszCur >= 0x20;
+        ++pszCur);
+    return pszCur;
+}
+
+//first character that is not white space, or pszEnd
+const char *
+coapi_json_skip_space_scalar(
+    const char *pszCur,
+    const char *pszEnd
+    )
+{
+    while(pszCur < pszEnd &&
+          (*pszCur == ' ' || *pszCur == '\n' ||
+           *pszCur == '\r' || *pszCur == '\t'))
+    {
+        ++pszCur;
+    }
+    return pszCur;
+}
+
+uint32_t
+coapi_json_skip_container_scalar(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    COAPI_JSON_SKIP stSkip;
+
+    //the stack is not cleared, only what is pushed is read
+    stSkip.nDepth = 0;
+    stSkip.nExpect = JSON_EXPECT_ROOT;
+    return coapi_json_skip_tokens(pReader, &stSkip);
+}
+
+//steps the grammar of a container being skipped over the tokens at
+//the set bits of nTokens from pszBlock on. a token is a bracket, a
+//comma, a colon or the first character of a string or scalar. nothing
+//else is read. *pnDone is set, with the reader past it, when the
+//container closes. tokens follow each other with no pattern, so this
+//looks up tables instead of branching on them, and keeps the state in
+//locals, the next token needs it right away.
+uint32_t
+coapi_json_match_tokens(
+    PCOAPI_JSON_READER pReader,
+    PCOAPI_JSON_SKIP pSkip,
+    const char *pszBlock,
+    uint64_t nTokens,
+    int *pnDone
+    )
+{
+    uint32_t dwError = 0;
+    int nExpect = pSkip->nExpect;
+    int nDepth = pSkip->nDepth;
+
+    for(; nTokens; nTokens &= nTokens - 1)
+    {
+        const char *pszPos = pszBlock + __builtin_ctzll(nTokens);
+        int nToken = _nJsonTokens[(unsigned char)*pszPos];
+        int nNext = _nJsonNext[nExpect][nToken];
+
+        //only read back if this opens a container
+        pSkip->nStack[nDepth] = _nJsonAfterValue[nExpect];
+        nDepth += _nJsonDepth[nToken];
+        if(nNext == JSON_EXPECT_NONE || nDepth > COAPI_JSON_MAX_DEPTH)
+        {
+            pSkip->nExpect = nExpect;
+            pSkip->nDepth = nDepth - _nJsonDepth[nToken];
+            dwError = coapi_json_token_error(pReader, pSkip, pszPos);
+            BAIL_ON_ERROR(dwError);
+        }
+        nExpect = nNext == JSON_EXPECT_POP ? pSkip->nStack[nDepth] : nNext;
+        if(!nDepth)
+        {
+            pReader->pszCur = pszPos + 1;
+            *pnDone = 1;
+            break;
+        }
+    }
+    pSkip->nExpect = nExpect;
+    pSkip->nDepth = nDepth;
+
+error:
+    return dwError;
+}
+
+//the error for the token at pszPos that coapi_json_match_tokens refused
+uint32_t
+coapi_json_token_error(
+    PCOAPI_JSON_READER pReader,
+    PCOAPI_JSON_SKIP pSkip,
+    const char *pszPos
+    )
+{
+    int nToken = _nJsonTokens[(unsigned char)*pszPos];
+
+    pReader->pszCur = pszPos;
+    if(_nJsonDepth[nToken] > 0 && pSkip->nDepth == COAPI_JSON_MAX_DEPTH)
+    {
+        return coapi_json_error(pReader, "maximum nesting depth");
+    }
+    switch(pSkip->nExpect)
+    {
+        case JSON_EXPECT_ROOT:
+        case JSON_EXPECT_ARRAY_VALUE:
+        case JSON_EXPECT_OBJECT_VALUE:
+            return coapi_json_error(pReader, "expected value");
+        case JSON_EXPECT_ARRAY_VALUE_OR_CLOSE:
+            return coapi_json_error(pReader, "expected value or ]");
+        case JSON_EXPECT_ARRAY_COMMA_OR_CLOSE:
+            return coapi_json_error(pReader, "expected , or ]");
+        case JSON_EXPECT_OBJECT_KEY_OR_CLOSE:
+            return coapi_json_error(pReader, "string or '}' expected");
+        case JSON_EXPECT_OBJECT_KEY:
+            return coapi_json_error(pReader, "expected string");
+        case JSON_EXPECT_OBJECT_COLON:
+            return coapi_json_error(pReader, "':' expected");
+        default:
+            return coapi_json_error(pReader, "expected , or }");
+    }
+}
+
+//skips a token at a time until the container being skipped closes
+uint32_t
+coapi_json_skip_tokens(
+    PCOAPI_JSON_READER pReader,
+    PCOAPI_JSON_SKIP pSkip
+    )
+{
+    uint32_t dwError = 0;
+    int nDone = 0;
+
+    while(!nDone)
+    {
+        coapi_json_skip_space(pReader);
+        if(pReader->pszCur >= pReader->pszEnd)
+        {
+            dwError = coapi_json_error(pReader, "premature end of input");
+            BAIL_ON_ERROR(dwError);
+        }
+
+        dwError = coapi_json_skip_token(pReader, pSkip, &nDone);
+        BAIL_ON_ERROR(dwError);
+    }
+
+error:
+    return dwError;
+}
+
+#ifdef COAPI_HAVE_SSE2
+//loads stay within the text, the last bytes are left to the scalar scan
+const char *
+coapi_json_find_string_end_sse2(
+    const char *pszCur,
+    const char *pszEnd
+    )
+{
+    const __m128i stQuote = _mm_set1_epi8('"');
+    const __m128i stBackslash = _mm_set1_epi8('\\');
+    const __m128i stControl = _mm_set1_epi8(0x1f);
+
+    for(; pszEnd - pszCur >= 16; pszCur += 16)
+    {
+        __m128i stText = _mm_loadu_si128((const __m128i *)pszCur);
+        //unsigned max with 0x1f is 0x1f only for bytes up to 0x1f
+        __m128i stMatch = _mm_or_si128(
+                              _mm_or_si128(
+                                  _mm_cmpeq_epi8(stText, stQuote),
+                                  _mm_cmpeq_epi8(stText, stBackslash)),
+                              _mm_cmpeq_epi8(
+                                  _mm_max_epu8(stText, stControl),
+                                  stControl));
+        int nMask = _mm_movemask_epi8(stMatch);
+
+        if(nMask)
+        {
+            return pszCur + __builtin_ctz(nMask);
+        }
+    }
+    return coapi_json_find_string_end_scalar(pszCur, pszEnd);
+}
+
+const char *
+coapi_json_skip_space_sse2(
+    const char *pszCur,
+    const char *pszEnd
+    )
+{
+    const __m128i stSpace = _mm_set1_epi8(' ');
+    const __m128i stNewLine = _mm_set1_epi8('\n');
+    const __m128i stReturn = _mm_set1_epi8('\r');
+    const __m128i stTab = _mm_set1_epi8('\t');
+
+    for(; pszEnd - pszCur >= 16; pszCur += 16)
+    {
+        __m128i stText = _mm_loadu_si128((const __m128i *)pszCur);
+        __m128i stMatch = _mm_or_si128(
+                              _mm_or_si128(
+                                  _mm_cmpeq_epi8(stText, stSpace),
+                                  _mm_cmpeq_epi8(stText, stNewLine)),
+                              _mm_or_si128(
+                                  _mm_cmpeq_epi8(stText, stReturn),
+                                  _mm_cmpeq_epi8(stText, stTab)));
+        int nMask = _mm_movemask_epi8(stMatch) ^ 0xffff;
+
+        if(nMask)
+        {
+            return pszCur + __builtin_ctz(nMask);
+        }
+    }
+    return coapi_json_skip_space_scalar(pszCur, pszEnd);
+}
+
+uint32_t
+coapi_json_skip_container_sse2(
+    PCOAPI_JSON_READER pReader
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszCur = pReader->pszCur;
+    const char *pszEnd = pReader->pszEnd;
+    COAPI_JSON_SKIP stSkip;
+    int nDone = 0;
+
+    stSkip.nDepth = 0;
+    stSkip.nExpect = JSON_EXPECT_ROOT;
+    while(!nDone && pszEnd - pszCur >= 64)
+    {
+        COAPI_JSON_BLOCK stBlock = {0};
+        uint64_t nString = 0;
+        uint64_t nScalar = 0;
+        uint64_t nStop = 0;
+        uint64_t nToken = 0;
+        uint64_t nRun = 0;
+        const char *pszDone = NULL;
+        int nStopPos = 64;
+
+        coapi_json_index_block(pszCur, &stBlock);
+
+        //each bit becomes the xor of the quotes up to it, which is set
+        //from an opening quote to the byte before the closing one.
+        //blocks always start outside strings.
+        nString = stBlock.nQuote;
+        nString ^= nString << 1;
+        nString ^= nString << 2;
+        nString ^= nString << 4;
+        nString ^= nString << 8;
+        nString ^= nString << 16;
+        nString ^= nString << 32;
+
+        //bytes of numbers and literals, and anything else out of place
+        nScalar = ~(nString | stBlock.nQuote | stBlock.nStructural |
+                    stBlock.nSpace);
+
+        //quotes after a backslash are not known from the masks. strings
+        //with escapes or control characters, or that go on past the
+        //block, are left to coapi_json_skip_token from their opening
+        //quote, and so is a scalar at the end of the block.
+        nStop = stBlock.nSpecial & nString;
+        nStop |= nString & (1ULL << 63);
+        if(nStop)
+        {
+            nStop &= -nStop;
+            nStopPos = 63 - __builtin_clzll(stBlock.nQuote & nString &
+                                            (nStop | (nStop - 1)));
+        }
+        if(nScalar >> 63)
+        {
+            int nRunPos = ~nScalar ? 64 - __builtin_clzll(~nScalar) : 0;
+
+            if(nRunPos < nStopPos)
+            {
+                nStopPos = nRunPos;
+            }
+        }
+
+        nToken = (stBlock.nQuote & nString) |
+                 (stBlock.nStructural & ~nString) |
+                 (nScalar & ~(nScalar << 1));
+        if(nStopPos < 64)
+        {
+            nToken &= (1ULL << nStopPos) - 1;
+        }
+
+        dwError = coapi_json_match_tokens(pReader,
+                                          &stSkip,
+                                          pszCur,
+                                          nToken,
+                                          &nDone);
+        BAIL_ON_ERROR(dwError);
+
+        //each run of scalar bytes in the container must be one number
+        //or literal
+        nRun = nToken & nScalar;
+        pszDone = pReader->pszCur;
+        if(nDone && pszDone - pszCur < 64)
+        {
+            nRun &= (1ULL << (pszDone - pszCur)) - 1;
+        }
+        for(; nRun; nRun &= nRun - 1)
+        {
+            int nPos = __builtin_ctzll(nRun);
+
+            pReader->pszCur = pszCur + nPos;
+            dwError = coapi_json_skip_scalar(pReader);
+            BAIL_ON_ERROR(dwError);
+
+            if(pReader->pszCur !=
+               pszCur + nPos + __builtin_ctzll(~nScalar >> nPos))
+            {
+                dwError = coapi_json_error(pReader, "invalid token");
+                BAIL_ON_ERROR(dwError);
+            }
+        }
+
+        if(nDone)
+        {
+            pReader->pszCur = pszDone;
+            break;
+        }
+        if(nStopPos < 64)
+        {
+            pReader->pszCur = pszCur + nStopPos;
+            dwError = coapi_json_skip_token(pReader, &stSkip, &nDone);
+            BAIL_ON_ERROR(dwError);
+            pszCur = pReader->pszCur;
+        }
+        else
+        {
+            pszCur += 64;
+        }
+    }
+
+    if(!nDone)
+    {
+        pReader->pszCur = pszCur;
+        dwError = coapi_json_skip_tokens(pReader, &stSkip);
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//masks of the bytes of the 64 at pszCur that the container skip looks at
+void
+coapi_json_index_block(
+    const char *pszCur,
+    PCOAPI_JSON_BLOCK pBlock
+    )
+{
+    const __m128i stQuote = _mm_set1_epi8('"');
+    const __m128i stBackslash = _mm_set1_epi8('\\');
+    const __m128i stCase = _mm_set1_epi8(0x20);
+    const __m128i stOpen = _mm_set1_epi8('{');
+    const __m128i stClose = _mm_set1_epi8('}');
+    const __m128i stComma = _mm_set1_epi8(',');
+    const __m128i stColon = _mm_set1_epi8(':');
+    const __m128i stSpace = _mm_set1_epi8(' ');
+    const __m128i stNewLine = _mm_set1_epi8('\n');
+    const __m128i stReturn = _mm_set1_epi8('\r');
+    const __m128i stTab = _mm_set1_epi8('\t');
+    const __m128i stControl = _mm_set1_epi8(0x1f);
+    int i = 0;
+
+    for(i = 0; i < 4; ++i)
+    {
+        __m128i stText = _mm_loadu_si128((const __m128i *)pszCur + i);
+        //[ and ] are { and } without the 0x20 bit
+        __m128i stFolded = _mm_or_si128(stText, stCase);
+        int nShift = i * 16;
+
+        pBlock->nQuote |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+                              _mm_cmpeq_epi8(stText, stQuote)) << nShift;
+        pBlock->nStructural |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+                                   _mm_or_si128(
+                                       _mm_or_si128(
+                                           _mm_cmpeq_epi8(stFolded, stOpen),
+                                           _mm_cmpeq_epi8(stFolded, stClose)),
+                                       _mm_or_si128(
+                                           _mm_cmpeq_epi8(stText, stComma),
+                                           _mm_cmpeq_epi8(stText, stColon))))
+                               << nShift;
+        pBlock->nSpace |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+                              _mm_or_si128(
+                                  _mm_or_si128(
+                                      _mm_cmpeq_epi8(stText, stSpace),
+                                      _mm_cmpeq_epi8(stText, stNewLine)),
+                                  _mm_or_si128(
+                                      _mm_cmpeq_epi8(stText, stReturn),
+                                      _mm_cmpeq_epi8(stText, stTab))))
+                          << nShift;
+        //unsigned max with 0x1f is 0x1f only for bytes up to 0x1f
+        pBlock->nSpecial |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+                                _mm_or_si128(
+                                    _mm_cmpeq_epi8(stText, stBackslash),
+                                    _mm_cmpeq_epi8(
+                                        _mm_max_epu8(stText, stControl),
+                                        stControl))) << nShift;
+    }
+}
+#endif
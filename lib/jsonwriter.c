@@ -0,0 +1,305 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Streaming json writer.
+//Output is appended to one buffer as the writers walk their data, with
+//no document tree in between. Writers that have an fd write the buffer
+//out each time it fills up, so it stays at COAPI_JSON_WRITER_BUFFER.
+//Otherwise the buffer grows to hold all of the output. Separators are
+//up to the callers, which know the shape of what they write.
+
+#include "includes.h"
+
+void
+coapi_json_writer_init(
+    PCOAPI_JSON_WRITER pWriter,
+    int fd
+    )
+{
+    if(pWriter)
+    {
+        memset(pWriter, 0, sizeof(*pWriter));
+        pWriter->fd = fd;
+    }
+}
+
+void
+coapi_json_writer_free(
+    PCOAPI_JSON_WRITER pWriter
+    )
+{
+    if(pWriter)
+    {
+        SAFE_FREE_MEMORY(pWriter->pszBuffer);
+        pWriter->pszBuffer = NULL;
+        pWriter->nLength = 0;
+        pWriter->nCapacity = 0;
+    }
+}
+
+//writes out the buffer. no op without an fd.
+uint32_t
+coapi_json_writer_flush(
+    PCOAPI_JSON_WRITER pWriter
+    )
+{
+    uint32_t dwError = 0;
+    size_t nWritten = 0;
+
+    if(!pWriter)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pWriter->fd < 0)
+    {
+        goto cleanup;
+    }
+
+    while(nWritten < pWriter->nLength)
+    {
+        ssize_t nBytes = write(pWriter->fd,
+                               pWriter->pszBuffer + nWritten,
+                               pWriter->nLength - nWritten);
+        if(nBytes < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            dwError = errno;
+            BAIL_ON_ERROR(dwError);
+        }
+        nWritten += nBytes;
+    }
+    pWriter->nLength = 0;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//makes room for nSize more bytes at the end of the buffer
+uint32_t
+coapi_json_writer_reserve(
+    PCOAPI_JSON_WRITER pWriter,
+    size_t nSize
+    )
+{
+    uint32_t dwError = 0;
+    size_t nCapacity = 0;
+    char *pszBuffer = NULL;
+
+    if(!pWriter)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pWriter->nLength + nSize <= pWriter->nCapacity)
+    {
+        goto cleanup;
+    }
+
+    dwError = coapi_json_writer_flush(pWriter);
+    BAIL_ON_ERROR(dwError);
+
+    if(pWriter->nLength + nSize <= pWriter->nCapacity)
+    {
+        goto cleanup;
+    }
+
+    nCapacity = pWriter->nCapacity ?
+                pWriter->nCapacity : COAPI_JSON_WRITER_BUFFER;
+    while(nCapacity < pWriter->nLength + nSize)
+    {
+        nCapacity *= 2;
+    }
+
+    dwError = coapi_reallocate_memory(pWriter->pszBuffer,
+                                      nCapacity,
+                                      (void **)&pszBuffer);
+    BAIL_ON_ERROR(dwError);
+
+    pWriter->pszBuffer = pszBuffer;
+    pWriter->nCapacity = nCapacity;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_json_write_raw(
+    PCOAPI_JSON_WRITER pWriter,
+    const char *pszText,
+    size_t nLength
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!nLength)
+    {
+        goto cleanup;
+    }
+
+    dwError = coapi_json_writer_reserve(pWriter, nLength);
+    BAIL_ON_ERROR(dwError);
+
+    memcpy(pWriter->pszBuffer + pWriter->nLength, pszText, nLength);
+    pWriter->nLength += nLength;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//writes pszString quoted. runs that need no escape are copied as is.
+uint32_t
+coapi_json_write_string(
+    PCOAPI_JSON_WRITER pWriter,
+    const char *pszString
+    )
+{
+    uint32_t dwError = 0;
+    static const char szHex[] = "0123456789abcdef";
+    const char *pszRun = NULL;
+    const char *pszCur = NULL;
+    char szEscape[6] = {'\\', 'u', '0', '0'};
+
+    if(!pWriter || !pszString)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "\"");
+    BAIL_ON_ERROR(dwError);
+
+    for(pszRun = pszCur = pszString; *pszCur; ++pszCur)
+    {
+        unsigned char ch = *pszCur;
+
+        if(ch >= 0x20 && ch != '"' && ch != '\\')
+        {
+            continue;
+        }
+
+        dwError = coapi_json_write_raw(pWriter, pszRun, pszCur - pszRun);
+        BAIL_ON_ERROR(dwError);
+        pszRun = pszCur + 1;
+
+        switch(ch)
+        {
+            case '"':
+                dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "\\\"");
+            break;
+            case '\\':
+                dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "\\\\");
+            break;
+            case '\n':
+                dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "\\n");
+            break;
+            case '\r':
+                dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "\\r");
+            break;
+            case '\t':
+                dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "\\t");
+            break;
+            default:
+                szEscape[4] = szHex[ch >> 4];
+                szEscape[5] = szHex[ch & 0xf];
+                dwError = coapi_json_write_raw(pWriter,
+                                               szEscape,
+                                               sizeof(szEscape));
+        }
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_write_raw(pWriter, pszRun, pszCur - pszRun);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "\"");
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//a comma before all but the first member or element
+uint32_t
+coapi_json_write_separator(
+    PCOAPI_JSON_WRITER pWriter,
+    int *pnFirst
+    )
+{
+    if(*pnFirst)
+    {
+        *pnFirst = 0;
+        return 0;
+    }
+    return COAPI_JSON_WRITE_LITERAL(pWriter, ",");
+}
+
+//writes ,"pszKey":"pszValue", without the comma while *pnFirst is set.
+//no op for a NULL value.
+uint32_t
+coapi_json_write_member(
+    PCOAPI_JSON_WRITER pWriter,
+    int *pnFirst,
+    const char *pszKey,
+    const char *pszValue
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!pWriter || !pnFirst || !pszKey)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!pszValue)
+    {
+        goto cleanup;
+    }
+
+    dwError = coapi_json_write_separator(pWriter, pnFirst);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_write_string(pWriter, pszKey);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ":");
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_write_string(pWriter, pszValue);
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Counts, wall time and arena allocations of a load, by phase. A phase
+//is measured from a mark taken at its start. Loader threads keep stats
+//of their own, which are added to the def's when they are joined.
+
+#include "includes.h"
+
+uint64_t
+coapi_get_time_ns(
+    void
+    )
+{
+    struct timespec stNow = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return (uint64_t)stNow.tv_sec * 1000000000ULL + stNow.tv_nsec;
+}
+
+//what the loader allocated so far, in the def arena and the temp arenas
+void
+coapi_loader_get_allocations(
+    PCOAPI_LOADER pLoader,
+    size_t *pnAllocations,
+    size_t *pnAllocatedBytes
+    )
+{
+    size_t nAllocations = 0;
+    size_t nAllocatedBytes = 0;
+
+    if(pLoader)
+    {
+        nAllocations = pLoader->nTempAllocations;
+        nAllocatedBytes = pLoader->nTempAllocatedBytes;
+        if(pLoader->pArena)
+        {
+            nAllocations += pLoader->pArena->nAllocations;
+            nAllocatedBytes += pLoader->pArena->nAllocatedBytes;
+        }
+        if(pLoader->pTempArena)
+        {
+            nAllocations += pLoader->pTempArena->nAllocations;
+            nAllocatedBytes += pLoader->pTempArena->nAllocatedBytes;
+        }
+    }
+    *pnAllocations = nAllocations;
+    *pnAllocatedBytes = nAllocatedBytes;
+}
+
+//pLoader can be NULL for phases that only take time
+void
+coapi_load_phase_begin(
+    PCOAPI_LOADER pLoader,
+    PCOAPI_LOAD_PHASE pMark
+    )
+{
+    coapi_loader_get_allocations(pLoader,
+                                 &pMark->nAllocations,
+                                 &pMark->nAllocatedBytes);
+    pMark->nNanoseconds = coapi_get_time_ns();
+}
+
+//adds what happened since pMark to pPhase
+void
+coapi_load_phase_end(
+    PCOAPI_LOADER pLoader,
+    PCOAPI_LOAD_PHASE pMark,
+    PCOAPI_LOAD_PHASE pPhase
+    )
+{
+    size_t nAllocations = 0;
+    size_t nAllocatedBytes = 0;
+
+    pPhase->nNanoseconds += coapi_get_time_ns() - pMark->nNanoseconds;
+
+    coapi_loader_get_allocations(pLoader, &nAllocations, &nAllocatedBytes);
+    pPhase->nAllocations += nAllocations - pMark->nAllocations;
+    pPhase->nAllocatedBytes += nAllocatedBytes - pMark->nAllocatedBytes;
+}
+
+void
+coapi_add_load_phase(
+    PCOAPI_LOAD_PHASE pPhase,
+    PCOAPI_LOAD_PHASE pSource
+    )
+{
+    pPhase->nNanoseconds += pSource->nNanoseconds;
+    pPhase->nAllocations += pSource->nAllocations;
+    pPhase->nAllocatedBytes += pSource->nAllocatedBytes;
+}
+
+//adds the stats of a loader thread to the stats of the load
+void
+coapi_add_load_stats(
+    PCOAPI_LOAD_STATS pStats,
+    PCOAPI_LOAD_STATS pSource
+    )
+{
+    if(!pStats || !pSource)
+    {
+        return;
+    }
+    pStats->nSharedParams += pSource->nSharedParams;
+    pStats->nSharedParamBytes += pSource->nSharedParamBytes;
+    pStats->nModules += pSource->nModules;
+    pStats->nEndPoints += pSource->nEndPoints;
+    pStats->nMethods += pSource->nMethods;
+    pStats->nParams += pSource->nParams;
+    pStats->nOptions += pSource->nOptions;
+    coapi_add_load_phase(&pStats->stRead, &pSource->stRead);
+    coapi_add_load_phase(&pStats->stRoot, &pSource->stRoot);
+    coapi_add_load_phase(&pStats->stModules, &pSource->stModules);
+    coapi_add_load_phase(&pStats->stEndPoints, &pSource->stEndPoints);
+    coapi_add_load_phase(&pStats->stParams, &pSource->stParams);
+    coapi_add_load_phase(&pStats->stPathNames, &pSource->stPathNames);
+    coapi_add_load_phase(&pStats->stIndex, &pSource->stIndex);
+}
+
+//modules, endpoints and methods of a def with its table built
+uint32_t
+coapi_count_api_def(
+    PREST_API_DEF pApiDef,
+    PCOAPI_LOAD_STATS pStats
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_MODULE pModule = NULL;
+
+    if(!pApiDef || !pApiDef->pTable || !pStats)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pStats->nModules = 0;
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        ++pStats->nModules;
+    }
+    pStats->nEndPoints = pApiDef->pTable->nEndPointCount;
+    pStats->nMethods = pApiDef->pTable->nMethodCount;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_get_load_stats(
+    PREST_API_DEF pApiDef,
+    PCOAPI_LOAD_STATS pStats
+    )
+{
+    uint32_t dwError = 0;
+
+    if(!pApiDef || !pStats)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *pStats = pApiDef->stStats;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+void
+coapi_print_load_phase(
+    const char *pszName,
+    PCOAPI_LOAD_PHASE pPhase
+    )
+{
+    printf("%-14s %10.3f %12zu %14zu\n",
+           pszName,
+           pPhase->nNanoseconds / 1000000.0,
+           pPhase->nAllocations,
+           pPhase->nAllocatedBytes);
+}
+
+void
+coapi_print_load_stats(
+    PCOAPI_LOAD_STATS pStats
+    )
+{
+    COAPI_LOAD_PHASE stTotal = {0};
+
+    if(!pStats)
+    {
+        return;
+    }
+
+    coapi_add_load_phase(&stTotal, &pStats->stRead);
+    coapi_add_load_phase(&stTotal, &pStats->stRoot);
+    coapi_add_load_phase(&stTotal, &pStats->stEndPoints);
+    coapi_add_load_phase(&stTotal, &pStats->stIndex);
+
+    printf("modules       : %zu\n", pStats->nModules);
+    printf("endpoints     : %zu\n", pStats->nEndPoints);
+    printf("methods       : %zu\n", pStats->nMethods);
+    printf("params        : %zu\n", pStats->nParams);
+    printf("enum options  : %zu\n", pStats->nOptions);
+    printf("shared params : %zu (%zu bytes)\n",
+           pStats->nSharedParams,
+           pStats->nSharedParamBytes);
+    printf("\n");
+    printf("%-14s %10s %12s %14s\n", "phase", "ms", "allocations", "bytes");
+    coapi_print_load_phase("read", &pStats->stRead);
+    coapi_print_load_phase("root", &pStats->stRoot);
+    coapi_print_load_phase("  modules", &pStats->stModules);
+    coapi_print_load_phase("endpoints", &pStats->stEndPoints);
+    coapi_print_load_phase("  params", &pStats->stParams);
+    coapi_print_load_phase("  path names", &pStats->stPathNames);
+    coapi_print_load_phase("index", &pStats->stIndex);
+    coapi_print_load_phase("total", &stTotal);
+}
@@ -0,0 +1,336 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Parallel load of the paths object. The keys are indexed in one pass,
+//contiguous ranges of paths are loaded on worker threads with their own
+//reader, arena and string table, and the endpoints are then added to
+//their modules in path order so the result matches a serial load.
+
+#include "includes.h"
+
+//records where each path key starts. nothing is decoded in place here,
+//the workers read the keys again.
+uint32_t
+coapi_index_paths(
+    PCOAPI_LOADER pLoader,
+    PCOAPI_PATH_INDEX pIndex
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_JSON_READER pReader = NULL;
+    const char *pszKey = NULL;
+    const char **ppszKeys = NULL;
+    int nInSitu = 0;
+
+    if(!pLoader || !pIndex)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pReader = &pLoader->stReader;
+    nInSitu = pReader->nInSitu;
+    pReader->nInSitu = 0;
+
+    dwError = coapi_json_begin_object(pReader);
+    BAIL_ON_ERROR(dwError);
+
+    for(;;)
+    {
+        const char *pszKeyStart = pReader->pszCur;
+
+        dwError = coapi_json_next_key(pReader, &pszKey);
+        if(dwError == ENOENT)
+        {
+            dwError = 0;
+            break;
+        }
+        BAIL_ON_ERROR(dwError);
+
+        if(pIndex->nCount == pIndex->nCapacity)
+        {
+            size_t nCapacity = pIndex->nCapacity ? pIndex->nCapacity * 2 : 256;
+
+            dwError = coapi_reallocate_memory(pIndex->ppszKeys,
+                                              sizeof(char *) * nCapacity,
+                                              (void **)&ppszKeys);
+            BAIL_ON_ERROR(dwError);
+
+            pIndex->ppszKeys = ppszKeys;
+            pIndex->nCapacity = nCapacity;
+        }
+        pIndex->ppszKeys[pIndex->nCount++] = pszKeyStart;
+
+        dwError = coapi_json_skip_value(pReader);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pIndex->nCount)
+    {
+        dwError = coapi_allocate_memory(
+                      sizeof(PREST_API_ENDPOINT) * pIndex->nCount,
+                      (void **)&pIndex->ppEndPoints);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_allocate_memory(
+                      sizeof(PREST_API_MODULE) * pIndex->nCount,
+                      (void **)&pIndex->ppModules);
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    if(pReader)
+    {
+        pReader->nInSitu = nInSitu;
+    }
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+void
+coapi_free_path_index(
+    PCOAPI_PATH_INDEX pIndex
+    )
+{
+    if(!pIndex)
+    {
+        return;
+    }
+    SAFE_FREE_MEMORY(pIndex->ppszKeys);
+    SAFE_FREE_MEMORY(pIndex->ppEndPoints);
+    SAFE_FREE_MEMORY(pIndex->ppModules);
+}
+
+//loads paths nStart to nEnd. stops at the first error, which is left
+//in dwError.
+void *
+coapi_path_worker(
+    void *pArg
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_PATH_WORKER pWorker = pArg;
+    PCOAPI_LOADER pLoader = NULL;
+    PCOAPI_PATH_INDEX pIndex = NULL;
+    const char *pszKey = NULL;
+    size_t i = 0;
+
+    if(!pWorker)
+    {
+        return NULL;
+    }
+
+    pLoader = &pWorker->stLoader;
+    pIndex = pWorker->pIndex;
+
+    for(i = pWorker->nStart; i < pWorker->nEnd; ++i)
+    {
+        PREST_API_MODULE pModule = NULL;
+
+        dwError = coapi_check_cancel(pLoader->pnCancel);
+        BAIL_ON_ERROR(dwError);
+
+        pLoader->stReader.pszCur = pIndex->ppszKeys[i];
+        pLoader->stReader.nNeedComma = i > 0;
+
+        dwError = coapi_json_next_key(&pLoader->stReader, &pszKey);
+        BAIL_ON_ERROR(dwError);
+
+        if(pLoader->nFilterModule)
+        {
+            dwError = coapi_peek_endpoint_module(pLoader,
+                                                 pWorker->pApiModules,
+                                                 &pModule);
+            BAIL_ON_ERROR(dwError);
+
+            if(pModule && pModule != pLoader->pFilterModule)
+            {
+                continue;
+            }
+        }
+
+        dwError = coapi_load_endpoint(pLoader,
+                                      pszKey,
+                                      pWorker->pszBasePath,
+                                      pWorker->pApiModules,
+                                      &pIndex->ppEndPoints[i],
+                                      &pIndex->ppModules[i]);
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    pWorker->dwError = dwError;
+    return NULL;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_load_endpoints_parallel(
+    PCOAPI_LOADER pLoader,
+    const char *pszBasePath,
+    PREST_API_MODULE pApiModules,
+    uint32_t dwThreads
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_PATH_INDEX stIndex = {0};
+    PCOAPI_PATH_WORKER pWorkers = NULL;
+    size_t nWorkers = 0;
+    size_t i = 0;
+
+    if(!pLoader || !pszBasePath || !pApiModules)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_index_paths(pLoader, &stIndex);
+    BAIL_ON_ERROR(dwError);
+
+    if(!dwThreads)
+    {
+        long nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        dwThreads = nCpus > 0 ? nCpus : 1;
+    }
+    if(dwThreads > COAPI_PARALLEL_MAX_THREADS)
+    {
+        dwThreads = COAPI_PARALLEL_MAX_THREADS;
+    }
+
+    nWorkers = stIndex.nCount / COAPI_PARALLEL_MIN_PATHS;
+    if(nWorkers > dwThreads)
+    {
+        nWorkers = dwThreads;
+    }
+    if(!nWorkers)
+    {
+        nWorkers = 1;
+    }
+
+    dwError = coapi_allocate_memory(sizeof(COAPI_PATH_WORKER) * nWorkers,
+                                    (void **)&pWorkers);
+    BAIL_ON_ERROR(dwError);
+
+    for(i = 0; i < nWorkers; ++i)
+    {
+        PCOAPI_PATH_WORKER pWorker = &pWorkers[i];
+        PCOAPI_LOADER pWorkerLoader = &pWorker->stLoader;
+
+        pWorker->pIndex = &stIndex;
+        pWorker->nStart = stIndex.nCount * i / nWorkers;
+        pWorker->nEnd = stIndex.nCount * (i + 1) / nWorkers;
+        pWorker->pszBasePath = pszBasePath;
+        pWorker->pApiModules = pApiModules;
+
+        coapi_json_reader_init(&pWorkerLoader->stReader,
+                               pLoader->stReader.pszStart,
+                               pLoader->stReader.pszEnd -
+                               pLoader->stReader.pszStart);
+        pWorkerLoader->stReader.nInSitu = pLoader->stReader.nInSitu;
+        pWorkerLoader->stReader.pScanner = pLoader->stReader.pScanner;
+        pWorkerLoader->pApiDef = pLoader->pApiDef;
+        pWorkerLoader->dwFlags = pLoader->dwFlags;
+        pWorkerLoader->nFilterModule = pLoader->nFilterModule;
+        pWorkerLoader->pFilterModule = pLoader->pFilterModule;
+        pWorkerLoader->pDefaultModule = pLoader->pDefaultModule;
+        pWorkerLoader->pszRefParameters = pLoader->pszRefParameters;
+        pWorkerLoader->pszRefDefinitions = pLoader->pszRefDefinitions;
+        pWorkerLoader->pnCancel = pLoader->pnCancel;
+
+        dwError = coapi_arena_create(&pWorkerLoader->pArena);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //the calling thread takes the first range
+    for(i = 1; i < nWorkers; ++i)
+    {
+        if(pthread_create(&pWorkers[i].nThread,
+                          NULL,
+                          coapi_path_worker,
+                          &pWorkers[i]))
+        {
+            dwError = EAGAIN;
+            BAIL_ON_ERROR(dwError);
+        }
+        pWorkers[i].nStarted = 1;
+    }
+    coapi_path_worker(&pWorkers[0]);
+
+    for(i = 1; i < nWorkers; ++i)
+    {
+        pthread_join(pWorkers[i].nThread, NULL);
+        pWorkers[i].nStarted = 0;
+    }
+
+    //the first error in path order is the one a serial load reports
+    for(i = 0; i < nWorkers; ++i)
+    {
+        dwError = pWorkers[i].dwError;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //modules have no endpoints before paths are loaded. prepending in
+    //reverse path order gives the serial order without a tail walk.
+    for(i = stIndex.nCount; i > 0; --i)
+    {
+        PREST_API_ENDPOINT pEndPoint = stIndex.ppEndPoints[i - 1];
+        PREST_API_MODULE pModule = stIndex.ppModules[i - 1];
+
+        if(!pEndPoint)
+        {
+            continue;
+        }
+        if(!pModule)
+        {
+            dwError = EINVAL;
+            BAIL_ON_ERROR(dwError);
+        }
+        pEndPoint->pNext = pModule->pEndPoints;
+        pModule->pEndPoints = pEndPoint;
+    }
+
+cleanup:
+    if(pWorkers)
+    {
+        for(i = 0; i < nWorkers; ++i)
+        {
+            PCOAPI_LOADER pWorkerLoader = &pWorkers[i].stLoader;
+
+            if(pWorkers[i].nStarted)
+            {
+                pthread_join(pWorkers[i].nThread, NULL);
+            }
+            //anything the worker allocated now belongs to the def
+            if(pWorkerLoader->pArena)
+            {
+                coapi_arena_merge(pLoader->pArena, pWorkerLoader->pArena);
+            }
+            pLoader->nTempAllocations += pWorkerLoader->nTempAllocations;
+            pLoader->nTempAllocatedBytes +=
+                pWorkerLoader->nTempAllocatedBytes;
+            coapi_add_load_stats(&pLoader->stStats, &pWorkerLoader->stStats);
+            coapi_free_loader(pWorkerLoader);
+        }
+        SAFE_FREE_MEMORY(pWorkers);
+    }
+    coapi_free_path_index(&stIndex);
+    return dwError;
+
+error:
+    goto cleanup;
+}
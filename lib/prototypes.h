@@ -14,92 +14,1353 @@
 
 #pragma once
 
+//api.c
 uint32_t
-coapi_find_tagged_module(
-    json_t *pPath,
-    PREST_API_MODULE pModules,
-    PREST_API_MODULE *ppModule
+coapi_load_file(
+    const char *pszFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    const int *pnCancel,
+    PREST_API_DEF *ppApiDef
+    );
+
+//apitable.c
+uint32_t
+coapi_build_api_table(
+    PREST_API_DEF pApiDef
+    );
+
+void
+coapi_free_api_table(
+    PCOAPI_API_TABLE pTable
+    );
+
+uint32_t
+coapi_table_find_endpoint(
+    PCOAPI_API_TABLE pTable,
+    const char *pszName,
+    PREST_API_ENDPOINT *ppEndPoint
+    );
+
+uint32_t
+coapi_table_update_params(
+    PCOAPI_API_TABLE pTable,
+    PREST_API_METHOD pMethod
+    );
+
+//arena.c
+uint32_t
+coapi_arena_create(
+    PCOAPI_ARENA *ppArena
+    );
+
+uint32_t
+coapi_arena_add_block(
+    PCOAPI_ARENA pArena,
+    size_t nSize,
+    PCOAPI_ARENA_BLOCK *ppBlock
+    );
+
+uint32_t
+coapi_arena_allocate_aligned(
+    PCOAPI_ARENA pArena,
+    size_t nSize,
+    size_t nAlign,
+    void **ppMemory
+    );
+
+uint32_t
+coapi_arena_allocate(
+    PCOAPI_ARENA pArena,
+    size_t nSize,
+    void **ppMemory
+    );
+
+uint32_t
+coapi_arena_allocate_string_length(
+    PCOAPI_ARENA pArena,
+    const char *pszString,
+    size_t nLength,
+    char **ppszString
+    );
+
+uint32_t
+coapi_arena_allocate_string(
+    PCOAPI_ARENA pArena,
+    const char *pszString,
+    char **ppszString
+    );
+
+uint32_t
+coapi_arena_allocate_string_printf(
+    PCOAPI_ARENA pArena,
+    char **ppszString,
+    const char *pszFmt,
+    ...
+    );
+
+void
+coapi_arena_free(
+    PCOAPI_ARENA pArena
+    );
+
+void
+coapi_arena_merge(
+    PCOAPI_ARENA pArena,
+    PCOAPI_ARENA pSource
+    );
+
+//async.c
+void *
+coapi_load_task_run(
+    void *pArg
+    );
+
+void
+coapi_load_task_destroy(
+    PCOAPI_LOAD_TASK pTask
+    );
+
+uint32_t
+coapi_check_cancel(
+    const int *pnCancel
+    );
+
+//decompress.c
+COAPI_COMPRESSION
+coapi_get_compression(
+    const char *pData,
+    size_t nLength
+    );
+
+uint32_t
+coapi_text_buffer_reserve(
+    PCOAPI_TEXT_BUFFER pBuffer,
+    size_t nSize
+    );
+
+void
+coapi_text_buffer_free(
+    PCOAPI_TEXT_BUFFER pBuffer
+    );
+
+uint32_t
+coapi_gzip_decompress(
+    const char *pData,
+    size_t nLength,
+    PCOAPI_TEXT_BUFFER pBuffer
+    );
+
+uint32_t
+coapi_zstd_decompress(
+    const char *pData,
+    size_t nLength,
+    PCOAPI_TEXT_BUFFER pBuffer
+    );
+
+uint32_t
+coapi_decompress_text(
+    const char *pData,
+    size_t nLength,
+    COAPI_COMPRESSION nCompression,
+    char **ppszText,
+    size_t *pnLength
+    );
+
+//jsonreader.c
+void
+coapi_json_reader_init(
+    PCOAPI_JSON_READER pReader,
+    const char *pszText,
+    size_t nLength
+    );
+
+void
+coapi_json_reader_free(
+    PCOAPI_JSON_READER pReader
+    );
+
+uint32_t
+coapi_json_error(
+    PCOAPI_JSON_READER pReader,
+    const char *pszError
+    );
+
+void
+coapi_json_skip_space(
+    PCOAPI_JSON_READER pReader
+    );
+
+uint32_t
+coapi_json_peek(
+    PCOAPI_JSON_READER pReader,
+    COAPI_JSON_TYPE *pnType
+    );
+
+uint32_t
+coapi_json_expect(
+    PCOAPI_JSON_READER pReader,
+    char chExpected,
+    const char *pszError
+    );
+
+uint32_t
+coapi_json_begin_object(
+    PCOAPI_JSON_READER pReader
+    );
+
+uint32_t
+coapi_json_begin_array(
+    PCOAPI_JSON_READER pReader
+    );
+
+uint32_t
+coapi_json_next_key(
+    PCOAPI_JSON_READER pReader,
+    const char **ppszKey
+    );
+
+uint32_t
+coapi_json_next_element(
+    PCOAPI_JSON_READER pReader
+    );
+
+uint32_t
+coapi_json_reserve_buffer(
+    PCOAPI_JSON_READER pReader,
+    size_t nSize
+    );
+
+uint32_t
+coapi_json_read_hex4(
+    PCOAPI_JSON_READER pReader,
+    const char *pszHex,
+    uint32_t *pnValue
+    );
+
+uint32_t
+coapi_json_unescape(
+    PCOAPI_JSON_READER pReader,
+    char *pszOut,
+    size_t *pnLength
+    );
+
+uint32_t
+coapi_json_get_string(
+    PCOAPI_JSON_READER pReader,
+    const char **ppszValue
+    );
+
+uint32_t
+coapi_json_get_string_value(
+    PCOAPI_JSON_READER pReader,
+    PCOAPI_ARENA pArena,
+    char **ppszValue
+    );
+
+uint32_t
+coapi_json_get_true(
+    PCOAPI_JSON_READER pReader,
+    int *pnTrue
+    );
+
+uint32_t
+coapi_json_skip_string(
+    PCOAPI_JSON_READER pReader
+    );
+
+size_t
+coapi_json_escape_length(
+    const char *pszCur,
+    const char *pszEnd
+    );
+
+uint32_t
+coapi_json_skip_literal(
+    PCOAPI_JSON_READER pReader,
+    const char *pszLiteral
+    );
+
+uint32_t
+coapi_json_skip_number(
+    PCOAPI_JSON_READER pReader
+    );
+
+uint32_t
+coapi_json_skip_container(
+    PCOAPI_JSON_READER pReader
+    );
+
+uint32_t
+coapi_json_skip_token(
+    PCOAPI_JSON_READER pReader,
+    PCOAPI_JSON_SKIP pSkip,
+    int *pnDone
+    );
+
+uint32_t
+coapi_json_skip_scalar(
+    PCOAPI_JSON_READER pReader
+    );
+
+uint32_t
+coapi_json_skip_value(
+    PCOAPI_JSON_READER pReader
+    );
+
+int
+coapi_json_pointer_token_equals(
+    const char *pszToken,
+    size_t nLength,
+    const char *pszKey
+    );
+
+uint32_t
+coapi_json_find_pointer(
+    PCOAPI_JSON_READER pReader,
+    const char *pszPointer
+    );
+
+uint32_t
+coapi_json_end(
+    PCOAPI_JSON_READER pReader
+    );
+
+//jsonscan.c
+PCOAPI_JSON_SCANNER
+coapi_json_get_scanner(
+    uint32_t dwFlags
+    );
+
+const char *
+coapi_json_find_string_end_scalar(
+    const char *pszCur,
+    const char *pszEnd
+    );
+
+const char *
+coapi_json_skip_space_scalar(
+    const char *pszCur,
+    const char *pszEnd
+    );
+
+uint32_t
+coapi_json_skip_container_scalar(
+    PCOAPI_JSON_READER pReader
+    );
+
+uint32_t
+coapi_json_match_tokens(
+    PCOAPI_JSON_READER pReader,
+    PCOAPI_JSON_SKIP pSkip,
+    const char *pszBlock,
+    uint64_t nTokens,
+    int *pnDone
+    );
+
+uint32_t
+coapi_json_token_error(
+    PCOAPI_JSON_READER pReader,
+    PCOAPI_JSON_SKIP pSkip,
+    const char *pszPos
+    );
+
+uint32_t
+coapi_json_skip_tokens(
+    PCOAPI_JSON_READER pReader,
+    PCOAPI_JSON_SKIP pSkip
+    );
+
+#ifdef COAPI_HAVE_SSE2
+const char *
+coapi_json_find_string_end_sse2(
+    const char *pszCur,
+    const char *pszEnd
+    );
+
+const char *
+coapi_json_skip_space_sse2(
+    const char *pszCur,
+    const char *pszEnd
+    );
+
+uint32_t
+coapi_json_skip_container_sse2(
+    PCOAPI_JSON_READER pReader
+    );
+
+void
+coapi_json_index_block(
+    const char *pszCur,
+    PCOAPI_JSON_BLOCK pBlock
+    );
+#endif
+
+//jsonwriter.c
+void
+coapi_json_writer_init(
+    PCOAPI_JSON_WRITER pWriter,
+    int fd
+    );
+
+void
+coapi_json_writer_free(
+    PCOAPI_JSON_WRITER pWriter
+    );
+
+uint32_t
+coapi_json_writer_flush(
+    PCOAPI_JSON_WRITER pWriter
+    );
+
+uint32_t
+coapi_json_writer_reserve(
+    PCOAPI_JSON_WRITER pWriter,
+    size_t nSize
+    );
+
+uint32_t
+coapi_json_write_raw(
+    PCOAPI_JSON_WRITER pWriter,
+    const char *pszText,
+    size_t nLength
+    );
+
+uint32_t
+coapi_json_write_string(
+    PCOAPI_JSON_WRITER pWriter,
+    const char *pszString
+    );
+
+uint32_t
+coapi_json_write_separator(
+    PCOAPI_JSON_WRITER pWriter,
+    int *pnFirst
+    );
+
+uint32_t
+coapi_json_write_member(
+    PCOAPI_JSON_WRITER pWriter,
+    int *pnFirst,
+    const char *pszKey,
+    const char *pszValue
+    );
+
+//specwriter.c
+uint32_t
+coapi_write_spec(
+    PCOAPI_JSON_WRITER pWriter,
+    PREST_API_DEF pApiDef
+    );
+
+uint32_t
+coapi_write_endpoint(
+    PCOAPI_JSON_WRITER pWriter,
+    PREST_API_DEF pApiDef,
+    PREST_API_MODULE pModule,
+    PREST_API_ENDPOINT pEndPoint
+    );
+
+uint32_t
+coapi_write_method(
+    PCOAPI_JSON_WRITER pWriter,
+    PREST_API_DEF pApiDef,
+    PREST_API_MODULE pModule,
+    PREST_API_METHOD pMethod,
+    PREST_API_PARAM pEnd
+    );
+
+uint32_t
+coapi_write_params(
+    PCOAPI_JSON_WRITER pWriter,
+    int *pnFirst,
+    PREST_API_PARAM pParams,
+    PREST_API_PARAM pEnd
+    );
+
+uint32_t
+coapi_write_param(
+    PCOAPI_JSON_WRITER pWriter,
+    PREST_API_PARAM pParam
+    );
+
+uint32_t
+coapi_get_rest_type_string(
+    RESTPARAMTYPE nType,
+    const char **ppszType
+    );
+
+int
+coapi_params_equal(
+    PREST_API_PARAM pParam1,
+    PREST_API_PARAM pParam2
+    );
+
+uint32_t
+coapi_find_own_params_end(
+    PREST_API_PARAM pParams,
+    PREST_API_PARAM pPathParams,
+    PREST_API_PARAM *ppEnd
+    );
+
+//strtable.c
+uint32_t
+coapi_string_hash(
+    const char *pszString,
+    size_t nLength
+    );
+
+void
+coapi_string_table_init(
+    PCOAPI_STRING_TABLE pTable
+    );
+
+void
+coapi_string_table_free(
+    PCOAPI_STRING_TABLE pTable
+    );
+
+uint32_t
+coapi_string_table_grow(
+    PCOAPI_STRING_TABLE pTable
+    );
+
+uint32_t
+coapi_string_table_intern(
+    PCOAPI_STRING_TABLE pTable,
+    PCOAPI_ARENA pArena,
+    const char *pszString,
+    size_t nLength,
+    int nBorrow,
+    char **ppszString
+    );
+
+PCOAPI_STRING_ENTRY
+coapi_string_table_find_slot(
+    PCOAPI_STRING_TABLE pTable,
+    const char *pszString,
+    size_t nLength,
+    uint32_t dwHash
+    );
+
+uint32_t
+coapi_string_table_intern_block(
+    PCOAPI_STRING_TABLE pTable,
+    PCOAPI_ARENA pArena,
+    const void *pData,
+    size_t nSize,
+    void **ppData
+    );
+
+uint32_t
+coapi_string_table_get_value(
+    PCOAPI_STRING_TABLE pTable,
+    const char *pszString,
+    size_t nLength,
+    void **ppValue
+    );
+
+uint32_t
+coapi_string_table_set_value(
+    PCOAPI_STRING_TABLE pTable,
+    PCOAPI_ARENA pArena,
+    const char *pszString,
+    size_t nLength,
+    void *pValue
+    );
+
+//utils.c
+uint32_t
+coapi_file_map(
+    const char *pszFileName,
+    char **ppszText,
+    size_t *pnLength
+    );
+
+void
+coapi_file_unmap(
+    void *pText,
+    size_t nLength
+    );
+
+//federation.c
+uint32_t
+coapi_name_federated_modules(
+    PCOAPI_ARENA pArena,
+    const char *pszSpecName,
+    PCOAPI_SPEC pSpec
+    );
+
+//footprint.c
+size_t
+coapi_footprint_round(
+    size_t nSize
+    );
+
+int
+coapi_footprint_is_borrowed(
+    PREST_API_DEF pApiDef,
+    const void *pBlock
+    );
+
+uint32_t
+coapi_footprint_add(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    const void *pBlock,
+    size_t nSize,
+    PCOAPI_FOOTPRINT_ENTRY pEntry,
+    size_t *pnBytes
+    );
+
+uint32_t
+coapi_footprint_add_string(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    const char *pszString,
+    PCOAPI_FOOTPRINT_ENTRY pEntry,
+    size_t *pnBytes
+    );
+
+uint32_t
+coapi_footprint_add_entry(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    size_t nParent,
+    COAPI_FOOTPRINT_LEVEL nLevel,
+    PCOAPI_FOOTPRINT_ENTRY *ppEntry
+    );
+
+void
+coapi_footprint_add_child(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    size_t nParent,
+    size_t nChild
+    );
+
+uint32_t
+coapi_footprint_walk_param(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    size_t nParent,
+    PREST_API_PARAM pParam
+    );
+
+uint32_t
+coapi_footprint_walk_method(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    size_t nParent,
+    PREST_API_ENDPOINT pEndPoint,
+    PREST_API_METHOD pMethod
+    );
+
+uint32_t
+coapi_footprint_walk_endpoint(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    size_t nParent,
+    PREST_API_ENDPOINT pEndPoint
+    );
+
+uint32_t
+coapi_footprint_walk_module(
+    PCOAPI_FOOTPRINT_WALK pWalk,
+    PREST_API_MODULE pModule
+    );
+
+size_t
+coapi_footprint_get_index_bytes(
+    PCOAPI_API_TABLE pTable
+    );
+
+size_t
+coapi_footprint_entry_bytes(
+    PCOAPI_FOOTPRINT_ENTRY pEntry
+    );
+
+int
+coapi_footprint_compare_bytes(
+    size_t nLeft,
+    size_t nRight,
+    PCOAPI_FOOTPRINT_ENTRY pLeft,
+    PCOAPI_FOOTPRINT_ENTRY pRight
+    );
+
+int
+coapi_footprint_compare_def(
+    const void *pLeft,
+    const void *pRight
+    );
+
+int
+coapi_footprint_compare_total(
+    const void *pLeft,
+    const void *pRight
+    );
+
+int
+coapi_footprint_compare_strings(
+    const void *pLeft,
+    const void *pRight
+    );
+
+int
+coapi_footprint_compare_options(
+    const void *pLeft,
+    const void *pRight
+    );
+
+int
+coapi_footprint_compare_nodes(
+    const void *pLeft,
+    const void *pRight
+    );
+
+int
+coapi_footprint_compare_shared(
+    const void *pLeft,
+    const void *pRight
+    );
+
+const char *
+coapi_footprint_name(
+    const char *pszName
+    );
+
+//image.c
+uint32_t
+coapi_image_reserve(
+    PCOAPI_IMAGE_WRITER pWriter,
+    size_t nSize,
+    size_t *pnOffset
+    );
+
+uint32_t
+coapi_image_add_reloc(
+    PCOAPI_IMAGE_WRITER pWriter,
+    size_t nSlot,
+    size_t nTarget
+    );
+
+uint32_t
+coapi_image_set_pointer(
+    PCOAPI_IMAGE_WRITER pWriter,
+    size_t nSlot,
+    size_t nTarget
     );
 
-//jsonutils.c
 uint32_t
-get_json_object_from_string(
+coapi_image_put_string(
+    PCOAPI_IMAGE_WRITER pWriter,
     const char *pszString,
-    json_t **ppJsonObject
+    size_t nSlot
     );
 
 uint32_t
-json_safe_get_string_value(
-    json_t *pRoot,
-    const char *pszKey,
-    char **ppszValue
+coapi_image_write_params(
+    PCOAPI_IMAGE_WRITER pWriter,
+    PREST_API_PARAM pParams,
+    size_t nHeadSlot
     );
 
 uint32_t
-json_get_string_value(
-    json_t *pRoot,
-    const char *pszKey,
-    char **ppszValue
+coapi_image_write_method(
+    PCOAPI_IMAGE_WRITER pWriter,
+    PREST_API_METHOD pMethod,
+    size_t nSlot
     );
 
-//utils.c
 uint32_t
-coapi_file_read_all_text(
-    const char *pszFileName,
-    char **ppszText
+coapi_image_write_endpoints(
+    PCOAPI_IMAGE_WRITER pWriter,
+    PREST_API_ENDPOINT pEndPoints,
+    size_t nHeadSlot
+    );
+
+uint32_t
+coapi_image_write_modules(
+    PCOAPI_IMAGE_WRITER pWriter,
+    PREST_API_MODULE pModules,
+    size_t nHeadSlot
+    );
+
+uint32_t
+coapi_image_write(
+    PREST_API_DEF pApiDef,
+    const char *pszPath,
+    size_t nSourceLength,
+    uint64_t nSourceHash,
+    PCOAPI_IMAGE_WRITER pWriter
+    );
+
+uint32_t
+coapi_image_save(
+    PCOAPI_IMAGE_WRITER pWriter,
+    const char *pszImageFile
+    );
+
+void
+coapi_image_free_writer(
+    PCOAPI_IMAGE_WRITER pWriter
+    );
+
+uint32_t
+coapi_image_check_header(
+    PCOAPI_IMAGE_HEADER pHeader,
+    size_t nFileSize,
+    PCOAPI_SPEC_INDEX pSource
+    );
+
+uint32_t
+coapi_image_relocate(
+    char *pBase,
+    PCOAPI_IMAGE_HEADER pHeader
+    );
+
+int
+coapi_image_is_inside(
+    PCOAPI_IMAGE_CHECK pCheck,
+    const void *p,
+    size_t nSize
+    );
+
+uint32_t
+coapi_image_check_string(
+    PCOAPI_IMAGE_CHECK pCheck,
+    const char *pszString
+    );
+
+uint32_t
+coapi_image_check_node(
+    PCOAPI_IMAGE_CHECK pCheck,
+    const void *pNode,
+    size_t nSize,
+    uint8_t nKind,
+    int *pnChecked
+    );
+
+void
+coapi_image_mark_node(
+    PCOAPI_IMAGE_CHECK pCheck,
+    const void *pNode,
+    uint8_t nKind
+    );
+
+uint32_t
+coapi_image_check_params(
+    PCOAPI_IMAGE_CHECK pCheck,
+    PREST_API_PARAM pParams
+    );
+
+uint32_t
+coapi_image_check_method(
+    PCOAPI_IMAGE_CHECK pCheck,
+    PREST_API_METHOD pMethod
+    );
+
+uint32_t
+coapi_image_check_endpoints(
+    PCOAPI_IMAGE_CHECK pCheck,
+    PREST_API_ENDPOINT pEndPoints
+    );
+
+uint32_t
+coapi_image_check_def(
+    const char *pBase,
+    PCOAPI_IMAGE_HEADER pHeader,
+    PREST_API_DEF pApiDef
+    );
+
+uint32_t
+coapi_image_load(
+    const char *pszImageFile,
+    const char *pszFile,
+    const char *pszPath,
+    PREST_API_DEF *ppApiDef
+    );
+
+uint32_t
+coapi_image_get_file_name(
+    const char *pszFile,
+    char **ppszImageFile
+    );
+
+uint32_t
+coapi_image_load_for_file(
+    const char *pszFile,
+    PREST_API_DEF *ppApiDef
+    );
+
+uint32_t
+coapi_image_filter_module(
+    PREST_API_DEF pApiDef,
+    const char *pszModule
+    );
+
+void
+coapi_image_free(
+    PREST_API_DEF pApiDef
+    );
+
+uint32_t
+coapi_image_compile(
+    const char *pszFile,
+    const char *pszImageFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    const int *pnCancel
+    );
+
+uint32_t
+coapi_get_shared_dir(
+    char **ppszDir
+    );
+
+uint32_t
+coapi_check_shared_file(
+    const struct stat *pFile
+    );
+
+uint32_t
+coapi_get_shared_file_name(
+    const char *pszPath,
+    const char *pszExtension,
+    char **ppszFile
+    );
+
+uint32_t
+coapi_image_get_shared_name(
+    const char *pszFile,
+    char **ppszImageFile,
+    char **ppszPath
+    );
+
+uint32_t
+coapi_image_load_shared(
+    const char *pszFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    const int *pnCancel,
+    PREST_API_DEF *ppApiDef
+    );
+
+//specindex.c
+uint64_t
+coapi_xxh_rotl(
+    uint64_t nValue,
+    int nBits
+    );
+
+uint64_t
+coapi_xxh_read64(
+    const char *pszPos
+    );
+
+uint64_t
+coapi_xxh_round(
+    uint64_t nAcc,
+    uint64_t nInput
+    );
+
+uint64_t
+coapi_xxh_merge(
+    uint64_t nAcc,
+    uint64_t nValue
+    );
+
+uint64_t
+coapi_hash_text(
+    const char *pszText,
+    size_t nLength
+    );
+
+void
+coapi_spec_index_set_source(
+    PCOAPI_SPEC_INDEX pIndex,
+    const struct stat *pSource
+    );
+
+int
+coapi_spec_index_matches(
+    PCOAPI_SPEC_INDEX pIndex,
+    const struct stat *pSource
+    );
+
+uint32_t
+coapi_spec_index_get_name(
+    const char *pszFile,
+    char **ppszIndexFile,
+    char **ppszPath
+    );
+
+uint32_t
+coapi_spec_index_read(
+    const char *pszIndexFile,
+    const char *pszPath,
+    PCOAPI_SPEC_INDEX pIndex
+    );
+
+uint32_t
+coapi_spec_index_write(
+    const char *pszIndexFile,
+    const char *pszPath,
+    PCOAPI_SPEC_INDEX pIndex
+    );
+
+void
+coapi_spec_index_update(
+    const char *pszFile,
+    const struct stat *pSource,
+    size_t nTextLength,
+    uint64_t nTextHash
+    );
+
+uint32_t
+coapi_spec_index_get(
+    const char *pszFile,
+    PCOAPI_SPEC_INDEX pIndex
+    );
+
+//loadstats.c
+uint64_t
+coapi_get_time_ns(
+    void
+    );
+
+void
+coapi_loader_get_allocations(
+    PCOAPI_LOADER pLoader,
+    size_t *pnAllocations,
+    size_t *pnAllocatedBytes
+    );
+
+void
+coapi_load_phase_begin(
+    PCOAPI_LOADER pLoader,
+    PCOAPI_LOAD_PHASE pMark
+    );
+
+void
+coapi_load_phase_end(
+    PCOAPI_LOADER pLoader,
+    PCOAPI_LOAD_PHASE pMark,
+    PCOAPI_LOAD_PHASE pPhase
+    );
+
+void
+coapi_add_load_phase(
+    PCOAPI_LOAD_PHASE pPhase,
+    PCOAPI_LOAD_PHASE pSource
+    );
+
+void
+coapi_add_load_stats(
+    PCOAPI_LOAD_STATS pStats,
+    PCOAPI_LOAD_STATS pSource
+    );
+
+uint32_t
+coapi_count_api_def(
+    PREST_API_DEF pApiDef,
+    PCOAPI_LOAD_STATS pStats
+    );
+
+void
+coapi_print_load_phase(
+    const char *pszName,
+    PCOAPI_LOAD_PHASE pPhase
+    );
+
+//parallel.c
+uint32_t
+coapi_index_paths(
+    PCOAPI_LOADER pLoader,
+    PCOAPI_PATH_INDEX pIndex
+    );
+
+void
+coapi_free_path_index(
+    PCOAPI_PATH_INDEX pIndex
+    );
+
+void *
+coapi_path_worker(
+    void *pArg
+    );
+
+uint32_t
+coapi_load_endpoints_parallel(
+    PCOAPI_LOADER pLoader,
+    const char *pszBasePath,
+    PREST_API_MODULE pApiModules,
+    uint32_t dwThreads
+    );
+
+//ptrmap.c
+uint32_t
+coapi_pointer_hash(
+    const void *pKey
+    );
+
+void
+coapi_pointer_map_free(
+    PCOAPI_POINTER_MAP pMap
+    );
+
+uint32_t
+coapi_pointer_map_grow(
+    PCOAPI_POINTER_MAP pMap
+    );
+
+PCOAPI_POINTER_ENTRY
+coapi_pointer_map_find_slot(
+    PCOAPI_POINTER_MAP pMap,
+    const void *pKey
+    );
+
+uint32_t
+coapi_pointer_map_get(
+    PCOAPI_POINTER_MAP pMap,
+    const void *pKey,
+    size_t *pnValue
+    );
+
+uint32_t
+coapi_pointer_map_set(
+    PCOAPI_POINTER_MAP pMap,
+    const void *pKey,
+    size_t nValue
+    );
+
+//reload.c
+uint32_t
+coapi_api_handle_load(
+    PCOAPI_API_HANDLE pHandle,
+    PREST_API_DEF *ppApiDef
+    );
+
+void
+coapi_api_handle_synchronize(
+    PCOAPI_API_HANDLE pHandle
+    );
+
+int
+coapi_api_handle_is_spec_event(
+    PCOAPI_API_HANDLE pHandle,
+    const char *pBuffer,
+    ssize_t nLength
+    );
+
+void *
+coapi_api_handle_watch(
+    void *pArg
     );
 
 //restapidef.c
+uint32_t
+coapi_load_api_def(
+    const char *pszText,
+    size_t nLength,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    const int *pnCancel,
+    PREST_API_DEF *ppApiDef
+    );
+
+uint32_t
+coapi_loader_begin_def(
+    PCOAPI_LOADER pLoader,
+    uint32_t dwFlags,
+    const int *pnCancel,
+    PREST_API_DEF *ppApiDef
+    );
+
+uint32_t
+coapi_load_spec(
+    PCOAPI_LOADER pLoader,
+    const char *pszText,
+    size_t nLength,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PCOAPI_SPEC pSpec
+    );
+
+uint32_t
+coapi_loader_end_def(
+    PCOAPI_LOADER pLoader
+    );
+
+void
+coapi_free_loader(
+    PCOAPI_LOADER pLoader
+    );
+
+uint32_t
+coapi_load_interned_string(
+    PCOAPI_LOADER pLoader,
+    char **ppszValue
+    );
+
+uint32_t
+coapi_load_module(
+    PCOAPI_LOADER pLoader,
+    PREST_API_MODULE *ppApiModule
+    );
+
 uint32_t
 coapi_load_modules(
-    json_t *pRoot,
+    PCOAPI_LOADER pLoader,
     PREST_API_MODULE *ppApiModules
     );
 
+uint32_t
+coapi_replace_endpoint_path(
+    PCOAPI_ARENA pArena,
+    char *pszActualName,
+    PREST_API_PARAM pApiParams,
+    char **ppszName
+    );
+
+uint32_t
+coapi_load_method_tags(
+    PCOAPI_LOADER pLoader,
+    char **ppszTag,
+    int *pnTagCount
+    );
+
+uint32_t
+coapi_load_method(
+    PCOAPI_LOADER pLoader,
+    const char *pszMethod,
+    RESTMETHOD nMethod,
+    int nLazy,
+    PREST_API_METHOD *ppMethod,
+    char **ppszTag,
+    int *pnTagCount
+    );
+
+uint32_t
+coapi_load_method_fields(
+    PCOAPI_LOADER pLoader,
+    PREST_API_METHOD pMethod,
+    int nSkipDetails,
+    char **ppszTag,
+    int *pnTagCount
+    );
+
+uint32_t
+coapi_load_endpoint(
+    PCOAPI_LOADER pLoader,
+    const char *pszPath,
+    const char *pszBasePath,
+    PREST_API_MODULE pApiModules,
+    PREST_API_ENDPOINT *ppEndPoint,
+    PREST_API_MODULE *ppModule
+    );
+
+uint32_t
+coapi_peek_endpoint_module(
+    PCOAPI_LOADER pLoader,
+    PREST_API_MODULE pApiModules,
+    PREST_API_MODULE *ppModule
+    );
+
 uint32_t
 coapi_load_endpoints(
-    json_t *pRoot,
+    PCOAPI_LOADER pLoader,
     const char *pszBasePath,
     PREST_API_MODULE pApiModules
     );
 
+uint32_t
+coapi_fill_enum(
+    PCOAPI_LOADER pLoader,
+    int *pnOptionCount,
+    char ***pppszOptions
+    );
+
+uint32_t
+coapi_load_parameter(
+    PCOAPI_LOADER pLoader,
+    PREST_API_PARAM *ppParam
+    );
+
+uint32_t
+coapi_resolve_parameter_ref(
+    PCOAPI_LOADER pLoader,
+    const char *pszRef,
+    PREST_API_PARAM *ppParam
+    );
+
 uint32_t
 coapi_load_parameters(
-    json_t *pMethod,
+    PCOAPI_LOADER pLoader,
     PREST_API_PARAM *ppParam
     );
 
+uint32_t
+coapi_add_path_params(
+    PCOAPI_LOADER pLoader,
+    PREST_API_PARAM pPathParams,
+    PREST_API_PARAM *ppParams
+    );
+
+uint32_t
+coapi_share_param(
+    PCOAPI_LOADER pLoader,
+    PREST_API_PARAM pParam,
+    PREST_API_PARAM pNext,
+    PREST_API_PARAM *ppShared
+    );
+
+uint32_t
+coapi_share_params(
+    PCOAPI_LOADER pLoader,
+    PREST_API_PARAM pParams,
+    PREST_API_PARAM pSkip,
+    PREST_API_PARAM pTail,
+    PREST_API_PARAM *ppShared
+    );
+
+PREST_API_PARAM
+coapi_find_param(
+    PREST_API_PARAM pParams,
+    PREST_API_PARAM pParam
+    );
+
 uint32_t
 coapi_load_secure_scheme(
-    json_t *pRoot,
+    PCOAPI_LOADER pLoader,
     int *pnHasSecure
     );
 
+uint32_t
+coapi_find_tagged_module(
+    const char *pszTag,
+    int nTagCount,
+    PREST_API_MODULE pModules,
+    PREST_API_MODULE *ppModule
+    );
+
 uint32_t
 coapi_module_add_endpoint(
+    PCOAPI_LOADER pLoader,
     PREST_API_MODULE pModule,
     PREST_API_ENDPOINT pEndPoint
     );
 
 uint32_t
 coapi_add_default_module(
+    PCOAPI_ARENA pArena,
     const char *pszModuleName,
     PREST_API_MODULE *ppApiModules
     );
 
 void
 coapi_free_api_param(
-    PREST_API_PARAM pParam
+    PREST_API_PARAM pParam,
+    PREST_API_PARAM pStop
     );
 
 void
-coapi_free_api_endpoint(
-    PREST_API_ENDPOINT pEndPoint
+coapi_free_api_method(
+    PREST_API_METHOD pMethod,
+    PREST_API_PARAM pPathParams
     );
 
 void
-coapi_free_api_method(
-    PREST_API_METHOD pMethod
+coapi_free_api_endpoint(
+    PREST_API_ENDPOINT pEndPoint
     );
 
 void
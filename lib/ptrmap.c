@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Map from a pointer to an offset or index. Used to write a node that
+//is shared by several lists only once.
+
+#include "includes.h"
+
+uint32_t
+coapi_pointer_hash(
+    const void *pKey
+    )
+{
+    uint64_t nKey = (uintptr_t)pKey;
+
+    nKey ^= nKey >> 33;
+    nKey *= 0xff51afd7ed558ccdULL;
+    nKey ^= nKey >> 33;
+    return (uint32_t)nKey;
+}
+
+void
+coapi_pointer_map_free(
+    PCOAPI_POINTER_MAP pMap
+    )
+{
+    if(!pMap)
+    {
+        return;
+    }
+    SAFE_FREE_MEMORY(pMap->pEntries);
+    memset(pMap, 0, sizeof(*pMap));
+}
+
+uint32_t
+coapi_pointer_map_grow(
+    PCOAPI_POINTER_MAP pMap
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_POINTER_ENTRY pEntries = NULL;
+    size_t nCapacity = 0;
+    size_t i = 0;
+
+    if(!pMap)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nCapacity = pMap->nCapacity ? pMap->nCapacity * 2 :
+                                  COAPI_POINTER_MAP_SIZE;
+
+    dwError = coapi_allocate_memory(sizeof(COAPI_POINTER_ENTRY) * nCapacity,
+                                    (void **)&pEntries);
+    BAIL_ON_ERROR(dwError);
+
+    for(i = 0; i < pMap->nCapacity; ++i)
+    {
+        PCOAPI_POINTER_ENTRY pEntry = &pMap->pEntries[i];
+        size_t nSlot = 0;
+
+        if(!pEntry->pKey)
+        {
+            continue;
+        }
+
+        nSlot = coapi_pointer_hash(pEntry->pKey) & (nCapacity - 1);
+        while(pEntries[nSlot].pKey)
+        {
+            nSlot = (nSlot + 1) & (nCapacity - 1);
+        }
+        pEntries[nSlot] = *pEntry;
+    }
+
+    SAFE_FREE_MEMORY(pMap->pEntries);
+    pMap->pEntries = pEntries;
+    pMap->nCapacity = nCapacity;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//the entry for pKey, or the free slot for it. the map must have at
+//least one free slot.
+PCOAPI_POINTER_ENTRY
+coapi_pointer_map_find_slot(
+    PCOAPI_POINTER_MAP pMap,
+    const void *pKey
+    )
+{
+    size_t nSlot = coapi_pointer_hash(pKey) & (pMap->nCapacity - 1);
+
+    while(pMap->pEntries[nSlot].pKey && pMap->pEntries[nSlot].pKey != pKey)
+    {
+        nSlot = (nSlot + 1) & (pMap->nCapacity - 1);
+    }
+    return &pMap->pEntries[nSlot];
+}
+
+//returns ENOENT if pKey is not in the map
+uint32_t
+coapi_pointer_map_get(
+    PCOAPI_POINTER_MAP pMap,
+    const void *pKey,
+    size_t *pnValue
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_POINTER_ENTRY pEntry = NULL;
+
+    if(!pMap || !pKey || !pnValue)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!pMap->nCount)
+    {
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pEntry = coapi_pointer_map_find_slot(pMap, pKey);
+    if(!pEntry->pKey)
+    {
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *pnValue = pEntry->nValue;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_pointer_map_set(
+    PCOAPI_POINTER_MAP pMap,
+    const void *pKey,
+    size_t nValue
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_POINTER_ENTRY pEntry = NULL;
+
+    if(!pMap || !pKey)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if((pMap->nCount + 1) * 2 > pMap->nCapacity)
+    {
+        dwError = coapi_pointer_map_grow(pMap);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pEntry = coapi_pointer_map_find_slot(pMap, pKey);
+    if(!pEntry->pKey)
+    {
+        pEntry->pKey = pKey;
+        ++pMap->nCount;
+    }
+    pEntry->nValue = nValue;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
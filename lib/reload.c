@@ -0,0 +1,430 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Reloadable api def for long running hosts. A watcher thread reloads
+//the spec when it changes and publishes the new def with an atomic
+//store. Readers bracket their use of the def with acquire and release,
+//which only count readers and never wait. Before an old def is freed,
+//the writer flips the reader epoch twice and waits for the readers
+//counted under each epoch to leave.
+
+#include "includes.h"
+
+uint32_t
+coapi_api_handle_open(
+    const char *pszFile,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PMODULE_REG_MAP pRegMap,
+    PCOAPI_API_HANDLE *ppHandle
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_API_HANDLE pHandle = NULL;
+    const char *pszName = NULL;
+
+    if(IsNullOrEmptyString(pszFile) || !pRegMap || !ppHandle)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //lazy methods are filled in by readers, which is not safe to share
+    if(pOptions && (pOptions->dwFlags & COAPI_LOAD_LAZY_METHODS))
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_allocate_memory(sizeof(COAPI_API_HANDLE),
+                                    (void **)&pHandle);
+    BAIL_ON_ERROR(dwError);
+
+    pHandle->nInotifyFd = -1;
+    pHandle->pnStopPipe[0] = -1;
+    pHandle->pnStopPipe[1] = -1;
+    pHandle->pRegMap = pRegMap;
+
+    dwError = pthread_mutex_init(&pHandle->mutexReload, NULL);
+    BAIL_ON_ERROR(dwError);
+    pHandle->nMutexInit = 1;
+
+    dwError = coapi_allocate_string(pszFile, &pHandle->pszFile);
+    BAIL_ON_ERROR(dwError);
+
+    if(pOptions)
+    {
+        pHandle->stOptions = *pOptions;
+        pHandle->stOptions.pszModule = NULL;
+        if(pOptions->pszModule)
+        {
+            dwError = coapi_allocate_string(pOptions->pszModule,
+                                            &pHandle->pszModule);
+            BAIL_ON_ERROR(dwError);
+            pHandle->stOptions.pszModule = pHandle->pszModule;
+        }
+    }
+
+    //editors and deploy tools usually replace the file, so the
+    //directory is watched for the file name
+    pszName = strrchr(pszFile, '/');
+    if(pszName)
+    {
+        dwError = coapi_allocate_string(pszFile, &pHandle->pszDir);
+        BAIL_ON_ERROR(dwError);
+        pHandle->pszDir[pszName - pszFile + 1] = '\0';
+        ++pszName;
+    }
+    else
+    {
+        dwError = coapi_allocate_string(".", &pHandle->pszDir);
+        BAIL_ON_ERROR(dwError);
+        pszName = pszFile;
+    }
+    pHandle->pszName = pszName - pszFile + pHandle->pszFile;
+
+    dwError = coapi_api_handle_load(pHandle, &pHandle->pApiDef);
+    BAIL_ON_ERROR(dwError);
+
+    pHandle->nInotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if(pHandle->nInotifyFd < 0)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(inotify_add_watch(pHandle->nInotifyFd,
+                         pHandle->pszDir,
+                         IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pipe2(pHandle->pnStopPipe, O_CLOEXEC))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = pthread_create(&pHandle->nWatcher,
+                             NULL,
+                             coapi_api_handle_watch,
+                             pHandle);
+    BAIL_ON_ERROR(dwError);
+    pHandle->nWatcherStarted = 1;
+
+    *ppHandle = pHandle;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppHandle)
+    {
+        *ppHandle = NULL;
+    }
+    coapi_api_handle_close(pHandle);
+    goto cleanup;
+}
+
+//loads the spec and maps the implementations into a new def
+uint32_t
+coapi_api_handle_load(
+    PCOAPI_API_HANDLE pHandle,
+    PREST_API_DEF *ppApiDef
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_DEF pApiDef = NULL;
+
+    if(!pHandle || !ppApiDef)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_load_from_file_ex(pHandle->pszFile,
+                                      &pHandle->stOptions,
+                                      &pApiDef);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_map_api_impl(pApiDef, pHandle->pRegMap);
+    BAIL_ON_ERROR(dwError);
+
+    *ppApiDef = pApiDef;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppApiDef)
+    {
+        *ppApiDef = NULL;
+    }
+    coapi_free_api_def(pApiDef);
+    goto cleanup;
+}
+
+//returns the current def and the reader slot to release it with.
+//never blocks. the def stays valid until coapi_api_handle_release.
+uint32_t
+coapi_api_handle_acquire(
+    PCOAPI_API_HANDLE pHandle,
+    PREST_API_DEF *ppApiDef,
+    int *pnSlot
+    )
+{
+    uint32_t dwError = 0;
+    int nSlot = 0;
+
+    if(!pHandle || !ppApiDef || !pnSlot)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nSlot = __atomic_load_n(&pHandle->dwEpoch, __ATOMIC_SEQ_CST) & 1;
+    __atomic_add_fetch(&pHandle->pdwReaders[nSlot], 1, __ATOMIC_SEQ_CST);
+
+    *ppApiDef = __atomic_load_n(&pHandle->pApiDef, __ATOMIC_SEQ_CST);
+    *pnSlot = nSlot;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+void
+coapi_api_handle_release(
+    PCOAPI_API_HANDLE pHandle,
+    int nSlot
+    )
+{
+    if(!pHandle || nSlot < 0 || nSlot > 1)
+    {
+        return;
+    }
+    __atomic_sub_fetch(&pHandle->pdwReaders[nSlot], 1, __ATOMIC_SEQ_CST);
+}
+
+//waits until no reader can still hold a def unpublished before this
+//call. readers that start later see the new def.
+void
+coapi_api_handle_synchronize(
+    PCOAPI_API_HANDLE pHandle
+    )
+{
+    int i = 0;
+
+    if(!pHandle)
+    {
+        return;
+    }
+
+    for(i = 0; i < 2; ++i)
+    {
+        uint32_t dwSlot =
+            __atomic_fetch_add(&pHandle->dwEpoch, 1, __ATOMIC_SEQ_CST) & 1;
+
+        while(__atomic_load_n(&pHandle->pdwReaders[dwSlot], __ATOMIC_SEQ_CST))
+        {
+            usleep(COAPI_RELOAD_GRACE_POLL_US);
+        }
+    }
+}
+
+//loads the spec again and publishes it if it loads and maps. on error
+//the current def stays. the caller must not hold an acquire of pHandle,
+//as synchronize would wait for it.
+uint32_t
+coapi_api_handle_reload(
+    PCOAPI_API_HANDLE pHandle
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_DEF pOldApiDef = NULL;
+    int nLocked = 0;
+
+    if(!pHandle)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pthread_mutex_lock(&pHandle->mutexReload);
+    nLocked = 1;
+
+    dwError = coapi_api_handle_load(pHandle, &pApiDef);
+    BAIL_ON_ERROR(dwError);
+
+    pOldApiDef = __atomic_exchange_n(&pHandle->pApiDef,
+                                     pApiDef,
+                                     __ATOMIC_SEQ_CST);
+    pApiDef = NULL;
+
+    coapi_api_handle_synchronize(pHandle);
+    coapi_free_api_def(pOldApiDef);
+
+cleanup:
+    if(nLocked)
+    {
+        pthread_mutex_unlock(&pHandle->mutexReload);
+    }
+    return dwError;
+
+error:
+    if(pHandle)
+    {
+        fprintf(stderr,
+                "reload of %s failed: %u. keeping the loaded api def\n",
+                pHandle->pszFile,
+                dwError);
+    }
+    goto cleanup;
+}
+
+//true if the inotify events read into pBuffer name the spec file
+int
+coapi_api_handle_is_spec_event(
+    PCOAPI_API_HANDLE pHandle,
+    const char *pBuffer,
+    ssize_t nLength
+    )
+{
+    const char *pCur = pBuffer;
+
+    while(pCur < pBuffer + nLength)
+    {
+        const struct inotify_event *pEvent =
+            (const struct inotify_event *)pCur;
+
+        if(pEvent->len && !strcmp(pEvent->name, pHandle->pszName))
+        {
+            return 1;
+        }
+        pCur += sizeof(struct inotify_event) + pEvent->len;
+    }
+    return 0;
+}
+
+void *
+coapi_api_handle_watch(
+    void *pArg
+    )
+{
+    PCOAPI_API_HANDLE pHandle = pArg;
+    char pBuffer[COAPI_RELOAD_EVENT_BUFFER]
+        __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd pFds[2];
+    int nChanged = 0;
+
+    if(!pHandle)
+    {
+        return NULL;
+    }
+
+    pFds[0].fd = pHandle->nInotifyFd;
+    pFds[0].events = POLLIN;
+    pFds[1].fd = pHandle->pnStopPipe[0];
+    pFds[1].events = POLLIN;
+
+    for(;;)
+    {
+        //once a change is seen, wait for writes to settle before loading
+        int nReady = poll(pFds, 2, nChanged ? COAPI_RELOAD_SETTLE_MS : -1);
+
+        if(nReady < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        if(pFds[1].revents)
+        {
+            break;
+        }
+
+        if(!nReady)
+        {
+            nChanged = 0;
+            coapi_api_handle_reload(pHandle);
+            continue;
+        }
+
+        if(pFds[0].revents & POLLIN)
+        {
+            ssize_t nLength = 0;
+
+            while((nLength = read(pHandle->nInotifyFd,
+                                  pBuffer,
+                                  sizeof(pBuffer))) > 0)
+            {
+                if(coapi_api_handle_is_spec_event(pHandle, pBuffer, nLength))
+                {
+                    nChanged = 1;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+//stops the watcher and frees the current def. there must be no readers
+//left.
+void
+coapi_api_handle_close(
+    PCOAPI_API_HANDLE pHandle
+    )
+{
+    if(!pHandle)
+    {
+        return;
+    }
+
+    if(pHandle->nWatcherStarted)
+    {
+        if(write(pHandle->pnStopPipe[1], "x", 1) != 1)
+        {
+            fprintf(stderr, "could not signal the spec watcher\n");
+        }
+        pthread_join(pHandle->nWatcher, NULL);
+    }
+    if(pHandle->pnStopPipe[0] >= 0)
+    {
+        close(pHandle->pnStopPipe[0]);
+    }
+    if(pHandle->pnStopPipe[1] >= 0)
+    {
+        close(pHandle->pnStopPipe[1]);
+    }
+    if(pHandle->nInotifyFd >= 0)
+    {
+        close(pHandle->nInotifyFd);
+    }
+    if(pHandle->nMutexInit)
+    {
+        pthread_mutex_destroy(&pHandle->mutexReload);
+    }
+    coapi_free_api_def(pHandle->pApiDef);
+    SAFE_FREE_MEMORY(pHandle->pszFile);
+    SAFE_FREE_MEMORY(pHandle->pszDir);
+    SAFE_FREE_MEMORY(pHandle->pszModule);
+    SAFE_FREE_MEMORY(pHandle);
+}
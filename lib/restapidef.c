@@ -14,487 +14,2099 @@
 
 #include "includes.h"
 
+//reads the spec in one pass over the root object, see coapi_load_spec.
+//with COAPI_LOAD_BORROW_STRINGS, pszText is a private writable mapping
+//from coapi_file_map. strings are decoded in place and the def keeps
+//the mapping, which is unmapped with the def or here on error.
+//COAPI_LOAD_LAZY_METHODS keeps the mapping the same way so that method
+//details can be read later. pOptions can be NULL. the load stops with
+//ECANCELED between paths once *pnCancel is set. pnCancel can be NULL.
+uint32_t
+coapi_load_api_def(
+    const char *pszText,
+    size_t nLength,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    const int *pnCancel,
+    PREST_API_DEF *ppApiDef
+    )
+{
+    uint32_t dwError = 0;
+    uint32_t dwFlags = pOptions ? pOptions->dwFlags : 0;
+    COAPI_LOADER stLoader = {{0}};
+    COAPI_SPEC stSpec = {0};
+    PREST_API_DEF pApiDef = NULL;
+
+    if(!pszText || !nLength || !ppApiDef)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_loader_begin_def(&stLoader, dwFlags, pnCancel, &pApiDef);
+    BAIL_ON_ERROR(dwError);
+
+    if(dwFlags & COAPI_LOAD_KEEP_SOURCE)
+    {
+        pApiDef->pSource = (void *)pszText;
+        pApiDef->nSourceSize = nLength;
+    }
+
+    dwError = coapi_load_spec(&stLoader, pszText, nLength, pOptions, &stSpec);
+    BAIL_ON_ERROR(dwError);
+
+    pApiDef->pszHost = stSpec.pszHost;
+    pApiDef->pszBasePath = stSpec.pszBasePath;
+    pApiDef->nHasSecureScheme = stSpec.nHasSecureScheme;
+    pApiDef->nNoModules = stSpec.nNoModules;
+    pApiDef->pModules = stSpec.pModules;
+
+    if(pApiDef->pSource)
+    {
+        pApiDef->pszRefParameters = stLoader.pszRefParameters;
+        pApiDef->pszRefDefinitions = stLoader.pszRefDefinitions;
+    }
+
+    dwError = coapi_loader_end_def(&stLoader);
+    BAIL_ON_ERROR(dwError);
+
+    *ppApiDef = pApiDef;
+
+cleanup:
+    coapi_free_loader(&stLoader);
+    return dwError;
+
+error:
+    if(ppApiDef)
+    {
+        *ppApiDef = NULL;
+    }
+    if(pApiDef)
+    {
+        coapi_free_api_def(pApiDef);
+    }
+    else if(pszText && (dwFlags & COAPI_LOAD_KEEP_SOURCE))
+    {
+        coapi_file_unmap((void *)pszText, nLength);
+    }
+    goto cleanup;
+}
+
+//creates the arena and an empty def for a load
+uint32_t
+coapi_loader_begin_def(
+    PCOAPI_LOADER pLoader,
+    uint32_t dwFlags,
+    const int *pnCancel,
+    PREST_API_DEF *ppApiDef
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_DEF pApiDef = NULL;
+
+    if(!pLoader || !ppApiDef)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_arena_create(&pLoader->pArena);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_arena_allocate(pLoader->pArena,
+                                   sizeof(REST_API_DEF),
+                                   (void **)&pApiDef);
+    BAIL_ON_ERROR(dwError);
+
+    pApiDef->pArena = pLoader->pArena;
+    pApiDef->dwLoadFlags = dwFlags;
+
+    pLoader->pApiDef = pApiDef;
+    pLoader->dwFlags = dwFlags;
+    pLoader->pnCancel = pnCancel;
+
+    *ppApiDef = pApiDef;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppApiDef)
+    {
+        *ppApiDef = NULL;
+    }
+    if(pLoader)
+    {
+        coapi_arena_free(pLoader->pArena);
+        pLoader->pArena = NULL;
+    }
+    goto cleanup;
+}
+
+//reads one spec into the def of pLoader. paths are read last, after
+//host, basePath and tags are known, from the offset recorded when the
+//paths key was seen. subtrees the api def does not use (definitions,
+//responses, examples..) are skipped without being decoded. host,
+//basePath, schemes and modules go to pSpec and the endpoints to the
+//modules. strings and params already loaded from other specs are
+//shared, $refs are resolved within this spec.
+uint32_t
+coapi_load_spec(
+    PCOAPI_LOADER pLoader,
+    const char *pszText,
+    size_t nLength,
+    PCOAPI_LOAD_OPTIONS pOptions,
+    PCOAPI_SPEC pSpec
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_JSON_READER pReader = NULL;
+    const char *pszKey = NULL;
+    const char *pszPaths = NULL;
+    PREST_API_MODULE pModule = NULL;
+    int nHasSchemes = 0;
+    int nHasTags = 0;
+    COAPI_LOAD_PHASE stMark = {0};
+    COAPI_LOAD_PHASE stModulesMark = {0};
+
+    if(!pLoader || !pszText || !nLength || !pSpec)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pReader = &pLoader->stReader;
+    coapi_json_reader_free(pReader);
+    coapi_json_reader_init(pReader, pszText, nLength);
+    pReader->pScanner = coapi_json_get_scanner(pLoader->dwFlags);
+    if(pLoader->dwFlags & COAPI_LOAD_BORROW_STRINGS)
+    {
+        pReader->nInSitu = 1;
+    }
+
+    //$refs name objects of the spec they are in
+    coapi_string_table_free(&pLoader->stRefs);
+    pLoader->pszRefParameters = NULL;
+    pLoader->pszRefDefinitions = NULL;
+    pLoader->nFilterModule = 0;
+    pLoader->pFilterModule = NULL;
+    pLoader->pDefaultModule = NULL;
+
+    coapi_load_phase_begin(pLoader, &stMark);
+
+    dwError = coapi_json_begin_object(pReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_key(pReader, &pszKey)))
+    {
+        if(!strcmp(pszKey, "host"))
+        {
+            dwError = coapi_json_get_string_value(
+                          pReader,
+                          pLoader->pArena,
+                          &pSpec->pszHost);
+        }
+        else if(!strcmp(pszKey, "basePath"))
+        {
+            dwError = coapi_json_get_string_value(
+                          pReader,
+                          pLoader->pArena,
+                          &pSpec->pszBasePath);
+        }
+        else if(!strcmp(pszKey, "schemes"))
+        {
+            nHasSchemes = 1;
+            dwError = coapi_load_secure_scheme(
+                          pLoader,
+                          &pSpec->nHasSecureScheme);
+        }
+        else if(!strcmp(pszKey, "tags"))
+        {
+            nHasTags = 1;
+            pSpec->pModules = NULL;
+            coapi_load_phase_begin(pLoader, &stModulesMark);
+            dwError = coapi_load_modules(pLoader, &pSpec->pModules);
+            coapi_load_phase_end(pLoader,
+                                 &stModulesMark,
+                                 &pLoader->stStats.stModules);
+        }
+        else if(!strcmp(pszKey, "paths"))
+        {
+            coapi_json_skip_space(pReader);
+            pszPaths = pReader->pszCur;
+            dwError = coapi_json_skip_value(pReader);
+        }
+        //shared objects are read when a $ref names them
+        else if(!strcmp(pszKey, "parameters"))
+        {
+            coapi_json_skip_space(pReader);
+            pLoader->pszRefParameters = pReader->pszCur;
+            dwError = coapi_json_skip_value(pReader);
+        }
+        else if(!strcmp(pszKey, "definitions"))
+        {
+            coapi_json_skip_space(pReader);
+            pLoader->pszRefDefinitions = pReader->pszCur;
+            dwError = coapi_json_skip_value(pReader);
+        }
+        else
+        {
+            dwError = coapi_json_skip_value(pReader);
+        }
+        BAIL_ON_ERROR(dwError);
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_end(pReader);
+    BAIL_ON_ERROR(dwError);
+
+    //default to https if not specified
+    if(!nHasSchemes)
+    {
+        pSpec->nHasSecureScheme = 1;
+    }
+
+    if(!pSpec->pszHost || !pSpec->pszBasePath)
+    {
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!nHasTags)
+    {
+        coapi_load_phase_begin(pLoader, &stModulesMark);
+        dwError = coapi_add_default_module(
+                      pLoader->pArena,
+                      pSpec->pszBasePath,
+                      &pSpec->pModules);
+        BAIL_ON_ERROR(dwError);
+        coapi_load_phase_end(pLoader,
+                             &stModulesMark,
+                             &pLoader->stStats.stModules);
+
+        pSpec->nNoModules = 1;
+    }
+
+    if(!pszPaths)
+    {
+        fprintf(stderr, "paths not found in api def\n");
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //an unknown module filter leaves every endpoint out
+    if(pOptions && pOptions->pszModule)
+    {
+        pLoader->nFilterModule = 1;
+        dwError = coapi_find_module_by_name(pOptions->pszModule,
+                                            pSpec->pModules,
+                                            &pLoader->pFilterModule);
+        if(dwError == ENODATA)
+        {
+            dwError = 0;
+        }
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //modules are kept in spec order but endpoints without a known tag
+    //still go to the last listed one, as they always have
+    for(pModule = pSpec->pModules; pModule; pModule = pModule->pNext)
+    {
+        pLoader->pDefaultModule = pModule;
+    }
+
+    coapi_load_phase_end(pLoader, &stMark, &pLoader->stStats.stRoot);
+
+    pReader->pszCur = pszPaths;
+    coapi_load_phase_begin(pLoader, &stMark);
+    if(pLoader->dwFlags & COAPI_LOAD_PARALLEL)
+    {
+        dwError = coapi_load_endpoints_parallel(
+                      pLoader,
+                      pSpec->pszBasePath,
+                      pSpec->pModules,
+                      pOptions->dwThreads);
+    }
+    else
+    {
+        dwError = coapi_load_endpoints(
+                      pLoader,
+                      pSpec->pszBasePath,
+                      pSpec->pModules);
+    }
+    BAIL_ON_ERROR(dwError);
+    coapi_load_phase_end(pLoader, &stMark, &pLoader->stStats.stEndPoints);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//builds the index of a def whose specs are all loaded and fills in
+//its stats
+uint32_t
+coapi_loader_end_def(
+    PCOAPI_LOADER pLoader
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_DEF pApiDef = NULL;
+    COAPI_LOAD_PHASE stMark = {0};
+
+    if(!pLoader || !pLoader->pApiDef)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pApiDef = pLoader->pApiDef;
+
+    coapi_load_phase_begin(pLoader, &stMark);
+    dwError = coapi_build_api_table(pApiDef);
+    BAIL_ON_ERROR(dwError);
+    coapi_load_phase_end(pLoader, &stMark, &pLoader->stStats.stIndex);
+
+    dwError = coapi_count_api_def(pApiDef, &pLoader->stStats);
+    BAIL_ON_ERROR(dwError);
+
+    pApiDef->stStats = pLoader->stStats;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//frees what a loader holds for the duration of a load. the arena
+//belongs to the def and is left alone.
+void
+coapi_free_loader(
+    PCOAPI_LOADER pLoader
+    )
+{
+    if(!pLoader)
+    {
+        return;
+    }
+    SAFE_FREE_MEMORY(pLoader->pszScratch);
+    coapi_string_table_free(&pLoader->stStrings);
+    coapi_string_table_free(&pLoader->stBlocks);
+    coapi_string_table_free(&pLoader->stRefs);
+    coapi_pointer_map_free(&pLoader->stTails);
+    coapi_arena_free(pLoader->pTempArena);
+    pLoader->pTempArena = NULL;
+    coapi_json_reader_free(&pLoader->stReader);
+}
+
+//names and values that repeat across a spec (parameter names and
+//locations, enum options, tags) are stored once per definition.
+uint32_t
+coapi_load_interned_string(
+    PCOAPI_LOADER pLoader,
+    char **ppszValue
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszValue = NULL;
+
+    if(!pLoader || !ppszValue)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_get_string(&pLoader->stReader, &pszValue);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_string_table_intern(&pLoader->stStrings,
+                                        pLoader->pArena,
+                                        pszValue,
+                                        pLoader->stReader.nLength,
+                                        pLoader->stReader.nInSitu,
+                                        ppszValue);
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszValue)
+    {
+        *ppszValue = NULL;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_load_module(
+    PCOAPI_LOADER pLoader,
+    PREST_API_MODULE *ppApiModule
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszKey = NULL;
+    PREST_API_MODULE pApiModule = NULL;
+
+    if(!pLoader || !ppApiModule)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_arena_allocate(pLoader->pArena,
+                                   sizeof(REST_API_MODULE),
+                                   (void **)&pApiModule);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_begin_object(&pLoader->stReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_key(&pLoader->stReader, &pszKey)))
+    {
+        if(!strcmp(pszKey, "name"))
+        {
+            dwError = coapi_load_interned_string(
+                          pLoader,
+                          &pApiModule->pszName);
+        }
+        else if(!strcmp(pszKey, "description") &&
+                !(pLoader->dwFlags & COAPI_LOAD_NO_DOCS))
+        {
+            dwError = coapi_json_get_string_value(
+                          &pLoader->stReader,
+                          pLoader->pArena,
+                          &pApiModule->pszDescription);
+        }
+        else
+        {
+            dwError = coapi_json_skip_value(&pLoader->stReader);
+        }
+        BAIL_ON_ERROR(dwError);
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    if(!pApiModule->pszName)
+    {
+        fprintf(stderr, "name not found for tag in api def\n");
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppApiModule = pApiModule;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppApiModule)
+    {
+        *ppApiModule = NULL;
+    }
+    goto cleanup;
+}
+
 uint32_t
 coapi_load_modules(
-    json_t *pRoot,
+    PCOAPI_LOADER pLoader,
     PREST_API_MODULE *ppApiModules
     )
 {
     uint32_t dwError = 0;
-    json_t *pTags = NULL;
-    json_t *pTag = NULL;
-    int i = 0;
-    PREST_API_MODULE pApiModules = NULL;
-    PREST_API_MODULE pApiModule = NULL;
+    PREST_API_MODULE pApiModules = NULL;
+    PREST_API_MODULE *ppTail = &pApiModules;
+    PREST_API_MODULE pApiModule = NULL;
+
+    if(!pLoader || !ppApiModules)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_begin_array(&pLoader->stReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_element(&pLoader->stReader)))
+    {
+        dwError = coapi_load_module(pLoader, &pApiModule);
+        BAIL_ON_ERROR(dwError);
+
+        *ppTail = pApiModule;
+        ppTail = &pApiModule->pNext;
+        pApiModule = NULL;
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    *ppApiModules = pApiModules;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppApiModules)
+    {
+        *ppApiModules = NULL;
+    }
+    goto cleanup;
+}
+
+//without path params the name is pszActualName itself
+uint32_t
+coapi_replace_endpoint_path(
+    PCOAPI_ARENA pArena,
+    char *pszActualName,
+    PREST_API_PARAM pApiParams,
+    char **ppszName
+    )
+{
+    uint32_t dwError = 0;
+    char *pszName = NULL;
+    char *pszNameTemp = NULL;
+    char *pszPath = NULL;
+    PREST_API_PARAM pApiParam = NULL;
+
+    if(!pArena || IsNullOrEmptyString(pszActualName) || !ppszName)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    for(pApiParam = pApiParams; pApiParam; pApiParam = pApiParam->pNext)
+    {
+        if(pApiParam->nIn != RESTPARAMIN_PATH)
+        {
+            continue;
+        }
+
+        dwError = coapi_allocate_string_printf(
+                      &pszPath,
+                      "{%s}",
+                      pApiParam->pszName);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = string_replace(
+                      pszActualName,
+                      pszPath,
+                      "*",
+                      &pszNameTemp);
+        if(dwError == ENOENT)
+        {
+            fprintf(stderr,
+                    "path '%s' specified with bad path string: %s\n",
+                    pApiParam->pszName,
+                    pszActualName);
+        }
+        BAIL_ON_ERROR(dwError);
+
+        SAFE_FREE_MEMORY(pszName);
+        pszName = pszNameTemp;
+        pszNameTemp = NULL;
+
+        SAFE_FREE_MEMORY(pszPath);
+        pszPath = NULL;
+    }
+
+    if(pszName)
+    {
+        dwError = coapi_arena_allocate_string(pArena, pszName, ppszName);
+        BAIL_ON_ERROR(dwError);
+    }
+    else
+    {
+        *ppszName = pszActualName;
+    }
+
+cleanup:
+    SAFE_FREE_MEMORY(pszName);
+    SAFE_FREE_MEMORY(pszNameTemp);
+    SAFE_FREE_MEMORY(pszPath);
+    return dwError;
+
+error:
+    if(ppszName)
+    {
+        *ppszName = NULL;
+    }
+    goto cleanup;
+}
+
+//keeps the first tag and the number of tags of a method
+uint32_t
+coapi_load_method_tags(
+    PCOAPI_LOADER pLoader,
+    char **ppszTag,
+    int *pnTagCount
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_JSON_TYPE nType = JSON_TYPE_NONE;
+    char *pszTag = NULL;
+    int nTagCount = 0;
+
+    if(!pLoader || !ppszTag || !pnTagCount)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_peek(&pLoader->stReader, &nType);
+    BAIL_ON_ERROR(dwError);
+
+    if(nType != JSON_TYPE_ARRAY)
+    {
+        fprintf(stderr, "tags is not a json array\n");
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_begin_array(&pLoader->stReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_element(&pLoader->stReader)))
+    {
+        if(!nTagCount)
+        {
+            dwError = coapi_load_interned_string(pLoader, &pszTag);
+        }
+        else
+        {
+            dwError = coapi_json_skip_value(&pLoader->stReader);
+        }
+        BAIL_ON_ERROR(dwError);
+        ++nTagCount;
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    *ppszTag = pszTag;
+    *pnTagCount = nTagCount;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszTag)
+    {
+        *ppszTag = NULL;
+    }
+    if(pnTagCount)
+    {
+        *pnTagCount = 0;
+    }
+    goto cleanup;
+}
+
+//*pnTagCount is -1 if the method has no tags.
+//a lazy method keeps where its object starts and reads only the tags.
+uint32_t
+coapi_load_method(
+    PCOAPI_LOADER pLoader,
+    const char *pszMethod,
+    RESTMETHOD nMethod,
+    int nLazy,
+    PREST_API_METHOD *ppMethod,
+    char **ppszTag,
+    int *pnTagCount
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_METHOD pMethod = NULL;
+    char *pszTag = NULL;
+    int nTagCount = -1;
+    int nInSitu = 0;
+
+    if(!pLoader || !pszMethod || !ppMethod || !ppszTag || !pnTagCount)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nInSitu = pLoader->stReader.nInSitu;
+
+    dwError = coapi_arena_allocate(pLoader->pArena,
+                                   sizeof(REST_API_METHOD),
+                                   (void **)&pMethod);
+    BAIL_ON_ERROR(dwError);
+
+    //method names are shared. keys decoded in place are part of the
+    //mapped spec and are kept as is.
+    dwError = coapi_string_table_intern(&pLoader->stStrings,
+                                        pLoader->pArena,
+                                        pszMethod,
+                                        strlen(pszMethod),
+                                        nInSitu,
+                                        &pMethod->pszMethod);
+    BAIL_ON_ERROR(dwError);
+
+    pMethod->nMethod = nMethod;
+
+    if(nLazy)
+    {
+        //the object is read again later, so nothing in it is decoded
+        //in place now
+        coapi_json_skip_space(&pLoader->stReader);
+        pMethod->pszDetails = pLoader->stReader.pszCur;
+        pLoader->stReader.nInSitu = 0;
+    }
+
+    dwError = coapi_load_method_fields(pLoader,
+                                       pMethod,
+                                       nLazy,
+                                       &pszTag,
+                                       &nTagCount);
+    BAIL_ON_ERROR(dwError);
+
+    *ppMethod = pMethod;
+    *ppszTag = pszTag;
+    *pnTagCount = nTagCount;
+
+cleanup:
+    if(pLoader)
+    {
+        pLoader->stReader.nInSitu = nInSitu;
+    }
+    return dwError;
+
+error:
+    if(ppMethod)
+    {
+        *ppMethod = NULL;
+    }
+    if(ppszTag)
+    {
+        *ppszTag = NULL;
+    }
+    goto cleanup;
+}
+
+//reads one method object. nSkipDetails leaves out summary, description
+//and params. tags are skipped if ppszTag is NULL.
+uint32_t
+coapi_load_method_fields(
+    PCOAPI_LOADER pLoader,
+    PREST_API_METHOD pMethod,
+    int nSkipDetails,
+    char **ppszTag,
+    int *pnTagCount
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszKey = NULL;
+    COAPI_JSON_TYPE nType = JSON_TYPE_NONE;
+
+    if(!pLoader || !pMethod || (ppszTag && !pnTagCount))
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_json_begin_object(&pLoader->stReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_key(&pLoader->stReader, &pszKey)))
+    {
+        if(!strcmp(pszKey, "tags") && ppszTag)
+        {
+            dwError = coapi_load_method_tags(pLoader, ppszTag, pnTagCount);
+        }
+        else if(nSkipDetails)
+        {
+            dwError = coapi_json_skip_value(&pLoader->stReader);
+        }
+        else if((pLoader->dwFlags & COAPI_LOAD_NO_DOCS) &&
+                (!strcmp(pszKey, "summary") || !strcmp(pszKey, "description")))
+        {
+            dwError = coapi_json_skip_value(&pLoader->stReader);
+        }
+        else if(!strcmp(pszKey, "summary"))
+        {
+            dwError = coapi_json_get_string_value(
+                          &pLoader->stReader,
+                          pLoader->pArena,
+                          &pMethod->pszSummary);
+        }
+        else if(!strcmp(pszKey, "description"))
+        {
+            dwError = coapi_json_get_string_value(
+                          &pLoader->stReader,
+                          pLoader->pArena,
+                          &pMethod->pszDescription);
+        }
+        else if(!strcmp(pszKey, "parameters"))
+        {
+            pMethod->pParams = NULL;
+
+            dwError = coapi_json_peek(&pLoader->stReader, &nType);
+            BAIL_ON_ERROR(dwError);
+
+            if(nType == JSON_TYPE_ARRAY)
+            {
+                dwError = coapi_load_parameters(pLoader, &pMethod->pParams);
+            }
+            else
+            {
+                dwError = coapi_json_skip_value(&pLoader->stReader);
+            }
+        }
+        else
+        {
+            dwError = coapi_json_skip_value(&pLoader->stReader);
+        }
+        BAIL_ON_ERROR(dwError);
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//the lock of the table keeps readers of a lazily loaded def from
+//reading a method twice at once
+uint32_t
+coapi_load_method_details(
+    PREST_API_DEF pApiDef,
+    PREST_API_METHOD pMethod
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_LOADER stLoader = {{0}};
+    REST_API_METHOD stMethod = {0};
+    PCOAPI_API_TABLE pTable = NULL;
+    const char *pszEnd = NULL;
+    size_t nFailed = 0;
+    int nLocked = 0;
+
+    if(!pApiDef || !pMethod)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pTable = pApiDef->pTable;
+    if(pTable && !pTable->nHasParams)
+    {
+        pthread_mutex_lock(&pTable->mutexDetails);
+        nLocked = 1;
+    }
+
+    if(!pMethod->pszDetails)
+    {
+        goto cleanup;
+    }
+
+    if(nLocked &&
+       !coapi_pointer_map_get(&pTable->stFailedDetails, pMethod, &nFailed))
+    {
+        dwError = nFailed;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!pApiDef->pSource)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pszEnd = (const char *)pApiDef->pSource + pApiDef->nSourceSize;
+    if(pMethod->pszDetails < (const char *)pApiDef->pSource ||
+       pMethod->pszDetails >= pszEnd)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //the reader spans the spec so that $ref targets are in reach
+    coapi_json_reader_init(&stLoader.stReader,
+                           pApiDef->pSource,
+                           pApiDef->nSourceSize);
+    stLoader.stReader.pszCur = pMethod->pszDetails;
+    stLoader.stReader.pScanner =
+        coapi_json_get_scanner(pApiDef->dwLoadFlags);
+    stLoader.stReader.nInSitu =
+        (pApiDef->dwLoadFlags & COAPI_LOAD_BORROW_STRINGS) ? 1 : 0;
+    stLoader.pApiDef = pApiDef;
+    stLoader.pArena = pApiDef->pArena;
+    stLoader.dwFlags = pApiDef->dwLoadFlags;
+    stLoader.pszRefParameters = pApiDef->pszRefParameters;
+    stLoader.pszRefDefinitions = pApiDef->pszRefDefinitions;
+
+    //fields are set only once the whole object is read
+    dwError = coapi_load_method_fields(&stLoader, &stMethod, 0, NULL, NULL);
+    BAIL_ON_ERROR(dwError);
+
+    //until now the params were only the path level ones
+    dwError = coapi_add_path_params(&stLoader,
+                                    pMethod->pParams,
+                                    &stMethod.pParams);
+    BAIL_ON_ERROR(dwError);
+
+    pMethod->pszSummary = stMethod.pszSummary;
+    pMethod->pszDescription = stMethod.pszDescription;
+    pMethod->pParams = stMethod.pParams;
+    pMethod->pszDetails = NULL;
+
+cleanup:
+    coapi_free_loader(&stLoader);
+    if(nLocked)
+    {
+        pthread_mutex_unlock(&pTable->mutexDetails);
+    }
+    return dwError;
+
+error:
+    //strings read so far were decoded in place, so the text cannot be
+    //read again. later calls get the same error.
+    if(nLocked && stLoader.stReader.nInSitu && !nFailed)
+    {
+        coapi_pointer_map_set(&pTable->stFailedDetails, pMethod, dwError);
+    }
+    goto cleanup;
+}
+
+//copy on write for param lists. the copy is in the def arena, which a
+//def mapped from an image gets on first use. a def put together by the
+//caller has neither, its params are freed node by node and are the
+//caller's to copy.
+uint32_t
+coapi_unshare_method_params(
+    PREST_API_DEF pApiDef,
+    PREST_API_METHOD pMethod
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_PARAM pParam = NULL;
+    PREST_API_PARAM pCopy = NULL;
+    PREST_API_PARAM pCopies = NULL;
+    PREST_API_PARAM *ppTail = &pCopies;
+    int nLocked = 0;
+
+    if(!pApiDef || !pMethod || (!pApiDef->pArena && !pApiDef->pImage))
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_load_method_details(pApiDef, pMethod);
+    BAIL_ON_ERROR(dwError);
+
+    //details of other methods can be read from the arena meanwhile
+    if(pApiDef->pTable)
+    {
+        pthread_mutex_lock(&pApiDef->pTable->mutexDetails);
+        nLocked = 1;
+    }
+
+    if(!pApiDef->pArena)
+    {
+        dwError = coapi_arena_create(&pApiDef->pArena);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    for(pParam = pMethod->pParams; pParam; pParam = pParam->pNext)
+    {
+        dwError = coapi_arena_allocate(pApiDef->pArena,
+                                       sizeof(REST_API_PARAM),
+                                       (void **)&pCopy);
+        BAIL_ON_ERROR(dwError);
+
+        *pCopy = *pParam;
+        if(pParam->nOptionCount > 0 && pParam->ppszOptions)
+        {
+            dwError = coapi_arena_allocate(
+                          pApiDef->pArena,
+                          sizeof(char *) * pParam->nOptionCount,
+                          (void **)&pCopy->ppszOptions);
+            BAIL_ON_ERROR(dwError);
+
+            memcpy(pCopy->ppszOptions,
+                   pParam->ppszOptions,
+                   sizeof(char *) * pParam->nOptionCount);
+        }
+        pCopy->pNext = NULL;
+
+        *ppTail = pCopy;
+        ppTail = &pCopy->pNext;
+    }
+
+    pMethod->pParams = pCopies;
+
+    if(pApiDef->pTable)
+    {
+        dwError = coapi_table_update_params(pApiDef->pTable, pMethod);
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    if(nLocked)
+    {
+        pthread_mutex_unlock(&pApiDef->pTable->mutexDetails);
+    }
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_load_endpoint(
+    PCOAPI_LOADER pLoader,
+    const char *pszPath,
+    const char *pszBasePath,
+    PREST_API_MODULE pApiModules,
+    PREST_API_ENDPOINT *ppEndPoint,
+    PREST_API_MODULE *ppModule
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszMethod = NULL;
+    const char *pszCmdStart = NULL;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    PREST_API_METHOD pRestMethod = NULL;
+    PREST_API_METHOD pFirstMethod = NULL;
+    PREST_API_MODULE pModule = NULL;
+    char *pszTag = NULL;
+    int nTagCount = 0;
+    int i = 0;
+    int nProfile = 0;
+    COAPI_LOAD_PHASE stMark = {0};
+
+    if(!pLoader || !pszPath || !pszBasePath || !pApiModules ||
+       !ppEndPoint || !ppModule)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nProfile = (pLoader->dwFlags & COAPI_LOAD_PROFILE) != 0;
+
+    dwError = coapi_arena_allocate(pLoader->pArena,
+                                   sizeof(REST_API_ENDPOINT),
+                                   (void **)&pEndPoint);
+    BAIL_ON_ERROR(dwError);
+
+    pszCmdStart = strrchr(pszPath, URL_SEPARATOR);
+    pszCmdStart = pszCmdStart ? pszCmdStart + 1 : pszPath;
+
+    if(pLoader->stReader.nInSitu)
+    {
+        pEndPoint->pszCommandName = (char *)pszCmdStart;
+    }
+    else
+    {
+        dwError = coapi_arena_allocate_string(pLoader->pArena,
+                                              pszCmdStart,
+                                              &pEndPoint->pszCommandName);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_arena_allocate_string_printf(pLoader->pArena,
+                                                 &pEndPoint->pszActualName,
+                                                 "%s%s",
+                                                 pszBasePath,
+                                                 pszPath);
+    BAIL_ON_ERROR(dwError);
+
+    //unless decoded in place, pszPath is in the reader buffer and is
+    //not valid past this point
+    dwError = coapi_json_begin_object(&pLoader->stReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_key(&pLoader->stReader, &pszMethod)))
+    {
+        RESTMETHOD nMethod = METHOD_INVALID;
+
+        if(!strcmp(pszMethod, "parameters"))
+        {
+            pEndPoint->pParams = NULL;
+            dwError = coapi_load_parameters(pLoader, &pEndPoint->pParams);
+            BAIL_ON_ERROR(dwError);
+            continue;
+        }
+
+        dwError = coapi_get_rest_method(pszMethod, &nMethod);
+        BAIL_ON_ERROR(dwError);
+
+        if(pEndPoint->pMethods[nMethod])
+        {
+            printf("error entry already exists\n");
+            dwError = EEXIST;
+            BAIL_ON_ERROR(dwError);
+        }
+
+        //the first method names the endpoint from its path params, so
+        //it is always read in full
+        dwError = coapi_load_method(pLoader,
+                                    pszMethod,
+                                    nMethod,
+                                    (pLoader->dwFlags &
+                                     COAPI_LOAD_LAZY_METHODS) &&
+                                    pFirstMethod,
+                                    &pRestMethod,
+                                    &pszTag,
+                                    &nTagCount);
+        BAIL_ON_ERROR(dwError);
+
+        if(!pFirstMethod)
+        {
+            pFirstMethod = pRestMethod;
+        }
+
+        pEndPoint->pMethods[nMethod] = pRestMethod;
+        pRestMethod = NULL;
+
+        if(!pModule)
+        {
+            //find the module tagged
+            dwError = coapi_find_tagged_module(pszTag,
+                                               nTagCount,
+                                               pApiModules,
+                                               &pModule);
+            if(dwError == ENODATA)
+            {
+                pModule = pLoader->pDefaultModule;
+                dwError = 0;
+            }
+            BAIL_ON_ERROR(dwError);
+        }
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    //path level params can follow the methods in the path object
+    dwError = coapi_share_params(pLoader,
+                                 pEndPoint->pParams,
+                                 NULL,
+                                 NULL,
+                                 &pEndPoint->pParams);
+    BAIL_ON_ERROR(dwError);
+
+    for(i = 0; i < METHOD_COUNT; ++i)
+    {
+        if(!pEndPoint->pMethods[i])
+        {
+            continue;
+        }
+        dwError = coapi_add_path_params(pLoader,
+                                        pEndPoint->pParams,
+                                        &pEndPoint->pMethods[i]->pParams);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pFirstMethod)
+    {
+        if(nProfile)
+        {
+            coapi_load_phase_begin(pLoader, &stMark);
+        }
+        dwError = coapi_replace_endpoint_path(
+                      pLoader->pArena,
+                      pEndPoint->pszActualName,
+                      pFirstMethod->pParams,
+                      &pEndPoint->pszName);
+        BAIL_ON_ERROR(dwError);
+        if(nProfile)
+        {
+            coapi_load_phase_end(pLoader,
+                                 &stMark,
+                                 &pLoader->stStats.stPathNames);
+        }
+
+        pEndPoint->nHasPathSubs = strcmp(pEndPoint->pszActualName,
+                                         pEndPoint->pszName) != 0;
+    }
+
+    *ppEndPoint = pEndPoint;
+    *ppModule = pModule;
+
+cleanup:
+    //params as read are all shared or dropped by now
+    if(pLoader && pLoader->pTempArena)
+    {
+        pLoader->nTempAllocations += pLoader->pTempArena->nAllocations;
+        pLoader->nTempAllocatedBytes +=
+            pLoader->pTempArena->nAllocatedBytes;
+        coapi_arena_free(pLoader->pTempArena);
+        pLoader->pTempArena = NULL;
+    }
+    return dwError;
+
+error:
+    if(ppEndPoint)
+    {
+        *ppEndPoint = NULL;
+    }
+    if(ppModule)
+    {
+        *ppModule = NULL;
+    }
+    goto cleanup;
+}
+
+//finds the module an endpoint would be added to without reading it.
+//this is the first tag of the first method, same as coapi_load_endpoint.
+//*ppModule is NULL if that cannot be told here, in which case the
+//endpoint is loaded and reports its own errors. the reader is left at
+//the start of the path object.
+uint32_t
+coapi_peek_endpoint_module(
+    PCOAPI_LOADER pLoader,
+    PREST_API_MODULE pApiModules,
+    PREST_API_MODULE *ppModule
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_JSON_READER pReader = NULL;
+    COAPI_JSON_READER stSaved = {0};
+    COAPI_JSON_TYPE nType = JSON_TYPE_NONE;
+    RESTMETHOD nMethod = METHOD_INVALID;
+    PREST_API_MODULE pModule = NULL;
+    const char *pszKey = NULL;
+    const char *pszTag = NULL;
+
+    if(!pLoader || !pApiModules || !ppModule)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppModule = NULL;
+
+    //the path key is still in the reader buffer, use the scratch buffer.
+    //nothing is decoded in place so that the object can be read again.
+    pReader = &pLoader->stReader;
+    stSaved = *pReader;
+    pReader->pszBuffer = pLoader->pszScratch;
+    pReader->nBufferSize = pLoader->nScratchSize;
+    pReader->nInSitu = 0;
+
+    dwError = coapi_json_begin_object(pReader);
+    BAIL_ON_ERROR(dwError);
+
+    //path level params do not decide the module
+    while(!(dwError = coapi_json_next_key(pReader, &pszKey)) &&
+          !strcmp(pszKey, "parameters"))
+    {
+        dwError = coapi_json_skip_value(pReader);
+        BAIL_ON_ERROR(dwError);
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+        goto cleanup;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    if(coapi_get_rest_method(pszKey, &nMethod))
+    {
+        goto cleanup;
+    }
+
+    dwError = coapi_json_peek(pReader, &nType);
+    BAIL_ON_ERROR(dwError);
+
+    if(nType != JSON_TYPE_OBJECT)
+    {
+        goto cleanup;
+    }
+
+    dwError = coapi_json_begin_object(pReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_key(pReader, &pszKey)))
+    {
+        if(strcmp(pszKey, "tags"))
+        {
+            dwError = coapi_json_skip_value(pReader);
+            BAIL_ON_ERROR(dwError);
+            continue;
+        }
+
+        dwError = coapi_json_peek(pReader, &nType);
+        BAIL_ON_ERROR(dwError);
+
+        if(nType != JSON_TYPE_ARRAY)
+        {
+            goto cleanup;
+        }
+
+        dwError = coapi_json_begin_array(pReader);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_json_next_element(pReader);
+        if(dwError == ENOENT)
+        {
+            dwError = 0;
+            break;
+        }
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_json_peek(pReader, &nType);
+        BAIL_ON_ERROR(dwError);
+
+        if(nType != JSON_TYPE_STRING)
+        {
+            goto cleanup;
+        }
+
+        dwError = coapi_json_get_string(pReader, &pszTag);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_find_module_by_name(pszTag, pApiModules, &pModule);
+        if(dwError == ENODATA)
+        {
+            dwError = 0;
+        }
+        BAIL_ON_ERROR(dwError);
+        break;
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    //untagged methods and unknown tags go to the last listed module
+    *ppModule = pModule ? pModule : pLoader->pDefaultModule;
+
+cleanup:
+    if(pReader)
+    {
+        pLoader->pszScratch = pReader->pszBuffer;
+        pLoader->nScratchSize = pReader->nBufferSize;
+        *pReader = stSaved;
+    }
+    return dwError;
+
+error:
+    if(ppModule)
+    {
+        *ppModule = NULL;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_load_endpoints(
+    PCOAPI_LOADER pLoader,
+    const char *pszBasePath,
+    PREST_API_MODULE pApiModules
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszKey = NULL;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    PREST_API_MODULE pModule = NULL;
 
-    if(!pRoot || !ppApiModules)
+    if(!pLoader || !pszBasePath || !pApiModules)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    pTags = json_object_get(pRoot, "tags");
-    if(!pTags)
+    dwError = coapi_json_begin_object(&pLoader->stReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_key(&pLoader->stReader, &pszKey)))
     {
-        dwError = ENODATA;
+        dwError = coapi_check_cancel(pLoader->pnCancel);
         BAIL_ON_ERROR(dwError);
-    }
 
-    json_array_foreach(pTags, i, pTag)
-    {
-        json_t *pDescription = NULL;
-        json_t *pName = json_object_get(pTag, "name");
-        if(!pName)
+        if(pLoader->nFilterModule)
         {
-            fprintf(stderr, "name not found for tag in api def\n");
-            dwError = EINVAL;
+            dwError = coapi_peek_endpoint_module(pLoader, pApiModules, &pModule);
             BAIL_ON_ERROR(dwError);
+
+            if(pModule && pModule != pLoader->pFilterModule)
+            {
+                dwError = coapi_json_skip_value(&pLoader->stReader);
+                BAIL_ON_ERROR(dwError);
+                continue;
+            }
         }
 
-        dwError = coapi_allocate_memory(sizeof(REST_API_MODULE),
-                                        (void **)&pApiModule);
+        dwError = coapi_load_endpoint(pLoader,
+                                      pszKey,
+                                      pszBasePath,
+                                      pApiModules,
+                                      &pEndPoint,
+                                      &pModule);
         BAIL_ON_ERROR(dwError);
 
-        dwError = coapi_allocate_string(json_string_value(pName),
-                                    &pApiModule->pszName);
+        dwError = coapi_module_add_endpoint(pLoader, pModule, pEndPoint);
         BAIL_ON_ERROR(dwError);
 
-        dwError = json_safe_get_string_value(
-                      pTag,
-                      "description",
-                      &pApiModule->pszDescription);
+        pEndPoint = NULL;
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_fill_enum(
+    PCOAPI_LOADER pLoader,
+    int *pnOptionCount,
+    char ***pppszOptions
+    )
+{
+    uint32_t dwError = 0;
+    int nOptionCount = 0;
+    int nCapacity = 0;
+    char **ppszOptions = NULL;
+    char **ppszTemp = NULL;
+    char **ppszArenaOptions = NULL;
+
+    if(!pLoader || !pppszOptions || !pnOptionCount)
+    {
+        dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
+    }
 
-        pApiModule->pNext = pApiModules;
-        pApiModules = pApiModule;
-        pApiModule = NULL;
+    dwError = coapi_json_begin_array(&pLoader->stReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_element(&pLoader->stReader)))
+    {
+        if(nOptionCount == nCapacity)
+        {
+            nCapacity = nCapacity ? nCapacity * 2 : 8;
+            dwError = coapi_reallocate_memory(ppszOptions,
+                                              sizeof(char *) * nCapacity,
+                                              (void **)&ppszTemp);
+            BAIL_ON_ERROR(dwError);
+            ppszOptions = ppszTemp;
+        }
+
+        dwError = coapi_load_interned_string(
+                      pLoader,
+                      &ppszOptions[nOptionCount]);
+        BAIL_ON_ERROR(dwError);
+
+        ++nOptionCount;
+    }
+    pLoader->stStats.nOptions += nOptionCount;
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
     }
+    BAIL_ON_ERROR(dwError);
 
-    *ppApiModules = pApiModules;
+    //options grow on the heap until the count is known. the strings
+    //are interned, so equal lists of options are equal arrays.
+    if(nOptionCount)
+    {
+        size_t nCount = pLoader->stBlocks.nCount;
+
+        dwError = coapi_string_table_intern_block(
+                      &pLoader->stBlocks,
+                      pLoader->pArena,
+                      ppszOptions,
+                      sizeof(char *) * nOptionCount,
+                      (void **)&ppszArenaOptions);
+        BAIL_ON_ERROR(dwError);
+
+        if(nCount == pLoader->stBlocks.nCount)
+        {
+            pLoader->stStats.nSharedParamBytes += sizeof(char *) * nOptionCount;
+        }
+    }
 
+    *pnOptionCount = nOptionCount;
+    *pppszOptions = ppszArenaOptions;
 cleanup:
+    SAFE_FREE_MEMORY(ppszOptions);
     return dwError;
 
 error:
-    if(ppApiModules)
+    if(pppszOptions)
     {
-        *ppApiModules = NULL;
+        *pppszOptions = NULL;
+    }
+    if(pnOptionCount)
+    {
+        *pnOptionCount = 0;
     }
-    coapi_free_api_module(pApiModules);
-    coapi_free_api_module(pApiModule);
     goto cleanup;
 }
 
 uint32_t
-coapi_replace_endpoint_path(
-    const char *pszActualName,
-    PREST_API_PARAM pApiParams,
-    char **ppszName
+coapi_load_parameter(
+    PCOAPI_LOADER pLoader,
+    PREST_API_PARAM *ppParam
     )
 {
     uint32_t dwError = 0;
-    char *pszName = NULL;
-    char *pszNameTemp = NULL;
-    char *pszPath = NULL;
-    PREST_API_PARAM pApiParam = NULL;
+    const char *pszKey = NULL;
+    const char *pszType = NULL;
+    const char *pszRef = NULL;
+    PREST_API_PARAM pParam = NULL;
+    PREST_API_PARAM pRefParam = NULL;
 
-    if(IsNullOrEmptyString(pszActualName) || !ppszName)
+    if(!pLoader || !ppParam)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    for(pApiParam = pApiParams; pApiParam; pApiParam = pApiParam->pNext)
+    //the param as read is only kept until it is shared
+    if(!pLoader->pTempArena)
+    {
+        dwError = coapi_arena_create(&pLoader->pTempArena);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_arena_allocate(pLoader->pTempArena,
+                                   sizeof(REST_API_PARAM),
+                                   (void **)&pParam);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_begin_object(&pLoader->stReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_key(&pLoader->stReader, &pszKey)))
     {
-        if(strcmp(pApiParam->pszIn, "path"))
+        if(!strcmp(pszKey, "name"))
         {
-            continue;
+            dwError = coapi_load_interned_string(pLoader, &pParam->pszName);
         }
+        else if(!strcmp(pszKey, "in"))
+        {
+            dwError = coapi_load_interned_string(pLoader, &pParam->pszIn);
+            BAIL_ON_ERROR(dwError);
 
-        dwError = coapi_allocate_string_printf(
-                      &pszPath,
-                      "{%s}",
-                      pApiParam->pszName);
-        BAIL_ON_ERROR(dwError);
+            //unknown locations are kept as the spec has them
+            dwError = coapi_get_rest_param_in(pParam->pszIn, &pParam->nIn);
+            if(dwError == ENOENT)
+            {
+                dwError = 0;
+            }
+        }
+        else if(!strcmp(pszKey, "required"))
+        {
+            dwError = coapi_json_get_true(&pLoader->stReader, &pParam->nRequired);
+        }
+        else if(!strcmp(pszKey, "type"))
+        {
+            dwError = coapi_json_get_string(&pLoader->stReader, &pszType);
+            BAIL_ON_ERROR(dwError);
 
-        dwError = string_replace(
-                      pszActualName,
-                      pszPath,
-                      "*",
-                      &pszNameTemp);
-        if(dwError == ENOENT)
+            dwError = coapi_get_rest_type(pszType, &pParam->nType);
+        }
+        else if(!strcmp(pszKey, "enum"))
         {
-            fprintf(stderr,
-                    "path '%s' specified with bad path string: %s\n",
-                    pApiParam->pszName,
-                    pszActualName);
+            pParam->ppszOptions = NULL;
+            pParam->nOptionCount = 0;
+            dwError = coapi_fill_enum(pLoader,
+                                      &pParam->nOptionCount,
+                                      &pParam->ppszOptions);
+        }
+        else if(!strcmp(pszKey, "$ref"))
+        {
+            dwError = coapi_json_get_string(&pLoader->stReader, &pszRef);
+            BAIL_ON_ERROR(dwError);
+
+            dwError = coapi_resolve_parameter_ref(pLoader, pszRef, &pRefParam);
+        }
+        else
+        {
+            dwError = coapi_json_skip_value(&pLoader->stReader);
         }
         BAIL_ON_ERROR(dwError);
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
 
-        SAFE_FREE_MEMORY(pszName);
-        pszName = pszNameTemp;
-        pszNameTemp = NULL;
+    //a reference replaces the whole object. the copy shares the
+    //strings and options of the resolved parameter.
+    if(pRefParam)
+    {
+        *pParam = *pRefParam;
+        pParam->pNext = NULL;
+    }
 
-        SAFE_FREE_MEMORY(pszPath);
-        pszPath = NULL;
+    if(!pParam->pszName)
+    {
+        fprintf(stderr, "parameter: missing required field - name\n");
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
     }
 
-    if(!pszName)
+    if(!pParam->pszIn)
     {
-        dwError = coapi_allocate_string(pszActualName, &pszName);
+        fprintf(stderr, "parameter: missing required field - in\n");
+        dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    *ppszName = pszName;
+    ++pLoader->stStats.nParams;
+    *ppParam = pParam;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppParam)
+    {
+        *ppParam = NULL;
+    }
+    goto cleanup;
+}
+
+//loads the parameter a local $ref such as #/parameters/pageSize points
+//at. each target is loaded and shared once per load.
+uint32_t
+coapi_resolve_parameter_ref(
+    PCOAPI_LOADER pLoader,
+    const char *pszRef,
+    PREST_API_PARAM *ppParam
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_JSON_READER pReader = NULL;
+    COAPI_JSON_READER stSaved = {0};
+    PREST_API_PARAM pParam = NULL;
+    const char *pszTarget = NULL;
+    const char *pszPointer = NULL;
+    size_t nRefLength = 0;
+
+    if(!pLoader || !pszRef || !ppParam)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nRefLength = strlen(pszRef);
+    dwError = coapi_string_table_get_value(&pLoader->stRefs,
+                                           pszRef,
+                                           nRefLength,
+                                           (void **)&pParam);
+    if(!dwError)
+    {
+        *ppParam = pParam;
+        goto cleanup;
+    }
+    if(dwError != ENOENT)
+    {
+        BAIL_ON_ERROR(dwError);
+    }
+    dwError = 0;
+
+    if(!strncmp(pszRef, "#/parameters/", sizeof("#/parameters/") - 1))
+    {
+        pszTarget = pLoader->pszRefParameters;
+        pszPointer = pszRef + sizeof("#/parameters") - 1;
+    }
+    else if(!strncmp(pszRef, "#/definitions/", sizeof("#/definitions/") - 1))
+    {
+        pszTarget = pLoader->pszRefDefinitions;
+        pszPointer = pszRef + sizeof("#/definitions") - 1;
+    }
+    else
+    {
+        fprintf(stderr, "parameter: unsupported $ref - %s\n", pszRef);
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pLoader->nRefDepth >= COAPI_REF_MAX_DEPTH)
+    {
+        fprintf(stderr, "parameter: $ref loop - %s\n", pszRef);
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //pszRef stays in the saved reader buffer. the target is read into
+    //a buffer of its own and never decoded in place, since other
+    //references and loader threads read it too.
+    pReader = &pLoader->stReader;
+    stSaved = *pReader;
+    pReader->pszBuffer = NULL;
+    pReader->nBufferSize = 0;
+    pReader->nInSitu = 0;
+    pReader->pszCur = pszTarget;
+    ++pLoader->nRefDepth;
+
+    if(pszTarget)
+    {
+        dwError = coapi_json_find_pointer(pReader, pszPointer);
+    }
+    if(!pszTarget || dwError == ENOENT)
+    {
+        fprintf(stderr, "parameter: $ref not found - %s\n", pszRef);
+        dwError = EINVAL;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_load_parameter(pLoader, &pParam);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_share_param(pLoader, pParam, NULL, &pParam);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_string_table_set_value(&pLoader->stRefs,
+                                           pLoader->pArena,
+                                           pszRef,
+                                           nRefLength,
+                                           pParam);
+    BAIL_ON_ERROR(dwError);
+
+    *ppParam = pParam;
+
+cleanup:
+    if(pReader)
+    {
+        coapi_json_reader_free(pReader);
+        *pReader = stSaved;
+        --pLoader->nRefDepth;
+    }
+    return dwError;
+
+error:
+    if(ppParam)
+    {
+        *ppParam = NULL;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_load_parameters(
+    PCOAPI_LOADER pLoader,
+    PREST_API_PARAM *ppParams
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_PARAM pParams = NULL;
+    PREST_API_PARAM *ppTail = &pParams;
+    PREST_API_PARAM pParam = NULL;
+    COAPI_LOAD_PHASE stMark = {0};
+    int nProfile = 0;
+
+    if(!pLoader || !ppParams)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nProfile = (pLoader->dwFlags & COAPI_LOAD_PROFILE) != 0;
+    if(nProfile)
+    {
+        coapi_load_phase_begin(pLoader, &stMark);
+    }
+
+    dwError = coapi_json_begin_array(&pLoader->stReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_element(&pLoader->stReader)))
+    {
+        dwError = coapi_load_parameter(pLoader, &pParam);
+        BAIL_ON_ERROR(dwError);
+
+        //spec order
+        *ppTail = pParam;
+        ppTail = &pParam->pNext;
+        pParam = NULL;
+    }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    if(nProfile)
+    {
+        coapi_load_phase_end(pLoader, &stMark, &pLoader->stStats.stParams);
+    }
+
+    *ppParams = pParams;
+
 cleanup:
-    SAFE_FREE_MEMORY(pszNameTemp);
-    SAFE_FREE_MEMORY(pszPath);
     return dwError;
 
 error:
-    if(ppszName)
+    if(ppParams)
     {
-        *ppszName = NULL;
+        *ppParams = NULL;
     }
-    SAFE_FREE_MEMORY(pszName);
     goto cleanup;
 }
 
+//links the path level params behind the params of a method, so all
+//methods of a path share them. a method param with the same name and
+//location overrides a path param. the method then gets its own list
+//of the path params it does not override. *ppParams is the list as
+//read and is replaced by the shared list.
 uint32_t
-coapi_load_endpoints(
-    json_t *pRoot,
-    const char *pszBasePath,
-    PREST_API_MODULE pApiModules
+coapi_add_path_params(
+    PCOAPI_LOADER pLoader,
+    PREST_API_PARAM pPathParams,
+    PREST_API_PARAM *ppParams
     )
 {
     uint32_t dwError = 0;
-    json_t *pPaths = NULL;
-    json_t *pPath = NULL;
-    const char *pszKey = NULL;
-    PREST_API_ENDPOINT pEndPoint = NULL;
-    PREST_API_METHOD pRestMethod = NULL;
-
-    if(!pRoot || !pszBasePath || !pApiModules)
-    {
-        dwError = EINVAL;
-        BAIL_ON_ERROR(dwError);
-    }
+    PREST_API_PARAM pParam = NULL;
+    PREST_API_PARAM pTail = pPathParams;
 
-    pPaths = json_object_get(pRoot, "paths");
-    if(!pPaths)
+    if(!pLoader || !ppParams)
     {
-        fprintf(stderr, "paths not found in api def\n");
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    json_object_foreach(pPaths, pszKey, pPath)
+    for(pParam = *ppParams; pParam; pParam = pParam->pNext)
     {
-        const char *pszMethod = NULL;
-        json_t *pMethod = NULL;
-        PREST_API_MODULE pModule = NULL;
-        const char *pszCmdStart = NULL;
-
-        dwError = coapi_allocate_memory(sizeof(REST_API_ENDPOINT),
-                                        (void **)&pEndPoint);
-        BAIL_ON_ERROR(dwError);
-
-        pszCmdStart = strrchr(pszKey, URL_SEPARATOR);
-        pszCmdStart = pszCmdStart ? pszCmdStart + 1 : pszKey;
-
-        dwError = coapi_allocate_string(pszCmdStart,
-                                        &pEndPoint->pszCommandName);
-        BAIL_ON_ERROR(dwError);
-
-        dwError = coapi_allocate_string_printf(&pEndPoint->pszActualName,
-                                               "%s%s",
-                                               pszBasePath,
-                                               pszKey);
-        BAIL_ON_ERROR(dwError);
-
-        json_object_foreach(pPath, pszMethod, pMethod)
+        if(coapi_find_param(pPathParams, pParam))
         {
-            RESTMETHOD nMethod = METHOD_INVALID;
-            pRestMethod = NULL;
-
-            dwError = coapi_get_rest_method(pszMethod, &nMethod);
-            BAIL_ON_ERROR(dwError);
-
-            if(pEndPoint->pMethods[nMethod])
-            {
-                printf("error entry already exists\n");
-                dwError = EEXIST;
-                BAIL_ON_ERROR(dwError);
-            }
-
-            dwError = coapi_allocate_memory(sizeof(REST_API_METHOD),
-                                            (void **)&pRestMethod);
-            BAIL_ON_ERROR(dwError);
-
-            dwError = coapi_allocate_string(
-                          pszMethod,
-                          &pRestMethod->pszMethod);
-            BAIL_ON_ERROR(dwError);
-
-            dwError = json_safe_get_string_value(
-                          pMethod,
-                          "summary",
-                          &pRestMethod->pszSummary);
-            BAIL_ON_ERROR(dwError);
-
-            dwError = json_safe_get_string_value(
-                          pMethod,
-                          "description",
-                          &pRestMethod->pszDescription);
-            BAIL_ON_ERROR(dwError);
-
-            pRestMethod->nMethod = nMethod;
-
-            dwError = coapi_load_parameters(pMethod, &pRestMethod->pParams);
-            if(dwError == ENODATA)
-            {
-                dwError = 0;//allow no params
-            }
+            dwError = coapi_share_params(pLoader,
+                                         pPathParams,
+                                         *ppParams,
+                                         NULL,
+                                         &pTail);
             BAIL_ON_ERROR(dwError);
-
-            if(IsNullOrEmptyString(pEndPoint->pszName))
-            {
-                dwError = coapi_replace_endpoint_path(
-                              pEndPoint->pszActualName,
-                              pRestMethod->pParams,
-                              &pEndPoint->pszName);
-                BAIL_ON_ERROR(dwError);
-
-                pEndPoint->nHasPathSubs = strcmp(pEndPoint->pszActualName,
-                                                 pEndPoint->pszName) != 0;
-            }
-
-            pEndPoint->pMethods[nMethod] = pRestMethod;
-            pRestMethod = NULL;
-
-            if(!pModule)
-            {
-                //find the module tagged
-                dwError = coapi_find_tagged_module(pMethod, pApiModules, &pModule);
-                if(dwError == ENODATA)
-                {
-                    pModule = pApiModules;
-                    dwError = 0;
-                }
-                BAIL_ON_ERROR(dwError);
-            }
+            break;
         }
-
-        dwError = coapi_module_add_endpoint(pModule, pEndPoint);
-        BAIL_ON_ERROR(dwError);
     }
 
+    dwError = coapi_share_params(pLoader, *ppParams, NULL, pTail, ppParams);
+    BAIL_ON_ERROR(dwError);
+
 cleanup:
     return dwError;
 
 error:
-    coapi_free_api_endpoint(pEndPoint);
-    coapi_free_api_method(pRestMethod);
     goto cleanup;
 }
 
+//the shared node with the fields of pParam followed by pNext. nodes
+//are shared by content, including the tail, so equal lists and equal
+//ends of lists are stored once.
 uint32_t
-coapi_fill_enum(
-    json_t *pJsonEnum,
-    int *pnOptionCount,
-    char ***pppszOptions
+coapi_share_param(
+    PCOAPI_LOADER pLoader,
+    PREST_API_PARAM pParam,
+    PREST_API_PARAM pNext,
+    PREST_API_PARAM *ppShared
     )
 {
     uint32_t dwError = 0;
-    int i = 0;
-    int nOptionCount = 0;
-    json_t *pEnumValue = NULL;
-    char **ppszOptions = NULL;
+    REST_API_PARAM stParam;
+    size_t nCount = 0;
 
-    if(!pJsonEnum || !pppszOptions || !pnOptionCount)
+    if(!pLoader || !pParam || !ppShared)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    nOptionCount = json_array_size(pJsonEnum);
-    if(nOptionCount <= 0)
-    {
-        dwError = ENODATA;
-        BAIL_ON_ERROR(dwError);
-    }
-
-    dwError = coapi_allocate_memory(sizeof(char *) * nOptionCount,
-                                    (void **)&ppszOptions);
+    //compared as bytes, so padding must be zero as well
+    memset(&stParam, 0, sizeof(stParam));
+    stParam.pszName = pParam->pszName;
+    stParam.pszIn = pParam->pszIn;
+    stParam.nIn = pParam->nIn;
+    stParam.nRequired = pParam->nRequired;
+    stParam.nType = pParam->nType;
+    stParam.nOptionCount = pParam->nOptionCount;
+    stParam.ppszOptions = pParam->ppszOptions;
+    stParam.pNext = pNext;
+
+    nCount = pLoader->stBlocks.nCount;
+
+    dwError = coapi_string_table_intern_block(&pLoader->stBlocks,
+                                              pLoader->pArena,
+                                              &stParam,
+                                              sizeof(stParam),
+                                              (void **)ppShared);
     BAIL_ON_ERROR(dwError);
 
-    json_array_foreach(pJsonEnum, i, pEnumValue)
+    if(nCount == pLoader->stBlocks.nCount)
     {
-        dwError = coapi_allocate_string(
-                      json_string_value(pEnumValue),
-                      &ppszOptions[i]);
-        BAIL_ON_ERROR(dwError);
+        ++pLoader->stStats.nSharedParams;
+        pLoader->stStats.nSharedParamBytes += sizeof(stParam);
     }
 
-    *pnOptionCount = nOptionCount;
-    *pppszOptions = ppszOptions;
 cleanup:
     return dwError;
 
 error:
-    if(dwError == ENODATA)
-    {
-        dwError = 0;
-    }
-    if(pppszOptions)
-    {
-        *pppszOptions = NULL;
-    }
-    if(pnOptionCount)
+    if(ppShared)
     {
-        *pnOptionCount = 0;
+        *ppShared = NULL;
     }
-    coapi_free_string_array_with_count(ppszOptions, nOptionCount);
     goto cleanup;
 }
 
+//shares the params of pParams that are not in pSkip, in the same
+//order, in front of pTail
 uint32_t
-coapi_load_parameters(
-    json_t *pMethod,
-    PREST_API_PARAM *ppParams
+coapi_share_params(
+    PCOAPI_LOADER pLoader,
+    PREST_API_PARAM pParams,
+    PREST_API_PARAM pSkip,
+    PREST_API_PARAM pTail,
+    PREST_API_PARAM *ppShared
     )
 {
     uint32_t dwError = 0;
-    int i = 0;
-    PREST_API_PARAM pParams = NULL;
     PREST_API_PARAM pParam = NULL;
-    json_t *pJsonParams = NULL;
-    json_t *pJsonParam = NULL;
+    PREST_API_PARAM pShared = pTail;
+    PREST_API_PARAM *ppParams = NULL;
+    size_t nCount = 0;
+    size_t i = 0;
 
-    if(!pMethod || !ppParams)
+    if(!pLoader || !ppShared)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    pJsonParams = json_object_get(pMethod, "parameters");
-    if(!pJsonParams)
+    for(pParam = pParams; pParam; pParam = pParam->pNext)
     {
-        dwError = ENODATA;
-        BAIL_ON_ERROR(dwError);
+        ++nCount;
     }
 
-    json_array_foreach(pJsonParams, i, pJsonParam)
+    if(nCount && !pLoader->pTempArena)
     {
-        json_t *pTemp = NULL;
-        dwError = coapi_allocate_memory(sizeof(REST_API_PARAM),
-                                        (void **)&pParam);
+        dwError = coapi_arena_create(&pLoader->pTempArena);
         BAIL_ON_ERROR(dwError);
+    }
 
-        pTemp = json_object_get(pJsonParam, "name");
-        if(pTemp)
-        {
-            dwError = coapi_allocate_string(json_string_value(pTemp),
-                                            &pParam->pszName);
-            BAIL_ON_ERROR(dwError);
-        }
-        else
-        {
-            fprintf(stderr, "parameter: missing required field - name\n");
-            dwError = EINVAL;
-            BAIL_ON_ERROR(dwError);
-        }
-
-        pTemp = json_object_get(pJsonParam, "in");
-        if(pTemp)
-        {
-            dwError = coapi_allocate_string(json_string_value(pTemp),
-                                            &pParam->pszIn);
-            BAIL_ON_ERROR(dwError);
-        }
-        else
-        {
-            fprintf(stderr, "parameter: missing required field - in\n");
-            dwError = EINVAL;
-            BAIL_ON_ERROR(dwError);
-        }
-
-        pTemp = json_object_get(pJsonParam, "required");
-        if(pTemp)
-        {
-            pParam->nRequired = json_is_true(pTemp);
-        }
+    if(nCount)
+    {
+        dwError = coapi_arena_allocate(pLoader->pTempArena,
+                                       sizeof(PREST_API_PARAM) * nCount,
+                                       (void **)&ppParams);
+        BAIL_ON_ERROR(dwError);
+    }
 
-        pTemp = json_object_get(pJsonParam, "type");
-        if(pTemp)
-        {
-            dwError = coapi_get_rest_type(json_string_value(pTemp), &pParam->nType);
-            BAIL_ON_ERROR(dwError);
-        }
+    for(pParam = pParams, i = 0; pParam; pParam = pParam->pNext, ++i)
+    {
+        ppParams[i] = pParam;
+    }
 
-        pTemp = json_object_get(pJsonParam, "enum");
-        if(pTemp)
+    //nodes are shared from the end of the list
+    for(i = nCount; i > 0; --i)
+    {
+        if(pSkip && coapi_find_param(pSkip, ppParams[i - 1]))
         {
-            dwError = coapi_fill_enum(pTemp,
-                                      &pParam->nOptionCount,
-                                      &pParam->ppszOptions);
-            BAIL_ON_ERROR(dwError);
+            continue;
         }
-        pParam->pNext = pParams;
-        pParams = pParam;
-        pParam = NULL;
+        dwError = coapi_share_param(pLoader,
+                                    ppParams[i - 1],
+                                    pShared,
+                                    &pShared);
+        BAIL_ON_ERROR(dwError);
     }
 
-    *ppParams = pParams;
+    *ppShared = pShared;
 
 cleanup:
     return dwError;
 
 error:
-    if(ppParams)
+    if(ppShared)
     {
-        *ppParams = NULL;
+        *ppShared = NULL;
     }
-    coapi_free_api_param(pParams);
-    coapi_free_api_param(pParam);
     goto cleanup;
 }
 
+//the param in pParams with the name and location of pParam
+PREST_API_PARAM
+coapi_find_param(
+    PREST_API_PARAM pParams,
+    PREST_API_PARAM pParam
+    )
+{
+    for(; pParams; pParams = pParams->pNext)
+    {
+        if(!strcmp(pParams->pszName, pParam->pszName) &&
+           !strcmp(pParams->pszIn, pParam->pszIn))
+        {
+            return pParams;
+        }
+    }
+    return NULL;
+}
+
 uint32_t
 coapi_load_secure_scheme(
-    json_t *pRoot,
+    PCOAPI_LOADER pLoader,
     int *pnHasSecureScheme
     )
 {
     uint32_t dwError = 0;
-    json_t *pSchemes = NULL;
-    json_t *pScheme = NULL;
-    int i = 0;
+    COAPI_JSON_TYPE nType = JSON_TYPE_NONE;
+    const char *pszScheme = NULL;
     int nHasSecureScheme = 0;
 
-    if(!pRoot || !pnHasSecureScheme)
+    if(!pLoader || !pnHasSecureScheme)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    pSchemes = json_object_get(pRoot, "schemes");
-    if(!pSchemes)
-    {
-        dwError = ENODATA;
-        BAIL_ON_ERROR(dwError);
-    }
+    dwError = coapi_json_peek(&pLoader->stReader, &nType);
+    BAIL_ON_ERROR(dwError);
 
-    if(!json_is_array(pSchemes))
+    if(nType != JSON_TYPE_ARRAY)
     {
         fprintf(stderr, "schemes is not a json array\n");
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    json_array_foreach(pSchemes, i, pScheme)
+    dwError = coapi_json_begin_array(&pLoader->stReader);
+    BAIL_ON_ERROR(dwError);
+
+    while(!(dwError = coapi_json_next_element(&pLoader->stReader)))
     {
-        const char *pszScheme = json_string_value(pScheme);
+        if(nHasSecureScheme)
+        {
+            dwError = coapi_json_skip_value(&pLoader->stReader);
+            BAIL_ON_ERROR(dwError);
+            continue;
+        }
+
+        dwError = coapi_json_get_string(&pLoader->stReader, &pszScheme);
+        BAIL_ON_ERROR(dwError);
+
         if(IsNullOrEmptyString(pszScheme))
         {
             dwError = EINVAL;
@@ -503,9 +2115,13 @@ coapi_load_secure_scheme(
         if(!strcasecmp("https", pszScheme))
         {
             nHasSecureScheme = 1;
-            break;
         }
     }
+    if(dwError == ENOENT)
+    {
+        dwError = 0;
+    }
+    BAIL_ON_ERROR(dwError);
 
     *pnHasSecureScheme = nHasSecureScheme;
 cleanup:
@@ -521,33 +2137,50 @@ error:
 
 uint32_t
 coapi_module_add_endpoint(
+    PCOAPI_LOADER pLoader,
     PREST_API_MODULE pModule,
     PREST_API_ENDPOINT pEndPoint
     )
 {
     uint32_t dwError = 0;
-    PREST_API_ENDPOINT pEndPoints = NULL;
+    PREST_API_ENDPOINT pTail = NULL;
+    size_t nTail = 0;
 
-    if(!pModule || !pEndPoint)
+    if(!pLoader || !pModule || !pEndPoint)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    pEndPoints = pModule->pEndPoints;
-    while(pEndPoints && pEndPoints->pNext)
+    //the list is only walked the first time a module is seen
+    dwError = coapi_pointer_map_get(&pLoader->stTails, pModule, &nTail);
+    if(dwError == ENOENT)
     {
-        pEndPoints = pEndPoints->pNext;
+        dwError = 0;
+        for(pTail = pModule->pEndPoints;
+            pTail && pTail->pNext;
+            pTail = pTail->pNext);
     }
-    if(pEndPoints)
+    else
+    {
+        pTail = (PREST_API_ENDPOINT)nTail;
+    }
+    BAIL_ON_ERROR(dwError);
+
+    if(pTail)
     {
-        pEndPoints->pNext = pEndPoint;
+        pTail->pNext = pEndPoint;
     }
     else
     {
         pModule->pEndPoints = pEndPoint;
     }
 
+    dwError = coapi_pointer_map_set(&pLoader->stTails,
+                                    pModule,
+                                    (size_t)pEndPoint);
+    BAIL_ON_ERROR(dwError);
+
 cleanup:
     return dwError;
 
@@ -555,61 +2188,41 @@ error:
     goto cleanup;
 }
 
+//pszTag and nTagCount are as returned by coapi_load_method
 uint32_t
 coapi_find_tagged_module(
-    json_t *pPath,
+    const char *pszTag,
+    int nTagCount,
     PREST_API_MODULE pModules,
     PREST_API_MODULE *ppModule
     )
 {
     uint32_t dwError = 0;
-    int nTagEntries = 0;
     PREST_API_MODULE pModule = NULL;
-    PREST_API_MODULE pModuleTemp = NULL;
-    json_t *pTags = NULL;
-    json_t *pTag = NULL;
-    const char *pszTag = NULL;
 
-    if(!pPath || !pModules || !ppModule)
+    if(!pModules || !ppModule)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    pTags = json_object_get(pPath, "tags");
-    if(!pTags)
+    if(nTagCount < 0)
     {
         dwError = ENODATA;
         BAIL_ON_ERROR(dwError);
     }
 
-    if(!json_is_array(pTags))
-    {
-        fprintf(stderr, "tags is not a json array\n");
-        dwError = EINVAL;
-        BAIL_ON_ERROR(dwError);
-    }
-
-    nTagEntries = json_array_size(pTags);
-    if(nTagEntries < 1)
+    if(nTagCount < 1)
     {
         fprintf(stderr, "there are no tag entries for this end point\n");
         dwError = ENODATA;
         BAIL_ON_ERROR(dwError);
     }
-    else if(nTagEntries > 1)
+    else if(nTagCount > 1)
     {
         fprintf(stdout, "there are more than one tag entries. using first entry\n");
     }
 
-    pTag = json_array_get(pTags, 0);
-    if(!pTag)
-    {
-        dwError = EINVAL;
-        BAIL_ON_ERROR(dwError);
-    }
-
-    pszTag = json_string_value(pTag);
     if(!pszTag)
     {
         dwError = EINVAL;
@@ -677,6 +2290,7 @@ error:
 
 uint32_t
 coapi_add_default_module(
+    PCOAPI_ARENA pArena,
     const char *pszModuleName,
     PREST_API_MODULE *ppApiModules
     )
@@ -684,19 +2298,23 @@ coapi_add_default_module(
     uint32_t dwError = 0;
     PREST_API_MODULE pApiModule = NULL;
 
-    if(IsNullOrEmptyString(pszModuleName) || !ppApiModules)
+    if(!pArena || IsNullOrEmptyString(pszModuleName) || !ppApiModules)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    dwError = coapi_allocate_memory(sizeof(REST_API_MODULE),
-                                        (void **)&pApiModule);
+    dwError = coapi_arena_allocate(pArena,
+                                   sizeof(REST_API_MODULE),
+                                   (void **)&pApiModule);
     BAIL_ON_ERROR(dwError);
 
-    dwError = coapi_allocate_string(pszModuleName, &pApiModule->pszName);
+    dwError = coapi_arena_allocate_string(pArena,
+                                          pszModuleName,
+                                          &pApiModule->pszName);
     BAIL_ON_ERROR(dwError);
-    dwError = coapi_allocate_string(
+    dwError = coapi_arena_allocate_string(
+                      pArena,
                       "default module",
                       &pApiModule->pszDescription);
     BAIL_ON_ERROR(dwError);
@@ -711,7 +2329,6 @@ error:
     {
         *ppApiModules = NULL;
     }
-    coapi_free_api_module(pApiModule);
     goto cleanup;
 }
 
@@ -829,7 +2446,7 @@ coapi_is_integer(
 
     while(*pszValue)
     {
-        if(!isdigit(*pszValue))
+        if(!isdigit((unsigned char)*pszValue))
         {
             dwError = EINVAL;
             BAIL_ON_ERROR(dwError);
@@ -1010,23 +2627,35 @@ coapi_find_method(
         BAIL_ON_ERROR(dwError);
     }
 
-    pModule = pApiDef->pModules;
-    while(pModule)
+    //every loaded def has a table. the lists are walked for defs
+    //put together by hand.
+    if(pApiDef->pTable)
     {
-        dwError = coapi_find_endpoint_by_name(pszEndPoint,
-                                        pModule->pEndPoints,
-                                        &pEndPoint);
-        if(dwError == ENOENT)
-        {
-            dwError = 0;
-        }
+        dwError = coapi_table_find_endpoint(pApiDef->pTable,
+                                            pszEndPoint,
+                                            &pEndPoint);
         BAIL_ON_ERROR(dwError);
-
-        if(pEndPoint)
+    }
+    else
+    {
+        pModule = pApiDef->pModules;
+        while(pModule)
         {
-            break;
+            dwError = coapi_find_endpoint_by_name(pszEndPoint,
+                                            pModule->pEndPoints,
+                                            &pEndPoint);
+            if(dwError == ENOENT)
+            {
+                dwError = 0;
+            }
+            BAIL_ON_ERROR(dwError);
+
+            if(pEndPoint)
+            {
+                break;
+            }
+            pModule = pModule->pNext;
         }
-        pModule = pModule->pNext;
     }
 
     if(!pEndPoint)
@@ -1046,6 +2675,9 @@ coapi_find_method(
         BAIL_ON_ERROR(dwError);
     }
 
+    dwError = coapi_load_method_details(pApiDef, pMethod);
+    BAIL_ON_ERROR(dwError);
+
     *ppMethod = pMethod;
 cleanup:
     return dwError;
@@ -1117,6 +2749,61 @@ error:
     goto cleanup;
 }
 
+//returns ENOENT for locations this library does not know about
+uint32_t
+coapi_get_rest_param_in(
+    const char *pszIn,
+    RESTPARAMIN *pnIn
+    )
+{
+    uint32_t dwError = 0;
+    RESTPARAMIN nIn = RESTPARAMIN_INVALID;
+
+    if(!pszIn || !pnIn)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!strcmp(pszIn, "path"))
+    {
+        nIn = RESTPARAMIN_PATH;
+    }
+    else if(!strcmp(pszIn, "query"))
+    {
+        nIn = RESTPARAMIN_QUERY;
+    }
+    else if(!strcmp(pszIn, "header"))
+    {
+        nIn = RESTPARAMIN_HEADER;
+    }
+    else if(!strcmp(pszIn, "body"))
+    {
+        nIn = RESTPARAMIN_BODY;
+    }
+    else if(!strcmp(pszIn, "formData"))
+    {
+        nIn = RESTPARAMIN_FORMDATA;
+    }
+    else
+    {
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *pnIn = nIn;
+
+cleanup:
+    return dwError;
+
+error:
+    if(pnIn)
+    {
+        *pnIn = RESTPARAMIN_INVALID;
+    }
+    goto cleanup;
+}
+
 uint32_t
 coapi_get_rest_method_string(
     RESTMETHOD nMethod,
@@ -1363,16 +3050,16 @@ error:
     goto cleanup;
 }
 
+//the free functions of nodes are for defs put together by the caller,
+//with every node and string allocated on its own. loaded defs are in
+//an arena or an image.
 void
 coapi_free_api_param(
-    PREST_API_PARAM pParam
+    PREST_API_PARAM pParam,
+    PREST_API_PARAM pStop
     )
 {
-    if(!pParam)
-    {
-        return;
-    }
-    while(pParam)
+    while(pParam && pParam != pStop)
     {
         PREST_API_PARAM pParamTemp = pParam->pNext;
 
@@ -1387,16 +3074,19 @@ coapi_free_api_param(
     }
 }
 
+//a method's params end with the path level params of its endpoint,
+//pass those as pPathParams to leave them to the endpoint
 void
 coapi_free_api_method(
-    PREST_API_METHOD pMethod
+    PREST_API_METHOD pMethod,
+    PREST_API_PARAM pPathParams
     )
 {
     if(!pMethod)
     {
         return;
     }
-    coapi_free_api_param(pMethod->pParams);
+    coapi_free_api_param(pMethod->pParams, pPathParams);
     coapi_free_memory(pMethod->pszMethod);
     SAFE_FREE_MEMORY(pMethod->pszSummary);
     SAFE_FREE_MEMORY(pMethod->pszDescription);
@@ -1420,9 +3110,11 @@ coapi_free_api_endpoint(
         {
             if(pEndPoint->pMethods[i])
             {
-                coapi_free_api_method(pEndPoint->pMethods[i]);
+                coapi_free_api_method(pEndPoint->pMethods[i],
+                                      pEndPoint->pParams);
             }
         }
+        coapi_free_api_param(pEndPoint->pParams, NULL);
         SAFE_FREE_MEMORY(pEndPoint->pszActualName);
         SAFE_FREE_MEMORY(pEndPoint->pszName);
         SAFE_FREE_MEMORY(pEndPoint->pszCommandName);
@@ -1460,9 +3152,27 @@ coapi_free_api_def(
 {
     if(pApiDef)
     {
+        coapi_free_api_table(pApiDef->pTable);
+    }
+    if(pApiDef && pApiDef->pImage)
+    {
+        coapi_image_free(pApiDef);
+    }
+    else if(pApiDef && !pApiDef->pArena)
+    {
+        //put together by the caller
         SAFE_FREE_MEMORY(pApiDef->pszHost);
         SAFE_FREE_MEMORY(pApiDef->pszBasePath);
         coapi_free_api_module(pApiDef->pModules);
         SAFE_FREE_MEMORY(pApiDef);
     }
+    else if(pApiDef)
+    {
+        //the def itself is in the arena
+        if(pApiDef->pSource)
+        {
+            coapi_file_unmap(pApiDef->pSource, pApiDef->nSourceSize);
+        }
+        coapi_arena_free(pApiDef->pArena);
+    }
 }
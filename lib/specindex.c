@@ -0,0 +1,449 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Sidecar index of spec contents. Compiled and shared images record the
+//hash of the spec text they were built from and are current when it
+//matches the text of the spec now. The index keeps that hash for a
+//spec path together with the stat it was taken at, in a small file in
+//COAPI_SHARED_IMAGE_DIR named after the real path. While the stat of
+//the spec matches, the hash is taken from the index: one stat and one
+//small read. A changed stat has the text hashed again and the index
+//rewritten, so touching or copying a spec keeps its images.
+//The hash is xxh64 of the text, after decompression.
+
+#include "includes.h"
+
+#define XXH_PRIME64_1 0x9e3779b185ebca87ULL
+#define XXH_PRIME64_2 0xc2b2ae3d27d4eb4fULL
+#define XXH_PRIME64_3 0x165667b19e3779f9ULL
+#define XXH_PRIME64_4 0x85ebca77c2b2ae63ULL
+#define XXH_PRIME64_5 0x27d4eb2f165667c5ULL
+
+uint64_t
+coapi_xxh_rotl(
+    uint64_t nValue,
+    int nBits
+    )
+{
+    return (nValue << nBits) | (nValue >> (64 - nBits));
+}
+
+uint64_t
+coapi_xxh_read64(
+    const char *pszPos
+    )
+{
+    uint64_t nValue = 0;
+
+    memcpy(&nValue, pszPos, sizeof(nValue));
+    return nValue;
+}
+
+uint64_t
+coapi_xxh_round(
+    uint64_t nAcc,
+    uint64_t nInput
+    )
+{
+    nAcc += nInput * XXH_PRIME64_2;
+    return coapi_xxh_rotl(nAcc, 31) * XXH_PRIME64_1;
+}
+
+uint64_t
+coapi_xxh_merge(
+    uint64_t nAcc,
+    uint64_t nValue
+    )
+{
+    nAcc ^= coapi_xxh_round(0, nValue);
+    return nAcc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+//xxh64 with seed 0. reads are little endian.
+uint64_t
+coapi_hash_text(
+    const char *pszText,
+    size_t nLength
+    )
+{
+    const char *pszCur = pszText;
+    const char *pszEnd = pszText + nLength;
+    uint64_t nHash = 0;
+
+    if(nLength >= 32)
+    {
+        uint64_t v1 = XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = XXH_PRIME64_2;
+        uint64_t v3 = 0;
+        uint64_t v4 = -XXH_PRIME64_1;
+
+        for(; pszEnd - pszCur >= 32; pszCur += 32)
+        {
+            v1 = coapi_xxh_round(v1, coapi_xxh_read64(pszCur));
+            v2 = coapi_xxh_round(v2, coapi_xxh_read64(pszCur + 8));
+            v3 = coapi_xxh_round(v3, coapi_xxh_read64(pszCur + 16));
+            v4 = coapi_xxh_round(v4, coapi_xxh_read64(pszCur + 24));
+        }
+        nHash = coapi_xxh_rotl(v1, 1) + coapi_xxh_rotl(v2, 7) +
+                coapi_xxh_rotl(v3, 12) + coapi_xxh_rotl(v4, 18);
+        nHash = coapi_xxh_merge(nHash, v1);
+        nHash = coapi_xxh_merge(nHash, v2);
+        nHash = coapi_xxh_merge(nHash, v3);
+        nHash = coapi_xxh_merge(nHash, v4);
+    }
+    else
+    {
+        nHash = XXH_PRIME64_5;
+    }
+    nHash += nLength;
+
+    for(; pszEnd - pszCur >= 8; pszCur += 8)
+    {
+        nHash ^= coapi_xxh_round(0, coapi_xxh_read64(pszCur));
+        nHash = coapi_xxh_rotl(nHash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if(pszEnd - pszCur >= 4)
+    {
+        uint32_t nWord = 0;
+
+        memcpy(&nWord, pszCur, sizeof(nWord));
+        nHash ^= nWord * XXH_PRIME64_1;
+        nHash = coapi_xxh_rotl(nHash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        pszCur += 4;
+    }
+    for(; pszCur < pszEnd; ++pszCur)
+    {
+        nHash ^= (unsigned char)*pszCur * XXH_PRIME64_5;
+        nHash = coapi_xxh_rotl(nHash, 11) * XXH_PRIME64_1;
+    }
+
+    nHash ^= nHash >> 33;
+    nHash *= XXH_PRIME64_2;
+    nHash ^= nHash >> 29;
+    nHash *= XXH_PRIME64_3;
+    nHash ^= nHash >> 32;
+    return nHash;
+}
+
+void
+coapi_spec_index_set_source(
+    PCOAPI_SPEC_INDEX pIndex,
+    const struct stat *pSource
+    )
+{
+    pIndex->nSourceDevice = pSource->st_dev;
+    pIndex->nSourceInode = pSource->st_ino;
+    pIndex->nSourceSize = pSource->st_size;
+    pIndex->nSourceMtimeSec = pSource->st_mtim.tv_sec;
+    pIndex->nSourceMtimeNsec = pSource->st_mtim.tv_nsec;
+    pIndex->nSourceCtimeSec = pSource->st_ctim.tv_sec;
+    pIndex->nSourceCtimeNsec = pSource->st_ctim.tv_nsec;
+}
+
+//ctime is part of the key because mtime can be set back by hand
+int
+coapi_spec_index_matches(
+    PCOAPI_SPEC_INDEX pIndex,
+    const struct stat *pSource
+    )
+{
+    return pIndex->nSourceDevice == (uint64_t)pSource->st_dev &&
+           pIndex->nSourceInode == (uint64_t)pSource->st_ino &&
+           pIndex->nSourceSize == (uint64_t)pSource->st_size &&
+           pIndex->nSourceMtimeSec == (int64_t)pSource->st_mtim.tv_sec &&
+           pIndex->nSourceMtimeNsec == (int64_t)pSource->st_mtim.tv_nsec &&
+           pIndex->nSourceCtimeSec == (int64_t)pSource->st_ctim.tv_sec &&
+           pIndex->nSourceCtimeNsec == (int64_t)pSource->st_ctim.tv_nsec;
+}
+
+//the index file and the real path it is for
+uint32_t
+coapi_spec_index_get_name(
+    const char *pszFile,
+    char **ppszIndexFile,
+    char **ppszPath
+    )
+{
+    uint32_t dwError = 0;
+    char *pszRealPath = NULL;
+    char *pszPath = NULL;
+    char *pszIndexFile = NULL;
+
+    if(IsNullOrEmptyString(pszFile) || !ppszIndexFile || !ppszPath)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pszRealPath = realpath(pszFile, NULL);
+    if(!pszRealPath)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_allocate_string(pszRealPath, &pszPath);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_get_shared_file_name(pszPath,
+                                         COAPI_INDEX_EXTENSION,
+                                         &pszIndexFile);
+    BAIL_ON_ERROR(dwError);
+
+    *ppszIndexFile = pszIndexFile;
+    *ppszPath = pszPath;
+
+cleanup:
+    free(pszRealPath);
+    return dwError;
+
+error:
+    SAFE_FREE_MEMORY(pszPath);
+    SAFE_FREE_MEMORY(pszIndexFile);
+    goto cleanup;
+}
+
+//the index is the header followed by the path, read in one go. like
+//shared images, only indexes of this user that no one else can write
+//to are read.
+uint32_t
+coapi_spec_index_read(
+    const char *pszIndexFile,
+    const char *pszPath,
+    PCOAPI_SPEC_INDEX pIndex
+    )
+{
+    uint32_t dwError = 0;
+    int fd = -1;
+    struct stat stIndex = {0};
+    char szBuffer[sizeof(COAPI_SPEC_INDEX) + PATH_MAX];
+    size_t nPathLength = strlen(pszPath);
+    ssize_t nRead = 0;
+
+    if(nPathLength > PATH_MAX)
+    {
+        dwError = ENAMETOOLONG;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    fd = open(pszIndexFile, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if(fd < 0)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(fstat(fd, &stIndex))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_check_shared_file(&stIndex);
+    BAIL_ON_ERROR(dwError);
+
+    nRead = pread(fd, szBuffer, sizeof(COAPI_SPEC_INDEX) + nPathLength, 0);
+    if(nRead < 0)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if((size_t)nRead != sizeof(COAPI_SPEC_INDEX) + nPathLength)
+    {
+        dwError = ESTALE;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //an index of another path with the same name hash is not used
+    memcpy(pIndex, szBuffer, sizeof(*pIndex));
+    if(memcmp(pIndex->szMagic, COAPI_INDEX_MAGIC, sizeof(pIndex->szMagic)) ||
+       pIndex->dwVersion != COAPI_INDEX_VERSION ||
+       pIndex->dwPathLength != nPathLength ||
+       memcmp(szBuffer + sizeof(COAPI_SPEC_INDEX), pszPath, nPathLength))
+    {
+        dwError = ESTALE;
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//written aside and renamed like images, readers see a whole index
+uint32_t
+coapi_spec_index_write(
+    const char *pszIndexFile,
+    const char *pszPath,
+    PCOAPI_SPEC_INDEX pIndex
+    )
+{
+    uint32_t dwError = 0;
+    char *pszTempFile = NULL;
+    int fd = -1;
+    size_t nPathLength = strlen(pszPath);
+
+    memcpy(pIndex->szMagic, COAPI_INDEX_MAGIC, sizeof(pIndex->szMagic));
+    pIndex->dwVersion = COAPI_INDEX_VERSION;
+    pIndex->dwPathLength = nPathLength;
+
+    dwError = coapi_allocate_string_printf(
+                  &pszTempFile,
+                  "%s.XXXXXX",
+                  pszIndexFile);
+    BAIL_ON_ERROR(dwError);
+
+    fd = mkstemp(pszTempFile);
+    if(fd < 0)
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(write(fd, pIndex, sizeof(*pIndex)) != sizeof(*pIndex) ||
+       write(fd, pszPath, nPathLength) != (ssize_t)nPathLength)
+    {
+        dwError = errno ? errno : EIO;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(fchmod(fd, 0644) || close(fd))
+    {
+        fd = -1;
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+    fd = -1;
+
+    if(rename(pszTempFile, pszIndexFile))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+cleanup:
+    SAFE_FREE_MEMORY(pszTempFile);
+    return dwError;
+
+error:
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+    if(pszTempFile)
+    {
+        unlink(pszTempFile);
+    }
+    goto cleanup;
+}
+
+//records the hash of text read from pszFile after pSource was taken.
+//a change in between leaves the index for the old stat, which no
+//longer matches. the index is only a cache, failing to write it is
+//not an error.
+void
+coapi_spec_index_update(
+    const char *pszFile,
+    const struct stat *pSource,
+    size_t nTextLength,
+    uint64_t nTextHash
+    )
+{
+    char *pszIndexFile = NULL;
+    char *pszPath = NULL;
+    COAPI_SPEC_INDEX stIndex = {{0}};
+
+    if(coapi_spec_index_get_name(pszFile, &pszIndexFile, &pszPath))
+    {
+        return;
+    }
+
+    coapi_spec_index_set_source(&stIndex, pSource);
+    stIndex.nTextLength = nTextLength;
+    stIndex.nTextHash = nTextHash;
+
+    coapi_spec_index_write(pszIndexFile, pszPath, &stIndex);
+
+    SAFE_FREE_MEMORY(pszIndexFile);
+    SAFE_FREE_MEMORY(pszPath);
+}
+
+//the hash of the spec text now, from the index while the stat of the
+//spec matches it. otherwise the text is read, hashed and indexed.
+uint32_t
+coapi_spec_index_get(
+    const char *pszFile,
+    PCOAPI_SPEC_INDEX pIndex
+    )
+{
+    uint32_t dwError = 0;
+    struct stat stSource = {0};
+    char *pszIndexFile = NULL;
+    char *pszPath = NULL;
+    char *pszText = NULL;
+    size_t nLength = 0;
+    COAPI_SPEC_INDEX stIndex = {{0}};
+
+    if(IsNullOrEmptyString(pszFile) || !pIndex)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(stat(pszFile, &stSource))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //without a name the text is hashed every time
+    if(!coapi_spec_index_get_name(pszFile, &pszIndexFile, &pszPath) &&
+       !coapi_spec_index_read(pszIndexFile, pszPath, &stIndex) &&
+       coapi_spec_index_matches(&stIndex, &stSource))
+    {
+        *pIndex = stIndex;
+        goto cleanup;
+    }
+
+    dwError = coapi_file_map(pszFile, &pszText, &nLength);
+    BAIL_ON_ERROR(dwError);
+
+    memset(&stIndex, 0, sizeof(stIndex));
+    coapi_spec_index_set_source(&stIndex, &stSource);
+    stIndex.nTextLength = nLength;
+    stIndex.nTextHash = coapi_hash_text(pszText, nLength);
+
+    if(pszIndexFile)
+    {
+        coapi_spec_index_write(pszIndexFile, pszPath, &stIndex);
+    }
+
+    *pIndex = stIndex;
+
+cleanup:
+    coapi_file_unmap(pszText, nLength);
+    SAFE_FREE_MEMORY(pszIndexFile);
+    SAFE_FREE_MEMORY(pszPath);
+    return dwError;
+
+error:
+    goto cleanup;
+}
@@ -0,0 +1,687 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Writes a def back out as a swagger spec with the json writer.
+//Only what the loader keeps is written: host, basePath, schemes, tags
+//and the paths with their methods and params. Params a method shares
+//with its path are written once at path level, so that loading the
+//output gives the same lists again.
+
+#include "includes.h"
+
+uint32_t
+coapi_write_api_def(
+    PREST_API_DEF pApiDef,
+    int fd
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_JSON_WRITER stWriter = {0};
+
+    if(!pApiDef || fd < 0)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    coapi_json_writer_init(&stWriter, fd);
+
+    dwError = coapi_write_spec(&stWriter, pApiDef);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_writer_flush(&stWriter);
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    coapi_json_writer_free(&stWriter);
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_write_api_def_to_string(
+    PREST_API_DEF pApiDef,
+    char **ppszJson,
+    size_t *pnLength
+    )
+{
+    uint32_t dwError = 0;
+    COAPI_JSON_WRITER stWriter = {0};
+
+    if(!pApiDef || !ppszJson || !pnLength)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    coapi_json_writer_init(&stWriter, -1);
+
+    dwError = coapi_write_spec(&stWriter, pApiDef);
+    BAIL_ON_ERROR(dwError);
+
+    //terminated, not counted in the length
+    dwError = coapi_json_writer_reserve(&stWriter, 1);
+    BAIL_ON_ERROR(dwError);
+    stWriter.pszBuffer[stWriter.nLength] = '\0';
+
+    *ppszJson = stWriter.pszBuffer;
+    *pnLength = stWriter.nLength;
+    stWriter.pszBuffer = NULL;
+
+cleanup:
+    coapi_json_writer_free(&stWriter);
+    return dwError;
+
+error:
+    if(ppszJson)
+    {
+        *ppszJson = NULL;
+    }
+    if(pnLength)
+    {
+        *pnLength = 0;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_write_spec(
+    PCOAPI_JSON_WRITER pWriter,
+    PREST_API_DEF pApiDef
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_MODULE pModule = NULL;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    int nFirst = 0;
+
+    if(!pWriter || !pApiDef)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "{\"swagger\":\"2.0\"");
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_write_member(pWriter,
+                                      &nFirst,
+                                      "host",
+                                      pApiDef->pszHost);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_write_member(pWriter,
+                                      &nFirst,
+                                      "basePath",
+                                      pApiDef->pszBasePath);
+    BAIL_ON_ERROR(dwError);
+
+    if(pApiDef->nHasSecureScheme)
+    {
+        dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ",\"schemes\":[\"https\"]");
+    }
+    else
+    {
+        dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ",\"schemes\":[\"http\"]");
+    }
+    BAIL_ON_ERROR(dwError);
+
+    //the default module of a spec without tags is not one
+    if(!pApiDef->nNoModules)
+    {
+        dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ",\"tags\":[");
+        BAIL_ON_ERROR(dwError);
+
+        nFirst = 1;
+        for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+        {
+            int nFirstMember = 1;
+
+            dwError = coapi_json_write_separator(pWriter, &nFirst);
+            BAIL_ON_ERROR(dwError);
+
+            dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "{");
+            BAIL_ON_ERROR(dwError);
+
+            dwError = coapi_json_write_member(pWriter,
+                                              &nFirstMember,
+                                              "name",
+                                              pModule->pszName);
+            BAIL_ON_ERROR(dwError);
+
+            dwError = coapi_json_write_member(pWriter,
+                                              &nFirstMember,
+                                              "description",
+                                              pModule->pszDescription);
+            BAIL_ON_ERROR(dwError);
+
+            dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "}");
+            BAIL_ON_ERROR(dwError);
+        }
+
+        dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "]");
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ",\"paths\":{");
+    BAIL_ON_ERROR(dwError);
+
+    nFirst = 1;
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        for(pEndPoint = pModule->pEndPoints;
+            pEndPoint;
+            pEndPoint = pEndPoint->pNext)
+        {
+            dwError = coapi_json_write_separator(pWriter, &nFirst);
+            BAIL_ON_ERROR(dwError);
+
+            dwError = coapi_write_endpoint(pWriter,
+                                           pApiDef,
+                                           pModule,
+                                           pEndPoint);
+            BAIL_ON_ERROR(dwError);
+        }
+    }
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "}}\n");
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//the path of an endpoint is its name after basePath
+uint32_t
+coapi_write_endpoint(
+    PCOAPI_JSON_WRITER pWriter,
+    PREST_API_DEF pApiDef,
+    PREST_API_MODULE pModule,
+    PREST_API_ENDPOINT pEndPoint
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszPath = NULL;
+    size_t nBasePath = 0;
+    PREST_API_METHOD pMethod = NULL;
+    PREST_API_PARAM pPathParams = NULL;
+    PREST_API_PARAM pOwnEnd[METHOD_COUNT] = {0};
+    int nFirst = 1;
+    int i = 0;
+
+    if(!pWriter || !pApiDef || !pModule || !pEndPoint)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pszPath = pEndPoint->pszActualName;
+    nBasePath = pApiDef->pszBasePath ? strlen(pApiDef->pszBasePath) : 0;
+    if(nBasePath && !strncmp(pszPath, pApiDef->pszBasePath, nBasePath))
+    {
+        pszPath += nBasePath;
+    }
+
+    //path params are written at path level only if every method ends
+    //with them. otherwise each method lists all of its params.
+    pPathParams = pEndPoint->pParams;
+    for(i = 0; i < METHOD_COUNT && pPathParams; ++i)
+    {
+        pMethod = pEndPoint->pMethods[i];
+        if(!pMethod)
+        {
+            continue;
+        }
+
+        if(pMethod->pszDetails)
+        {
+            dwError = coapi_load_method_details(pApiDef, pMethod);
+            BAIL_ON_ERROR(dwError);
+        }
+
+        if(coapi_find_own_params_end(pMethod->pParams,
+                                     pPathParams,
+                                     &pOwnEnd[i]))
+        {
+            pPathParams = NULL;
+        }
+    }
+
+    dwError = coapi_json_write_string(pWriter, pszPath);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ":{");
+    BAIL_ON_ERROR(dwError);
+
+    for(i = 0; i < METHOD_COUNT; ++i)
+    {
+        pMethod = pEndPoint->pMethods[i];
+        if(!pMethod)
+        {
+            continue;
+        }
+
+        dwError = coapi_json_write_separator(pWriter, &nFirst);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_write_method(pWriter,
+                                     pApiDef,
+                                     pModule,
+                                     pMethod,
+                                     pPathParams ? pOwnEnd[i] : NULL);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pPathParams)
+    {
+        dwError = coapi_write_params(pWriter, &nFirst, pPathParams, NULL);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "}");
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//params of pMethod up to pEnd are written
+uint32_t
+coapi_write_method(
+    PCOAPI_JSON_WRITER pWriter,
+    PREST_API_DEF pApiDef,
+    PREST_API_MODULE pModule,
+    PREST_API_METHOD pMethod,
+    PREST_API_PARAM pEnd
+    )
+{
+    uint32_t dwError = 0;
+    char *pszMethod = NULL;
+    int nFirst = 1;
+
+    if(!pWriter || !pApiDef || !pModule || !pMethod)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pMethod->pszDetails)
+    {
+        dwError = coapi_load_method_details(pApiDef, pMethod);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_get_rest_method_string(pMethod->nMethod, &pszMethod);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_write_string(pWriter, pszMethod);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ":{");
+    BAIL_ON_ERROR(dwError);
+
+    //methods of a spec without tags are in its default module
+    if(!pApiDef->nNoModules)
+    {
+        dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "\"tags\":[");
+        BAIL_ON_ERROR(dwError);
+
+        dwError = coapi_json_write_string(pWriter, pModule->pszName);
+        BAIL_ON_ERROR(dwError);
+
+        dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "]");
+        BAIL_ON_ERROR(dwError);
+        nFirst = 0;
+    }
+
+    dwError = coapi_json_write_member(pWriter,
+                                      &nFirst,
+                                      "summary",
+                                      pMethod->pszSummary);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_write_member(pWriter,
+                                      &nFirst,
+                                      "description",
+                                      pMethod->pszDescription);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_write_params(pWriter, &nFirst, pMethod->pParams, pEnd);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "}");
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    SAFE_FREE_MEMORY(pszMethod);
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//writes "parameters" with the params from pParams up to pEnd. no op
+//for an empty list.
+uint32_t
+coapi_write_params(
+    PCOAPI_JSON_WRITER pWriter,
+    int *pnFirst,
+    PREST_API_PARAM pParams,
+    PREST_API_PARAM pEnd
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_PARAM pParam = NULL;
+
+    if(!pWriter || !pnFirst)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pParams == pEnd)
+    {
+        goto cleanup;
+    }
+
+    dwError = coapi_json_write_separator(pWriter, pnFirst);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "\"parameters\":[");
+    BAIL_ON_ERROR(dwError);
+
+    for(pParam = pParams; pParam != pEnd; pParam = pParam->pNext)
+    {
+        if(pParam != pParams)
+        {
+            dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ",");
+            BAIL_ON_ERROR(dwError);
+        }
+
+        dwError = coapi_write_param(pWriter, pParam);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "]");
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//body params have a schema instead of a type. the loader does not
+//keep schemas, so an empty one is written.
+uint32_t
+coapi_write_param(
+    PCOAPI_JSON_WRITER pWriter,
+    PREST_API_PARAM pParam
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszType = NULL;
+    int nFirst = 1;
+    int i = 0;
+
+    if(!pWriter || !pParam)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "{");
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_write_member(pWriter,
+                                      &nFirst,
+                                      "name",
+                                      pParam->pszName);
+    BAIL_ON_ERROR(dwError);
+
+    dwError = coapi_json_write_member(pWriter,
+                                      &nFirst,
+                                      "in",
+                                      pParam->pszIn);
+    BAIL_ON_ERROR(dwError);
+
+    if(pParam->nRequired)
+    {
+        dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ",\"required\":true");
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pParam->nIn == RESTPARAMIN_BODY)
+    {
+        dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ",\"schema\":{}");
+        BAIL_ON_ERROR(dwError);
+    }
+    else if(!coapi_get_rest_type_string(pParam->nType, &pszType))
+    {
+        dwError = coapi_json_write_member(pWriter, &nFirst, "type", pszType);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(pParam->nOptionCount > 0 && pParam->ppszOptions)
+    {
+        dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ",\"enum\":[");
+        BAIL_ON_ERROR(dwError);
+
+        for(i = 0; i < pParam->nOptionCount; ++i)
+        {
+            if(i)
+            {
+                dwError = COAPI_JSON_WRITE_LITERAL(pWriter, ",");
+                BAIL_ON_ERROR(dwError);
+            }
+            dwError = coapi_json_write_string(pWriter,
+                                              pParam->ppszOptions[i]);
+            BAIL_ON_ERROR(dwError);
+        }
+
+        dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "]");
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = COAPI_JSON_WRITE_LITERAL(pWriter, "}");
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+uint32_t
+coapi_get_rest_type_string(
+    RESTPARAMTYPE nType,
+    const char **ppszType
+    )
+{
+    uint32_t dwError = 0;
+    const char *pszType = NULL;
+
+    if(!ppszType)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    switch(nType)
+    {
+        case RESTPARAM_INTEGER:
+            pszType = "integer";
+        break;
+        case RESTPARAM_NUMBER:
+            pszType = "number";
+        break;
+        case RESTPARAM_STRING:
+            pszType = "string";
+        break;
+        case RESTPARAM_BOOLEAN:
+            pszType = "boolean";
+        break;
+        case RESTPARAM_ARRAY:
+            pszType = "array";
+        break;
+        case RESTPARAM_FILE:
+            pszType = "file";
+        break;
+        default:
+            dwError = ENOENT;
+            BAIL_ON_ERROR(dwError);
+    }
+
+    *ppszType = pszType;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszType)
+    {
+        *ppszType = NULL;
+    }
+    goto cleanup;
+}
+
+int
+coapi_params_equal(
+    PREST_API_PARAM pParam1,
+    PREST_API_PARAM pParam2
+    )
+{
+    int i = 0;
+
+    if(pParam1 == pParam2)
+    {
+        return 1;
+    }
+    if(strcmp(pParam1->pszName, pParam2->pszName) ||
+       strcmp(pParam1->pszIn, pParam2->pszIn) ||
+       pParam1->nRequired != pParam2->nRequired ||
+       pParam1->nType != pParam2->nType ||
+       pParam1->nOptionCount != pParam2->nOptionCount)
+    {
+        return 0;
+    }
+    if(pParam1->ppszOptions == pParam2->ppszOptions)
+    {
+        return 1;
+    }
+    for(i = 0; i < pParam1->nOptionCount; ++i)
+    {
+        if(strcmp(pParam1->ppszOptions[i], pParam2->ppszOptions[i]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//finds where the params of a method end and the path params it does
+//not override begin, as coapi_add_path_params linked them. ENOENT if
+//the list does not end that way, eg: after coapi_unshare_method_params
+//and changes to the copy.
+uint32_t
+coapi_find_own_params_end(
+    PREST_API_PARAM pParams,
+    PREST_API_PARAM pPathParams,
+    PREST_API_PARAM *ppEnd
+    )
+{
+    uint32_t dwError = 0;
+    PREST_API_PARAM pStart = NULL;
+    PREST_API_PARAM pParam = NULL;
+    PREST_API_PARAM pOwn = NULL;
+    PREST_API_PARAM pPath = NULL;
+    int nOverridden = 0;
+
+    if(!ppEnd)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    //without overrides the list ends with the path list itself
+    for(pParam = pParams; pParam; pParam = pParam->pNext)
+    {
+        if(pParam == pPathParams)
+        {
+            *ppEnd = pParam;
+            goto cleanup;
+        }
+    }
+
+    //the first start after which the list is the path params that
+    //the params before it do not override
+    for(pStart = pParams; ; pStart = pStart->pNext)
+    {
+        pParam = pStart;
+        for(pPath = pPathParams; pPath; pPath = pPath->pNext)
+        {
+            nOverridden = 0;
+            for(pOwn = pParams; pOwn != pStart; pOwn = pOwn->pNext)
+            {
+                if(!strcmp(pOwn->pszName, pPath->pszName) &&
+                   !strcmp(pOwn->pszIn, pPath->pszIn))
+                {
+                    nOverridden = 1;
+                    break;
+                }
+            }
+            if(nOverridden)
+            {
+                continue;
+            }
+            if(!pParam || !coapi_params_equal(pParam, pPath))
+            {
+                break;
+            }
+            pParam = pParam->pNext;
+        }
+        if(!pPath && !pParam)
+        {
+            *ppEnd = pStart;
+            goto cleanup;
+        }
+        if(!pStart)
+        {
+            break;
+        }
+    }
+
+    dwError = ENOENT;
+    BAIL_ON_ERROR(dwError);
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppEnd)
+    {
+        *ppEnd = NULL;
+    }
+    goto cleanup;
+}
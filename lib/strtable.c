@@ -0,0 +1,358 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Interning table used while loading a spec. Identical names and values
+//are stored once in the arena and share a pointer. The table itself
+//only lives for the duration of the load.
+
+#include "includes.h"
+
+uint32_t
+coapi_string_hash(
+    const char *pszString,
+    size_t nLength
+    )
+{
+    uint32_t dwHash = 2166136261u;
+    size_t i = 0;
+
+    for(i = 0; i < nLength; ++i)
+    {
+        dwHash ^= (unsigned char)pszString[i];
+        dwHash *= 16777619u;
+    }
+    return dwHash;
+}
+
+void
+coapi_string_table_init(
+    PCOAPI_STRING_TABLE pTable
+    )
+{
+    if(pTable)
+    {
+        memset(pTable, 0, sizeof(*pTable));
+    }
+}
+
+void
+coapi_string_table_free(
+    PCOAPI_STRING_TABLE pTable
+    )
+{
+    if(!pTable)
+    {
+        return;
+    }
+    SAFE_FREE_MEMORY(pTable->pEntries);
+    memset(pTable, 0, sizeof(*pTable));
+}
+
+uint32_t
+coapi_string_table_grow(
+    PCOAPI_STRING_TABLE pTable
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_STRING_ENTRY pEntries = NULL;
+    size_t nCapacity = 0;
+    size_t i = 0;
+
+    if(!pTable)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    nCapacity = pTable->nCapacity ? pTable->nCapacity * 2 :
+                                    COAPI_STRING_TABLE_SIZE;
+
+    dwError = coapi_allocate_memory(sizeof(COAPI_STRING_ENTRY) * nCapacity,
+                                    (void **)&pEntries);
+    BAIL_ON_ERROR(dwError);
+
+    for(i = 0; i < pTable->nCapacity; ++i)
+    {
+        PCOAPI_STRING_ENTRY pEntry = &pTable->pEntries[i];
+        size_t nSlot = 0;
+
+        if(!pEntry->pszString)
+        {
+            continue;
+        }
+
+        nSlot = pEntry->dwHash & (nCapacity - 1);
+        while(pEntries[nSlot].pszString)
+        {
+            nSlot = (nSlot + 1) & (nCapacity - 1);
+        }
+        pEntries[nSlot] = *pEntry;
+    }
+
+    SAFE_FREE_MEMORY(pTable->pEntries);
+    pTable->pEntries = pEntries;
+    pTable->nCapacity = nCapacity;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+//the entry holding pszString, or the free slot where it would go.
+//the table must have at least one free slot.
+PCOAPI_STRING_ENTRY
+coapi_string_table_find_slot(
+    PCOAPI_STRING_TABLE pTable,
+    const char *pszString,
+    size_t nLength,
+    uint32_t dwHash
+    )
+{
+    size_t nSlot = dwHash & (pTable->nCapacity - 1);
+    PCOAPI_STRING_ENTRY pEntry = NULL;
+
+    for(pEntry = &pTable->pEntries[nSlot];
+        pEntry->pszString;
+        pEntry = &pTable->pEntries[nSlot])
+    {
+        if(pEntry->dwHash == dwHash &&
+           pEntry->nLength == nLength &&
+           !memcmp(pEntry->pszString, pszString, nLength))
+        {
+            break;
+        }
+        nSlot = (nSlot + 1) & (pTable->nCapacity - 1);
+    }
+    return pEntry;
+}
+
+//returns the stored copy of pszString. new strings are copied into the
+//arena unless nBorrow is set, in which case pszString itself is kept
+//and must live as long as the arena.
+uint32_t
+coapi_string_table_intern(
+    PCOAPI_STRING_TABLE pTable,
+    PCOAPI_ARENA pArena,
+    const char *pszString,
+    size_t nLength,
+    int nBorrow,
+    char **ppszString
+    )
+{
+    uint32_t dwError = 0;
+    uint32_t dwHash = 0;
+    PCOAPI_STRING_ENTRY pEntry = NULL;
+    char *pszInterned = NULL;
+
+    if(!pTable || !pArena || !pszString || !ppszString)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if((pTable->nCount + 1) * 2 > pTable->nCapacity)
+    {
+        dwError = coapi_string_table_grow(pTable);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwHash = coapi_string_hash(pszString, nLength);
+    pEntry = coapi_string_table_find_slot(pTable, pszString, nLength, dwHash);
+    if(pEntry->pszString)
+    {
+        *ppszString = pEntry->pszString;
+        goto cleanup;
+    }
+
+    if(nBorrow)
+    {
+        pszInterned = (char *)pszString;
+    }
+    else
+    {
+        dwError = coapi_arena_allocate_string_length(pArena,
+                                                     pszString,
+                                                     nLength,
+                                                     &pszInterned);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pEntry->pszString = pszInterned;
+    pEntry->nLength = nLength;
+    pEntry->dwHash = dwHash;
+    ++pTable->nCount;
+
+    *ppszString = pszInterned;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppszString)
+    {
+        *ppszString = NULL;
+    }
+    goto cleanup;
+}
+
+//interns any block of bytes, such as a param node or an options array.
+//new blocks are copied into the arena with its usual alignment. blocks
+//are only shared as a whole and must not be changed once interned.
+uint32_t
+coapi_string_table_intern_block(
+    PCOAPI_STRING_TABLE pTable,
+    PCOAPI_ARENA pArena,
+    const void *pData,
+    size_t nSize,
+    void **ppData
+    )
+{
+    uint32_t dwError = 0;
+    uint32_t dwHash = 0;
+    PCOAPI_STRING_ENTRY pEntry = NULL;
+    void *pCopy = NULL;
+
+    if(!pTable || !pArena || !pData || !nSize || !ppData)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if((pTable->nCount + 1) * 2 > pTable->nCapacity)
+    {
+        dwError = coapi_string_table_grow(pTable);
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwHash = coapi_string_hash(pData, nSize);
+    pEntry = coapi_string_table_find_slot(pTable, pData, nSize, dwHash);
+    if(pEntry->pszString)
+    {
+        *ppData = pEntry->pszString;
+        goto cleanup;
+    }
+
+    dwError = coapi_arena_allocate(pArena, nSize, &pCopy);
+    BAIL_ON_ERROR(dwError);
+
+    memcpy(pCopy, pData, nSize);
+
+    pEntry->pszString = pCopy;
+    pEntry->nLength = nSize;
+    pEntry->dwHash = dwHash;
+    ++pTable->nCount;
+
+    *ppData = pCopy;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppData)
+    {
+        *ppData = NULL;
+    }
+    goto cleanup;
+}
+
+//tables used as a map keep a value with each string.
+//returns ENOENT if pszString is not in the table.
+uint32_t
+coapi_string_table_get_value(
+    PCOAPI_STRING_TABLE pTable,
+    const char *pszString,
+    size_t nLength,
+    void **ppValue
+    )
+{
+    uint32_t dwError = 0;
+    PCOAPI_STRING_ENTRY pEntry = NULL;
+
+    if(!pTable || !pszString || !ppValue)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!pTable->nCount)
+    {
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    pEntry = coapi_string_table_find_slot(pTable,
+                                          pszString,
+                                          nLength,
+                                          coapi_string_hash(pszString, nLength));
+    if(!pEntry->pszString)
+    {
+        dwError = ENOENT;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    *ppValue = pEntry->pValue;
+
+cleanup:
+    return dwError;
+
+error:
+    if(ppValue)
+    {
+        *ppValue = NULL;
+    }
+    goto cleanup;
+}
+
+uint32_t
+coapi_string_table_set_value(
+    PCOAPI_STRING_TABLE pTable,
+    PCOAPI_ARENA pArena,
+    const char *pszString,
+    size_t nLength,
+    void *pValue
+    )
+{
+    uint32_t dwError = 0;
+    char *pszInterned = NULL;
+    PCOAPI_STRING_ENTRY pEntry = NULL;
+
+    if(!pTable || !pArena || !pszString)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    dwError = coapi_string_table_intern(pTable,
+                                        pArena,
+                                        pszString,
+                                        nLength,
+                                        0,
+                                        &pszInterned);
+    BAIL_ON_ERROR(dwError);
+
+    pEntry = coapi_string_table_find_slot(pTable,
+                                          pszInterned,
+                                          nLength,
+                                          coapi_string_hash(pszInterned,
+                                                            nLength));
+    pEntry->pValue = pValue;
+
+cleanup:
+    return dwError;
+
+error:
+    goto cleanup;
+}
@@ -0,0 +1,419 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+//on disk header of a compiled spec image.
+//pointers inside the image hold COAPI_IMAGE_PREFERRED_BASE + offset
+//and are listed in the relocation table at nRelocOffset.
+typedef struct _COAPI_IMAGE_HEADER_
+{
+    char szMagic[8];
+    uint32_t dwVersion;
+    uint32_t dwPointerSize;
+    uint32_t dwDefSize;
+    uint32_t dwModuleSize;
+    uint32_t dwEndPointSize;
+    uint32_t dwMethodSize;
+    uint32_t dwParamSize;
+    uint32_t dwReserved;
+    uint64_t nImageSize;
+    uint64_t nPreferredBase;
+    uint64_t nDefOffset;
+    uint64_t nRelocOffset;
+    uint64_t nRelocCount;
+    //length and hash of the spec text this image was compiled from
+    uint64_t nSourceLength;
+    uint64_t nSourceHash;
+    //real path of the spec, terminated. shared images are only used
+    //for the spec they were compiled from.
+    uint64_t nPathOffset;
+    uint64_t nPathLength;
+}COAPI_IMAGE_HEADER, *PCOAPI_IMAGE_HEADER;
+
+//on disk sidecar index of a spec, followed by its real path.
+//nTextHash is the text of the spec when it had this stat.
+typedef struct _COAPI_SPEC_INDEX_
+{
+    char szMagic[8];
+    uint32_t dwVersion;
+    uint32_t dwPathLength;
+    uint64_t nSourceDevice;
+    uint64_t nSourceInode;
+    uint64_t nSourceSize;
+    int64_t nSourceMtimeSec;
+    int64_t nSourceMtimeNsec;
+    int64_t nSourceCtimeSec;
+    int64_t nSourceCtimeNsec;
+    uint64_t nTextLength;
+    uint64_t nTextHash;
+}COAPI_SPEC_INDEX, *PCOAPI_SPEC_INDEX;
+
+typedef struct _COAPI_POINTER_ENTRY_
+{
+    const void *pKey;
+    size_t nValue;
+}COAPI_POINTER_ENTRY, *PCOAPI_POINTER_ENTRY;
+
+typedef struct _COAPI_POINTER_MAP_
+{
+    PCOAPI_POINTER_ENTRY pEntries;
+    size_t nCapacity;
+    size_t nCount;
+}COAPI_POINTER_MAP, *PCOAPI_POINTER_MAP;
+
+//state of coapi_image_check_def
+typedef struct _COAPI_IMAGE_CHECK_
+{
+    const char *pBase;
+    size_t nImageSize;
+    //kind of the node checked at each aligned offset, 0 for none
+    uint8_t *pNodes;
+}COAPI_IMAGE_CHECK, *PCOAPI_IMAGE_CHECK;
+
+//state of coapi_get_footprint
+typedef struct _COAPI_FOOTPRINT_WALK_
+{
+    PREST_API_DEF pApiDef;
+    PCOAPI_FOOTPRINT pFootprint;
+    size_t nEntryCapacity;
+    //nodes and strings counted so far
+    COAPI_POINTER_MAP stSeen;
+}COAPI_FOOTPRINT_WALK, *PCOAPI_FOOTPRINT_WALK;
+
+typedef struct _COAPI_IMAGE_WRITER_
+{
+    char *pData;
+    size_t nSize;
+    size_t nCapacity;
+    uint64_t *pRelocs;
+    size_t nRelocCount;
+    size_t nRelocCapacity;
+    //params and option arrays already written, by address in the def
+    COAPI_POINTER_MAP stWritten;
+}COAPI_IMAGE_WRITER, *PCOAPI_IMAGE_WRITER;
+
+typedef enum _COAPI_JSON_TYPE_
+{
+    JSON_TYPE_NONE = 0,
+    JSON_TYPE_OBJECT,
+    JSON_TYPE_ARRAY,
+    JSON_TYPE_STRING,
+    JSON_TYPE_NUMBER,
+    JSON_TYPE_TRUE,
+    JSON_TYPE_FALSE,
+    JSON_TYPE_NULL
+}COAPI_JSON_TYPE;
+
+//endpoints in module order, which is the order lookups try them in.
+//names and flags that scans compare are kept apart from the nodes.
+//methods of endpoint i are pdwEndPointMethods[i] up to
+//pdwEndPointMethods[i + 1], params of method i likewise.
+typedef struct _COAPI_API_TABLE_
+{
+    size_t nEndPointCount;
+    const char **ppszEndPointNames;
+    uint32_t *pdwEndPointNameLengths;
+    //for names with path subs, one more than the length before the
+    //first wildcard. 0 for names without.
+    uint32_t *pdwEndPointPrefixes;
+    uint32_t *pdwEndPointMethods;
+    PREST_API_ENDPOINT *ppEndPoints;
+    size_t nMethodCount;
+    uint32_t *pdwMethodParams;
+    PREST_API_METHOD *ppMethods;
+    //params of lazily loaded methods are not known when the table is
+    //built and are read from the method instead
+    int nHasParams;
+    size_t nParamCount;
+    PREST_API_PARAM *ppParams;
+    //serializes allocations from the def arena after the load, by
+    //coapi_load_method_details and coapi_unshare_method_params
+    pthread_mutex_t mutexDetails;
+    //methods whose details failed after strings were decoded in place,
+    //with the error to return again
+    COAPI_POINTER_MAP stFailedDetails;
+}COAPI_API_TABLE;
+
+typedef enum _COAPI_COMPRESSION_
+{
+    COAPI_COMPRESSION_NONE = 0,
+    COAPI_COMPRESSION_GZIP,
+    COAPI_COMPRESSION_ZSTD
+}COAPI_COMPRESSION;
+
+//anonymous mapping that decompressed spec text is written to. it can be
+//unmapped like a mapped spec file. see decompress.c
+typedef struct _COAPI_TEXT_BUFFER_
+{
+    char *pszText;
+    size_t nLength;
+    size_t nCapacity;
+}COAPI_TEXT_BUFFER, *PCOAPI_TEXT_BUFFER;
+
+typedef const char *
+(*PFN_COAPI_JSON_SCAN)(
+    const char *pszCur,
+    const char *pszEnd
+    );
+
+struct _COAPI_JSON_READER_;
+
+typedef uint32_t
+(*PFN_COAPI_JSON_SKIP)(
+    struct _COAPI_JSON_READER_ *pReader
+    );
+
+//scans of the json reader that have simd versions. see jsonscan.c
+typedef struct _COAPI_JSON_SCANNER_
+{
+    const char *pszName;
+    //first quote, backslash or control character
+    PFN_COAPI_JSON_SCAN pfnFindStringEnd;
+    //first character that is not white space
+    PFN_COAPI_JSON_SCAN pfnSkipSpace;
+    //past the object or array at the reader
+    PFN_COAPI_JSON_SKIP pfnSkipContainer;
+}COAPI_JSON_SCANNER, *PCOAPI_JSON_SCANNER;
+
+//what the grammar allows next in a container being skipped, see the
+//tables in jsonscan.c
+typedef enum _COAPI_JSON_EXPECT_
+{
+    JSON_EXPECT_NONE = 0,
+    //the container being skipped, and what follows it
+    JSON_EXPECT_ROOT,
+    JSON_EXPECT_ARRAY_VALUE_OR_CLOSE,
+    JSON_EXPECT_ARRAY_VALUE,
+    JSON_EXPECT_ARRAY_COMMA_OR_CLOSE,
+    JSON_EXPECT_OBJECT_KEY_OR_CLOSE,
+    JSON_EXPECT_OBJECT_KEY,
+    JSON_EXPECT_OBJECT_COLON,
+    JSON_EXPECT_OBJECT_VALUE,
+    JSON_EXPECT_OBJECT_COMMA_OR_CLOSE,
+    //a container closes, what its parent expects is on the stack
+    JSON_EXPECT_POP,
+    JSON_EXPECT_COUNT
+}COAPI_JSON_EXPECT;
+
+//tokens of the json grammar, bytes that start none are scalars
+typedef enum _COAPI_JSON_TOKEN_
+{
+    JSON_TOKEN_SCALAR = 0,
+    JSON_TOKEN_STRING,
+    JSON_TOKEN_COMMA,
+    JSON_TOKEN_COLON,
+    JSON_TOKEN_OBJECT_OPEN,
+    JSON_TOKEN_ARRAY_OPEN,
+    JSON_TOKEN_OBJECT_CLOSE,
+    JSON_TOKEN_ARRAY_CLOSE,
+    JSON_TOKEN_COUNT
+}COAPI_JSON_TOKEN;
+
+//a container being skipped. the stack has what each open container
+//expects once the one inside it closes.
+typedef struct _COAPI_JSON_SKIP_
+{
+    unsigned char nStack[COAPI_JSON_MAX_DEPTH + 1];
+    int nDepth;
+    COAPI_JSON_EXPECT nExpect;
+}COAPI_JSON_SKIP, *PCOAPI_JSON_SKIP;
+
+//bit masks of 64 bytes of text, see coapi_json_index_block
+typedef struct _COAPI_JSON_BLOCK_
+{
+    uint64_t nQuote;
+    //brackets, commas and colons
+    uint64_t nStructural;
+    uint64_t nSpace;
+    //backslashes and bytes below 0x20, which strings cannot have as is
+    uint64_t nSpecial;
+}COAPI_JSON_BLOCK, *PCOAPI_JSON_BLOCK;
+
+//pull reader over spec text. see jsonreader.c
+typedef struct _COAPI_JSON_READER_
+{
+    const char *pszStart;
+    const char *pszCur;
+    const char *pszEnd;
+    PCOAPI_JSON_SCANNER pScanner;
+    //set once a container has a member so the next one needs a comma
+    int nNeedComma;
+    //decode strings into the text itself, which must then be writable
+    int nInSitu;
+    //last decoded string
+    char *pszBuffer;
+    size_t nBufferSize;
+    size_t nLength;
+}COAPI_JSON_READER, *PCOAPI_JSON_READER;
+
+//json output in one growing buffer. see jsonwriter.c
+typedef struct _COAPI_JSON_WRITER_
+{
+    char *pszBuffer;
+    size_t nLength;
+    size_t nCapacity;
+    //the buffer is written here whenever it is full. -1 keeps all of
+    //the output in the buffer.
+    int fd;
+}COAPI_JSON_WRITER, *PCOAPI_JSON_WRITER;
+
+//the usable part of a block follows at COAPI_ARENA_HEADER_SIZE
+typedef struct _COAPI_ARENA_BLOCK_
+{
+    struct _COAPI_ARENA_BLOCK_ *pNext;
+    size_t nSize;
+    size_t nUsed;
+}COAPI_ARENA_BLOCK, *PCOAPI_ARENA_BLOCK;
+
+//allocation is from the first block
+typedef struct _COAPI_ARENA_
+{
+    PCOAPI_ARENA_BLOCK pBlocks;
+    //allocations made, for load stats
+    size_t nAllocations;
+    size_t nAllocatedBytes;
+}COAPI_ARENA;
+
+typedef struct _COAPI_STRING_ENTRY_
+{
+    char *pszString;
+    size_t nLength;
+    uint32_t dwHash;
+    //set when the table is used as a map
+    void *pValue;
+}COAPI_STRING_ENTRY, *PCOAPI_STRING_ENTRY;
+
+typedef struct _COAPI_STRING_TABLE_
+{
+    PCOAPI_STRING_ENTRY pEntries;
+    size_t nCapacity;
+    size_t nCount;
+}COAPI_STRING_TABLE, *PCOAPI_STRING_TABLE;
+
+//state of one spec load
+typedef struct _COAPI_LOADER_
+{
+    COAPI_JSON_READER stReader;
+    PREST_API_DEF pApiDef;
+    PCOAPI_ARENA pArena;
+    COAPI_STRING_TABLE stStrings;
+    //param nodes and option arrays shared by content
+    COAPI_STRING_TABLE stBlocks;
+    //params as read, before they are shared. freed with the loader.
+    PCOAPI_ARENA pTempArena;
+    //allocations of temp arenas already freed
+    size_t nTempAllocations;
+    size_t nTempAllocatedBytes;
+    //what this loader did, for the def's stats
+    COAPI_LOAD_STATS stStats;
+    //resolved parameter $refs by reference string
+    COAPI_STRING_TABLE stRefs;
+    //top level parameters and definitions objects, targets of $ref
+    const char *pszRefParameters;
+    const char *pszRefDefinitions;
+    int nRefDepth;
+    uint32_t dwFlags;
+    //module filter from the load options
+    int nFilterModule;
+    PREST_API_MODULE pFilterModule;
+    //last listed module, home of untagged and unknown tag endpoints
+    PREST_API_MODULE pDefaultModule;
+    //last endpoint of each module, so endpoints are appended in order
+    COAPI_POINTER_MAP stTails;
+    //reader buffer used while looking ahead at an endpoint's tag
+    char *pszScratch;
+    size_t nScratchSize;
+    //set by coapi_load_task_cancel, checked between paths
+    const int *pnCancel;
+}COAPI_LOADER, *PCOAPI_LOADER;
+
+//what one spec defines besides its paths
+typedef struct _COAPI_SPEC_
+{
+    char *pszHost;
+    char *pszBasePath;
+    int nHasSecureScheme;
+    int nNoModules;
+    PREST_API_MODULE pModules;
+}COAPI_SPEC, *PCOAPI_SPEC;
+
+//paths object split up for loading on several threads. endpoints and
+//their modules are kept by path index and added in that order.
+typedef struct _COAPI_PATH_INDEX_
+{
+    const char **ppszKeys;
+    size_t nCount;
+    size_t nCapacity;
+    PREST_API_ENDPOINT *ppEndPoints;
+    PREST_API_MODULE *ppModules;
+}COAPI_PATH_INDEX, *PCOAPI_PATH_INDEX;
+
+typedef struct _COAPI_PATH_WORKER_
+{
+    pthread_t nThread;
+    int nStarted;
+    COAPI_LOADER stLoader;
+    PCOAPI_PATH_INDEX pIndex;
+    size_t nStart;
+    size_t nEnd;
+    const char *pszBasePath;
+    PREST_API_MODULE pApiModules;
+    uint32_t dwError;
+}COAPI_PATH_WORKER, *PCOAPI_PATH_WORKER;
+
+typedef struct _COAPI_API_HANDLE_
+{
+    char *pszFile;
+    char *pszDir;
+    //file name part of pszFile
+    const char *pszName;
+    char *pszModule;
+    COAPI_LOAD_OPTIONS stOptions;
+    PMODULE_REG_MAP pRegMap;
+    //published def. readers count themselves in the slot of the epoch.
+    PREST_API_DEF pApiDef;
+    uint32_t dwEpoch;
+    uint32_t pdwReaders[2];
+    pthread_mutex_t mutexReload;
+    int nMutexInit;
+    pthread_t nWatcher;
+    int nWatcherStarted;
+    int nInotifyFd;
+    int pnStopPipe[2];
+}COAPI_API_HANDLE;
+
+typedef struct _COAPI_LOAD_TASK_
+{
+    char *pszFile;
+    char *pszModule;
+    COAPI_LOAD_OPTIONS stOptions;
+    PFN_COAPI_LOAD_DONE pfnDone;
+    void *pUserData;
+    pthread_t nThread;
+    int nThreadStarted;
+    //held by the thread that starts the task until it is done with the
+    //task. the load thread takes it before the callback can free it.
+    pthread_mutex_t mutexStart;
+    int nMutexInit;
+    //set when the callback frees the task, only read on the load thread
+    int nFreeOnExit;
+    int nCancel;
+    //set with release order once the result below is, then the pipe
+    //is written
+    int nDone;
+    int pnDonePipe[2];
+    uint32_t dwError;
+    PREST_API_DEF pApiDef;
+}COAPI_LOAD_TASK;
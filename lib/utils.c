@@ -14,54 +14,89 @@
 
 #include "includes.h"
 
+//maps pszFileName private and writable so callers can decode in place
+//without the changes reaching the file. the mapping is read front to back
+//once, so the kernel is told to read ahead and drop pages behind.
+//gzip and zstd files are decompressed into an anonymous mapping, which
+//is unmapped the same way.
 uint32_t
-coapi_file_read_all_text(
+coapi_file_map(
     const char *pszFileName,
-    char **ppszText
+    char **ppszText,
+    size_t *pnLength
     )
 {
     uint32_t dwError = 0;
-    FILE *fp = NULL;
-    char *pszText = NULL;
-    int nLength = 0;
-    int nBytesRead = 0;
+    int fd = -1;
+    struct stat stFile = {0};
+    char *pszText = MAP_FAILED;
+    size_t nLength = 0;
+    COAPI_COMPRESSION nCompression = COAPI_COMPRESSION_NONE;
 
-    if(!pszFileName || !ppszText)
+    if(!pszFileName || !ppszText || !pnLength)
     {
         dwError = EINVAL;
         BAIL_ON_ERROR(dwError);
     }
 
-    fp = fopen(pszFileName, "r");
-    if(!fp)
+    fd = open(pszFileName, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
     {
         dwError = ENOENT;
         BAIL_ON_ERROR(dwError);
     }
-    fseek(fp, 0, SEEK_END);
-    nLength = ftell(fp);
 
-    dwError = coapi_allocate_memory(nLength + 1, (void **)&pszText);
-    BAIL_ON_ERROR(dwError);
+    if(fstat(fd, &stFile))
+    {
+        dwError = errno;
+        BAIL_ON_ERROR(dwError);
+    }
+
+    if(!S_ISREG(stFile.st_mode) || stFile.st_size <= 0 ||
+       (uint64_t)stFile.st_size > SIZE_MAX)
+    {
+        dwError = EINVAL;
+        BAIL_ON_ERROR(dwError);
+    }
+    nLength = stFile.st_size;
 
-    if(fseek(fp, 0, SEEK_SET))
+    pszText = mmap(NULL,
+                   nLength,
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE,
+                   fd,
+                   0);
+    if(pszText == MAP_FAILED)
     {
         dwError = errno;
         BAIL_ON_ERROR(dwError);
     }
 
-    nBytesRead = fread(pszText, 1, nLength, fp);
-    if(nBytesRead != nLength)
+    madvise(pszText, nLength, MADV_SEQUENTIAL);
+
+    //compressed specs are replaced by their text
+    nCompression = coapi_get_compression(pszText, nLength);
+    if(nCompression != COAPI_COMPRESSION_NONE)
     {
-        dwError = EBADFD;
+        char *pszCompressed = pszText;
+        size_t nCompressedLength = nLength;
+
+        dwError = coapi_decompress_text(pszCompressed,
+                                        nCompressedLength,
+                                        nCompression,
+                                        &pszText,
+                                        &nLength);
+        munmap(pszCompressed, nCompressedLength);
         BAIL_ON_ERROR(dwError);
     }
 
     *ppszText = pszText;
+    *pnLength = nLength;
+
 cleanup:
-    if(fp)
+    if(fd >= 0)
     {
-        fclose(fp);
+        close(fd);
     }
     return dwError;
 
@@ -70,7 +105,21 @@ error:
     {
         *ppszText = NULL;
     }
-    SAFE_FREE_MEMORY(pszText);
+    if(pnLength)
+    {
+        *pnLength = 0;
+    }
     goto cleanup;
 }
 
+void
+coapi_file_unmap(
+    void *pText,
+    size_t nLength
+    )
+{
+    if(pText && nLength)
+    {
+        munmap(pText, nLength);
+    }
+}
@@ -0,0 +1,343 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks defs put together by the caller next to loaded ones: lookups
+//walk the lists, coapi_unshare_method_params gives EINVAL and
+//coapi_free_api_def frees them node by node. A loaded def is in an
+//arena, which also holds the copy of params a method shared with
+//another one once it is unshared. Its arrays index the same endpoints,
+//methods and params as its lists, in list order.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <copenapi.h>
+#include "check_util.h"
+
+//both methods have the same params, so they share one list
+static const char *_pszSpec =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\",\"paths\":{"
+"\"/items\":{"
+"\"get\":{\"parameters\":[{\"name\":\"limit\",\"in\":\"query\","
+"\"type\":\"integer\"}]},"
+"\"delete\":{\"parameters\":[{\"name\":\"limit\",\"in\":\"query\","
+"\"type\":\"integer\"}]}}}}";
+
+static PREST_API_PARAM
+make_param(
+    const char *pszName
+    )
+{
+    PREST_API_PARAM pParam = calloc(1, sizeof(REST_API_PARAM));
+
+    if(pParam)
+    {
+        pParam->pszName = strdup(pszName);
+        pParam->pszIn = strdup("query");
+        pParam->nType = RESTPARAM_STRING;
+    }
+    return pParam;
+}
+
+//one module with /v1/items. get and put have a param of their own
+//that ends with the path level param of the endpoint.
+static PREST_API_DEF
+make_api_def(
+    void
+    )
+{
+    PREST_API_DEF pApiDef = calloc(1, sizeof(REST_API_DEF));
+    PREST_API_MODULE pModule = calloc(1, sizeof(REST_API_MODULE));
+    PREST_API_ENDPOINT pEndPoint = calloc(1, sizeof(REST_API_ENDPOINT));
+    RESTMETHOD pnMethods[] = {METHOD_GET, METHOD_PUT};
+    size_t i = 0;
+
+    if(!pApiDef || !pModule || !pEndPoint)
+    {
+        free(pApiDef);
+        free(pModule);
+        free(pEndPoint);
+        return NULL;
+    }
+
+    pApiDef->pszHost = strdup("h");
+    pApiDef->pszBasePath = strdup("/v1");
+    pApiDef->pModules = pModule;
+    pModule->pszName = strdup("items");
+    pModule->pEndPoints = pEndPoint;
+    pEndPoint->pszName = strdup("/v1/items");
+    pEndPoint->pszActualName = strdup("/items");
+    pEndPoint->pszCommandName = strdup("items");
+    pEndPoint->pParams = make_param("trace");
+
+    for(i = 0; i < sizeof(pnMethods) / sizeof(pnMethods[0]); ++i)
+    {
+        PREST_API_METHOD pMethod = calloc(1, sizeof(REST_API_METHOD));
+
+        if(!pMethod)
+        {
+            break;
+        }
+        pMethod->nMethod = pnMethods[i];
+        pMethod->pszMethod = strdup(i ? "put" : "get");
+        pMethod->pParams = make_param(i ? "body" : "limit");
+        if(pMethod->pParams)
+        {
+            pMethod->pParams->pNext = pEndPoint->pParams;
+        }
+        pEndPoint->pMethods[pnMethods[i]] = pMethod;
+    }
+    return pApiDef;
+}
+
+static void
+check_caller_def(
+    void
+    )
+{
+    PREST_API_DEF pApiDef = make_api_def();
+    PREST_API_METHOD pMethod = NULL;
+    PREST_API_PARAM pParams = NULL;
+    size_t nCount = 0;
+
+    CHECK(pApiDef != NULL);
+    if(!pApiDef)
+    {
+        return;
+    }
+
+    CHECK(!coapi_find_method(pApiDef, "/v1/items", "put", &pMethod));
+    CHECK(pMethod && !strcmp(pMethod->pszMethod, "put"));
+
+    //params stay the caller's, and the def gets no arena
+    pParams = pMethod ? pMethod->pParams : NULL;
+    CHECK(coapi_unshare_method_params(pApiDef, pMethod) == EINVAL);
+    CHECK(pMethod && pMethod->pParams == pParams);
+    CHECK(!pApiDef->pArena);
+
+    //it has no arrays either
+    CHECK(coapi_get_method_count(pApiDef, &nCount) == EINVAL);
+
+    coapi_free_api_def(pApiDef);
+}
+
+//two modules, the second with two paths
+static const char *_pszTableSpec =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\","
+"\"tags\":[{\"name\":\"pet\"},{\"name\":\"store\"}],\"paths\":{"
+"\"/pet/{id}\":{"
+"\"parameters\":[{\"name\":\"id\",\"in\":\"path\",\"required\":true,"
+"\"type\":\"string\"}],"
+"\"get\":{\"tags\":[\"pet\"],\"parameters\":["
+"{\"name\":\"state\",\"in\":\"query\",\"type\":\"string\"}]},"
+"\"put\":{\"tags\":[\"pet\"]},"
+"\"delete\":{\"tags\":[\"pet\"]}},"
+"\"/order\":{\"post\":{\"tags\":[\"store\"],\"parameters\":["
+"{\"name\":\"body\",\"in\":\"body\",\"required\":true},"
+"{\"name\":\"count\",\"in\":\"query\",\"type\":\"integer\"}]}},"
+"\"/inventory\":{\"get\":{\"tags\":[\"store\"]}}}}";
+
+//the arrays have the nodes of the lists in list order
+static void
+check_table(
+    PREST_API_DEF pApiDef
+    )
+{
+    PREST_API_MODULE pModule = NULL;
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    PREST_API_ENDPOINT pIndexed = NULL;
+    PREST_API_METHOD pMethod = NULL;
+    PREST_API_PARAM pParam = NULL;
+    PREST_API_PARAM pIndexedParam = NULL;
+    size_t nEndPoint = 0;
+    size_t nMethod = 0;
+    size_t nFirst = 0;
+    size_t nCount = 0;
+    size_t nParam = 0;
+    int i = 0;
+
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        for(pEndPoint = pModule->pEndPoints;
+            pEndPoint;
+            pEndPoint = pEndPoint->pNext, ++nEndPoint)
+        {
+            CHECK(!coapi_get_endpoint(pApiDef, nEndPoint, &pIndexed) &&
+                  pIndexed == pEndPoint);
+            CHECK(!coapi_get_endpoint_methods(pApiDef,
+                                              nEndPoint,
+                                              &nFirst,
+                                              &nCount));
+            CHECK(nFirst == nMethod);
+
+            for(i = 0; i < METHOD_COUNT; ++i)
+            {
+                if(!pEndPoint->pMethods[i])
+                {
+                    continue;
+                }
+                //reads the params of a lazy method first
+                CHECK(!coapi_get_param_count(pApiDef, nMethod, &nCount));
+                CHECK(!coapi_get_method(pApiDef, nMethod, &pMethod) &&
+                      pMethod == pEndPoint->pMethods[i]);
+
+                for(pParam = pEndPoint->pMethods[i]->pParams, nParam = 0;
+                    pParam;
+                    pParam = pParam->pNext, ++nParam)
+                {
+                    CHECK(!coapi_get_param(pApiDef,
+                                           nMethod,
+                                           nParam,
+                                           &pIndexedParam) &&
+                          pIndexedParam == pParam);
+                }
+                CHECK(nCount == nParam);
+                CHECK(coapi_get_param(pApiDef,
+                                      nMethod,
+                                      nParam,
+                                      &pIndexedParam) == ERANGE);
+                ++nMethod;
+            }
+        }
+    }
+
+    CHECK(!coapi_get_endpoint_count(pApiDef, &nCount) && nCount == nEndPoint);
+    CHECK(!coapi_get_method_count(pApiDef, &nCount) && nCount == nMethod);
+    CHECK(coapi_get_endpoint(pApiDef, nEndPoint, &pIndexed) == ERANGE);
+    CHECK(coapi_get_method(pApiDef, nMethod, &pMethod) == ERANGE);
+}
+
+static void
+check_tables(
+    void
+    )
+{
+    char szFile[] = "/tmp/check_api_def.XXXXXX";
+    COAPI_LOAD_OPTIONS stOptions = {COAPI_LOAD_LAZY_METHODS};
+    PREST_API_DEF pApiDef = NULL;
+    size_t nCount = 0;
+    int fd = mkstemp(szFile);
+
+    if(fd < 0)
+    {
+        CHECK(fd >= 0);
+        return;
+    }
+    close(fd);
+    CHECK(!check_write_file(szFile, _pszTableSpec));
+
+    CHECK(!coapi_load_from_file(szFile, &pApiDef));
+    CHECK(!coapi_get_endpoint_count(pApiDef, &nCount) && nCount == 3);
+    CHECK(!coapi_get_method_count(pApiDef, &nCount) && nCount == 5);
+    if(pApiDef)
+    {
+        check_table(pApiDef);
+    }
+    coapi_free_api_def(pApiDef);
+    pApiDef = NULL;
+
+    CHECK(!coapi_load_from_file_ex(szFile, &stOptions, &pApiDef));
+    if(pApiDef)
+    {
+        check_table(pApiDef);
+    }
+    coapi_free_api_def(pApiDef);
+    pApiDef = NULL;
+
+    CHECK(!coapi_compile_file(szFile, NULL));
+    CHECK(!coapi_load_from_file(szFile, &pApiDef));
+    if(pApiDef)
+    {
+        CHECK(pApiDef->pImage != NULL);
+        check_table(pApiDef);
+    }
+    coapi_free_api_def(pApiDef);
+
+    check_remove_spec(szFile);
+}
+
+//what the arena of the def has allocated, 0 on error
+static size_t
+arena_bytes(
+    PREST_API_DEF pApiDef
+    )
+{
+    PCOAPI_FOOTPRINT pFootprint = NULL;
+    size_t nBytes = 0;
+
+    if(!coapi_get_footprint(pApiDef, &pFootprint))
+    {
+        nBytes = pFootprint->nArenaBytes;
+    }
+    coapi_free_footprint(pFootprint);
+    return nBytes;
+}
+
+static void
+check_loaded_def(
+    void
+    )
+{
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_METHOD pGet = NULL;
+    PREST_API_METHOD pDelete = NULL;
+    size_t nArenaBytes = 0;
+
+    CHECK(!coapi_load_from_string(_pszSpec, &pApiDef));
+    if(!pApiDef)
+    {
+        return;
+    }
+    CHECK(pApiDef->pArena != NULL);
+    nArenaBytes = arena_bytes(pApiDef);
+    CHECK(nArenaBytes > 0);
+
+    CHECK(!coapi_find_method(pApiDef, "/v1/items", "get", &pGet));
+    CHECK(!coapi_find_method(pApiDef, "/v1/items", "delete", &pDelete));
+    if(pGet && pDelete)
+    {
+        CHECK(pGet->pParams && pGet->pParams == pDelete->pParams);
+
+        CHECK(!coapi_unshare_method_params(pApiDef, pDelete));
+        CHECK(pDelete->pParams && pDelete->pParams != pGet->pParams);
+        CHECK(arena_bytes(pApiDef) >= nArenaBytes + sizeof(REST_API_PARAM));
+        CHECK(pDelete->pParams &&
+              !strcmp(pDelete->pParams->pszName, "limit") &&
+              !pDelete->pParams->pNext);
+
+        //the copy can be changed without the get params seeing it
+        if(pDelete->pParams)
+        {
+            pDelete->pParams->nRequired = 1;
+        }
+        CHECK(pGet->pParams && !pGet->pParams->nRequired);
+    }
+
+    coapi_free_api_def(pApiDef);
+}
+
+int
+main(
+    void
+    )
+{
+    check_caller_def();
+    check_loaded_def();
+    check_tables();
+
+    return nFailed ? 1 : 0;
+}
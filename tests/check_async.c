@@ -0,0 +1,342 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks async loads: waits with a timeout of 0 and -1, the poll fd,
+//the callback, a callback that frees its own task, also as soon as a
+//small load is done, cancelled serial and parallel loads and tasks
+//freed without a wait. Callbacks block on a gate pipe so that a task
+//is known to be running while it is checked.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <copenapi.h>
+#include "check_util.h"
+
+//enough paths that a load is still running when it is cancelled
+#define CHECK_ASYNC_PATHS 50000
+//loads of a small spec whose callback frees the task at once
+#define CHECK_ASYNC_FREE_ROUNDS 200
+
+typedef struct _CHECK_DONE_
+{
+    //the callback reads a byte from here before it returns
+    int pnGate[2];
+    //and writes one here after it returns the def
+    int pnDone[2];
+    PCOAPI_LOAD_TASK pTask;
+    uint32_t dwError;
+    size_t nEndPoints;
+    int nCalls;
+}CHECK_DONE, *PCHECK_DONE;
+
+static int
+write_spec(
+    const char *pszPath,
+    int nPaths
+    )
+{
+    FILE *fp = fopen(pszPath, "w");
+    int i = 0;
+
+    if(!fp)
+    {
+        return errno;
+    }
+    fprintf(fp, "{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\","
+                "\"tags\":[{\"name\":\"a\"},{\"name\":\"b\"}],\"paths\":{");
+    for(i = 0; i < nPaths; ++i)
+    {
+        fprintf(fp,
+                "%s\"/p%d/{id}\":{\"get\":{\"tags\":[\"%s\"],"
+                "\"summary\":\"get %d\",\"parameters\":[{\"name\":\"id\","
+                "\"in\":\"path\",\"required\":true,\"type\":\"string\"}]}}",
+                i ? "," : "",
+                i,
+                i % 2 ? "b" : "a",
+                i);
+    }
+    fprintf(fp, "}}\n");
+    return fclose(fp) ? errno : 0;
+}
+
+static int
+is_readable(
+    int fd
+    )
+{
+    struct pollfd stPoll = {0};
+
+    stPoll.fd = fd;
+    stPoll.events = POLLIN;
+    return poll(&stPoll, 1, 0) == 1 && (stPoll.revents & POLLIN);
+}
+
+static void
+on_done(
+    void *pUserData,
+    uint32_t dwError,
+    PREST_API_DEF pApiDef
+    )
+{
+    PCHECK_DONE pDone = pUserData;
+    char c = 0;
+
+    if(read(pDone->pnGate[0], &c, 1) != 1)
+    {
+        fprintf(stderr, "could not read the gate\n");
+    }
+    pDone->dwError = dwError;
+    pDone->nEndPoints = check_count_endpoints(pApiDef);
+    ++pDone->nCalls;
+    coapi_free_api_def(pApiDef);
+
+    //set by the test before it opens the gate
+    if(c == 'f')
+    {
+        coapi_load_task_free(pDone->pTask);
+    }
+    if(write(pDone->pnDone[1], "x", 1) != 1)
+    {
+        fprintf(stderr, "could not signal the test\n");
+    }
+}
+
+static void
+check_callback(
+    const char *pszFile
+    )
+{
+    CHECK_DONE stDone = {{0}};
+    PCOAPI_LOAD_TASK pTask = NULL;
+    PREST_API_DEF pApiDef = NULL;
+    char c = 0;
+
+    if(pipe(stDone.pnGate) || pipe(stDone.pnDone))
+    {
+        ++nFailed;
+        return;
+    }
+
+    CHECK(!coapi_load_from_file_async(pszFile,
+                                      NULL,
+                                      on_done,
+                                      &stDone,
+                                      &pTask));
+
+    //the callback has not returned, so the task is not done
+    CHECK(coapi_load_task_wait(pTask, 0, &pApiDef) == ETIMEDOUT);
+    CHECK(!pApiDef);
+    CHECK(!is_readable(coapi_load_task_get_fd(pTask)));
+
+    CHECK(write(stDone.pnGate[1], "g", 1) == 1);
+    CHECK(coapi_load_task_wait(pTask, -1, &pApiDef) == 0);
+    CHECK(is_readable(coapi_load_task_get_fd(pTask)));
+    CHECK(stDone.nCalls == 1);
+    CHECK(stDone.dwError == 0);
+    CHECK(stDone.nEndPoints == CHECK_ASYNC_PATHS);
+    //the def went to the callback
+    CHECK(!pApiDef);
+    coapi_load_task_free(pTask);
+
+    //a callback that frees its own task
+    CHECK(!coapi_load_from_file_async(pszFile,
+                                      NULL,
+                                      on_done,
+                                      &stDone,
+                                      &stDone.pTask));
+    CHECK(write(stDone.pnGate[1], "f", 1) == 1);
+    CHECK(read(stDone.pnDone[0], &c, 1) == 1);
+    CHECK(read(stDone.pnDone[0], &c, 1) == 1);
+    CHECK(stDone.nCalls == 2);
+    CHECK(stDone.nEndPoints == CHECK_ASYNC_PATHS);
+
+    close(stDone.pnGate[0]);
+    close(stDone.pnGate[1]);
+    close(stDone.pnDone[0]);
+    close(stDone.pnDone[1]);
+}
+
+//frees the task as soon as the load of a small spec is done, before
+//coapi_load_from_file_async may have returned
+static void
+on_done_free(
+    void *pUserData,
+    uint32_t dwError,
+    PREST_API_DEF pApiDef
+    )
+{
+    PCHECK_DONE pDone = pUserData;
+
+    coapi_load_task_free(pDone->pTask);
+    coapi_free_api_def(pApiDef);
+    pDone->dwError = dwError;
+    if(write(pDone->pnDone[1], "x", 1) != 1)
+    {
+        fprintf(stderr, "could not signal the test\n");
+    }
+}
+
+static void
+check_free_at_once(
+    const char *pszFile
+    )
+{
+    CHECK_DONE stDone = {{0}};
+    char c = 0;
+    int i = 0;
+
+    if(pipe(stDone.pnDone))
+    {
+        ++nFailed;
+        return;
+    }
+
+    for(i = 0; i < CHECK_ASYNC_FREE_ROUNDS; ++i)
+    {
+        CHECK(!coapi_load_from_file_async(pszFile,
+                                          NULL,
+                                          on_done_free,
+                                          &stDone,
+                                          &stDone.pTask));
+        CHECK(read(stDone.pnDone[0], &c, 1) == 1);
+        CHECK(stDone.dwError == 0);
+    }
+
+    close(stDone.pnDone[0]);
+    close(stDone.pnDone[1]);
+}
+
+static void
+check_wait(
+    const char *pszFile
+    )
+{
+    PCOAPI_LOAD_TASK pTask = NULL;
+    PREST_API_DEF pApiDef = NULL;
+    struct pollfd stPoll = {0};
+
+    CHECK(!coapi_load_from_file_async(pszFile, NULL, NULL, NULL, &pTask));
+
+    //the fd becomes readable when the load is done
+    stPoll.fd = coapi_load_task_get_fd(pTask);
+    stPoll.events = POLLIN;
+    CHECK(stPoll.fd >= 0);
+    CHECK(poll(&stPoll, 1, -1) == 1);
+
+    CHECK(coapi_load_task_wait(pTask, 0, &pApiDef) == 0);
+    CHECK(check_count_endpoints(pApiDef) == CHECK_ASYNC_PATHS);
+    coapi_free_api_def(pApiDef);
+
+    //only the first wait takes the def
+    CHECK(coapi_load_task_wait(pTask, -1, &pApiDef) == 0);
+    CHECK(!pApiDef);
+    coapi_load_task_free(pTask);
+
+    CHECK(coapi_load_task_wait(NULL, 0, &pApiDef) == EINVAL);
+    CHECK(coapi_load_task_get_fd(NULL) == -1);
+}
+
+static void
+check_cancel(
+    const char *pszFile,
+    uint32_t dwFlags
+    )
+{
+    COAPI_LOAD_OPTIONS stOptions = {0};
+    PCOAPI_LOAD_TASK pTask = NULL;
+    PREST_API_DEF pApiDef = NULL;
+
+    stOptions.dwFlags = dwFlags;
+    stOptions.dwThreads = 4;
+
+    CHECK(!coapi_load_from_file_async(pszFile,
+                                      &stOptions,
+                                      NULL,
+                                      NULL,
+                                      &pTask));
+    coapi_load_task_cancel(pTask);
+    CHECK(coapi_load_task_wait(pTask, -1, &pApiDef) == ECANCELED);
+    CHECK(!pApiDef);
+    coapi_load_task_free(pTask);
+}
+
+static void
+check_free_without_wait(
+    const char *pszFile
+    )
+{
+    PCOAPI_LOAD_TASK pTask = NULL;
+
+    //free waits for the load and frees the def no one took
+    CHECK(!coapi_load_from_file_async(pszFile, NULL, NULL, NULL, &pTask));
+    coapi_load_task_free(pTask);
+
+    CHECK(!coapi_load_from_file_async(pszFile, NULL, NULL, NULL, &pTask));
+    coapi_load_task_cancel(pTask);
+    coapi_load_task_free(pTask);
+
+    CHECK(coapi_load_from_file_async("/nonexistent/spec.json",
+                                     NULL,
+                                     NULL,
+                                     NULL,
+                                     &pTask) == 0);
+    CHECK(coapi_load_task_wait(pTask, -1, NULL) != 0);
+    coapi_load_task_free(pTask);
+}
+
+int
+main(
+    void
+    )
+{
+    char szFile[] = "/tmp/check_async.XXXXXX";
+    int fd = mkstemp(szFile);
+
+    if(fd < 0)
+    {
+        fprintf(stderr, "could not make a temp file\n");
+        return 1;
+    }
+    close(fd);
+
+    if(write_spec(szFile, 1))
+    {
+        fprintf(stderr, "could not write %s\n", szFile);
+        unlink(szFile);
+        return 1;
+    }
+
+    check_free_at_once(szFile);
+
+    if(write_spec(szFile, CHECK_ASYNC_PATHS))
+    {
+        fprintf(stderr, "could not write %s\n", szFile);
+        unlink(szFile);
+        return 1;
+    }
+
+    check_callback(szFile);
+    check_wait(szFile);
+    check_cancel(szFile, 0);
+    check_cancel(szFile, COAPI_LOAD_PARALLEL);
+    check_free_without_wait(szFile);
+
+    unlink(szFile);
+    return nFailed ? 1 : 0;
+}
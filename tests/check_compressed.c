@@ -0,0 +1,220 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks gzip and zstd spec files: each loads to the same def as the
+//plain spec, and cut short or without its library it fails to load.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+#include <copenapi.h>
+#include "check_util.h"
+
+static const char *_pszSpec =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\","
+"\"tags\":[{\"name\":\"pet\",\"description\":\"Pets\"}],\"paths\":{"
+"\"/pet/{id}\":{"
+"\"parameters\":[{\"name\":\"id\",\"in\":\"path\",\"required\":true,"
+"\"type\":\"string\"}],"
+"\"get\":{\"tags\":[\"pet\"],\"summary\":\"Find a pet\",\"parameters\":["
+"{\"name\":\"state\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"on\",\"off\"]}]},"
+"\"delete\":{\"tags\":[\"pet\"],\"summary\":\"Remove a pet\"}}}}";
+
+static char _szFile[] = "/tmp/check_compressed.XXXXXX";
+
+static char *_pszExpected = NULL;
+
+static int
+write_bytes(
+    const char *pszPath,
+    const void *pData,
+    size_t nLength
+    )
+{
+    FILE *fp = fopen(pszPath, "w");
+    int nRet = 0;
+
+    if(!fp)
+    {
+        return errno;
+    }
+    if(fwrite(pData, 1, nLength, fp) != nLength)
+    {
+        nRet = EIO;
+    }
+    return fclose(fp) ? errno : nRet;
+}
+
+static uint32_t
+load_dump(
+    uint32_t dwFlags,
+    char **ppszJson
+    )
+{
+    COAPI_LOAD_OPTIONS stOptions = {0};
+    PREST_API_DEF pApiDef = NULL;
+    uint32_t dwError = 0;
+
+    stOptions.dwFlags = dwFlags;
+    dwError = coapi_load_from_file_ex(_szFile, &stOptions, &pApiDef);
+    if(!dwError)
+    {
+        *ppszJson = check_dump_api_def(pApiDef);
+    }
+    coapi_free_api_def(pApiDef);
+    return dwError;
+}
+
+//pData is the whole compressed spec
+static void
+check_compressed(
+    const unsigned char *pData,
+    size_t nLength
+    )
+{
+    uint32_t pdwFlags[] =
+    {
+        0,
+        COAPI_LOAD_BORROW_STRINGS,
+        COAPI_LOAD_LAZY_METHODS,
+    };
+    char *pszJson = NULL;
+    size_t i = 0;
+
+    CHECK(!write_bytes(_szFile, pData, nLength));
+    for(i = 0; i < sizeof(pdwFlags) / sizeof(pdwFlags[0]); ++i)
+    {
+        pszJson = NULL;
+        CHECK(!load_dump(pdwFlags[i], &pszJson));
+        CHECK(pszJson && _pszExpected && !strcmp(pszJson, _pszExpected));
+        free(pszJson);
+    }
+
+    //cut short in the middle and at the end
+    CHECK(!write_bytes(_szFile, pData, nLength / 2));
+    CHECK(load_dump(0, &pszJson) != 0);
+    CHECK(!write_bytes(_szFile, pData, nLength - 1));
+    CHECK(load_dump(0, &pszJson) != 0);
+}
+
+static void
+check_gzip(
+    void
+    )
+{
+#ifdef HAVE_LIBZ
+    size_t nText = strlen(_pszSpec);
+    size_t nHalf = nText / 2;
+    size_t nCapacity = 2 * compressBound(nText) + 64;
+    unsigned char *pData = malloc(nCapacity);
+    size_t nLength = 0;
+    size_t i = 0;
+
+    if(!pData)
+    {
+        CHECK(pData != NULL);
+        return;
+    }
+
+    //two members, as gzip -c of the two halves writes them
+    for(i = 0; i < 2; ++i)
+    {
+        z_stream stStream = {0};
+
+        CHECK(deflateInit2(&stStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                           15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+        stStream.next_in = (unsigned char *)_pszSpec + (i ? nHalf : 0);
+        stStream.avail_in = i ? nText - nHalf : nHalf;
+        stStream.next_out = pData + nLength;
+        stStream.avail_out = nCapacity - nLength;
+        CHECK(deflate(&stStream, Z_FINISH) == Z_STREAM_END);
+        nLength = nCapacity - stStream.avail_out;
+        deflateEnd(&stStream);
+    }
+
+    check_compressed(pData, nLength);
+    free(pData);
+#else
+    char *pszJson = NULL;
+
+    CHECK(!write_bytes(_szFile, "\x1f\x8b\x08\x00", 4));
+    CHECK(load_dump(0, &pszJson) == ENOTSUP);
+#endif
+}
+
+static void
+check_zstd(
+    void
+    )
+{
+#ifdef HAVE_LIBZSTD
+    size_t nText = strlen(_pszSpec);
+    size_t nCapacity = ZSTD_compressBound(nText);
+    unsigned char *pData = malloc(nCapacity);
+    size_t nLength = 0;
+
+    if(!pData)
+    {
+        CHECK(pData != NULL);
+        return;
+    }
+    nLength = ZSTD_compress(pData, nCapacity, _pszSpec, nText, 1);
+    CHECK(!ZSTD_isError(nLength));
+    if(!ZSTD_isError(nLength))
+    {
+        check_compressed(pData, nLength);
+    }
+    free(pData);
+#else
+    char *pszJson = NULL;
+
+    CHECK(!write_bytes(_szFile, "\x28\xb5\x2f\xfd", 4));
+    CHECK(load_dump(0, &pszJson) == ENOTSUP);
+#endif
+}
+
+int
+main(
+    void
+    )
+{
+    int fd = mkstemp(_szFile);
+
+    if(fd < 0)
+    {
+        fprintf(stderr, "check_compressed: no temp file\n");
+        return 1;
+    }
+    close(fd);
+
+    CHECK(!check_write_file(_szFile, _pszSpec));
+    CHECK(!load_dump(0, &_pszExpected));
+
+    check_gzip();
+    check_zstd();
+
+    unlink(_szFile);
+    free(_pszExpected);
+    return nFailed ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks coapi_load_federation: modules named <spec>.<tag> and <spec>
+//for a spec without tags, EINVAL for duplicate spec names and options
+//it does not support, and lookups that find endpoints of every spec.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <copenapi.h>
+#include "check_util.h"
+
+static const char *_pszPetSpec =
+"{\"swagger\":\"2.0\",\"host\":\"pets.local\",\"basePath\":\"/pets\","
+"\"tags\":[{\"name\":\"pet\"},{\"name\":\"store\"}],"
+"\"paths\":{"
+"\"/pet/{id}\":{\"get\":{\"tags\":[\"pet\"],\"parameters\":["
+"{\"name\":\"id\",\"in\":\"path\",\"required\":true,\"type\":\"string\"}]}},"
+"\"/order\":{\"post\":{\"tags\":[\"store\"]}},"
+"\"/common\":{\"get\":{\"tags\":[\"pet\"]}}}}";
+
+static const char *_pszUserSpec =
+"{\"swagger\":\"2.0\",\"host\":\"users.local\",\"basePath\":\"/users\","
+"\"paths\":{"
+"\"/user\":{\"get\":{},\"put\":{}},"
+"\"/common\":{\"get\":{}}}}";
+
+int
+main(
+    void
+    )
+{
+    char szDir[] = "/tmp/check_federation.XXXXXX";
+    char szPets[256];
+    char szUsers[256];
+    COAPI_FEDERATED_SPEC pSpecs[2] = {{0}};
+    COAPI_LOAD_OPTIONS stOptions = {0};
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_MODULE pModule = NULL;
+    PREST_API_METHOD pMethod = NULL;
+    const char *ppszModules[] = {"petstore.pet", "petstore.store", "users"};
+    size_t i = 0;
+
+    if(!mkdtemp(szDir))
+    {
+        fprintf(stderr, "could not make a temp dir\n");
+        return 1;
+    }
+
+    snprintf(szPets, sizeof(szPets), "%s/pets.json", szDir);
+    snprintf(szUsers, sizeof(szUsers), "%s/users.json", szDir);
+    if(check_write_file(szPets, _pszPetSpec) ||
+       check_write_file(szUsers, _pszUserSpec))
+    {
+        fprintf(stderr, "could not write the specs to %s\n", szDir);
+        return 1;
+    }
+
+    pSpecs[0].pszName = "petstore";
+    pSpecs[0].pszFile = szPets;
+    pSpecs[1].pszName = "users";
+    pSpecs[1].pszFile = szUsers;
+
+    CHECK(coapi_load_federation(pSpecs, 2, NULL, &pApiDef) == 0);
+    if(pApiDef)
+    {
+        //modules in spec order, tagged ones prefixed with the spec name
+        pModule = pApiDef->pModules;
+        for(i = 0; i < 3; ++i)
+        {
+            CHECK(pModule && !strcmp(pModule->pszName, ppszModules[i]));
+            pModule = pModule ? pModule->pNext : NULL;
+        }
+        CHECK(!pModule);
+
+        CHECK(!coapi_find_module_by_name("petstore.pet",
+                                         pApiDef->pModules,
+                                         &pModule) &&
+              check_count_module_endpoints(pModule) == 2);
+        CHECK(!coapi_find_module_by_name("users",
+                                         pApiDef->pModules,
+                                         &pModule) &&
+              check_count_module_endpoints(pModule) == 2);
+
+        //the def is served from the first spec
+        CHECK(!strcmp(pApiDef->pszHost, "pets.local"));
+
+        //endpoint names keep the basePath of their own spec
+        CHECK(!coapi_find_method(pApiDef, "/pets/pet/42", "get", &pMethod));
+        CHECK(!coapi_find_method(pApiDef, "/pets/order", "post", &pMethod));
+        CHECK(!coapi_find_method(pApiDef, "/users/user", "put", &pMethod));
+        CHECK(!coapi_find_method(pApiDef, "/users/common", "get", &pMethod));
+        CHECK(!coapi_find_method(pApiDef, "/pets/common", "get", &pMethod));
+        CHECK(coapi_find_method(pApiDef, "/users/order", "post", &pMethod) ==
+              ENOENT);
+        coapi_free_api_def(pApiDef);
+        pApiDef = NULL;
+    }
+
+    //spec names are module prefixes and must be unique
+    pSpecs[1].pszName = "petstore";
+    CHECK(coapi_load_federation(pSpecs, 2, NULL, &pApiDef) == EINVAL);
+    CHECK(!pApiDef);
+    pSpecs[1].pszName = "users";
+
+    //every spec is unmapped once read and modules come from all of them
+    stOptions.dwFlags = COAPI_LOAD_BORROW_STRINGS;
+    CHECK(coapi_load_federation(pSpecs, 2, &stOptions, &pApiDef) == EINVAL);
+    stOptions.dwFlags = COAPI_LOAD_LAZY_METHODS;
+    CHECK(coapi_load_federation(pSpecs, 2, &stOptions, &pApiDef) == EINVAL);
+    stOptions.dwFlags = 0;
+    stOptions.pszModule = "pet";
+    CHECK(coapi_load_federation(pSpecs, 2, &stOptions, &pApiDef) == EINVAL);
+
+    unlink(szPets);
+    unlink(szUsers);
+    rmdir(szDir);
+
+    return nFailed ? 1 : 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks that the bytes of a footprint add up: the total is the def,
+//the index and the modules, and every entry has at least the bytes of
+//the entries below it, plus a node of its own above the params.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <copenapi.h>
+#include "check_util.h"
+
+//get and delete of /pet/{id} share their list, /order has options
+static const char *_pszSpec =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\","
+"\"tags\":[{\"name\":\"pet\",\"description\":\"Pets\"},"
+"{\"name\":\"store\"}],\"paths\":{"
+"\"/pet/{id}\":{"
+"\"parameters\":[{\"name\":\"id\",\"in\":\"path\",\"required\":true,"
+"\"type\":\"string\"}],"
+"\"get\":{\"tags\":[\"pet\"],\"summary\":\"Find a pet\",\"parameters\":["
+"{\"name\":\"fields\",\"in\":\"query\",\"type\":\"string\"}]},"
+"\"delete\":{\"tags\":[\"pet\"],\"parameters\":["
+"{\"name\":\"fields\",\"in\":\"query\",\"type\":\"string\"}]}},"
+"\"/order\":{\"post\":{\"tags\":[\"store\"],\"parameters\":["
+"{\"name\":\"kind\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"now\",\"later\"]}]}}}}";
+
+typedef struct _CHECK_BYTES_
+{
+    size_t nStringBytes;
+    size_t nOptionBytes;
+    size_t nNodeBytes;
+    size_t nSharedBytes;
+}CHECK_BYTES;
+
+//node of an entry that is not shared with others
+static size_t
+own_node_bytes(
+    COAPI_FOOTPRINT_LEVEL nLevel
+    )
+{
+    switch(nLevel)
+    {
+        case COAPI_FOOTPRINT_MODULE:
+            return sizeof(REST_API_MODULE);
+        case COAPI_FOOTPRINT_ENDPOINT:
+            return sizeof(REST_API_ENDPOINT);
+        case COAPI_FOOTPRINT_METHOD:
+            return sizeof(REST_API_METHOD);
+        default:
+            return 0;
+    }
+}
+
+//entries in def order: each one is the sum of the entries below it
+//and bytes of its own
+static void
+check_entries(
+    PCOAPI_FOOTPRINT pFootprint
+    )
+{
+    PCOAPI_FOOTPRINT_ENTRY pEntries = pFootprint->pEntries;
+    size_t nCount = pFootprint->nEntryCount;
+    CHECK_BYTES *pChildren = calloc(nCount + 1, sizeof(CHECK_BYTES));
+    size_t pnStack[COAPI_FOOTPRINT_LEVEL_COUNT] = {0};
+    size_t nDepth = 0;
+    size_t nModuleBytes = 0;
+    size_t i = 0;
+
+    if(!pChildren)
+    {
+        CHECK(pChildren != NULL);
+        return;
+    }
+
+    for(i = 0; i < nCount; ++i)
+    {
+        PCOAPI_FOOTPRINT_ENTRY pEntry = &pEntries[i];
+
+        CHECK(pEntry->nIndex == i);
+        while(nDepth && pEntries[pnStack[nDepth - 1]].nLevel >= pEntry->nLevel)
+        {
+            --nDepth;
+        }
+        if(pEntry->nLevel == COAPI_FOOTPRINT_MODULE)
+        {
+            CHECK(!nDepth);
+            nModuleBytes += pEntry->nStringBytes +
+                            pEntry->nOptionBytes +
+                            pEntry->nNodeBytes;
+        }
+        else if(nDepth)
+        {
+            CHECK_BYTES *pParent = &pChildren[pnStack[nDepth - 1]];
+
+            CHECK(pEntry->pszModule == pEntries[pnStack[0]].pszModule);
+            pParent->nStringBytes += pEntry->nStringBytes;
+            pParent->nOptionBytes += pEntry->nOptionBytes;
+            pParent->nNodeBytes += pEntry->nNodeBytes;
+            pParent->nSharedBytes += pEntry->nSharedBytes;
+        }
+        else
+        {
+            CHECK(nDepth > 0);
+        }
+        if(nDepth < COAPI_FOOTPRINT_LEVEL_COUNT)
+        {
+            pnStack[nDepth++] = i;
+        }
+    }
+
+    for(i = 0; i < nCount; ++i)
+    {
+        PCOAPI_FOOTPRINT_ENTRY pEntry = &pEntries[i];
+
+        CHECK(pEntry->nStringBytes >= pChildren[i].nStringBytes);
+        CHECK(pEntry->nOptionBytes >= pChildren[i].nOptionBytes);
+        CHECK(pEntry->nSharedBytes >= pChildren[i].nSharedBytes);
+        CHECK(pEntry->nNodeBytes >=
+              pChildren[i].nNodeBytes + own_node_bytes(pEntry->nLevel));
+    }
+
+    CHECK(pFootprint->nTotalBytes ==
+          pFootprint->nDefBytes + pFootprint->nIndexBytes + nModuleBytes);
+
+    free(pChildren);
+}
+
+static void
+check_sort(
+    PCOAPI_FOOTPRINT pFootprint
+    )
+{
+    size_t nTotal = pFootprint->nTotalBytes;
+    size_t nBytes = 0;
+    size_t nLast = SIZE_MAX;
+    size_t i = 0;
+
+    CHECK(!coapi_sort_footprint(pFootprint, COAPI_FOOTPRINT_SORT_TOTAL));
+    for(i = 0; i < pFootprint->nEntryCount; ++i)
+    {
+        PCOAPI_FOOTPRINT_ENTRY pEntry = &pFootprint->pEntries[i];
+
+        nBytes = pEntry->nStringBytes +
+                 pEntry->nOptionBytes +
+                 pEntry->nNodeBytes;
+        CHECK(nBytes <= nLast);
+        nLast = nBytes;
+    }
+    CHECK(pFootprint->nTotalBytes == nTotal);
+
+    //back in def order the sums hold as before
+    CHECK(!coapi_sort_footprint(pFootprint, COAPI_FOOTPRINT_SORT_DEF));
+    check_entries(pFootprint);
+
+    CHECK(coapi_sort_footprint(pFootprint, COAPI_FOOTPRINT_SORT_INVALID) ==
+          EINVAL);
+}
+
+int
+main(
+    void
+    )
+{
+    PREST_API_DEF pApiDef = NULL;
+    PCOAPI_FOOTPRINT pFootprint = NULL;
+    size_t nShared = 0;
+    size_t nOptions = 0;
+    size_t i = 0;
+
+    CHECK(!coapi_load_from_string(_pszSpec, &pApiDef));
+    CHECK(pApiDef && !coapi_get_footprint(pApiDef, &pFootprint));
+    if(!pFootprint)
+    {
+        coapi_free_api_def(pApiDef);
+        return 1;
+    }
+
+    //2 modules, 2 endpoints, 3 methods, the path param once and the
+    //params of get, delete and post
+    CHECK(pFootprint->nEntryCount == 2 + 2 + 3 + 1 + 3);
+    check_entries(pFootprint);
+
+    for(i = 0; i < pFootprint->nEntryCount; ++i)
+    {
+        nShared += pFootprint->pEntries[i].nSharedBytes;
+        nOptions += pFootprint->pEntries[i].nOptionBytes;
+    }
+    //delete has the list of get
+    CHECK(nShared > 0);
+    CHECK(nOptions > 0);
+
+    check_sort(pFootprint);
+
+    coapi_free_footprint(pFootprint);
+    coapi_free_api_def(pApiDef);
+    return nFailed ? 1 : 0;
+}
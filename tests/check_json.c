@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks strings with escapes decode the same with each json scanner and
+//with strings borrowed from the file, and that bad input fails to load
+//instead of reading past it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <copenapi.h>
+#include "check_util.h"
+
+//the escaped summary is followed by a long description, more input than
+//the summary needs
+#define CHECK_JSON_PAD 4096
+
+static const char *_pszSummary = "say \"hi\"\\\ttab\xc3\xa9/";
+
+static const char *_pszHead =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\","
+"\"paths\":{\"/pet\":{\"get\":{"
+"\"summary\":\"say \\\"hi\\\"\\\\\\ttab\\u00e9\\/\","
+"\"description\":\"";
+
+static const char *_pszTail = "\"}}}}";
+
+static const char *_ppszBad[] =
+{
+    //a byte past ascii where a value starts
+    "{\"swagger\":\"2.0\",\"host\":\"h\",\"x\":\xe9}",
+    //an escape cut short by the end of the input
+    "{\"swagger\":\"2.0\",\"host\":\"h\\",
+    "{\"swagger\":\"2.0\",\"host\":\"h\\u00",
+    //an unknown escape and a raw control char
+    "{\"swagger\":\"2.0\",\"host\":\"h\\q\"}",
+    "{\"swagger\":\"2.0\",\"host\":\"h\\n\x01\"}",
+    //numbers without digits
+    "{\"swagger\":\"2.0\",\"host\":\"h\",\"x\":-\xe9}",
+    "{\"swagger\":\"2.0\",\"host\":\"h\",\"x\":1.e5}",
+};
+
+static void
+check_summary(
+    const char *pszFile,
+    uint32_t dwFlags
+    )
+{
+    COAPI_LOAD_OPTIONS stOptions = {0};
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_METHOD pMethod = NULL;
+
+    stOptions.dwFlags = dwFlags;
+    CHECK(!coapi_load_from_file_ex(pszFile, &stOptions, &pApiDef));
+    if(pApiDef)
+    {
+        CHECK(!coapi_find_method(pApiDef, "/v1/pet", "get", &pMethod));
+        CHECK(pMethod && pMethod->pszSummary &&
+              !strcmp(pMethod->pszSummary, _pszSummary));
+        CHECK(pMethod && pMethod->pszDescription &&
+              strlen(pMethod->pszDescription) == CHECK_JSON_PAD);
+    }
+    coapi_free_api_def(pApiDef);
+}
+
+int
+main(
+    void
+    )
+{
+    char szFile[] = "/tmp/check_json.XXXXXX";
+    size_t nHead = strlen(_pszHead);
+    size_t nTail = strlen(_pszTail);
+    char *pszSpec = NULL;
+    PREST_API_DEF pApiDef = NULL;
+    size_t i = 0;
+    int fd = mkstemp(szFile);
+
+    pszSpec = malloc(nHead + CHECK_JSON_PAD + nTail + 1);
+    if(fd < 0 || !pszSpec)
+    {
+        fprintf(stderr, "check_json: no temp file\n");
+        return 1;
+    }
+    close(fd);
+
+    memcpy(pszSpec, _pszHead, nHead);
+    memset(pszSpec + nHead, 'x', CHECK_JSON_PAD);
+    memcpy(pszSpec + nHead + CHECK_JSON_PAD, _pszTail, nTail + 1);
+    CHECK(!check_write_file(szFile, pszSpec));
+
+    check_summary(szFile, 0);
+    check_summary(szFile, COAPI_LOAD_SCALAR_JSON);
+    check_summary(szFile, COAPI_LOAD_BORROW_STRINGS);
+    check_summary(szFile, COAPI_LOAD_LAZY_METHODS);
+
+    for(i = 0; i < sizeof(_ppszBad) / sizeof(_ppszBad[0]); ++i)
+    {
+        CHECK(coapi_load_from_string(_ppszBad[i], &pApiDef) != 0);
+        coapi_free_api_def(pApiDef);
+        pApiDef = NULL;
+    }
+
+    unlink(szFile);
+    free(pszSpec);
+    return nFailed != 0;
+}
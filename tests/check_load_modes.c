@@ -0,0 +1,398 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks that the load modes give the same def as a plain load of the
+//same spec, compared by writing each def back out as a spec.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <copenapi.h>
+#include "check_util.h"
+
+static const char *_pszSpec =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\","
+"\"tags\":[{\"name\":\"pet\",\"description\":\"Pets\"},"
+"{\"name\":\"store\",\"description\":\"Orders \\\"now\\\"\"}],"
+"\"paths\":{"
+"\"/pet/{id}\":{"
+"\"parameters\":[{\"name\":\"id\",\"in\":\"path\",\"required\":true,"
+"\"type\":\"string\"}],"
+"\"get\":{\"tags\":[\"pet\"],\"summary\":\"Find a pet\","
+"\"description\":\"Finds a pet by id\",\"parameters\":["
+"{\"name\":\"state\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"on\",\"off\"]}]},"
+"\"put\":{\"tags\":[\"pet\"],\"summary\":\"Update a pet\"}},"
+"\"/order\":{\"post\":{\"tags\":[\"store\"],\"summary\":\"Order\","
+"\"parameters\":[{\"name\":\"body\",\"in\":\"body\",\"required\":true},"
+"{\"name\":\"count\",\"in\":\"query\",\"type\":\"integer\"}]}}}}";
+
+//paths of the spec for parallel loads, enough for several threads
+#define CHECK_PARALLEL_PATHS 3000
+
+//the dump of a plain load that the other modes are compared with
+static char *_pszExpected = NULL;
+
+static char *
+dump_file(
+    const char *pszFile,
+    uint32_t dwFlags
+    )
+{
+    COAPI_LOAD_OPTIONS stOptions = {0};
+    PREST_API_DEF pApiDef = NULL;
+    char *pszJson = NULL;
+
+    stOptions.dwFlags = dwFlags;
+    if(!coapi_load_from_file_ex(pszFile, &stOptions, &pApiDef))
+    {
+        pszJson = check_dump_api_def(pApiDef);
+    }
+    coapi_free_api_def(pApiDef);
+    return pszJson;
+}
+
+static int
+same_as_plain(
+    const char *pszJson
+    )
+{
+    return pszJson && _pszExpected && !strcmp(pszJson, _pszExpected);
+}
+
+//borrowed strings are decoded in a private mapping of the file, which
+//is left as it was
+static void
+check_borrow_strings(
+    const char *pszFile
+    )
+{
+    COAPI_LOAD_OPTIONS stOptions = {COAPI_LOAD_BORROW_STRINGS};
+    PREST_API_DEF pApiDef = NULL;
+    PCOAPI_FOOTPRINT pFootprint = NULL;
+    char *pszJson = NULL;
+    size_t nLength = strlen(_pszSpec);
+    char *pszText = malloc(nLength + 1);
+    FILE *fp = NULL;
+
+    CHECK(!coapi_load_from_file_ex(pszFile, &stOptions, &pApiDef));
+    CHECK(pApiDef && !coapi_get_footprint(pApiDef, &pFootprint) &&
+          pFootprint->nBorrowedBytes > 0);
+    pszJson = check_dump_api_def(pApiDef);
+    CHECK(same_as_plain(pszJson));
+    coapi_free_footprint(pFootprint);
+    coapi_free_api_def(pApiDef);
+
+    fp = fopen(pszFile, "r");
+    CHECK(fp && pszText && fread(pszText, 1, nLength + 1, fp) == nLength &&
+          !memcmp(pszText, _pszSpec, nLength));
+
+    if(fp)
+    {
+        fclose(fp);
+    }
+    free(pszText);
+    free(pszJson);
+}
+
+//the string need not be terminated, what follows nLength is not read
+static void
+check_string_length(
+    void
+    )
+{
+    COAPI_LOAD_OPTIONS stOptions = {0};
+    PREST_API_DEF pApiDef = NULL;
+    size_t nLength = strlen(_pszSpec);
+    char *pszText = malloc(nLength + 2);
+    char *pszJson = NULL;
+
+    if(!pszText)
+    {
+        CHECK(pszText != NULL);
+        return;
+    }
+    memcpy(pszText, _pszSpec, nLength);
+    memcpy(pszText + nLength, "}x", 2);
+
+    CHECK(!coapi_load_from_string_ex(pszText, nLength, &stOptions, &pApiDef));
+    pszJson = check_dump_api_def(pApiDef);
+    CHECK(same_as_plain(pszJson));
+
+    free(pszJson);
+    coapi_free_api_def(pApiDef);
+    free(pszText);
+}
+
+//index of the first method named pszMethod, or the method count
+static size_t
+find_method_index(
+    PREST_API_DEF pApiDef,
+    const char *pszMethod
+    )
+{
+    PREST_API_METHOD pMethod = NULL;
+    size_t nCount = 0;
+    size_t i = 0;
+
+    coapi_get_method_count(pApiDef, &nCount);
+    for(i = 0; i < nCount; ++i)
+    {
+        if(!coapi_get_method(pApiDef, i, &pMethod) &&
+           pMethod->pszMethod && !strcmp(pMethod->pszMethod, pszMethod))
+        {
+            break;
+        }
+    }
+    return i;
+}
+
+//methods keep their object in the spec until a lookup reads it
+static void
+check_lazy_methods(
+    const char *pszFile
+    )
+{
+    COAPI_LOAD_OPTIONS stOptions = {COAPI_LOAD_LAZY_METHODS};
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_METHOD pGet = NULL;
+    PREST_API_METHOD pPut = NULL;
+    PREST_API_PARAM pParam = NULL;
+    size_t nPut = 0;
+    size_t nCount = 0;
+    char *pszJson = NULL;
+
+    CHECK(!coapi_load_from_file_ex(pszFile, &stOptions, &pApiDef));
+    if(!pApiDef)
+    {
+        return;
+    }
+
+    nPut = find_method_index(pApiDef, "put");
+    CHECK(!coapi_get_method(pApiDef, nPut, &pPut));
+    CHECK(pPut && pPut->pszDetails && !pPut->pszSummary);
+
+    CHECK(!coapi_find_method(pApiDef, "/v1/pet/7", "get", &pGet));
+    CHECK(pGet && !pGet->pszDetails && pGet->pszSummary &&
+          !strcmp(pGet->pszSummary, "Find a pet"));
+    CHECK(pGet && pGet->pParams &&
+          !strcmp(pGet->pParams->pszName, "state") &&
+          pGet->pParams->pNext &&
+          !strcmp(pGet->pParams->pNext->pszName, "id"));
+    //reading one method leaves the others alone
+    CHECK(pPut && pPut->pszDetails);
+
+    CHECK(!coapi_get_param_count(pApiDef, nPut, &nCount) && nCount == 1);
+    CHECK(pPut && !pPut->pszDetails && pPut->pszSummary);
+    CHECK(!coapi_get_param(pApiDef, nPut, 0, &pParam) &&
+          !strcmp(pParam->pszName, "id"));
+
+    pszJson = check_dump_api_def(pApiDef);
+    CHECK(same_as_plain(pszJson));
+    free(pszJson);
+    coapi_free_api_def(pApiDef);
+
+    pszJson = dump_file(pszFile,
+                        COAPI_LOAD_LAZY_METHODS | COAPI_LOAD_BORROW_STRINGS);
+    CHECK(same_as_plain(pszJson));
+    free(pszJson);
+}
+
+//params of every method, in method order. free with free.
+static size_t *
+get_param_counts(
+    PREST_API_DEF pApiDef,
+    size_t *pnMethods
+    )
+{
+    size_t *pnCounts = NULL;
+    size_t i = 0;
+
+    if(coapi_get_method_count(pApiDef, pnMethods) ||
+       !(pnCounts = calloc(*pnMethods + 1, sizeof(size_t))))
+    {
+        return NULL;
+    }
+    for(i = 0; i < *pnMethods; ++i)
+    {
+        coapi_get_param_count(pApiDef, i, &pnCounts[i]);
+    }
+    return pnCounts;
+}
+
+//summaries and descriptions are left out, the params are all there
+static void
+check_no_docs(
+    const char *pszFile,
+    uint32_t dwFlags
+    )
+{
+    COAPI_LOAD_OPTIONS stOptions = {0};
+    PREST_API_DEF pPlain = NULL;
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_MODULE pModule = NULL;
+    PREST_API_METHOD pMethod = NULL;
+    size_t *pnPlainCounts = NULL;
+    size_t *pnCounts = NULL;
+    size_t nPlainMethods = 0;
+    size_t nMethods = 0;
+    size_t i = 0;
+
+    CHECK(!coapi_load_from_file(pszFile, &pPlain));
+    stOptions.dwFlags = COAPI_LOAD_NO_DOCS | dwFlags;
+    CHECK(!coapi_load_from_file_ex(pszFile, &stOptions, &pApiDef));
+    if(!pPlain || !pApiDef)
+    {
+        coapi_free_api_def(pPlain);
+        coapi_free_api_def(pApiDef);
+        return;
+    }
+
+    CHECK(!coapi_find_method(pPlain, "/v1/pet/7", "get", &pMethod));
+    CHECK(pMethod && pMethod->pszSummary && pMethod->pszDescription);
+    CHECK(pPlain->pModules && pPlain->pModules->pszDescription);
+
+    CHECK(!coapi_find_method(pApiDef, "/v1/pet/7", "get", &pMethod));
+    CHECK(pMethod && !pMethod->pszSummary && !pMethod->pszDescription);
+
+    pnPlainCounts = get_param_counts(pPlain, &nPlainMethods);
+    pnCounts = get_param_counts(pApiDef, &nMethods);
+    CHECK(pnPlainCounts && pnCounts && nMethods == nPlainMethods &&
+          !memcmp(pnCounts, pnPlainCounts, nMethods * sizeof(size_t)));
+
+    for(i = 0; i < nMethods; ++i)
+    {
+        CHECK(!coapi_get_method(pApiDef, i, &pMethod) &&
+              !pMethod->pszSummary && !pMethod->pszDescription);
+    }
+    for(pModule = pApiDef->pModules; pModule; pModule = pModule->pNext)
+    {
+        CHECK(!pModule->pszDescription);
+    }
+
+    free(pnPlainCounts);
+    free(pnCounts);
+    coapi_free_api_def(pPlain);
+    coapi_free_api_def(pApiDef);
+}
+
+//writes a spec of CHECK_PARALLEL_PATHS paths in three modules
+static int
+write_big_spec(
+    const char *pszFile
+    )
+{
+    FILE *fp = fopen(pszFile, "w");
+    int i = 0;
+
+    if(!fp)
+    {
+        return 1;
+    }
+    fputs("{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\","
+          "\"paths\":{", fp);
+    for(i = 0; i < CHECK_PARALLEL_PATHS; ++i)
+    {
+        fprintf(fp,
+                "%s\"/m%d/r%d/{id}\":{"
+                "\"parameters\":[{\"name\":\"id\",\"in\":\"path\","
+                "\"required\":true,\"type\":\"string\"}],"
+                "\"get\":{\"tags\":[\"m%d\"],\"summary\":\"get %d\","
+                "\"parameters\":[{\"name\":\"q%d\",\"in\":\"query\","
+                "\"type\":\"string\",\"enum\":[\"a\",\"b\"]}]},"
+                "\"delete\":{\"tags\":[\"m%d\"]}}",
+                i ? "," : "", i % 3, i, i % 3, i, i % 7, i % 3);
+    }
+    fputs("}}", fp);
+    return fclose(fp) != 0;
+}
+
+//paths split across threads end up as a serial load has them
+static void
+check_parallel(
+    void
+    )
+{
+    char szFile[] = "/tmp/check_load_modes.XXXXXX";
+    char *pszSerial = NULL;
+    char *pszJson = NULL;
+    COAPI_LOAD_OPTIONS stOptions = {COAPI_LOAD_PARALLEL, NULL, 4};
+    PREST_API_DEF pApiDef = NULL;
+    int fd = mkstemp(szFile);
+
+    if(fd < 0)
+    {
+        CHECK(fd >= 0);
+        return;
+    }
+    close(fd);
+    CHECK(!write_big_spec(szFile));
+
+    pszSerial = dump_file(szFile, 0);
+    CHECK(pszSerial != NULL);
+
+    CHECK(!coapi_load_from_file_ex(szFile, &stOptions, &pApiDef));
+    CHECK(check_count_endpoints(pApiDef) == CHECK_PARALLEL_PATHS);
+    pszJson = check_dump_api_def(pApiDef);
+    CHECK(pszJson && pszSerial && !strcmp(pszJson, pszSerial));
+    free(pszJson);
+    coapi_free_api_def(pApiDef);
+
+    pszJson = dump_file(szFile,
+                        COAPI_LOAD_PARALLEL | COAPI_LOAD_BORROW_STRINGS);
+    CHECK(pszJson && pszSerial && !strcmp(pszJson, pszSerial));
+    free(pszJson);
+
+    pszJson = dump_file(szFile,
+                        COAPI_LOAD_PARALLEL | COAPI_LOAD_LAZY_METHODS);
+    CHECK(pszJson && pszSerial && !strcmp(pszJson, pszSerial));
+    free(pszJson);
+
+    unlink(szFile);
+    free(pszSerial);
+}
+
+int
+main(
+    void
+    )
+{
+    char szFile[] = "/tmp/check_load_modes.XXXXXX";
+    int fd = mkstemp(szFile);
+
+    if(fd < 0)
+    {
+        fprintf(stderr, "check_load_modes: no temp file\n");
+        return 1;
+    }
+    close(fd);
+    CHECK(!check_write_file(szFile, _pszSpec));
+
+    _pszExpected = dump_file(szFile, 0);
+    CHECK(_pszExpected != NULL);
+
+    check_borrow_strings(szFile);
+    check_string_length();
+    check_lazy_methods(szFile);
+    check_no_docs(szFile, 0);
+    check_no_docs(szFile, COAPI_LOAD_LAZY_METHODS);
+    check_no_docs(szFile, COAPI_LOAD_BORROW_STRINGS);
+    check_parallel();
+
+    unlink(szFile);
+    free(_pszExpected);
+    return nFailed ? 1 : 0;
+}
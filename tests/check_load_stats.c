@@ -0,0 +1,128 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks load stats of a json load against those of a load of the same
+//spec from its compiled image. Both count the same modules, endpoints
+//and methods. An image load reads no params and spends nothing on the
+//root or paths, whatever the load that compiled the image counted.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <copenapi.h>
+#include "check_util.h"
+
+static const char *_pszSpec =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\","
+"\"tags\":[{\"name\":\"pet\"},{\"name\":\"store\"}],\"paths\":{"
+"\"/pet/{id}\":{\"get\":{\"tags\":[\"pet\"],\"parameters\":["
+"{\"name\":\"id\",\"in\":\"path\",\"required\":true,\"type\":\"string\"},"
+"{\"name\":\"state\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"on\",\"off\"]}]},"
+"\"put\":{\"tags\":[\"pet\"]}},"
+"\"/order\":{\"post\":{\"tags\":[\"store\"],\"parameters\":["
+"{\"name\":\"body\",\"in\":\"body\",\"required\":true}]}}}}";
+
+static int
+is_zero_phase(
+    PCOAPI_LOAD_PHASE pPhase
+    )
+{
+    return !pPhase->nNanoseconds &&
+           !pPhase->nAllocations &&
+           !pPhase->nAllocatedBytes;
+}
+
+static int
+load_stats(
+    const char *pszFile,
+    int nImage,
+    PCOAPI_LOAD_STATS pStats
+    )
+{
+    PREST_API_DEF pApiDef = NULL;
+    int nRet = 1;
+
+    if(!coapi_load_from_file(pszFile, &pApiDef) &&
+       (pApiDef->pImage != NULL) == nImage &&
+       !coapi_get_load_stats(pApiDef, pStats))
+    {
+        nRet = 0;
+    }
+    coapi_free_api_def(pApiDef);
+    return nRet;
+}
+
+int
+main(
+    void
+    )
+{
+    char szFile[] = "/tmp/check_load_stats.XXXXXX";
+    COAPI_LOAD_STATS stJson = {0};
+    COAPI_LOAD_STATS stImage = {0};
+    COAPI_LOAD_STATS stAgain = {0};
+    int fd = mkstemp(szFile);
+
+    if(fd < 0)
+    {
+        fprintf(stderr, "could not make a temp file\n");
+        return 1;
+    }
+    close(fd);
+
+    if(check_write_file(szFile, _pszSpec))
+    {
+        fprintf(stderr, "could not write %s\n", szFile);
+        unlink(szFile);
+        return 1;
+    }
+
+    CHECK(!load_stats(szFile, 0, &stJson));
+    CHECK(stJson.nModules == 2);
+    CHECK(stJson.nEndPoints == 2);
+    CHECK(stJson.nMethods == 3);
+    CHECK(stJson.nParams == 3);
+    CHECK(stJson.nOptions == 2);
+    CHECK(stJson.stEndPoints.nAllocations > 0);
+    CHECK(stJson.stIndex.nAllocations > 0);
+
+    CHECK(!coapi_compile_file(szFile, NULL));
+
+    CHECK(!load_stats(szFile, 1, &stImage));
+    CHECK(stImage.nModules == stJson.nModules);
+    CHECK(stImage.nEndPoints == stJson.nEndPoints);
+    CHECK(stImage.nMethods == stJson.nMethods);
+    CHECK(!stImage.nParams && !stImage.nOptions);
+    CHECK(!stImage.nSharedParams && !stImage.nSharedParamBytes);
+    CHECK(is_zero_phase(&stImage.stRoot));
+    CHECK(is_zero_phase(&stImage.stModules));
+    CHECK(is_zero_phase(&stImage.stEndPoints));
+    CHECK(is_zero_phase(&stImage.stParams));
+    CHECK(is_zero_phase(&stImage.stPathNames));
+    CHECK(stImage.stIndex.nAllocations > 0);
+
+    //counts of a second image load are the same
+    CHECK(!load_stats(szFile, 1, &stAgain));
+    CHECK(stAgain.stIndex.nAllocations == stImage.stIndex.nAllocations);
+    CHECK(stAgain.stIndex.nAllocatedBytes ==
+          stImage.stIndex.nAllocatedBytes);
+    CHECK(stAgain.stRead.nAllocations == stImage.stRead.nAllocations);
+
+    check_remove_spec(szFile);
+    return nFailed ? 1 : 0;
+}
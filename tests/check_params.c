@@ -0,0 +1,504 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks the params of a loaded def: locations by enum, repeated names,
+//locations and enum options sharing one interned string, $refs
+//loading to the same def as the params written out in full, path
+//params shared by the methods of the path, and equal lists and ends of
+//lists stored once.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <copenapi.h>
+#include "check_util.h"
+
+//limit is on both paths with lists that differ after it
+static const char *_pszIntern =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\","
+"\"tags\":[{\"name\":\"pet\"}],\"paths\":{"
+"\"/a\":{\"get\":{\"tags\":[\"pet\"],\"parameters\":["
+"{\"name\":\"limit\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"low\",\"high\"]},"
+"{\"name\":\"token\",\"in\":\"header\",\"type\":\"string\"},"
+"{\"name\":\"file\",\"in\":\"formData\",\"type\":\"file\"},"
+"{\"name\":\"sid\",\"in\":\"cookie\",\"type\":\"string\"}]}},"
+"\"/b\":{\"get\":{\"tags\":[\"pet\"],\"parameters\":["
+"{\"name\":\"limit\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"low\",\"high\"]},"
+"{\"name\":\"body\",\"in\":\"body\",\"required\":true}]}}}}";
+
+//the params are given after the paths, a ref to a ref included
+static const char *_pszRefs =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\",\"paths\":{"
+"\"/a\":{\"get\":{\"parameters\":[{\"$ref\":\"#/parameters/limit\"},"
+"{\"name\":\"q\",\"in\":\"query\",\"type\":\"string\"}]}},"
+"\"/b\":{\"get\":{\"parameters\":[{\"$ref\":\"#/parameters/limit\"},"
+"{\"$ref\":\"#/parameters/size\"}]}}},"
+"\"parameters\":{"
+"\"limit\":{\"name\":\"limit\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"low\",\"high\"]},"
+"\"size\":{\"$ref\":\"#/definitions/size\"}},"
+"\"definitions\":{\"size\":{\"name\":\"size\",\"in\":\"header\","
+"\"type\":\"integer\",\"required\":true}}}";
+
+static const char *_pszFlat =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\",\"paths\":{"
+"\"/a\":{\"get\":{\"parameters\":["
+"{\"name\":\"limit\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"low\",\"high\"]},"
+"{\"name\":\"q\",\"in\":\"query\",\"type\":\"string\"}]}},"
+"\"/b\":{\"get\":{\"parameters\":["
+"{\"name\":\"limit\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"low\",\"high\"]},"
+"{\"name\":\"size\",\"in\":\"header\",\"type\":\"integer\","
+"\"required\":true}]}}}}";
+
+//refs that do not load
+static const char *_ppszBadRefs[] =
+{
+    "{\"swagger\":\"2.0\",\"host\":\"h\",\"paths\":{\"/a\":{\"get\":{"
+    "\"parameters\":[{\"$ref\":\"#/parameters/none\"}]}}},"
+    "\"parameters\":{}}",
+    "{\"swagger\":\"2.0\",\"host\":\"h\",\"paths\":{\"/a\":{\"get\":{"
+    "\"parameters\":[{\"$ref\":\"other.json#/parameters/a\"}]}}}}",
+    "{\"swagger\":\"2.0\",\"host\":\"h\",\"paths\":{\"/a\":{\"get\":{"
+    "\"parameters\":[{\"$ref\":\"#/parameters/a\"}]}}},"
+    "\"parameters\":{\"a\":{\"$ref\":\"#/parameters/b\"},"
+    "\"b\":{\"$ref\":\"#/parameters/a\"}}}",
+};
+
+//delete overrides the path param id with one of its own
+static const char *_pszPathParams =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\",\"paths\":{"
+"\"/pet/{id}\":{"
+"\"parameters\":[{\"name\":\"id\",\"in\":\"path\",\"required\":true,"
+"\"type\":\"string\"},"
+"{\"name\":\"trace\",\"in\":\"header\",\"type\":\"string\"}],"
+"\"get\":{\"parameters\":[{\"name\":\"state\",\"in\":\"query\","
+"\"type\":\"string\"}]},"
+"\"put\":{\"summary\":\"no params of its own\"},"
+"\"delete\":{\"parameters\":[{\"name\":\"id\",\"in\":\"path\","
+"\"required\":true,\"type\":\"integer\"}]}}}}";
+
+//a and b have equal lists, c ends with that list, d does not
+static const char *_pszShared =
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\",\"paths\":{"
+"\"/a\":{\"get\":{\"parameters\":["
+"{\"name\":\"limit\",\"in\":\"query\",\"type\":\"integer\"},"
+"{\"name\":\"page\",\"in\":\"query\",\"type\":\"integer\"}]}},"
+"\"/b\":{\"get\":{\"parameters\":["
+"{\"name\":\"limit\",\"in\":\"query\",\"type\":\"integer\"},"
+"{\"name\":\"page\",\"in\":\"query\",\"type\":\"integer\"}]}},"
+"\"/c\":{\"get\":{\"parameters\":["
+"{\"name\":\"sort\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"asc\",\"desc\"]},"
+"{\"name\":\"limit\",\"in\":\"query\",\"type\":\"integer\"},"
+"{\"name\":\"page\",\"in\":\"query\",\"type\":\"integer\"}]}},"
+"\"/d\":{\"get\":{\"parameters\":["
+"{\"name\":\"limit\",\"in\":\"query\",\"type\":\"integer\","
+"\"required\":true},"
+"{\"name\":\"sort\",\"in\":\"query\",\"type\":\"string\","
+"\"enum\":[\"asc\",\"desc\"]}]}}}}";
+
+static PREST_API_PARAM
+find_param(
+    PREST_API_METHOD pMethod,
+    const char *pszName
+    )
+{
+    PREST_API_PARAM pParam = NULL;
+
+    for(pParam = pMethod ? pMethod->pParams : NULL;
+        pParam;
+        pParam = pParam->pNext)
+    {
+        if(!strcmp(pParam->pszName, pszName))
+        {
+            break;
+        }
+    }
+    return pParam;
+}
+
+static void
+check_param_in(
+    void
+    )
+{
+    RESTPARAMIN nIn = RESTPARAMIN_INVALID;
+
+    CHECK(!coapi_get_rest_param_in("path", &nIn) && nIn == RESTPARAMIN_PATH);
+    CHECK(!coapi_get_rest_param_in("formData", &nIn) &&
+          nIn == RESTPARAMIN_FORMDATA);
+    CHECK(coapi_get_rest_param_in("cookie", &nIn) == ENOENT);
+    CHECK(coapi_get_rest_param_in(NULL, &nIn) == EINVAL);
+}
+
+static void
+check_intern(
+    const char *pszFile,
+    uint32_t dwFlags
+    )
+{
+    COAPI_LOAD_OPTIONS stOptions = {0};
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_METHOD pA = NULL;
+    PREST_API_METHOD pB = NULL;
+    PREST_API_PARAM pLimitA = NULL;
+    PREST_API_PARAM pLimitB = NULL;
+    PREST_API_PARAM pParam = NULL;
+
+    stOptions.dwFlags = dwFlags;
+    CHECK(!coapi_load_from_file_ex(pszFile, &stOptions, &pApiDef));
+    if(!pApiDef)
+    {
+        return;
+    }
+    CHECK(!coapi_find_method(pApiDef, "/v1/a", "get", &pA));
+    CHECK(!coapi_find_method(pApiDef, "/v1/b", "get", &pB));
+
+    pLimitA = find_param(pA, "limit");
+    pLimitB = find_param(pB, "limit");
+    CHECK(pLimitA && pLimitB && pLimitA != pLimitB);
+    if(pLimitA && pLimitB)
+    {
+        CHECK(pLimitA->nIn == RESTPARAMIN_QUERY);
+        CHECK(pLimitA->pszName == pLimitB->pszName);
+        CHECK(pLimitA->pszIn == pLimitB->pszIn);
+        CHECK(pLimitA->nOptionCount == 2 && pLimitB->nOptionCount == 2 &&
+              pLimitA->ppszOptions[1] == pLimitB->ppszOptions[1]);
+    }
+    CHECK(pA && pB && pA->pszMethod == pB->pszMethod);
+
+    pParam = find_param(pA, "token");
+    CHECK(pParam && pParam->nIn == RESTPARAMIN_HEADER);
+    pParam = find_param(pA, "file");
+    CHECK(pParam && pParam->nIn == RESTPARAMIN_FORMDATA);
+    pParam = find_param(pB, "body");
+    CHECK(pParam && pParam->nIn == RESTPARAMIN_BODY);
+    //unknown locations are kept as written
+    pParam = find_param(pA, "sid");
+    CHECK(pParam && pParam->nIn == RESTPARAMIN_INVALID &&
+          !strcmp(pParam->pszIn, "cookie"));
+
+    coapi_free_api_def(pApiDef);
+}
+
+static char *
+dump_file(
+    const char *pszFile,
+    uint32_t dwFlags
+    )
+{
+    COAPI_LOAD_OPTIONS stOptions = {0};
+    PREST_API_DEF pApiDef = NULL;
+    char *pszJson = NULL;
+
+    stOptions.dwFlags = dwFlags;
+    if(!coapi_load_from_file_ex(pszFile, &stOptions, &pApiDef))
+    {
+        pszJson = check_dump_api_def(pApiDef);
+    }
+    coapi_free_api_def(pApiDef);
+    return pszJson;
+}
+
+//every ref gets a node of its own that shares the strings and options
+//of its target
+static void
+check_ref_nodes(
+    const char *pszFile
+    )
+{
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_METHOD pA = NULL;
+    PREST_API_METHOD pB = NULL;
+    PREST_API_PARAM pLimitA = NULL;
+    PREST_API_PARAM pLimitB = NULL;
+    PREST_API_PARAM pSize = NULL;
+
+    CHECK(!coapi_load_from_file(pszFile, &pApiDef));
+    if(!pApiDef)
+    {
+        return;
+    }
+    CHECK(!coapi_find_method(pApiDef, "/v1/a", "get", &pA));
+    CHECK(!coapi_find_method(pApiDef, "/v1/b", "get", &pB));
+
+    pLimitA = find_param(pA, "limit");
+    pLimitB = find_param(pB, "limit");
+    CHECK(pLimitA && pLimitB && pLimitA != pLimitB);
+    if(pLimitA && pLimitB)
+    {
+        CHECK(pLimitA->pszName == pLimitB->pszName);
+        CHECK(pLimitA->ppszOptions == pLimitB->ppszOptions);
+    }
+    pSize = find_param(pB, "size");
+    CHECK(pSize && pSize->nIn == RESTPARAMIN_HEADER && pSize->nRequired);
+
+    coapi_free_api_def(pApiDef);
+}
+
+static void
+check_refs(
+    const char *pszFile,
+    const char *pszFlatFile
+    )
+{
+    uint32_t pdwFlags[] =
+    {
+        0,
+        COAPI_LOAD_BORROW_STRINGS,
+        COAPI_LOAD_LAZY_METHODS,
+        COAPI_LOAD_LAZY_METHODS | COAPI_LOAD_BORROW_STRINGS,
+        COAPI_LOAD_PARALLEL,
+    };
+    char *pszFlat = dump_file(pszFlatFile, 0);
+    char *pszJson = NULL;
+    char szImage[256];
+    PREST_API_DEF pApiDef = NULL;
+    size_t i = 0;
+
+    CHECK(pszFlat != NULL);
+    for(i = 0; i < sizeof(pdwFlags) / sizeof(pdwFlags[0]); ++i)
+    {
+        pszJson = dump_file(pszFile, pdwFlags[i]);
+        CHECK(pszJson && pszFlat && !strcmp(pszJson, pszFlat));
+        free(pszJson);
+    }
+
+    //the written spec has the refs resolved and loads to the same def
+    if(pszFlat && !coapi_load_from_string(pszFlat, &pApiDef))
+    {
+        pszJson = check_dump_api_def(pApiDef);
+        CHECK(pszJson && !strcmp(pszJson, pszFlat));
+        free(pszJson);
+    }
+    CHECK(pApiDef != NULL);
+    coapi_free_api_def(pApiDef);
+    pApiDef = NULL;
+
+    //and from the image of the spec
+    snprintf(szImage, sizeof(szImage), "%s.coapi", pszFile);
+    CHECK(!coapi_compile_file(pszFile, NULL));
+    pszJson = dump_file(pszFile, 0);
+    CHECK(pszJson && pszFlat && !strcmp(pszJson, pszFlat));
+    free(pszJson);
+    unlink(szImage);
+
+    check_ref_nodes(pszFile);
+
+    for(i = 0; i < sizeof(_ppszBadRefs) / sizeof(_ppszBadRefs[0]); ++i)
+    {
+        CHECK(coapi_load_from_string(_ppszBadRefs[i], &pApiDef) != 0);
+        coapi_free_api_def(pApiDef);
+        pApiDef = NULL;
+    }
+
+    free(pszFlat);
+}
+
+static size_t
+count_text(
+    const char *pszText,
+    const char *pszFind
+    )
+{
+    size_t nCount = 0;
+
+    while(pszText && (pszText = strstr(pszText, pszFind)) != NULL)
+    {
+        ++nCount;
+        ++pszText;
+    }
+    return nCount;
+}
+
+//the methods end with the nodes of the path list. delete overrides id
+//and ends with trace, the equal end of the path list.
+static void
+check_path_nodes(
+    PREST_API_DEF pApiDef
+    )
+{
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    PREST_API_METHOD pGet = NULL;
+    PREST_API_METHOD pPut = NULL;
+    PREST_API_METHOD pDelete = NULL;
+    PREST_API_PARAM pPathParams = NULL;
+    PREST_API_PARAM pParam = NULL;
+
+    CHECK(!coapi_get_endpoint(pApiDef, 0, &pEndPoint));
+    CHECK(!coapi_find_method(pApiDef, "/v1/pet/7", "get", &pGet));
+    CHECK(!coapi_find_method(pApiDef, "/v1/pet/7", "put", &pPut));
+    CHECK(!coapi_find_method(pApiDef, "/v1/pet/7", "delete", &pDelete));
+    if(!pEndPoint || !pGet || !pPut || !pDelete)
+    {
+        return;
+    }
+    pPathParams = pEndPoint->pParams;
+
+    CHECK(pPathParams && !strcmp(pPathParams->pszName, "id") &&
+          pPathParams->pNext &&
+          !strcmp(pPathParams->pNext->pszName, "trace"));
+    CHECK(pGet->pParams && !strcmp(pGet->pParams->pszName, "state") &&
+          pGet->pParams->pNext == pPathParams);
+    CHECK(pPut->pParams == pPathParams);
+
+    pParam = pDelete->pParams;
+    CHECK(pParam && pParam->nType == RESTPARAM_INTEGER);
+    pParam = pParam ? pParam->pNext : NULL;
+    CHECK(pParam && pParam == pPathParams->pNext);
+}
+
+static void
+check_path_params(
+    const char *pszFile
+    )
+{
+    PREST_API_DEF pApiDef = NULL;
+    char *pszJson = NULL;
+    char *pszAgain = NULL;
+    char szImage[256];
+
+    CHECK(!coapi_load_from_file(pszFile, &pApiDef));
+    if(pApiDef)
+    {
+        check_path_nodes(pApiDef);
+        pszJson = check_dump_api_def(pApiDef);
+    }
+    coapi_free_api_def(pApiDef);
+    pApiDef = NULL;
+
+    //written once at path level, and read back as they were
+    CHECK(count_text(pszJson, "\"trace\"") == 1);
+    CHECK(pszJson && !coapi_load_from_string(pszJson, &pApiDef));
+    if(pApiDef)
+    {
+        check_path_nodes(pApiDef);
+        pszAgain = check_dump_api_def(pApiDef);
+        CHECK(pszAgain && !strcmp(pszAgain, pszJson));
+        free(pszAgain);
+    }
+    coapi_free_api_def(pApiDef);
+    pApiDef = NULL;
+
+    snprintf(szImage, sizeof(szImage), "%s.coapi", pszFile);
+    CHECK(!coapi_compile_file(pszFile, NULL));
+    CHECK(!coapi_load_from_file(pszFile, &pApiDef));
+    if(pApiDef)
+    {
+        CHECK(pApiDef->pImage != NULL);
+        check_path_nodes(pApiDef);
+        pszAgain = check_dump_api_def(pApiDef);
+        CHECK(pszAgain && pszJson && !strcmp(pszAgain, pszJson));
+        free(pszAgain);
+    }
+    coapi_free_api_def(pApiDef);
+    unlink(szImage);
+
+    pszAgain = dump_file(pszFile, COAPI_LOAD_LAZY_METHODS);
+    CHECK(pszAgain && pszJson && !strcmp(pszAgain, pszJson));
+    free(pszAgain);
+
+    free(pszJson);
+}
+
+static void
+check_shared_lists(
+    void
+    )
+{
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_METHOD ppMethods[4] = {NULL};
+    const char *ppszPaths[] = {"/v1/a", "/v1/b", "/v1/c", "/v1/d"};
+    COAPI_LOAD_STATS stStats = {0};
+    PREST_API_PARAM pSortC = NULL;
+    PREST_API_PARAM pSortD = NULL;
+    size_t i = 0;
+
+    CHECK(!coapi_load_from_string(_pszShared, &pApiDef));
+    if(!pApiDef)
+    {
+        return;
+    }
+    for(i = 0; i < sizeof(ppszPaths) / sizeof(ppszPaths[0]); ++i)
+    {
+        CHECK(!coapi_find_method(pApiDef, ppszPaths[i], "get", &ppMethods[i]));
+        if(!ppMethods[i] || !ppMethods[i]->pParams)
+        {
+            coapi_free_api_def(pApiDef);
+            return;
+        }
+    }
+
+    CHECK(ppMethods[0]->pParams == ppMethods[1]->pParams);
+    CHECK(ppMethods[2]->pParams->pNext == ppMethods[0]->pParams);
+    CHECK(ppMethods[3]->pParams != ppMethods[0]->pParams);
+
+    //equal options arrays are stored once as well
+    pSortC = find_param(ppMethods[2], "sort");
+    pSortD = find_param(ppMethods[3], "sort");
+    CHECK(pSortC && pSortD && pSortC != pSortD &&
+          pSortC->ppszOptions == pSortD->ppszOptions);
+
+    //b has two nodes of a, c two more
+    CHECK(!coapi_get_load_stats(pApiDef, &stStats));
+    CHECK(stStats.nSharedParams >= 4);
+    CHECK(stStats.nSharedParamBytes >= 4 * sizeof(REST_API_PARAM));
+
+    coapi_free_api_def(pApiDef);
+}
+
+int
+main(
+    void
+    )
+{
+    char szFile[] = "/tmp/check_params.XXXXXX";
+    char szFlatFile[] = "/tmp/check_params.XXXXXX";
+    int fd = mkstemp(szFile);
+    int fdFlat = mkstemp(szFlatFile);
+
+    if(fd < 0 || fdFlat < 0)
+    {
+        fprintf(stderr, "check_params: no temp file\n");
+        return 1;
+    }
+    close(fd);
+    close(fdFlat);
+
+    check_param_in();
+
+    CHECK(!check_write_file(szFile, _pszIntern));
+    check_intern(szFile, 0);
+    check_intern(szFile, COAPI_LOAD_BORROW_STRINGS);
+
+    CHECK(!check_write_file(szFile, _pszRefs));
+    CHECK(!check_write_file(szFlatFile, _pszFlat));
+    check_refs(szFile, szFlatFile);
+
+    CHECK(!check_write_file(szFile, _pszPathParams));
+    check_path_params(szFile);
+
+    check_shared_lists();
+
+    check_remove_spec(szFile);
+    unlink(szFlatFile);
+    return nFailed ? 1 : 0;
+}
@@ -0,0 +1,280 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks reloadable api defs. Reader threads acquire and release the
+//def in a loop while the spec is rewritten in place and replaced by a
+//rename, and check that every def they get is complete: its host names
+//a generation, it has the endpoints of that generation and its handler
+//is mapped. A spec that does not load, seen by the watcher or given to
+//coapi_api_handle_reload, must leave the def as it was.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <copenapi.h>
+#include "check_util.h"
+
+#define CHECK_RELOAD_READERS 4
+#define CHECK_RELOAD_GENERATIONS 6
+//longest wait for the watcher to pick up a change
+#define CHECK_RELOAD_WAIT_MS 10000
+
+typedef struct _CHECK_READER_
+{
+    PCOAPI_API_HANDLE pHandle;
+    pthread_t nThread;
+    size_t nAcquires;
+    size_t nBad;
+}CHECK_READER, *PCHECK_READER;
+
+static int nStop = 0;
+static char szDir[] = "/tmp/check_reload.XXXXXX";
+static char szSpec[256];
+static char szTemp[256];
+
+static uint32_t
+items_get(
+    void *pIn,
+    void **ppOut
+    )
+{
+    return 0;
+}
+
+static REST_MODULE _items_rest_module[] =
+{
+    {
+        "/v1/items",
+        {items_get, NULL, NULL, NULL}
+    },
+    {0}
+};
+
+static uint32_t
+items_get_registration(
+    PREST_MODULE *ppRestModule
+    )
+{
+    *ppRestModule = _items_rest_module;
+    return 0;
+}
+
+static MODULE_REG_MAP _stRegMap[] =
+{
+    {"items", items_get_registration},
+    {NULL, NULL}
+};
+
+//generation nGen has nGen + 1 endpoints and its host is gen<nGen>
+static int
+write_generation(
+    const char *pszPath,
+    int nGen
+    )
+{
+    FILE *fp = fopen(pszPath, "w");
+    int i = 0;
+
+    if(!fp)
+    {
+        return errno;
+    }
+    fprintf(fp,
+            "{\"swagger\":\"2.0\",\"host\":\"gen%d\",\"basePath\":\"/v1\","
+            "\"tags\":[{\"name\":\"items\"}],\"paths\":{"
+            "\"/items\":{\"get\":{\"tags\":[\"items\"]}}",
+            nGen);
+    for(i = 0; i < nGen; ++i)
+    {
+        fprintf(fp,
+                ",\"/extra%d\":{\"get\":{\"tags\":[\"items\"],"
+                "\"summary\":\"extra %d of gen %d\"}}",
+                i,
+                i,
+                nGen);
+    }
+    fprintf(fp, "}}\n");
+    return fclose(fp) ? errno : 0;
+}
+
+//generation of a complete def, -1 for anything else
+static int
+get_generation(
+    PREST_API_DEF pApiDef
+    )
+{
+    PREST_API_METHOD pMethod = NULL;
+    int nGen = -1;
+
+    if(!pApiDef ||
+       !pApiDef->pszHost ||
+       sscanf(pApiDef->pszHost, "gen%d", &nGen) != 1 ||
+       check_count_endpoints(pApiDef) != (size_t)nGen + 1 ||
+       coapi_find_handler(pApiDef, "/v1/items", "get", &pMethod) ||
+       pMethod->pFnImpl != items_get)
+    {
+        return -1;
+    }
+    return nGen;
+}
+
+static void *
+read_loop(
+    void *pArg
+    )
+{
+    PCHECK_READER pReader = pArg;
+    PREST_API_DEF pApiDef = NULL;
+    int nSlot = 0;
+
+    while(!__atomic_load_n(&nStop, __ATOMIC_RELAXED))
+    {
+        if(coapi_api_handle_acquire(pReader->pHandle, &pApiDef, &nSlot))
+        {
+            ++pReader->nBad;
+            continue;
+        }
+        if(get_generation(pApiDef) < 0)
+        {
+            ++pReader->nBad;
+        }
+        coapi_api_handle_release(pReader->pHandle, nSlot);
+        ++pReader->nAcquires;
+    }
+    return NULL;
+}
+
+static int
+current_generation(
+    PCOAPI_API_HANDLE pHandle
+    )
+{
+    PREST_API_DEF pApiDef = NULL;
+    int nSlot = 0;
+    int nGen = -1;
+
+    if(!coapi_api_handle_acquire(pHandle, &pApiDef, &nSlot))
+    {
+        nGen = get_generation(pApiDef);
+        coapi_api_handle_release(pHandle, nSlot);
+    }
+    return nGen;
+}
+
+static int
+wait_for_generation(
+    PCOAPI_API_HANDLE pHandle,
+    int nGen
+    )
+{
+    int nWaited = 0;
+
+    for(nWaited = 0; nWaited < CHECK_RELOAD_WAIT_MS; nWaited += 10)
+    {
+        if(current_generation(pHandle) == nGen)
+        {
+            return 1;
+        }
+        usleep(10000);
+    }
+    return 0;
+}
+
+int
+main(
+    void
+    )
+{
+    PCOAPI_API_HANDLE pHandle = NULL;
+    CHECK_READER pReaders[CHECK_RELOAD_READERS] = {{0}};
+    int nGen = 0;
+    int i = 0;
+
+    if(!mkdtemp(szDir))
+    {
+        fprintf(stderr, "could not make a temp dir\n");
+        return 1;
+    }
+    snprintf(szSpec, sizeof(szSpec), "%s/spec.json", szDir);
+    snprintf(szTemp, sizeof(szTemp), "%s/spec.json.new", szDir);
+
+    CHECK(!write_generation(szSpec, 0));
+    CHECK(!coapi_api_handle_open(szSpec, NULL, _stRegMap, &pHandle));
+    if(!pHandle)
+    {
+        return 1;
+    }
+    CHECK(current_generation(pHandle) == 0);
+
+    for(i = 0; i < CHECK_RELOAD_READERS; ++i)
+    {
+        pReaders[i].pHandle = pHandle;
+        CHECK(!pthread_create(&pReaders[i].nThread,
+                              NULL,
+                              read_loop,
+                              &pReaders[i]));
+    }
+
+    //odd generations replace the file, even ones rewrite it in place
+    for(nGen = 1; nGen <= CHECK_RELOAD_GENERATIONS; ++nGen)
+    {
+        if(nGen % 2)
+        {
+            CHECK(!write_generation(szTemp, nGen));
+            CHECK(!rename(szTemp, szSpec));
+        }
+        else
+        {
+            CHECK(!write_generation(szSpec, nGen));
+        }
+        CHECK(wait_for_generation(pHandle, nGen));
+    }
+    --nGen;
+
+    //the watcher fails to load a broken spec and keeps the def
+    CHECK(!check_write_file(szTemp, "{\"swagger\":\"2.0\",\"paths\":{"));
+    CHECK(!rename(szTemp, szSpec));
+    usleep(500000);
+    CHECK(current_generation(pHandle) == nGen);
+
+    //so does a reload that is asked for
+    CHECK(coapi_api_handle_reload(pHandle) != 0);
+    CHECK(current_generation(pHandle) == nGen);
+
+    //a reload that is asked for publishes before it returns
+    CHECK(!write_generation(szTemp, nGen + 1));
+    CHECK(!rename(szTemp, szSpec));
+    CHECK(!coapi_api_handle_reload(pHandle));
+    CHECK(current_generation(pHandle) >= nGen + 1);
+
+    __atomic_store_n(&nStop, 1, __ATOMIC_RELAXED);
+    for(i = 0; i < CHECK_RELOAD_READERS; ++i)
+    {
+        pthread_join(pReaders[i].nThread, NULL);
+        CHECK(pReaders[i].nAcquires > 0);
+        CHECK(pReaders[i].nBad == 0);
+    }
+
+    coapi_api_handle_close(pHandle);
+    unlink(szSpec);
+    unlink(szTemp);
+    rmdir(szDir);
+
+    return nFailed ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Checks that a compiled image is used while the text of its spec is
+//the same, after a touch or a copy of both, and not after an edit,
+//even one that keeps the size and mtime of the spec.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <copenapi.h>
+#include "check_util.h"
+
+//the same length with either summary
+#define CHECK_SPEC_FORMAT \
+"{\"swagger\":\"2.0\",\"host\":\"h\",\"basePath\":\"/v1\",\"paths\":{" \
+"\"/pet\":{\"get\":{\"summary\":\"%s\"}}}}"
+
+static int
+write_spec(
+    const char *pszPath,
+    const char *pszSummary
+    )
+{
+    char szText[256];
+
+    snprintf(szText, sizeof(szText), CHECK_SPEC_FORMAT, pszSummary);
+    return check_write_file(pszPath, szText);
+}
+
+static int
+copy_file(
+    const char *pszFrom,
+    const char *pszTo
+    )
+{
+    char pszBuffer[4096];
+    FILE *fpFrom = fopen(pszFrom, "r");
+    FILE *fpTo = fopen(pszTo, "w");
+    size_t nRead = 0;
+    int nRet = !fpFrom || !fpTo;
+
+    while(!nRet && (nRead = fread(pszBuffer, 1, sizeof(pszBuffer), fpFrom)))
+    {
+        nRet = fwrite(pszBuffer, 1, nRead, fpTo) != nRead;
+    }
+    if(fpFrom)
+    {
+        fclose(fpFrom);
+    }
+    if(fpTo && fclose(fpTo))
+    {
+        nRet = 1;
+    }
+    return nRet;
+}
+
+//sets the mtime of pszPath to that in pStat plus nSeconds
+static int
+set_mtime(
+    const char *pszPath,
+    const struct stat *pStat,
+    long nSeconds
+    )
+{
+    struct timeval ptvTimes[2] = {{0}};
+
+    ptvTimes[0].tv_sec = pStat->st_atime;
+    ptvTimes[1].tv_sec = pStat->st_mtime + nSeconds;
+    return utimes(pszPath, ptvTimes);
+}
+
+//loads pszSpec and checks whether it came from the image and which
+//summary it has
+static void
+check_load(
+    const char *pszSpec,
+    int nImage,
+    const char *pszSummary
+    )
+{
+    PREST_API_DEF pApiDef = NULL;
+    PREST_API_METHOD pMethod = NULL;
+
+    CHECK(!coapi_load_from_file(pszSpec, &pApiDef));
+    if(!pApiDef)
+    {
+        return;
+    }
+    CHECK((pApiDef->pImage != NULL) == nImage);
+    CHECK(!coapi_find_method(pApiDef, "/v1/pet", "get", &pMethod) &&
+          pMethod->pszSummary && !strcmp(pMethod->pszSummary, pszSummary));
+    coapi_free_api_def(pApiDef);
+}
+
+int
+main(
+    void
+    )
+{
+    char szDir[] = "/tmp/check_spec_index.XXXXXX";
+    char szSpec[sizeof(szDir) + 32];
+    char szImage[sizeof(szDir) + 32];
+    char szCopy[sizeof(szDir) + 32];
+    char szCopyImage[sizeof(szDir) + 32];
+    struct stat stSpec = {0};
+
+    if(!mkdtemp(szDir))
+    {
+        fprintf(stderr, "check_spec_index: no temp dir\n");
+        return 1;
+    }
+    snprintf(szSpec, sizeof(szSpec), "%s/spec.json", szDir);
+    snprintf(szImage, sizeof(szImage), "%s/spec.json.coapi", szDir);
+    snprintf(szCopy, sizeof(szCopy), "%s/copy.json", szDir);
+    snprintf(szCopyImage, sizeof(szCopyImage), "%s/copy.json.coapi", szDir);
+
+    CHECK(!write_spec(szSpec, "one"));
+    CHECK(!coapi_compile_file(szSpec, NULL));
+    check_load(szSpec, 1, "one");
+
+    //a touch leaves the text as it was
+    CHECK(!stat(szSpec, &stSpec));
+    CHECK(!set_mtime(szSpec, &stSpec, 100));
+    check_load(szSpec, 1, "one");
+
+    //an edit of the same size with the mtime put back
+    CHECK(!stat(szSpec, &stSpec));
+    CHECK(!write_spec(szSpec, "two"));
+    CHECK(!set_mtime(szSpec, &stSpec, 0));
+    check_load(szSpec, 0, "two");
+    //and again, now that the index has the hash of the edit
+    check_load(szSpec, 0, "two");
+
+    //spec and image copied elsewhere
+    CHECK(!coapi_compile_file(szSpec, NULL));
+    CHECK(!copy_file(szSpec, szCopy));
+    CHECK(!copy_file(szImage, szCopyImage));
+    check_load(szCopy, 1, "two");
+
+    check_remove_spec(szCopy);
+    check_remove_spec(szSpec);
+    rmdir(szDir);
+    return nFailed ? 1 : 0;
+}
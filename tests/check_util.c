@@ -0,0 +1,165 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "check_util.h"
+
+//where shared images and spec indexes are kept, and how much of each
+//is read to find the path of its spec
+#define CHECK_SHARED_DIR "/dev/shm/copenapi-%u"
+#define CHECK_SHARED_HEAD 4096
+
+int nFailed = 0;
+
+int
+check_write_file(
+    const char *pszPath,
+    const char *pszText
+    )
+{
+    FILE *fp = fopen(pszPath, "w");
+
+    if(!fp)
+    {
+        return errno;
+    }
+    fputs(pszText, fp);
+    return fclose(fp) ? errno : 0;
+}
+
+size_t
+check_count_endpoints(
+    PREST_API_DEF pApiDef
+    )
+{
+    size_t nCount = 0;
+
+    if(!pApiDef || coapi_get_endpoint_count(pApiDef, &nCount))
+    {
+        return 0;
+    }
+    return nCount;
+}
+
+size_t
+check_count_module_endpoints(
+    PREST_API_MODULE pModule
+    )
+{
+    PREST_API_ENDPOINT pEndPoint = NULL;
+    size_t nCount = 0;
+
+    for(pEndPoint = pModule ? pModule->pEndPoints : NULL;
+        pEndPoint;
+        pEndPoint = pEndPoint->pNext)
+    {
+        ++nCount;
+    }
+    return nCount;
+}
+
+char *
+check_dump_api_def(
+    PREST_API_DEF pApiDef
+    )
+{
+    char *pszJson = NULL;
+    size_t nLength = 0;
+
+    if(!pApiDef || coapi_write_api_def_to_string(pApiDef, &pszJson, &nLength))
+    {
+        return NULL;
+    }
+    return pszJson;
+}
+
+//whether the head of pszPath has pszSpec, ending at a terminator or
+//at the end of the file
+static int
+names_spec(
+    const char *pszPath,
+    const char *pszSpec
+    )
+{
+    char pszHead[CHECK_SHARED_HEAD];
+    size_t nSpec = strlen(pszSpec);
+    size_t nHead = 0;
+    char *pszFound = NULL;
+    char *pszEnd = NULL;
+    FILE *fp = fopen(pszPath, "r");
+
+    if(!fp)
+    {
+        return 0;
+    }
+    nHead = fread(pszHead, 1, sizeof(pszHead), fp);
+    fclose(fp);
+
+    pszEnd = pszHead + nHead;
+    for(pszFound = memmem(pszHead, nHead, pszSpec, nSpec);
+        pszFound;
+        pszFound = memmem(pszFound + 1,
+                          pszEnd - pszFound - 1,
+                          pszSpec,
+                          nSpec))
+    {
+        if(pszFound + nSpec == pszEnd || !pszFound[nSpec])
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void
+check_remove_spec(
+    const char *pszSpec
+    )
+{
+    char szPath[PATH_MAX];
+    char *pszRealPath = realpath(pszSpec, NULL);
+    DIR *pDir = NULL;
+    struct dirent *pEntry = NULL;
+
+    snprintf(szPath, sizeof(szPath), "%s.coapi", pszSpec);
+    unlink(szPath);
+    unlink(pszSpec);
+
+    snprintf(szPath, sizeof(szPath), CHECK_SHARED_DIR, (unsigned)getuid());
+    pDir = pszRealPath ? opendir(szPath) : NULL;
+    while(pDir && (pEntry = readdir(pDir)) != NULL)
+    {
+        snprintf(szPath,
+                 sizeof(szPath),
+                 CHECK_SHARED_DIR "/%s",
+                 (unsigned)getuid(),
+                 pEntry->d_name);
+        if(pEntry->d_name[0] != '.' && names_spec(szPath, pszRealPath))
+        {
+            unlink(szPath);
+        }
+    }
+
+    if(pDir)
+    {
+        closedir(pDir);
+    }
+    free(pszRealPath);
+}
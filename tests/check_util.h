@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2016-2017 VMware, Inc.  All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License.  You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, without
+ * warranties or conditions of any kind, EITHER EXPRESS OR IMPLIED.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//Shared by the check programs. CHECK reports a failed condition and
+//counts it in nFailed, which main turns into the exit status.
+
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include <copenapi.h>
+
+#define CHECK(cond) \
+    do \
+    { \
+        if(!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            ++nFailed; \
+        } \
+    } while(0)
+
+extern int nFailed;
+
+//writes pszText to pszPath. returns 0 or errno.
+int
+check_write_file(
+    const char *pszPath,
+    const char *pszText
+    );
+
+//endpoints of every module, 0 on error
+size_t
+check_count_endpoints(
+    PREST_API_DEF pApiDef
+    );
+
+//endpoints in the list of one module
+size_t
+check_count_module_endpoints(
+    PREST_API_MODULE pModule
+    );
+
+//the def written back out as a spec, to compare two defs. free with
+//free. NULL on error.
+char *
+check_dump_api_def(
+    PREST_API_DEF pApiDef
+    );
+
+//removes pszSpec, its compiled image and the shared images and spec
+//indexes that name it
+void
+check_remove_spec(
+    const char *pszSpec
+    );
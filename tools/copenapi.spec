@@ -8,8 +8,6 @@ Distribution:  Photon
 License:       Apache 2.0
 URL:           http://www.github.com/vmware/copenapi
 BuildArch:     x86_64
-Requires:      jansson
-BuildRequires: jansson-devel
 Source0:       %{name}-%{version}.tar.gz
 
 %description